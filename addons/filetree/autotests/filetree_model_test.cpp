@@ -379,6 +379,20 @@ void FileTreeModelTest::buildTreeBatch_data()
 {
   // the easiest way to verify the equality of those two calls:)
   buildTree_data();
+
+  // enough documents to rebuild the model in one reset
+  QList<DummyDocument *> many;
+  ResultNode a("a", true);
+  ResultNode b("b", true);
+  for (int i = 0; i < 20; i++) {
+    const QString name = QStringLiteral("f%1.txt").arg(i);
+    many << new DummyDocument(QStringLiteral("file:///a/") + name);
+    many << new DummyDocument(QStringLiteral("file:///b/") + name);
+    a << ResultNode(name);
+    b << ResultNode(name);
+  }
+
+  QTest::newRow("reset") << many << (ResultNode() << a << b);
 }
 
 void FileTreeModelTest::buildTreeBatch()
@@ -142,6 +142,73 @@ void KateFileTree::setModel(QAbstractItemModel *model)
 {
     Q_ASSERT(qobject_cast<KateFileTreeProxyModel *>(model)); // we don't really work with anything else
     QTreeView::setModel(model);
+
+    connect(model, SIGNAL(modelAboutToBeReset()), this, SLOT(slotAboutToResetModel()));
+    connect(model, SIGNAL(modelReset()), this, SLOT(slotModelReset()));
+}
+
+void KateFileTree::slotAboutToResetModel()
+{
+    m_expandedPaths.clear();
+    m_selectedDocuments.clear();
+
+    // directories are found again by their path, documents by themselves
+    QList<QModelIndex> pending;
+    pending << QModelIndex();
+    while (!pending.isEmpty()) {
+        const QModelIndex parent = pending.takeLast();
+        for (int row = 0; row < model()->rowCount(parent); ++row) {
+            const QModelIndex index = model()->index(row, 0, parent);
+            if (isExpanded(index)) {
+                m_expandedPaths.insert(index.data(KateFileTreeModel::PathRole).toString());
+                pending << index;
+            }
+        }
+    }
+
+    foreach(const QModelIndex & index, selectionModel()->selectedIndexes()) {
+        if (KTextEditor::Document *doc = index.data(KateFileTreeModel::DocumentRole).value<KTextEditor::Document *>()) {
+            m_selectedDocuments << doc;
+        }
+    }
+
+    m_currentDocument = currentIndex().data(KateFileTreeModel::DocumentRole).value<KTextEditor::Document *>();
+}
+
+void KateFileTree::slotModelReset()
+{
+    if (!m_expandedPaths.isEmpty()) {
+        restoreExpansion(QModelIndex());
+        m_expandedPaths.clear();
+    }
+
+    KateFileTreeProxyModel *proxy = static_cast<KateFileTreeProxyModel *>(model());
+
+    QItemSelection selection;
+    foreach(KTextEditor::Document * doc, m_selectedDocuments) {
+        const QModelIndex index = doc ? proxy->docIndex(doc) : QModelIndex();
+        if (index.isValid()) {
+            selection.select(index, index);
+        }
+    }
+    m_selectedDocuments.clear();
+
+    if (m_currentDocument) {
+        selectionModel()->setCurrentIndex(proxy->docIndex(m_currentDocument), QItemSelectionModel::NoUpdate);
+        m_currentDocument.clear();
+    }
+    selectionModel()->select(selection, QItemSelectionModel::ClearAndSelect);
+}
+
+void KateFileTree::restoreExpansion(const QModelIndex &parent)
+{
+    for (int row = 0; row < model()->rowCount(parent); ++row) {
+        const QModelIndex index = model()->index(row, 0, parent);
+        if (m_expandedPaths.contains(index.data(KateFileTreeModel::PathRole).toString())) {
+            expand(index);
+            restoreExpansion(index);
+        }
+    }
 }
 
 QAction *KateFileTree::setupOption(
@@ -22,6 +22,9 @@
 
 #include <QUrl>
 #include <QIcon>
+#include <QList>
+#include <QPointer>
+#include <QSet>
 #include <QTreeView>
 
 namespace KTextEditor
@@ -85,7 +88,12 @@ private Q_SLOTS:
 
     void slotRenameFile();
 
+    void slotAboutToResetModel();
+    void slotModelReset();
+
 private:
+    void restoreExpansion(const QModelIndex &parent);
+
     QAction *setupOption(QActionGroup *group, const QIcon &, const QString &, const QString &, const char *slot, bool checked = false);
 
 private:
@@ -108,6 +116,11 @@ private:
     QAction *m_sortByOpeningOrder;
     QAction *m_resetHistory;
 
+    // the state kept over a reset of the model, e.g. when many documents are opened at once
+    QSet<QString> m_expandedPaths;
+    QList<QPointer<KTextEditor::Document> > m_selectedDocuments;
+    QPointer<KTextEditor::Document> m_currentDocument;
+
     QPersistentModelIndex m_previouslySelected;
     QPersistentModelIndex m_indexContextMenu;
 };
@@ -38,6 +38,9 @@
 
 #include "katefiletreedebug.h"
 
+// opening at least that many documents at once resets the model instead of inserting rows
+static const int BATCH_RESET_THRESHOLD = 32;
+
 class ProxyItemDir;
 class ProxyItem
 {
@@ -89,11 +92,17 @@ public:
     void clearFlag(Flag flag);
     bool flag(Flag flag) const;
 
+    /**
+     * @returns the directory child named @p name, or 0
+     */
+    ProxyItemDir *dirChild(const QString &name) const;
+
 private:
     QString m_path;
     QString m_documentName;
     ProxyItemDir *m_parent;
     QList<ProxyItem *> m_children;
+    QHash<QString, ProxyItem *> m_dirChildren; // directory children by their last path section
     int m_row;
     Flags m_flags;
 
@@ -125,7 +134,7 @@ QDebug operator<<(QDebug dbg, ProxyItem *item)
 class ProxyItemDir : public ProxyItem
 {
 public:
-    ProxyItemDir(QString n, ProxyItemDir *p = 0) : ProxyItem(n, p) {
+    ProxyItemDir(QString n, ProxyItemDir *p = 0) : ProxyItem(n, p, ProxyItem::Dir) {
         setFlag(ProxyItem::Dir);
         updateDisplay();
 
@@ -202,6 +211,10 @@ int ProxyItem::addChild(ProxyItem *item)
     m_children.append(item);
     item->m_parent = static_cast<ProxyItemDir *>(this);
 
+    if (item->flag(ProxyItem::Dir)) {
+        m_dirChildren.insert(item->m_path.section(QLatin1Char('/'), -1, -1), item);
+    }
+
     item->updateDisplay();
 
     return item_row;
@@ -218,6 +231,13 @@ void ProxyItem::remChild(ProxyItem *item)
         m_children[i]->m_row = i;
     }
 
+    if (item->flag(ProxyItem::Dir)) {
+        const QString name = item->m_path.section(QLatin1Char('/'), -1, -1);
+        if (m_dirChildren.value(name) == item) {
+            m_dirChildren.remove(name);
+        }
+    }
+
     item->m_parent = 0;
 }
 
@@ -226,6 +246,11 @@ ProxyItemDir *ProxyItem::parent() const
     return m_parent;
 }
 
+ProxyItemDir *ProxyItem::dirChild(const QString &name) const
+{
+    return static_cast<ProxyItemDir *>(m_dirChildren.value(name));
+}
+
 ProxyItem *ProxyItem::child(int idx) const
 {
     return (idx < 0 || idx >= m_children.count()) ? 0 : m_children[idx];
@@ -374,6 +399,12 @@ KateFileTreeModel::KateFileTreeModel(QObject *p)
     m_viewShade = KColorUtils::tint(bg, colors.foreground(KColorScheme::VisitedText).color(), 0.5);
     m_shadingEnabled = true;
     m_listMode = false;
+    m_batchInsert = false;
+
+    // collect all shading changes of one event loop iteration
+    m_backgroundTimer.setSingleShot(true);
+    m_backgroundTimer.setInterval(0);
+    connect(&m_backgroundTimer, SIGNAL(timeout()), this, SLOT(slotUpdateBackgrounds()));
 
     initModel();
 }
@@ -725,6 +756,21 @@ void KateFileTreeModel::documentOpened(KTextEditor::Document *doc)
 
 void KateFileTreeModel::documentsOpened(const QList<KTextEditor::Document *> &docs)
 {
+    int newDocs = 0;
+    foreach(KTextEditor::Document * doc, docs) {
+        if (!m_docmap.contains(doc)) {
+            newDocs++;
+        }
+    }
+
+    // announcing each row to the proxy and the views costs more than
+    // letting them rebuild once, if many documents arrive at once
+    const bool reset = newDocs >= BATCH_RESET_THRESHOLD;
+    if (reset) {
+        beginResetModel();
+        m_batchInsert = true;
+    }
+
     foreach(KTextEditor::Document * doc, docs) {
         if (m_docmap.contains(doc)) {
             documentNameChanged(doc);
@@ -732,6 +778,11 @@ void KateFileTreeModel::documentsOpened(const QList<KTextEditor::Document *> &do
             documentOpened(doc);
         }
     }
+
+    if (reset) {
+        m_batchInsert = false;
+        endResetModel();
+    }
 }
 
 void KateFileTreeModel::documentModifiedChanged(KTextEditor::Document *doc)
@@ -795,6 +846,10 @@ void KateFileTreeModel::documentActivated(const KTextEditor::Document *doc)
     }
 
     ProxyItem *item = m_docmap[doc];
+    if (!m_viewHistory.isEmpty() && m_viewHistory.first() == item) {
+        return;
+    }
+
     m_viewHistory.removeAll(item);
     m_viewHistory.prepend(item);
 
@@ -802,7 +857,7 @@ void KateFileTreeModel::documentActivated(const KTextEditor::Document *doc)
         m_viewHistory.removeLast();
     }
 
-    updateBackgrounds();
+    m_backgroundTimer.start();
 }
 
 void KateFileTreeModel::documentEdited(const KTextEditor::Document *doc)
@@ -812,13 +867,17 @@ void KateFileTreeModel::documentEdited(const KTextEditor::Document *doc)
     }
 
     ProxyItem *item = m_docmap[doc];
+    if (!m_editHistory.isEmpty() && m_editHistory.first() == item) {
+        return;
+    }
+
     m_editHistory.removeAll(item);
     m_editHistory.prepend(item);
     while (m_editHistory.count() > 10) {
         m_editHistory.removeLast();
     }
 
-    updateBackgrounds();
+    m_backgroundTimer.start();
 }
 
 void KateFileTreeModel::slotAboutToDeleteDocuments(const QList<KTextEditor::Document *> &docs)
@@ -854,7 +913,7 @@ void KateFileTreeModel::updateBackgrounds(bool force)
         return;
     }
 
-    QMap <ProxyItem *, EditViewCount> helper;
+    QHash<ProxyItem *, EditViewCount> helper;
     int i = 1;
 
     foreach(ProxyItem * item, m_viewHistory) {
@@ -868,13 +927,13 @@ void KateFileTreeModel::updateBackgrounds(bool force)
         i++;
     }
 
-    QMap<ProxyItem *, QBrush> oldBrushes = m_brushes;
+    QHash<ProxyItem *, QBrush> oldBrushes = m_brushes;
     m_brushes.clear();
 
     const int hc = m_viewHistory.count();
     const int ec = m_editHistory.count();
 
-    for (QMap<ProxyItem *, EditViewCount>::iterator it = helper.begin(); it != helper.end(); ++it) {
+    for (QHash<ProxyItem *, EditViewCount>::iterator it = helper.begin(); it != helper.end(); ++it) {
         QColor shade(m_viewShade);
         QColor eshade(m_editShade);
 
@@ -899,15 +958,57 @@ void KateFileTreeModel::updateBackgrounds(bool force)
         m_brushes[it.key()] = QBrush(KColorUtils::mix(QPalette().color(QPalette::Base), shade, t));
     }
 
-    foreach(ProxyItem * item, m_brushes.keys()) {
-        oldBrushes.remove(item);
-        const QModelIndex idx = createIndex(item->row(), 0, item);
-        dataChanged(idx, idx);
+    // only repaint items whose shade really changed
+    const QVector<int> roles(1, Qt::BackgroundRole);
+    for (QHash<ProxyItem *, QBrush>::const_iterator it = m_brushes.constBegin(); it != m_brushes.constEnd(); ++it) {
+        QHash<ProxyItem *, QBrush>::iterator old = oldBrushes.find(it.key());
+        if (old != oldBrushes.end()) {
+            const bool unchanged = (old.value() == it.value());
+            oldBrushes.erase(old);
+            if (unchanged && !force) {
+                continue;
+            }
+        }
+        const QModelIndex idx = createIndex(it.key()->row(), 0, it.key());
+        emit dataChanged(idx, idx, roles);
+    }
+
+    for (QHash<ProxyItem *, QBrush>::const_iterator it = oldBrushes.constBegin(); it != oldBrushes.constEnd(); ++it) {
+        const QModelIndex idx = createIndex(it.key()->row(), 0, it.key());
+        emit dataChanged(idx, idx, roles);
+    }
+}
+
+void KateFileTreeModel::slotUpdateBackgrounds()
+{
+    updateBackgrounds();
+}
+
+void KateFileTreeModel::beginInsertItems(const QModelIndex &parent, int first, int last)
+{
+    if (!m_batchInsert) {
+        beginInsertRows(parent, first, last);
+    }
+}
+
+void KateFileTreeModel::endInsertItems()
+{
+    if (!m_batchInsert) {
+        endInsertRows();
     }
+}
 
-    foreach(ProxyItem * item, oldBrushes.keys()) {
-        const QModelIndex idx = createIndex(item->row(), 0, item);
-        dataChanged(idx, idx);
+void KateFileTreeModel::beginRemoveItems(const QModelIndex &parent, int first, int last)
+{
+    if (!m_batchInsert) {
+        beginRemoveRows(parent, first, last);
+    }
+}
+
+void KateFileTreeModel::endRemoveItems()
+{
+    if (!m_batchInsert) {
+        endRemoveRows();
     }
 }
 
@@ -924,9 +1025,9 @@ void KateFileTreeModel::handleEmptyParents(ProxyItemDir *item)
     while (parent) {
         if (!item->childCount()) {
             const QModelIndex parent_index = (parent == m_root) ? QModelIndex() : createIndex(parent->row(), 0, parent);
-            beginRemoveRows(parent_index, item->row(), item->row());
+            beginRemoveItems(parent_index, item->row(), item->row());
             parent->remChild(item);
-            endRemoveRows();
+            endRemoveItems();
             delete item;
         } else {
             // breakout early, if this node isn't empty, theres no use in checking its parents
@@ -963,9 +1064,9 @@ void KateFileTreeModel::documentClosed(KTextEditor::Document *doc)
     ProxyItemDir *parent = node->parent();
 
     const QModelIndex parent_index = (parent == m_root) ? QModelIndex() : createIndex(parent->row(), 0, parent);
-    beginRemoveRows(parent_index, node->row(), node->row());
+    beginRemoveItems(parent_index, node->row(), node->row());
     node->parent()->remChild(node);
-    endRemoveRows();
+    endRemoveItems();
 
     delete node;
     handleEmptyParents(parent);
@@ -1035,21 +1136,10 @@ ProxyItemDir *KateFileTreeModel::findChildNode(const ProxyItemDir *parent, const
     Q_ASSERT(parent != 0);
     Q_ASSERT(!name.isEmpty());
 
-    if (!parent->childCount()) {
-        return 0;
-    }
-
-    foreach(ProxyItem * item, parent->children()) {
-        if (!item->flag(ProxyItem::Dir)) {
-            continue;
-        }
-
-        if (item->display() == name) {
-            return static_cast<ProxyItemDir *>(item);
-        }
-    }
+    // below the top level, the display of a directory is its last path section
+    Q_ASSERT(parent != m_root);
 
-    return 0;
+    return parent->dirChild(name);
 }
 
 void KateFileTreeModel::insertItemInto(ProxyItemDir *root, ProxyItem *item)
@@ -1075,18 +1165,18 @@ void KateFileTreeModel::insertItemInto(ProxyItemDir *root, ProxyItem *item)
         if (!find) {
             const QString new_name = current_parts.join(QLatin1String("/"));
             const QModelIndex parent_index = (ptr == m_root) ? QModelIndex() : createIndex(ptr->row(), 0, ptr);
-            beginInsertRows(parent_index, ptr->childCount(), ptr->childCount());
+            beginInsertItems(parent_index, ptr->childCount(), ptr->childCount());
             ptr = new ProxyItemDir(new_name, ptr);
-            endInsertRows();
+            endInsertItems();
         } else {
             ptr = find;
         }
     }
 
     const QModelIndex parent_index = (ptr == m_root) ? QModelIndex() : createIndex(ptr->row(), 0, ptr);
-    beginInsertRows(parent_index, ptr->childCount(), ptr->childCount());
+    beginInsertItems(parent_index, ptr->childCount(), ptr->childCount());
     ptr->addChild(item);
-    endInsertRows();
+    endInsertItems();
 }
 
 void KateFileTreeModel::handleInsert(ProxyItem *item)
@@ -1094,9 +1184,9 @@ void KateFileTreeModel::handleInsert(ProxyItem *item)
     Q_ASSERT(item != 0);
 
     if (m_listMode || item->flag(ProxyItem::Empty)) {
-        beginInsertRows(QModelIndex(), m_root->childCount(), m_root->childCount());
+        beginInsertItems(QModelIndex(), m_root->childCount(), m_root->childCount());
         m_root->addChild(item);
-        endInsertRows();
+        endInsertItems();
         return;
     }
 
@@ -1115,9 +1205,9 @@ void KateFileTreeModel::handleInsert(ProxyItem *item)
     new_root->setHost(item->host());
 
     // add new root to m_root
-    beginInsertRows(QModelIndex(), m_root->childCount(), m_root->childCount());
+    beginInsertItems(QModelIndex(), m_root->childCount(), m_root->childCount());
     m_root->addChild(new_root);
-    endInsertRows();
+    endInsertItems();
 
     // same fix as in findRootNode, try to match a full dir, instead of a partial path
     base += QLatin1Char('/');
@@ -1129,9 +1219,9 @@ void KateFileTreeModel::handleInsert(ProxyItem *item)
         }
 
         if (root->path().startsWith(base)) {
-            beginRemoveRows(QModelIndex(), root->row(), root->row());
+            beginRemoveItems(QModelIndex(), root->row(), root->row());
             m_root->remChild(root);
-            endRemoveRows();
+            endRemoveItems();
 
             //beginInsertRows(new_root_index, new_root->childCount(), new_root->childCount());
             // this can't use new_root->addChild directly, or it'll potentially miss a bunch of subdirs
@@ -1143,9 +1233,9 @@ void KateFileTreeModel::handleInsert(ProxyItem *item)
     // add item to new root
     // have to call begin/endInsertRows here, or the new item won't show up.
     const QModelIndex new_root_index = createIndex(new_root->row(), 0, new_root);
-    beginInsertRows(new_root_index, new_root->childCount(), new_root->childCount());
+    beginInsertItems(new_root_index, new_root->childCount(), new_root->childCount());
     new_root->addChild(item);
-    endInsertRows();
+    endInsertItems();
 
     handleDuplicitRootDisplay(new_root);
 }
@@ -1174,14 +1264,14 @@ void KateFileTreeModel::handleDuplicitRootDisplay(ProxyItemDir *init)
 
                 const QString rdir = root->path().section(QLatin1Char('/'), 0, -2);
                 if (!rdir.isEmpty()) {
-                    beginRemoveRows(QModelIndex(), root->row(), root->row());
+                    beginRemoveItems(QModelIndex(), root->row(), root->row());
                     m_root->remChild(root);
-                    endRemoveRows();
+                    endRemoveItems();
 
                     ProxyItemDir *irdir = new ProxyItemDir(rdir);
-                    beginInsertRows(QModelIndex(), m_root->childCount(), m_root->childCount());
+                    beginInsertItems(QModelIndex(), m_root->childCount(), m_root->childCount());
                     m_root->addChild(irdir);
-                    endInsertRows();
+                    endInsertItems();
 
                     insertItemInto(irdir, root);
 
@@ -1192,11 +1282,11 @@ void KateFileTreeModel::handleDuplicitRootDisplay(ProxyItemDir *init)
 
                         const QString xy = rdir + QLatin1Char('/');
                         if (node->path().startsWith(xy)) {
-                            beginRemoveRows(QModelIndex(), node->row(), node->row());
+                            beginRemoveItems(QModelIndex(), node->row(), node->row());
                             // check_root_removed must be sticky
                             check_root_removed = check_root_removed || (node == check_root);
                             m_root->remChild(node);
-                            endRemoveRows();
+                            endRemoveItems();
                             insertItemInto(irdir, node);
                         }
                     }
@@ -1208,14 +1298,14 @@ void KateFileTreeModel::handleDuplicitRootDisplay(ProxyItemDir *init)
                 if (!check_root_removed) {
                     const QString nrdir = check_root->path().section(QLatin1Char('/'), 0, -2);
                     if (!nrdir.isEmpty()) {
-                        beginRemoveRows(QModelIndex(), check_root->row(), check_root->row());
+                        beginRemoveItems(QModelIndex(), check_root->row(), check_root->row());
                         m_root->remChild(check_root);
-                        endRemoveRows();
+                        endRemoveItems();
 
                         ProxyItemDir *irdir = new ProxyItemDir(nrdir);
-                        beginInsertRows(QModelIndex(), m_root->childCount(), m_root->childCount());
+                        beginInsertItems(QModelIndex(), m_root->childCount(), m_root->childCount());
                         m_root->addChild(irdir);
-                        endInsertRows();
+                        endInsertItems();
 
                         insertItemInto(irdir, check_root);
 
@@ -1242,9 +1332,11 @@ void KateFileTreeModel::handleNameChange(ProxyItem *item)
     updateItemPathAndHost(item);
 
     if (m_listMode) {
-        const QModelIndex idx = createIndex(item->row(), 0, item);
         setupIcon(item);
-        emit dataChanged(idx, idx);
+        if (!m_batchInsert) {
+            const QModelIndex idx = createIndex(item->row(), 0, item);
+            emit dataChanged(idx, idx);
+        }
         return;
     }
 
@@ -1252,9 +1344,9 @@ void KateFileTreeModel::handleNameChange(ProxyItem *item)
     ProxyItemDir *parent = item->parent();
 
     const QModelIndex parent_index = (parent == m_root) ? QModelIndex() : createIndex(parent->row(), 0, parent);
-    beginRemoveRows(parent_index, item->row(), item->row());
+    beginRemoveItems(parent_index, item->row(), item->row());
     parent->remChild(item);
-    endRemoveRows();
+    endRemoveItems();
 
     handleEmptyParents(parent);
 
@@ -1309,12 +1401,23 @@ void KateFileTreeModel::setupIcon(ProxyItem *item) const
         icon_name = QMimeDatabase().mimeTypeForFile(url.path(), QMimeDatabase::MatchExtension).iconName();
     }
 
+    const bool overlay = item->flag(ProxyItem::ModifiedExternally) || item->flag(ProxyItem::DeletedExternally);
+
+    // theme lookups are expensive and most documents share a handful of icons
+    QHash<QString, QIcon> &cache = overlay ? m_overlayIconCache : m_iconCache;
+    QHash<QString, QIcon>::const_iterator it = cache.constFind(icon_name);
+    if (it != cache.constEnd()) {
+        item->setIcon(it.value());
+        return;
+    }
+
     QIcon icon = QIcon::fromTheme(icon_name);
 
-    if (item->flag(ProxyItem::ModifiedExternally) || item->flag(ProxyItem::DeletedExternally)) {
+    if (overlay) {
         icon = KIconUtils::addOverlay(icon, QIcon(QLatin1String("emblem-important")), Qt::TopLeftCorner);
     }
 
+    cache.insert(icon_name, icon);
     item->setIcon(icon);
 }
 
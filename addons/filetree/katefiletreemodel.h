@@ -22,6 +22,9 @@
 
 #include <QAbstractItemModel>
 #include <QColor>
+#include <QHash>
+#include <QIcon>
+#include <QTimer>
 
 #include <ktexteditor/modificationinterface.h>
 namespace KTextEditor
@@ -96,6 +99,9 @@ public Q_SLOTS:
 Q_SIGNALS:
     void triggerViewChangeAfterNameChange();
 
+private Q_SLOTS:
+    void slotUpdateBackgrounds();
+
 private:
     ProxyItemDir *findRootNode(const QString &name, const int r = 1) const;
     ProxyItemDir *findChildNode(const ProxyItemDir *parent, const QString &name) const;
@@ -109,6 +115,12 @@ private:
 
     void updateBackgrounds(bool force = false);
 
+    /* row change notifications, suppressed while documentsOpened() resets the model */
+    void beginInsertItems(const QModelIndex &parent, int first, int last);
+    void endInsertItems();
+    void beginRemoveItems(const QModelIndex &parent, int first, int last);
+    void endRemoveItems();
+
     void initModel();
     void clearModel();
     void connectDocument(const KTextEditor::Document *);
@@ -121,12 +133,17 @@ private:
 
     QList<ProxyItem *> m_viewHistory;
     QList<ProxyItem *> m_editHistory;
-    QMap<ProxyItem *, QBrush> m_brushes;
+    QHash<ProxyItem *, QBrush> m_brushes;
+    QTimer m_backgroundTimer;
+
+    mutable QHash<QString, QIcon> m_iconCache;
+    mutable QHash<QString, QIcon> m_overlayIconCache;
 
     QColor m_editShade;
     QColor m_viewShade;
 
     bool m_listMode;
+    bool m_batchInsert;
 };
 
 #endif /* KATEFILETREEMODEL_H */
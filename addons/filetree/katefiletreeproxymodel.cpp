@@ -21,12 +21,14 @@
 #include "katefiletreemodel.h"
 #include "katefiletreedebug.h"
 
-#include <QCollator>
 #include <ktexteditor/document.h>
 
 KateFileTreeProxyModel::KateFileTreeProxyModel(QObject *parent)
     : QSortFilterProxyModel(parent)
 {
+    // lessThan() runs for every comparison while sorting, set the collator up once
+    m_collator.setCaseSensitivity(Qt::CaseInsensitive);
+    m_collator.setNumericMode(true);
 }
 
 void KateFileTreeProxyModel::setSourceModel(QAbstractItemModel *model)
@@ -47,21 +49,17 @@ bool KateFileTreeProxyModel::lessThan(const QModelIndex &left, const QModelIndex
         return ((left_isdir - right_isdir)) > 0;
     }
 
-    QCollator collate;
-    collate.setCaseSensitivity(Qt::CaseInsensitive);
-    collate.setNumericMode(true);
-
     switch (sortRole()) {
     case Qt::DisplayRole: {
         const QString left_name = model->data(left).toString();
         const QString right_name = model->data(right).toString();
-        return collate.compare(left_name, right_name) < 0;
+        return m_collator.compare(left_name, right_name) < 0;
     }
 
     case KateFileTreeModel::PathRole: {
         const QString left_name = model->data(left, KateFileTreeModel::PathRole).toString();
         const QString right_name = model->data(right, KateFileTreeModel::PathRole).toString();
-        return collate.compare(left_name, right_name) < 0;
+        return m_collator.compare(left_name, right_name) < 0;
     }
 
     case KateFileTreeModel::OpeningOrderRole:
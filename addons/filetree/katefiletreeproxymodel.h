@@ -21,6 +21,7 @@
 #define KATE_FILETREEPROXYMODEL_H
 
 #include <QSortFilterProxyModel>
+#include <QCollator>
 
 namespace KTextEditor
 {
@@ -40,6 +41,8 @@ public:
 protected:
     bool lessThan(const QModelIndex &left, const QModelIndex &right) const;
 
+private:
+    QCollator m_collator;
 };
 
 #endif /* KATE_FILETREEPROXYMODEL_H */
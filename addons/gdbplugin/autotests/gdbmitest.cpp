@@ -0,0 +1,141 @@
+//
+// Description: Tests for the GDB/MI output parser
+//
+// Copyright (c) 2010 Kåre Särs <kare.sars@iki.fi>
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Library General Public
+//  License version 2 as published by the Free Software Foundation.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Library General Public License for more details.
+//
+//  You should have received a copy of the GNU Library General Public License
+//  along with this library; see the file COPYING.LIB.  If not, write to
+//  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+//  Boston, MA 02110-1301, USA.
+
+#include "gdbmitest.h"
+#include "gdbmi.h"
+
+#include <QtTest>
+
+QTEST_MAIN(GdbMiTest)
+
+void GdbMiTest::testStreamRecords()
+{
+    GdbMi::Record record = GdbMi::parseRecord("~\"$1 = \\\"a\\\\b\\\"\\n\"");
+    QCOMPARE(record.type, GdbMi::Record::Console);
+    QCOMPARE(record.token, -1);
+    QCOMPARE(record.text, QStringLiteral("$1 = \"a\\b\"\n"));
+
+    record = GdbMi::parseRecord("&\"No symbol \\\"x\\\" in current context.\\n\"");
+    QCOMPARE(record.type, GdbMi::Record::Log);
+    QCOMPARE(record.text, QStringLiteral("No symbol \"x\" in current context.\n"));
+
+    // non ASCII bytes are escaped as octal numbers
+    record = GdbMi::parseRecord("@\"\\101\\102\\tC\"");
+    QCOMPARE(record.type, GdbMi::Record::Target);
+    QCOMPARE(record.text, QStringLiteral("AB\tC"));
+
+    record = GdbMi::parseRecord("(gdb) ");
+    QCOMPARE(record.type, GdbMi::Record::Prompt);
+}
+
+void GdbMiTest::testResultRecords()
+{
+    GdbMi::Record record = GdbMi::parseRecord("12^done\r");
+    QCOMPARE(record.type, GdbMi::Record::Result);
+    QCOMPARE(record.token, 12);
+    QCOMPARE(record.klass, QStringLiteral("done"));
+    QVERIFY(record.results.isEmpty());
+
+    record = GdbMi::parseRecord("3^error,msg=\"The program is not being run.\"");
+    QCOMPARE(record.token, 3);
+    QCOMPARE(record.klass, QStringLiteral("error"));
+    QCOMPARE(record.results.value(QStringLiteral("msg")).toString(), QStringLiteral("The program is not being run."));
+
+    record = GdbMi::parseRecord("7^done,bkpt={number=\"1\",type=\"breakpoint\",disp=\"keep\",enabled=\"y\","
+                                "addr=\"0x0000000000400536\",func=\"main\",file=\"test.c\",fullname=\"/tmp/test.c\","
+                                "line=\"5\",thread-groups=[\"i1\"],times=\"0\"}");
+    const QVariantMap bkpt = record.results.value(QStringLiteral("bkpt")).toMap();
+    QCOMPARE(bkpt.value(QStringLiteral("number")).toString(), QStringLiteral("1"));
+    QCOMPARE(bkpt.value(QStringLiteral("fullname")).toString(), QStringLiteral("/tmp/test.c"));
+    QCOMPARE(bkpt.value(QStringLiteral("thread-groups")).toList().size(), 1);
+
+    // the locations of a multiple location breakpoint follow as nameless tuples
+    record = GdbMi::parseRecord("8^done,bkpt={number=\"2\",addr=\"<MULTIPLE>\"},{number=\"2.1\",line=\"3\"},{number=\"2.2\",line=\"9\"}");
+    QCOMPARE(record.results.size(), 1);
+    QCOMPARE(record.results.value(QStringLiteral("bkpt")).toMap().value(QStringLiteral("number")).toString(), QStringLiteral("2"));
+
+    record = GdbMi::parseRecord("9^done,variables=[{name=\"i\",arg=\"1\",value=\"5\"},{name=\"s\",value=\"{a = 1, b = 0x0}\"}],empty=[],tuple={}");
+    const QVariantList variables = record.results.value(QStringLiteral("variables")).toList();
+    QCOMPARE(variables.size(), 2);
+    QCOMPARE(variables[1].toMap().value(QStringLiteral("value")).toString(), QStringLiteral("{a = 1, b = 0x0}"));
+    QVERIFY(record.results.value(QStringLiteral("empty")).toList().isEmpty());
+    QVERIFY(record.results.value(QStringLiteral("tuple")).toMap().isEmpty());
+}
+
+void GdbMiTest::testStoppedRecord()
+{
+    const GdbMi::Record record = GdbMi::parseRecord("*stopped,reason=\"end-stepping-range\",frame={addr=\"0x00400540\","
+                                                    "func=\"main\",args=[{name=\"argc\",value=\"1\"}],file=\"test.c\","
+                                                    "fullname=\"/tmp/test.c\",line=\"6\"},thread-id=\"1\",stopped-threads=\"all\"");
+    QCOMPARE(record.type, GdbMi::Record::Exec);
+    QCOMPARE(record.klass, QStringLiteral("stopped"));
+    QCOMPARE(record.results.value(QStringLiteral("reason")).toString(), QStringLiteral("end-stepping-range"));
+
+    const QVariantMap frame = record.results.value(QStringLiteral("frame")).toMap();
+    QCOMPARE(frame.value(QStringLiteral("line")).toInt(), 6);
+    QCOMPARE(frame.value(QStringLiteral("args")).toList()[0].toMap().value(QStringLiteral("name")).toString(), QStringLiteral("argc"));
+    QCOMPARE(record.results.value(QStringLiteral("stopped-threads")).toString(), QStringLiteral("all"));
+
+    // a list of results keeps the values only
+    const GdbMi::Record stack = GdbMi::parseRecord("^done,stack=[frame={level=\"0\"},frame={level=\"1\"}]");
+    const QVariantList frames = stack.results.value(QStringLiteral("stack")).toList();
+    QCOMPARE(frames.size(), 2);
+    QCOMPARE(frames[1].toMap().value(QStringLiteral("level")).toString(), QStringLiteral("1"));
+}
+
+void GdbMiTest::testNotInterpreterOutput()
+{
+    const GdbMi::Record record = GdbMi::parseRecord("42 is the answer");
+    QCOMPARE(record.type, GdbMi::Record::Invalid);
+    QCOMPARE(record.token, -1);
+    QCOMPARE(record.text, QStringLiteral("42 is the answer"));
+}
+
+void GdbMiTest::testQuote()
+{
+    QCOMPARE(GdbMi::quote(QStringLiteral("print \"a\\b\"")), QStringLiteral("\"print \\\"a\\\\b\\\"\""));
+
+    // quoting and parsing are symmetric
+    const QString text = QStringLiteral("break /path with spaces/file.c:12");
+    const GdbMi::Record record = GdbMi::parseRecord("~" + GdbMi::quote(text).toLocal8Bit());
+    QCOMPARE(record.text, text);
+
+    // a command must stay on one line
+    const QString lines = QStringLiteral("a\nb\r\tc");
+    QCOMPARE(GdbMi::quote(lines), QStringLiteral("\"a\\nb\\r\\tc\""));
+    QCOMPARE(GdbMi::parseRecord("~" + GdbMi::quote(lines).toLocal8Bit()).text, lines);
+}
+
+void GdbMiTest::benchmarkStackList()
+{
+    QByteArray line("^done,stack=[");
+    for (int i = 0; i < 1000; i++) {
+        if (i > 0) {
+            line += ',';
+        }
+        line += "frame={level=\"" + QByteArray::number(i) + "\",addr=\"0x0000000000400536\",func=\"recurse\","
+                "file=\"test.c\",fullname=\"/tmp/test.c\",line=\"12\"}";
+    }
+    line += ']';
+
+    QBENCHMARK {
+        const GdbMi::Record record = GdbMi::parseRecord(line);
+        QCOMPARE(record.results.value(QStringLiteral("stack")).toList().size(), 1000);
+    }
+}
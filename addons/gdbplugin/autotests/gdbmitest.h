@@ -0,0 +1,38 @@
+//
+// Description: Tests for the GDB/MI output parser
+//
+// Copyright (c) 2010 Kåre Särs <kare.sars@iki.fi>
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Library General Public
+//  License version 2 as published by the Free Software Foundation.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Library General Public License for more details.
+//
+//  You should have received a copy of the GNU Library General Public License
+//  along with this library; see the file COPYING.LIB.  If not, write to
+//  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+//  Boston, MA 02110-1301, USA.
+
+#ifndef GDBMI_TEST_H
+#define GDBMI_TEST_H
+
+#include <QObject>
+
+class GdbMiTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testStreamRecords();
+    void testResultRecords();
+    void testStoppedRecord();
+    void testNotInterpreterOutput();
+    void testQuote();
+    void benchmarkStackList();
+};
+
+#endif
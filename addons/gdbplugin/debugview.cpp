@@ -22,9 +22,10 @@
 //  Boston, MA 02110-1301, USA.
 
 #include "debugview.h"
+#include "gdbmi.h"
 
-#include <QRegExp>
 #include <QFile>
+#include <QSet>
 #include <QTimer>
 
 #include <kmessagebox.h>
@@ -34,13 +35,15 @@
 #include <signal.h>
 #include <stdlib.h>
 
-static const QString PromptStr = QStringLiteral("(prompt)");
+// number of children listed at once, containers can be huge
+static const int CHILDREN_PAGE = 100;
 
 DebugView::DebugView(QObject* parent)
 :   QObject(parent),
     m_debugProcess(0),
     m_state(none),
-    m_subState(normal),
+    m_token(0),
+    m_running(false),
     m_debugLocationChanged(true),
     m_queryLocals(false)
 {
@@ -63,6 +66,9 @@ void DebugView::runDebugger(const GDBTargetConf &conf, const QStringList &ioFifo
         return;
     }
     m_targetConf = conf;
+    // the locals view is cleared on every start
+    m_locals.clear();
+    m_localsFrame.clear();
     if (ioFifos.size() == 3) {
         m_ioPipeString = QStringLiteral("< %1 1> %2 2> %3")
         .arg(ioFifos[0])
@@ -73,7 +79,8 @@ void DebugView::runDebugger(const GDBTargetConf &conf, const QStringList &ioFifo
     if (m_state == none) {
         m_outBuffer.clear();
         m_errBuffer.clear();
-        m_errorList.clear();
+        m_pending.clear();
+        m_running = false;
 
         //create a process to control GDB
         m_debugProcess.setWorkingDirectory(m_targetConf.workDir);
@@ -90,9 +97,11 @@ void DebugView::runDebugger(const GDBTargetConf &conf, const QStringList &ioFifo
         connect(&m_debugProcess, SIGNAL(finished(int,QProcess::ExitStatus)),
                             this, SLOT(slotDebugFinished(int,QProcess::ExitStatus)));
 
-        m_debugProcess.start(m_targetConf.gdbCmd);
+        // the machine interface answers with records instead of prose
+        m_debugProcess.start(m_targetConf.gdbCmd + QStringLiteral(" --interpreter=mi2"));
 
         m_nextCommands << QStringLiteral("set pagination off");
+        m_nextCommands << QStringLiteral("(Q)-enable-pretty-printing");
         m_state = ready;
     }
     else
@@ -105,7 +114,7 @@ void DebugView::runDebugger(const GDBTargetConf &conf, const QStringList &ioFifo
     m_nextCommands << QStringLiteral("set args %1 %2").arg(m_targetConf.arguments).arg(m_ioPipeString);
     m_nextCommands << QStringLiteral("set inferior-tty /dev/null");
     m_nextCommands << m_targetConf.customInit;
-    m_nextCommands << QStringLiteral("(Q) info breakpoints");
+    m_nextCommands << QStringLiteral("(Q)-break-list");
 }
 
 bool DebugView::debuggerRunning() const
@@ -151,36 +160,28 @@ void DebugView::slotError()
 
 void DebugView::slotReadDebugStdOut()
 {
-    m_outBuffer += QString::fromLocal8Bit(m_debugProcess.readAllStandardOutput().data());
-    int end=0;
-    // handle one line at a time
-    do {
-        end = m_outBuffer.indexOf(QLatin1Char('\n'));
-        if (end < 0) break;
-        processLine(m_outBuffer.mid(0, end));
-        m_outBuffer.remove(0,end+1);
-    } while (1);
-
-    if (m_outBuffer == QLatin1String("(gdb) ") || m_outBuffer == QLatin1String(">"))
-    {
-        m_outBuffer.clear();
-        processLine(PromptStr);
+    m_outBuffer += m_debugProcess.readAllStandardOutput();
+    // handle one line at a time, the buffer is only shifted once
+    int start = 0;
+    int end;
+    while ((end = m_outBuffer.indexOf('\n', start)) >= 0) {
+        processLine(m_outBuffer.mid(start, end - start));
+        start = end + 1;
     }
+    m_outBuffer.remove(0, start);
 }
 
 void DebugView::slotReadDebugStdErr()
 {
     m_errBuffer += QString::fromLocal8Bit(m_debugProcess.readAllStandardError().data());
     int end=0;
-    // add whole lines at a time to the error list
+    // command errors arrive as result records, whatever ends up here is just shown
     do {
         end = m_errBuffer.indexOf(QLatin1Char('\n'));
         if (end < 0) break;
-        m_errorList << m_errBuffer.mid(0, end);
+        emit outputError(m_errBuffer.left(end + 1));
         m_errBuffer.remove(0,end+1);
     } while (1);
-
-    processErrors();
 }
 
 void DebugView::slotDebugFinished(int /*exitCode*/, QProcess::ExitStatus status)
@@ -191,6 +192,10 @@ void DebugView::slotDebugFinished(int /*exitCode*/, QProcess::ExitStatus status)
     }
 
     m_state = none;
+    m_pending.clear();
+    m_running = false;
+    m_locals.clear();
+    m_localsFrame.clear();
     emit readyForInput(false);
 
     // remove all old breakpoints
@@ -237,10 +242,14 @@ void DebugView::slotInterrupt()
 
 void DebugView::slotKill()
 {
-    if(m_state != ready)
+    if(m_state == executingCmd)
     {
-        slotInterrupt();
-        m_state = ready;
+        if (m_running) {
+            slotInterrupt();
+        }
+        // sent as soon as gdb is done with the current command
+        m_nextCommands.prepend(QStringLiteral("kill"));
+        return;
     }
     issueCommand(QStringLiteral("kill"));
 }
@@ -252,7 +261,7 @@ void DebugView::slotReRun()
     m_nextCommands << QStringLiteral("set args %1 %2").arg(m_targetConf.arguments).arg(m_ioPipeString);
     m_nextCommands << QStringLiteral("set inferior-tty /dev/null");
     m_nextCommands << m_targetConf.customInit;
-    m_nextCommands << QStringLiteral("(Q) info breakpoints");
+    m_nextCommands << QStringLiteral("(Q)-break-list");
 
     m_nextCommands << QStringLiteral("tbreak main");
     m_nextCommands << QStringLiteral("run");
@@ -280,357 +289,583 @@ void DebugView::slotContinue()
     issueCommand(QStringLiteral("continue"));
 }
 
-static QRegExp breakpointList(QStringLiteral("Num\\s+Type\\s+Disp\\s+Enb\\s+Address\\s+What.*"));
-static QRegExp breakpointListed(QStringLiteral("(\\d)\\s+breakpoint\\s+keep\\sy\\s+0x[\\da-f]+\\sin\\s.+\\sat\\s([^:]+):(\\d+).*"));
-static QRegExp stackFrameAny(QStringLiteral("#(\\d+)\\s(.*)"));
-static QRegExp stackFrameFile(QStringLiteral("#(\\d+)\\s+(?:0x[\\da-f]+\\s*in\\s)*(\\S+)(\\s\\(.*\\)) at ([^:]+):(\\d+).*"));
-static QRegExp changeFile(QStringLiteral("(?:(?:Temporary\\sbreakpoint|Breakpoint)\\s*\\d+,\\s*|0x[\\da-f]+\\s*in\\s*)?[^\\s]+\\s*\\([^)]*\\)\\s*at\\s*([^:]+):(\\d+).*"));
-static QRegExp changeLine(QStringLiteral("(\\d+)\\s+.*"));
-static QRegExp breakPointReg(QStringLiteral("Breakpoint\\s+(\\d+)\\s+at\\s+0x[\\da-f]+:\\s+file\\s+([^\\,]+)\\,\\s+line\\s+(\\d+).*"));
-static QRegExp breakPointMultiReg(QStringLiteral("Breakpoint\\s+(\\d+)\\s+at\\s+0x[\\da-f]+:\\s+([^\\,]+):(\\d+).*"));
-static QRegExp breakPointDel(QStringLiteral("Deleted\\s+breakpoint.*"));
-static QRegExp exitProgram(QStringLiteral("(?:Program|.*Inferior.*)\\s+exited.*"));
-static QRegExp threadLine(QStringLiteral("\\**\\s+(\\d+)\\s+Thread.*"));
+// Commands the plugin issues itself are translated to their MI counterparts,
+// so that their results arrive as records. Anything else is run by the CLI.
+static QString toMiCommand(const QString &cmd)
+{
+    if (cmd.startsWith(QLatin1Char('-'))) {
+        return cmd;
+    }
 
-void DebugView::processLine(QString line)
+    const QString verb = cmd.section(QLatin1Char(' '), 0, 0);
+    const QString arg = cmd.section(QLatin1Char(' '), 1);
+    if (arg.isEmpty() &&
+        ((verb == QLatin1String("step")) ||
+        (verb == QLatin1String("next")) ||
+        (verb == QLatin1String("finish")) ||
+        (verb == QLatin1String("continue")) ||
+        (verb == QLatin1String("run"))))
+    {
+        return QStringLiteral("-exec-") + verb;
+    }
+    if (!arg.isEmpty() && !arg.contains(QLatin1Char(' ')))
+    {
+        if (verb == QLatin1String("break")) {
+            return QStringLiteral("-break-insert ") + GdbMi::quote(arg);
+        }
+        if (verb == QLatin1String("tbreak")) {
+            return QStringLiteral("-break-insert -t ") + GdbMi::quote(arg);
+        }
+    }
+    return QStringLiteral("-interpreter-exec console ") + GdbMi::quote(cmd);
+}
+
+// FIXME gdb older than 7.12 does not report frame and thread changes made by
+// CLI commands, guess them from the command
+static bool changesFrame(const QString &cmd)
+{
+    const QString verb = cmd.section(QLatin1Char(' '), 0, 0);
+    return (verb == QLatin1String("f")) ||
+        (verb == QLatin1String("frame")) ||
+        (verb == QLatin1String("up")) ||
+        (verb == QLatin1String("down")) ||
+        (verb == QLatin1String("thread"));
+}
+
+static QString sourceFile(const QVariantMap &frame)
+{
+    const QString fullName = frame.value(QStringLiteral("fullname")).toString();
+    return fullName.isEmpty() ? frame.value(QStringLiteral("file")).toString() : fullName;
+}
+
+// -1 for pretty printed containers, they only tell whether there are children
+static int childCount(const QVariantMap &varobj)
+{
+    if (varobj.value(QStringLiteral("has_more")).toString() == QLatin1String("1")) {
+        return -1;
+    }
+    if (varobj.contains(QStringLiteral("new_num_children"))) {
+        return varobj.value(QStringLiteral("new_num_children")).toInt();
+    }
+    return varobj.value(QStringLiteral("numchild")).toInt();
+}
+
+// mimics the frame lines of "info stack"
+static QString frameDescription(const QVariantMap &frame)
+{
+    QString info = frame.value(QStringLiteral("func")).toString() + QStringLiteral(" ()");
+
+    const QString addr = frame.value(QStringLiteral("addr")).toString();
+    if (!addr.isEmpty()) {
+        info = addr + QStringLiteral(" in ") + info;
+    }
+
+    if (frame.contains(QStringLiteral("file"))) {
+        info += QStringLiteral(" at %1:%2")
+        .arg(frame.value(QStringLiteral("file")).toString())
+        .arg(frame.value(QStringLiteral("line")).toString());
+    }
+    else if (frame.contains(QStringLiteral("from"))) {
+        info += QStringLiteral(" from ") + frame.value(QStringLiteral("from")).toString();
+    }
+    return info;
+}
+
+void DebugView::processLine(const QByteArray &line)
 {
     if (line.isEmpty()) return;
 
-    switch(m_state)
+    const GdbMi::Record record = GdbMi::parseRecord(line);
+    switch(record.type)
     {
-        case none:
-        case ready:
-            if(PromptStr == line)
+        case GdbMi::Record::Prompt:
+            if (m_state == ready)
             {
                 // we get here after initialization
                 QTimer::singleShot(0, this, SLOT(issueNextCommand()));
             }
             break;
 
-        case executingCmd:
-            if(breakpointList.exactMatch(line))
-            {
-                m_state = listingBreakpoints;
-                emit clearBreakpointMarks();
-                m_breakPointList.clear();
-            }
-            else if (line.contains(QStringLiteral("No breakpoints or watchpoints.")))
-            {
-                emit clearBreakpointMarks();
-                m_breakPointList.clear();
-            }
-            else if (stackFrameAny.exactMatch(line))
+        case GdbMi::Record::Result:
+        {
+            PendingCommand command;
+            command.token = -1;
+            for (int i = 0; i < m_pending.size(); i++)
             {
-                if (m_lastCommand.contains(QStringLiteral("info stack")))
-                {
-                    emit stackFrameInfo(stackFrameAny.cap(1), stackFrameAny.cap(2));
-                }
-                else
+                if (m_pending[i].token == record.token)
                 {
-                    m_subState = (m_subState == normal) ? stackFrameSeen : stackTraceSeen;
-
-                    m_newFrameLevel = stackFrameAny.cap(1).toInt();
-
-                    if (stackFrameFile.exactMatch(line))
-                    {
-                        m_newFrameFile = stackFrameFile.cap(4);
-                    }
-                }
-            }
-            else if(changeFile.exactMatch(line))
-            {
-                m_currentFile = changeFile.cap(1).trimmed();
-                int lineNum = changeFile.cap(2).toInt();
-
-                if (!m_nextCommands.contains(QStringLiteral("continue"))) {
-                    // GDB uses 1 based line numbers, kate uses 0 based...
-                    emit debugLocationChanged(resolveFileName(m_currentFile), lineNum - 1);
+                    command = m_pending.takeAt(i);
+                    break;
                 }
-                m_debugLocationChanged = true;
             }
-            else if(changeLine.exactMatch(line))
-            {
-                int lineNum = changeLine.cap(1).toInt();
+            processResult(command, record.klass, record.results);
+            break;
+        }
 
-                if(m_subState == stackFrameSeen)
-                {
-                    m_currentFile = m_newFrameFile;
-                }
-                if (!m_nextCommands.contains(QStringLiteral("continue"))) {
-                    // GDB uses 1 based line numbers, kate uses 0 based...
-                    emit debugLocationChanged(resolveFileName(m_currentFile), lineNum - 1);
-                }
-                m_debugLocationChanged = true;
-            }
-            else if (breakPointReg.exactMatch(line))
-            {
-                BreakPoint breakPoint;
-                breakPoint.number = breakPointReg.cap(1).toInt();
-                breakPoint.file = resolveFileName(breakPointReg.cap(2));
-                breakPoint.line = breakPointReg.cap(3).toInt();
-                m_breakPointList << breakPoint;
-                emit breakPointSet(breakPoint.file, breakPoint.line -1);
-            }
-            else if (breakPointMultiReg.exactMatch(line))
-            {
-                BreakPoint breakPoint;
-                breakPoint.number = breakPointMultiReg.cap(1).toInt();
-                breakPoint.file = resolveFileName(breakPointMultiReg.cap(2));
-                breakPoint.line = breakPointMultiReg.cap(3).toInt();
-                m_breakPointList << breakPoint;
-                emit breakPointSet(breakPoint.file, breakPoint.line -1);
-            }
-            else if (breakPointDel.exactMatch(line))
-            {
-                line.remove(QStringLiteral("Deleted breakpoint"));
-                line.remove(QLatin1Char('s')); // in case of multiple breakpoints
-                QStringList numbers = line.split(QLatin1Char(' '), QString::SkipEmptyParts);
-                for (int i=0; i<numbers.size(); i++) 
-                {
-                    for (int j = 0; j<m_breakPointList.size(); j++) 
-                    {
-                        if (numbers[i].toInt() == m_breakPointList[j].number)
-                        {
-                            emit breakPointCleared(m_breakPointList[j].file, m_breakPointList[j].line -1);
-                            m_breakPointList.removeAt(j);
-                            break;
-                        }
-                    }
-                }
-            }
-            else if (exitProgram.exactMatch(line) ||
-                line.contains(QStringLiteral("The program no longer exists")) ||
-                line.contains(QStringLiteral("Kill the program being debugged")))
+        case GdbMi::Record::Exec:
+            if (record.klass == QLatin1String("running"))
             {
-                // if there are still commands to execute remove them to remove unneeded output
-                // except  if the "kill was for "re-run"
-                if ((m_nextCommands.size() > 0) && !m_nextCommands[0].contains(QStringLiteral("file")))
-                {
-                    m_nextCommands.clear();
-                }
-                m_debugLocationChanged = false; // do not insert (Q) commands
-                emit programEnded();
+                m_running = true;
             }
-            else if(PromptStr == line)
+            else if (record.klass == QLatin1String("stopped"))
             {
-                if(m_subState == stackFrameSeen)
-                {
-                    emit stackFrameChanged(m_newFrameLevel);
-                }
-                m_state = ready;
-
-                // Give the error a possibility get noticed since stderr and stdout are not in sync
-                QTimer::singleShot(0, this, SLOT(issueNextCommand()));
+                processStopped(record.results);
             }
             break;
 
-        case listingBreakpoints:
-            if (breakpointListed.exactMatch(line))
+        case GdbMi::Record::Notify:
+            if (record.klass == QLatin1String("breakpoint-created"))
             {
-                BreakPoint breakPoint;
-                breakPoint.number = breakpointListed.cap(1).toInt();
-                breakPoint.file = resolveFileName(breakpointListed.cap(2));
-                breakPoint.line = breakpointListed.cap(3).toInt();
-                m_breakPointList << breakPoint;
-                emit breakPointSet(breakPoint.file, breakPoint.line -1);
+                addBreakpoint(record.results.value(QStringLiteral("bkpt")).toMap());
             }
-            else if(PromptStr == line)
+            else if (record.klass == QLatin1String("breakpoint-deleted"))
             {
-                m_state = ready;
-                QTimer::singleShot(0, this, SLOT(issueNextCommand()));
+                removeBreakpoint(record.results.value(QStringLiteral("id")).toInt());
             }
-            break;
-        case infoArgs:
-            if(PromptStr == line)
+            else if (record.klass == QLatin1String("thread-selected"))
             {
-                m_state = ready;
-                QTimer::singleShot(0, this, SLOT(issueNextCommand()));
-            }
-            else {
-                emit infoLocal(line);
+                m_debugLocationChanged = true;
             }
             break;
-        case printThis:
-            if(PromptStr == line)
-            {
-                m_state = ready;
-                QTimer::singleShot(0, this, SLOT(issueNextCommand()));
-            }
-            else {
-                emit infoLocal(line);
-            }
+
+        case GdbMi::Record::Console:
+        case GdbMi::Record::Target:
+            outputTextMaybe(record.text);
             break;
-        case infoLocals:
-            if(PromptStr == line)
+
+        case GdbMi::Record::Log:
+            m_lastLog = record.text;
+            if (m_pending.isEmpty() || !m_pending.first().cmd.startsWith(QStringLiteral("(Q)")))
             {
-                m_state = ready;
-                emit infoLocal(QString());
-                QTimer::singleShot(0, this, SLOT(issueNextCommand()));
-            }
-            else {
-                emit infoLocal(line);
+                emit outputError(record.text);
             }
             break;
-        case infoStack:
-            if(PromptStr == line)
-            {
-                m_state = ready;
-                emit stackFrameInfo(QString(), QString());
-                QTimer::singleShot(0, this, SLOT(issueNextCommand()));
-            }
-            else if (stackFrameAny.exactMatch(line))
-            {
-                emit stackFrameInfo(stackFrameAny.cap(1), stackFrameAny.cap(2));
-            }
+
+        case GdbMi::Record::Invalid:
+            // not from gdb, e.g. the inferior writing to the terminal
+            emit outputText(record.text + QLatin1Char('\n'));
             break;
-        case infoThreads:
-            if(PromptStr == line)
-            {
-                m_state = ready;
-                QTimer::singleShot(0, this, SLOT(issueNextCommand()));
-            }
-            else if (threadLine.exactMatch(line))
-            {
-                emit threadInfo(threadLine.cap(1).toInt(), (line[0] == QLatin1Char('*')));
-            }
+
+        case GdbMi::Record::Status:
             break;
     }
-    outputTextMaybe(line);
 }
 
-void DebugView::processErrors()
+void DebugView::processResult(const PendingCommand &command, const QString &klass, const QVariantMap &results)
 {
-    QString error;
-    while (m_errorList.size() > 0) {
-        error = m_errorList.takeFirst();
-        //qDebug() << error;
-        if(error == QLatin1String("The program is not being run."))
+    const QString cmd = command.cmd.startsWith(QStringLiteral("(Q)")) ? command.cmd.mid(3) : command.cmd;
+
+    if (klass == QLatin1String("error"))
+    {
+        processError(command.cmd, results.value(QStringLiteral("msg")).toString());
+    }
+    else if (klass == QLatin1String("running"))
+    {
+        m_running = true;
+    }
+    else if (results.contains(QStringLiteral("bkpt")))
+    {
+        addBreakpoint(results.value(QStringLiteral("bkpt")).toMap());
+    }
+    else if (cmd == QLatin1String("-break-list"))
+    {
+        emit clearBreakpointMarks();
+        m_breakPointList.clear();
+        const QVariantList body = results.value(QStringLiteral("BreakpointTable")).toMap().value(QStringLiteral("body")).toList();
+        foreach (const QVariant &bkpt, body) {
+            addBreakpoint(bkpt.toMap());
+        }
+    }
+    else if (cmd.startsWith(QStringLiteral("-break-delete ")))
+    {
+        removeBreakpoint(cmd.section(QLatin1Char(' '), 1, 1).toInt());
+    }
+    else if (cmd == QLatin1String("-stack-list-frames"))
+    {
+        foreach (const QVariant &frame, results.value(QStringLiteral("stack")).toList()) {
+            const QVariantMap map = frame.toMap();
+            emit stackFrameInfo(map.value(QStringLiteral("level")).toString(), frameDescription(map));
+        }
+        emit stackFrameInfo(QString(), QString());
+    }
+    else if (cmd == QLatin1String("-stack-info-frame"))
+    {
+        const QVariantMap frame = results.value(QStringLiteral("frame")).toMap();
+        m_currentFrame = QStringLiteral("%1:%2:%3")
+        .arg(frame.value(QStringLiteral("level")).toString())
+        .arg(frame.value(QStringLiteral("func")).toString())
+        .arg(sourceFile(frame));
+        if (frame.contains(QStringLiteral("line"))) {
+            // GDB uses 1 based line numbers, kate uses 0 based...
+            emit debugLocationChanged(resolveFileName(sourceFile(frame)), frame.value(QStringLiteral("line")).toInt() - 1);
+        }
+        emit stackFrameChanged(frame.value(QStringLiteral("level")).toInt());
+    }
+    else if (cmd.startsWith(QStringLiteral("-stack-list-variables")))
+    {
+        updateLocals(results.value(QStringLiteral("variables")).toList());
+    }
+    else if (cmd.startsWith(QStringLiteral("-var-create ")))
+    {
+        const QString varobj = results.value(QStringLiteral("name")).toString();
+        const QString expression = cmd.section(QLatin1Char(' '), 3);
+        m_locals.insert(expression, varobj);
+        emit variableCreated(QString(), varobj, expression,
+                             results.value(QStringLiteral("type")).toString(),
+                             results.value(QStringLiteral("value")).toString(),
+                             childCount(results));
+    }
+    else if (cmd.startsWith(QStringLiteral("-var-list-children ")))
+    {
+        const QString parent = cmd.section(QLatin1Char(' '), 2, 2);
+        const int from = cmd.section(QLatin1Char(' '), 3, 3).toInt();
+        const QVariantList children = results.value(QStringLiteral("children")).toList();
+        foreach (const QVariant &child, children) {
+            const QVariantMap map = child.toMap();
+            emit variableCreated(parent,
+                                 map.value(QStringLiteral("name")).toString(),
+                                 map.value(QStringLiteral("exp")).toString(),
+                                 map.value(QStringLiteral("type")).toString(),
+                                 map.value(QStringLiteral("value")).toString(),
+                                 childCount(map));
+        }
+        emit variableChildrenListed(parent, from + children.size(),
+                                    results.value(QStringLiteral("has_more")).toString() == QLatin1String("1"));
+    }
+    else if (cmd.startsWith(QStringLiteral("-var-update ")))
+    {
+        processVarUpdate(results.value(QStringLiteral("changelist")).toList());
+    }
+    else if (cmd == QLatin1String("-thread-info"))
+    {
+        emit threadInfo(-1 , false);
+        const QString current = results.value(QStringLiteral("current-thread-id")).toString();
+        foreach (const QVariant &thread, results.value(QStringLiteral("threads")).toList()) {
+            const QString id = thread.toMap().value(QStringLiteral("id")).toString();
+            emit threadInfo(id.toInt(), id == current);
+        }
+    }
+    else if (cmd == QLatin1String("kill"))
+    {
+        programExited();
+    }
+    else if (changesFrame(cmd))
+    {
+        m_debugLocationChanged = true;
+    }
+
+    QTimer::singleShot(0, this, SLOT(issueNextCommand()));
+}
+
+void DebugView::processStopped(const QVariantMap &results)
+{
+    m_running = false;
+
+    if (results.value(QStringLiteral("reason")).toString().startsWith(QStringLiteral("exited")))
+    {
+        programExited();
+    }
+    else
+    {
+        m_debugLocationChanged = true;
+    }
+
+    QTimer::singleShot(0, this, SLOT(issueNextCommand()));
+}
+
+void DebugView::programExited()
+{
+    // if there are still commands to execute remove them to remove unneeded output
+    // except  if the "kill was for "re-run"
+    if ((m_nextCommands.size() > 0) && !m_nextCommands[0].contains(QStringLiteral("file")))
+    {
+        m_nextCommands.clear();
+    }
+    m_debugLocationChanged = false; // do not insert (Q) commands
+    // the variable objects of the old process are of no use
+    m_locals.clear();
+    m_localsFrame.clear();
+    emit programEnded();
+}
+
+void DebugView::processError(const QString &cmd, const QString &error)
+{
+    if(error == QLatin1String("The program is not being run."))
+    {
+        if (cmd == QLatin1String("continue"))
         {
-            if (m_lastCommand == QLatin1String("continue"))
-            {
-                m_nextCommands.clear();
-                m_nextCommands << QStringLiteral("tbreak main");
-                m_nextCommands << QStringLiteral("run");
-                m_nextCommands << QStringLiteral("p setvbuf(stdout, 0, %1, 1024)").arg(_IOLBF);
-                m_nextCommands << QStringLiteral("continue");
-                QTimer::singleShot(0, this, SLOT(issueNextCommand()));
-            }
-            else if ((m_lastCommand == QLatin1String("step")) ||
-                (m_lastCommand == QLatin1String("next")) ||
-                (m_lastCommand == QLatin1String("finish")))
-            {
-                m_nextCommands.clear();
-                m_nextCommands << QStringLiteral("tbreak main");
-                m_nextCommands << QStringLiteral("run");
-                m_nextCommands << QStringLiteral("p setvbuf(stdout, 0, %1, 1024)").arg(_IOLBF);
-                QTimer::singleShot(0, this, SLOT(issueNextCommand()));
-            }
-            else if ((m_lastCommand == QLatin1String("kill")))
+            m_nextCommands.clear();
+            m_nextCommands << QStringLiteral("tbreak main");
+            m_nextCommands << QStringLiteral("run");
+            m_nextCommands << QStringLiteral("p setvbuf(stdout, 0, %1, 1024)").arg(_IOLBF);
+            m_nextCommands << QStringLiteral("continue");
+        }
+        else if ((cmd == QLatin1String("step")) ||
+            (cmd == QLatin1String("next")) ||
+            (cmd == QLatin1String("finish")))
+        {
+            m_nextCommands.clear();
+            m_nextCommands << QStringLiteral("tbreak main");
+            m_nextCommands << QStringLiteral("run");
+            m_nextCommands << QStringLiteral("p setvbuf(stdout, 0, %1, 1024)").arg(_IOLBF);
+        }
+        else if ((cmd == QLatin1String("kill")))
+        {
+            if (m_nextCommands.size() > 0)
             {
-                if (m_nextCommands.size() > 0)
-                {
-                    if (!m_nextCommands[0].contains(QStringLiteral("file")))
-                    {
-                        m_nextCommands.clear();
-                        m_nextCommands << QStringLiteral("quit");
-                    }
-                    // else continue with "ReRun"
-                }
-                else 
+                if (!m_nextCommands[0].contains(QStringLiteral("file")))
                 {
-                    m_nextCommands << QStringLiteral("quit");
+                    m_nextCommands.clear();
+                    m_nextCommands << QStringLiteral("-gdb-exit");
                 }
-                m_state = ready;
-                QTimer::singleShot(0, this, SLOT(issueNextCommand()));
+                // else continue with "ReRun"
+            }
+            else
+            {
+                m_nextCommands << QStringLiteral("-gdb-exit");
             }
-            // else do nothing
         }
-        else if (error.contains(QStringLiteral("No line ")) ||
-            error.contains(QStringLiteral("No source file named")))
-        {
-            // setting a breakpoint failed. Do not continue.
-            m_nextCommands.clear();
-            emit readyForInput(true);
+        // else do nothing
+    }
+    else if (error.contains(QStringLiteral("No line ")) ||
+        error.contains(QStringLiteral("No source file named")))
+    {
+        // setting a breakpoint failed. Do not continue.
+        m_nextCommands.clear();
+    }
+    else if (error.contains(QStringLiteral("No stack")))
+    {
+        m_nextCommands.clear();
+        m_locals.clear();
+        m_localsFrame.clear();
+        emit programEnded();
+    }
+
+    // the internal queries fail whenever there is no frame, that is not news
+    if (cmd.startsWith(QStringLiteral("(Q)-"))) {
+        return;
+    }
+    // errors of CLI commands are also written to the log stream
+    if (m_lastLog == error + QLatin1Char('\n')) {
+        return;
+    }
+    emit outputError(error + QLatin1Char('\n'));
+}
+
+void DebugView::addBreakpoint(const QVariantMap &bkpt)
+{
+    // temporary breakpoints are not marked
+    if (bkpt.value(QStringLiteral("disp")).toString() == QLatin1String("del")) {
+        return;
+    }
+
+    QVariantMap location = bkpt;
+    if (!location.contains(QStringLiteral("line"))) {
+        // newer gdb lists the locations of a multiple location breakpoint inline
+        const QVariantList locations = bkpt.value(QStringLiteral("locations")).toList();
+        if (locations.isEmpty()) {
+            return;
         }
-        else if (error.contains(QStringLiteral("No stack")))
-        {
-            m_nextCommands.clear();
-            emit programEnded();
+        location = locations.first().toMap();
+    }
+
+    BreakPoint breakPoint;
+    breakPoint.number = bkpt.value(QStringLiteral("number")).toInt();
+    for (int i = 0; i < m_breakPointList.size(); i++) {
+        if (m_breakPointList[i].number == breakPoint.number) {
+            return;
         }
+    }
+    breakPoint.file = resolveFileName(sourceFile(location));
+    breakPoint.line = location.value(QStringLiteral("line")).toInt();
+    m_breakPointList << breakPoint;
+    emit breakPointSet(breakPoint.file, breakPoint.line -1);
+}
 
-        if ((m_lastCommand == QLatin1String("(Q)print *this")) && error.contains(QStringLiteral("No symbol \"this\" in current context."))) {
-            continue;
+void DebugView::removeBreakpoint(int number)
+{
+    for (int j = 0; j<m_breakPointList.size(); j++)
+    {
+        if (number == m_breakPointList[j].number)
+        {
+            emit breakPointCleared(m_breakPointList[j].file, m_breakPointList[j].line -1);
+            m_breakPointList.removeAt(j);
+            break;
         }
-        emit outputError(error + QLatin1Char('\n'));
     }
- }
+}
 
 void DebugView::issueCommand(QString const& cmd)
 {
     if(m_state == ready)
     {
+        // anything already queued belongs to this command, e.g. "jump" after "tbreak"
+        m_nextCommands.prepend(cmd);
+        issueNextCommand();
+    }
+}
+
+void DebugView::sendCommand(const QString &cmd)
+{
+    if (m_state == ready) {
         emit readyForInput(false);
-        m_state = executingCmd;
-        if (cmd == QLatin1String("(Q)info locals")) {
-            m_state = infoLocals;
+    }
+    m_state = executingCmd;
+    m_lastLog.clear();
+
+    PendingCommand command;
+    command.token = ++m_token;
+    command.cmd = cmd;
+    m_pending << command;
+
+    QString miCmd;
+    if (cmd.startsWith(QStringLiteral("(Q)")))
+    {
+        miCmd = toMiCommand(cmd.mid(3));
+    }
+    else {
+        emit outputText(QStringLiteral("(gdb) ") + cmd + QLatin1Char('\n'));
+        miCmd = toMiCommand(cmd);
+    }
+    m_debugProcess.write(QByteArray::number(command.token) + miCmd.toLocal8Bit() + '\n');
+}
+
+bool DebugView::pendingQueriesOnly() const
+{
+    foreach (const PendingCommand &command, m_pending) {
+        if (!command.cmd.startsWith(QStringLiteral("(Q)-"))) {
+            return false;
         }
-        else if (cmd == QLatin1String("(Q)info args")) {
-            m_state = infoArgs;
+    }
+    return true;
+}
+
+void DebugView::queueFrameQueries()
+{
+    if (m_queryLocals) {
+        m_nextCommands << QStringLiteral("(Q)-stack-list-frames");
+    }
+    m_nextCommands << QStringLiteral("(Q)-stack-info-frame");
+    if (m_queryLocals) {
+        // the values are fetched through variable objects
+        m_nextCommands << QStringLiteral("(Q)-stack-list-variables --no-values");
+        m_nextCommands << QStringLiteral("(Q)-thread-info");
+    }
+}
+
+void DebugView::updateLocals(const QVariantList &variables)
+{
+    QStringList names;
+    QSet<QString> seen;
+    foreach (const QVariant &variable, variables) {
+        const QString name = variable.toMap().value(QStringLiteral("name")).toString();
+        if (!seen.contains(name)) {
+            seen.insert(name);
+            names << name;
         }
-        else if (cmd == QLatin1String("(Q)print *this")) {
-            m_state = printThis;
+    }
+
+    // variable objects are bound to the frame they were created in
+    if (m_localsFrame != m_currentFrame) {
+        deleteLocals();
+        m_localsFrame = m_currentFrame;
+    }
+    else if (!m_locals.isEmpty()) {
+        // only what changed since the last stop is reported back
+        m_nextCommands << QStringLiteral("(Q)-var-update --all-values *");
+    }
+
+    // locals of a block that was left
+    QHash<QString, QString>::iterator it = m_locals.begin();
+    while (it != m_locals.end()) {
+        if (seen.contains(it.key())) {
+            ++it;
+            continue;
         }
-        else if (cmd == QLatin1String("(Q)info stack")) {
-            m_state = infoStack;
+        m_nextCommands << QStringLiteral("(Q)-var-delete ") + it.value();
+        emit variableDeleted(it.value());
+        it = m_locals.erase(it);
+    }
+
+    foreach (const QString &name, names) {
+        if (!m_locals.contains(name)) {
+            m_nextCommands << QStringLiteral("(Q)-var-create - * ") + name;
         }
-        else if (cmd == QLatin1String("(Q)info thread")) {
-            emit threadInfo(-1 , false);
-            m_state = infoThreads;
+    }
+}
+
+void DebugView::processVarUpdate(const QVariantList &changes)
+{
+    foreach (const QVariant &change, changes) {
+        const QVariantMap map = change.toMap();
+        const QString varobj = map.value(QStringLiteral("name")).toString();
+
+        // a local out of scope is recreated by updateLocals() once it is listed again
+        const QString inScope = map.value(QStringLiteral("in_scope")).toString();
+        if (inScope == QLatin1String("invalid") || inScope == QLatin1String("false")) {
+            m_nextCommands << QStringLiteral("(Q)-var-delete ") + varobj;
+            const QString expression = m_locals.key(varobj);
+            if (!expression.isEmpty()) {
+                m_locals.remove(expression);
+            }
+            emit variableDeleted(varobj);
+            continue;
         }
-        m_subState = normal;
-        m_lastCommand = cmd;
 
-        if (cmd.startsWith(QStringLiteral("(Q)")))
+        if ((map.value(QStringLiteral("type_changed")).toString() == QLatin1String("true")) ||
+            map.contains(QStringLiteral("new_num_children")) ||
+            map.contains(QStringLiteral("new_children")))
         {
-            m_debugProcess.write(qPrintable(cmd.mid(3)));
+            emit variableChildrenChanged(varobj, childCount(map));
         }
-        else {
-            emit outputText(QStringLiteral("(gdb) ") + cmd + QLatin1Char('\n'));
-            m_debugProcess.write(qPrintable(cmd));
+        if (map.contains(QStringLiteral("value"))) {
+            emit variableChanged(varobj, map.value(QStringLiteral("value")).toString());
         }
-        m_debugProcess.write("\n");
     }
 }
 
+void DebugView::deleteLocals()
+{
+    foreach (const QString &varobj, m_locals) {
+        m_nextCommands << QStringLiteral("(Q)-var-delete ") + varobj;
+        emit variableDeleted(varobj);
+    }
+    m_locals.clear();
+}
+
 void DebugView::issueNextCommand()
 {
-    if(m_state == ready)
+    if (m_state == none) {
+        return;
+    }
+
+    // The internal queries are written in one go and their results are
+    // matched by token. Anything else waits for the previous commands and
+    // for the inferior to stop.
+    while (!m_running && (m_nextCommands.size() > 0))
     {
-        if(m_nextCommands.size() > 0)
-        {
-            QString cmd = m_nextCommands.takeFirst();
-            //qDebug() << "Next command" << cmd;
-            issueCommand(cmd);
-        }
-        else 
-        {
-            // FIXME "thread" needs a better generic solution 
-            if (m_debugLocationChanged || m_lastCommand.startsWith(QStringLiteral("thread"))) {
-                m_debugLocationChanged = false;
-                if (m_queryLocals && !m_lastCommand.startsWith(QStringLiteral("(Q)"))) {
-                    m_nextCommands << QStringLiteral("(Q)info stack");
-                    m_nextCommands << QStringLiteral("(Q)frame");
-                    m_nextCommands << QStringLiteral("(Q)info args");
-                    m_nextCommands << QStringLiteral("(Q)print *this");
-                    m_nextCommands << QStringLiteral("(Q)info locals");
-                    m_nextCommands << QStringLiteral("(Q)info thread");
-                    issueNextCommand();
-                    return;
-                }
-            }
-            emit readyForInput(true);
+        const bool query = m_nextCommands[0].startsWith(QStringLiteral("(Q)-"));
+        if ((m_pending.size() > 0) && !(query && pendingQueriesOnly())) {
+            return;
         }
+        QString cmd = m_nextCommands.takeFirst();
+        //qDebug() << "Next command" << cmd;
+        sendCommand(cmd);
     }
+
+    if (m_running || (m_pending.size() > 0)) {
+        return;
+    }
+
+    if (m_debugLocationChanged) {
+        m_debugLocationChanged = false;
+        queueFrameQueries();
+        issueNextCommand();
+        return;
+    }
+
+    m_state = ready;
+    emit readyForInput(true);
 }
 
 QUrl DebugView::resolveFileName(const QString &fileName)
@@ -673,9 +908,10 @@ QUrl DebugView::resolveFileName(const QString &fileName)
 
 void DebugView::outputTextMaybe(const QString &text)
 {
-    if (!m_lastCommand.startsWith(QStringLiteral("(Q)"))  && !text.contains(PromptStr))
+    // stream records do not carry a token, they belong to the oldest pending command
+    if (m_pending.isEmpty() || !m_pending.first().cmd.startsWith(QStringLiteral("(Q)")))
     {
-        emit outputText(text + QLatin1Char('\n'));
+        emit outputText(text);
     }
 }
 
@@ -685,12 +921,22 @@ void DebugView::slotQueryLocals(bool query)
     m_queryLocals = query;
     if (query && (m_state == ready) && (m_nextCommands.size() == 0))
     {
-        m_nextCommands << QStringLiteral("(Q)info stack");
-        m_nextCommands << QStringLiteral("(Q)frame");
-        m_nextCommands << QStringLiteral("(Q)info args");
-        m_nextCommands << QStringLiteral("(Q)print *this");
-        m_nextCommands << QStringLiteral("(Q)info locals");
-        m_nextCommands << QStringLiteral("(Q)info thread");
+        queueFrameQueries();
+        issueNextCommand();
+    }
+}
+
+void DebugView::slotListChildren(const QString &varobj, int from)
+{
+    if (m_state == none) {
+        return;
+    }
+
+    m_nextCommands << QStringLiteral("(Q)-var-list-children --all-values %1 %2 %3")
+    .arg(varobj)
+    .arg(from)
+    .arg(from + CHILDREN_PAGE);
+    if (m_state == ready) {
         issueNextCommand();
     }
 }
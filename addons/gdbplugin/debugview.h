@@ -26,8 +26,11 @@
 
 #include <QObject>
 
+#include <QByteArray>
+#include <QHash>
 #include <QProcess>
 #include <QUrl>
+#include <QVariant>
 
 #include "configview.h"
 
@@ -60,6 +63,7 @@ public Q_SLOTS:
     void slotReRun();
 
     void slotQueryLocals(bool display);
+    void slotListChildren(const QString &varobj, int from);
 
 private Q_SLOTS:
     void slotError();
@@ -77,7 +81,20 @@ Q_SIGNALS:
     void stackFrameChanged(int level);
     void threadInfo(int number, bool avtive);
 
-    void infoLocal(QString const& line);
+    /**
+     * A gdb variable object was created, @p parent is empty for locals.
+     * @p numChildren is -1 for pretty printed containers, which only tell
+     * whether they have children at all.
+     */
+    void variableCreated(const QString &parent, const QString &varobj, const QString &name,
+                         const QString &type, const QString &value, int numChildren);
+    void variableChanged(const QString &varobj, const QString &value);
+    void variableChildrenChanged(const QString &varobj, int numChildren);
+    /**
+     * The children of @p varobj up to @p next were listed.
+     */
+    void variableChildrenListed(const QString &varobj, int next, bool hasMore);
+    void variableDeleted(const QString &varobj);
 
     void outputText(const QString &text);
     void outputError(const QString &text);
@@ -90,20 +107,7 @@ private:
     {
         none,
         ready,
-        executingCmd,
-        listingBreakpoints,
-        infoStack,
-        infoArgs,
-        printThis,
-        infoLocals,
-        infoThreads
-    };
-
-    enum SubState
-    {
-        normal,
-        stackFrameSeen,
-        stackTraceSeen
+        executingCmd
     };
 
     struct BreakPoint
@@ -113,9 +117,26 @@ private:
         int  line;
     };
 
+    struct PendingCommand
+    {
+        int     token;
+        QString cmd;
+    };
+
 private:
-    void processLine(QString output);
-    void processErrors();
+    void processLine(const QByteArray &line);
+    void processResult(const PendingCommand &command, const QString &klass, const QVariantMap &results);
+    void processStopped(const QVariantMap &results);
+    void processError(const QString &cmd, const QString &error);
+    void programExited();
+    void sendCommand(const QString &cmd);
+    void queueFrameQueries();
+    void updateLocals(const QVariantList &variables);
+    void processVarUpdate(const QVariantList &changes);
+    void deleteLocals();
+    bool pendingQueriesOnly() const;
+    void addBreakpoint(const QVariantMap &bkpt);
+    void removeBreakpoint(int number);
     void outputTextMaybe(const QString &text);
     QUrl resolveFileName(const QString &fileName);
 
@@ -125,19 +146,20 @@ private:
     QString             m_ioPipeString;
 
     State               m_state;
-    SubState            m_subState;
 
-    QString             m_currentFile;
-    QString             m_newFrameFile;
-    int                 m_newFrameLevel;
     QStringList         m_nextCommands;
-    QString             m_lastCommand;
+    QList<PendingCommand> m_pending;
+    int                 m_token;
+    bool                m_running;
+    QString             m_lastLog;
     bool                m_debugLocationChanged;
     QList<BreakPoint>   m_breakPointList;
-    QString             m_outBuffer;
+    QByteArray          m_outBuffer;
     QString             m_errBuffer;
-    QStringList         m_errorList;
     bool                m_queryLocals;
+    QString             m_currentFrame;
+    QString             m_localsFrame;
+    QHash<QString, QString> m_locals; // expression -> variable object
 };
 
 #endif
@@ -0,0 +1,251 @@
+//
+// gdbmi.cpp
+//
+// Description: Parser for the GDB/MI machine interface output
+//
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Library General Public
+//  License version 2 as published by the Free Software Foundation.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Library General Public License for more details.
+//
+//  You should have received a copy of the GNU Library General Public License
+//  along with this library; see the file COPYING.LIB.  If not, write to
+//  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+//  Boston, MA 02110-1301, USA.
+
+#include "gdbmi.h"
+
+namespace
+{
+// A recursive descent parser over the raw bytes of one output line.
+// Only c-string contents are decoded, everything else is plain ASCII.
+class Parser
+{
+public:
+    Parser(const QByteArray &line) : m_line(line), m_pos(0) {}
+
+    bool atEnd() const { return m_pos >= m_line.size(); }
+    char peek() const { return atEnd() ? '\0' : m_line.at(m_pos); }
+
+    bool consume(char c)
+    {
+        if (peek() != c) {
+            return false;
+        }
+        m_pos++;
+        return true;
+    }
+
+    int parseToken()
+    {
+        int token = -1;
+        while (!atEnd() && m_line.at(m_pos) >= '0' && m_line.at(m_pos) <= '9') {
+            token = qMax(token, 0) * 10 + (m_line.at(m_pos) - '0');
+            m_pos++;
+        }
+        return token;
+    }
+
+    // a class or a variable name, ends at ',' '=' or the end of the line
+    QString parseWord()
+    {
+        const int start = m_pos;
+        while (!atEnd() && m_line.at(m_pos) != ',' && m_line.at(m_pos) != '=') {
+            m_pos++;
+        }
+        return QString::fromLatin1(m_line.constData() + start, m_pos - start);
+    }
+
+    QString parseCString()
+    {
+        if (!consume('"')) {
+            return QString();
+        }
+
+        QByteArray bytes;
+        bytes.reserve(m_line.size() - m_pos);
+        while (!atEnd()) {
+            char c = m_line.at(m_pos++);
+            if (c == '"') {
+                break;
+            }
+            if (c != '\\' || atEnd()) {
+                bytes += c;
+                continue;
+            }
+
+            c = m_line.at(m_pos++);
+            switch (c) {
+                case 'n': bytes += '\n'; break;
+                case 't': bytes += '\t'; break;
+                case 'r': bytes += '\r'; break;
+                case 'e': bytes += '\033'; break;
+                case 'a': bytes += '\a'; break;
+                case 'b': bytes += '\b'; break;
+                case 'f': bytes += '\f'; break;
+                case 'v': bytes += '\v'; break;
+                default:
+                    if (c >= '0' && c <= '7') {
+                        // up to three octal digits, used for non ASCII bytes
+                        int value = c - '0';
+                        for (int i = 0; i < 2 && peek() >= '0' && peek() <= '7'; i++) {
+                            value = value * 8 + (m_line.at(m_pos++) - '0');
+                        }
+                        bytes += char(value);
+                    }
+                    else {
+                        bytes += c;
+                    }
+            }
+        }
+        return QString::fromLocal8Bit(bytes);
+    }
+
+    QVariant parseValue()
+    {
+        switch (peek()) {
+            case '"':
+                return parseCString();
+            case '{': {
+                m_pos++;
+                const QVariantMap tuple = parseResults('}');
+                consume('}');
+                return tuple;
+            }
+            case '[': {
+                m_pos++;
+                const QVariantList list = parseList();
+                consume(']');
+                return list;
+            }
+        }
+        return QVariant();
+    }
+
+    // name=value pairs up to the end character or the end of the line
+    QVariantMap parseResults(char end)
+    {
+        QVariantMap results;
+        while (!atEnd() && peek() != end) {
+            if (peek() == '{' || peek() == '[' || peek() == '"') {
+                // gdb lists the locations of a multiple location breakpoint
+                // as nameless tuples after the "bkpt" result, skip them
+                parseValue();
+            }
+            else {
+                const QString name = parseWord();
+                if (!consume('=')) {
+                    break;
+                }
+                results.insert(name, parseValue());
+            }
+            if (!consume(',')) {
+                break;
+            }
+        }
+        return results;
+    }
+
+    QVariantList parseList()
+    {
+        QVariantList list;
+        while (!atEnd() && peek() != ']') {
+            if (peek() != '{' && peek() != '[' && peek() != '"') {
+                // a result list, only the values are of interest
+                parseWord();
+                if (!consume('=')) {
+                    break;
+                }
+            }
+            list << parseValue();
+            if (!consume(',')) {
+                break;
+            }
+        }
+        return list;
+    }
+
+private:
+    const QByteArray &m_line;
+    int               m_pos;
+};
+}
+
+GdbMi::Record GdbMi::parseRecord(const QByteArray &line)
+{
+    Record record;
+
+    QByteArray trimmed = line;
+    if (trimmed.endsWith('\r')) {
+        trimmed.chop(1);
+    }
+
+    if (trimmed.startsWith("(gdb)")) {
+        record.type = Record::Prompt;
+        return record;
+    }
+
+    Parser parser(trimmed);
+    record.token = parser.parseToken();
+
+    switch (parser.peek()) {
+        case '^': record.type = Record::Result; break;
+        case '*': record.type = Record::Exec; break;
+        case '+': record.type = Record::Status; break;
+        case '=': record.type = Record::Notify; break;
+        case '~': record.type = Record::Console; break;
+        case '@': record.type = Record::Target; break;
+        case '&': record.type = Record::Log; break;
+        default:
+            record.type = Record::Invalid;
+            record.token = -1;
+            record.text = QString::fromLocal8Bit(trimmed);
+            return record;
+    }
+    parser.consume(parser.peek());
+
+    if (record.type == Record::Console || record.type == Record::Target || record.type == Record::Log) {
+        if (parser.peek() != '"') {
+            record.type = Record::Invalid;
+            record.text = QString::fromLocal8Bit(trimmed);
+            return record;
+        }
+        record.text = parser.parseCString();
+        return record;
+    }
+
+    record.klass = parser.parseWord();
+    if (parser.consume(',')) {
+        record.results = parser.parseResults('\0');
+    }
+    return record;
+}
+
+QString GdbMi::quote(const QString &text)
+{
+    QString quoted;
+    quoted.reserve(text.size() + 2);
+    quoted += QLatin1Char('"');
+    for (int i = 0; i < text.size(); i++) {
+        const QChar c = text.at(i);
+        if (c == QLatin1Char('"') || c == QLatin1Char('\\')) {
+            quoted += QLatin1Char('\\');
+            quoted += c;
+        } else if (c == QLatin1Char('\n')) {
+            quoted += QLatin1String("\\n");
+        } else if (c == QLatin1Char('\r')) {
+            quoted += QLatin1String("\\r");
+        } else if (c == QLatin1Char('\t')) {
+            quoted += QLatin1String("\\t");
+        } else {
+            quoted += c;
+        }
+    }
+    quoted += QLatin1Char('"');
+    return quoted;
+}
@@ -0,0 +1,72 @@
+//
+// gdbmi.h
+//
+// Description: Parser for the GDB/MI machine interface output
+//
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Library General Public
+//  License version 2 as published by the Free Software Foundation.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Library General Public License for more details.
+//
+//  You should have received a copy of the GNU Library General Public License
+//  along with this library; see the file COPYING.LIB.  If not, write to
+//  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+//  Boston, MA 02110-1301, USA.
+
+#ifndef GDBMI_H
+#define GDBMI_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVariant>
+
+namespace GdbMi
+{
+    /**
+     * One line of GDB/MI output.
+     *
+     * Result values are stored as QString for c-strings, QVariantMap for
+     * tuples and QVariantList for lists. The names of the results inside a
+     * list are dropped, "stack=[frame={..},frame={..}]" becomes a list of maps.
+     */
+    struct Record
+    {
+        enum Type
+        {
+            Invalid,    ///< not MI output, the raw line is in text
+            Prompt,     ///< "(gdb)"
+            Result,     ///< ^done, ^running, ^error, ...
+            Exec,       ///< *stopped, *running
+            Status,     ///< +download, ...
+            Notify,     ///< =breakpoint-created, =thread-selected, ...
+            Console,    ///< ~"text"
+            Target,     ///< @"text"
+            Log         ///< &"text"
+        };
+
+        Record() : type(Invalid), token(-1) {}
+
+        Type        type;
+        int         token;   ///< -1 if the record has no token
+        QString     klass;   ///< done, stopped, breakpoint-created, ...
+        QVariantMap results;
+        QString     text;    ///< the text of stream records
+    };
+
+    /**
+     * Parse one line of output, without the trailing newline.
+     */
+    Record parseRecord(const QByteArray &line);
+
+    /**
+     * @return @p text as a MI c-string, usable as a command parameter
+     */
+    QString quote(const QString &text);
+}
+
+#endif
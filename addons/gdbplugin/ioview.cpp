@@ -25,14 +25,21 @@
 #include <QVBoxLayout>
 #include <QFile>
 #include <QDir>
-#include <QTextEdit>
+#include <QPlainTextEdit>
 #include <QLineEdit>
+#include <QLabel>
 #include <QScrollBar>
 #include <QSocketNotifier>
 #include <QString>
 #include <QFontDatabase>
+#include <QTextCharFormat>
+#include <QTextCodec>
+#include <QTextCursor>
+#include <QTextDecoder>
 
 #include <kcolorscheme.h>
+#include <kformat.h>
+#include <klocalizedstring.h>
 #include <krandom.h>
 
 #include <sys/types.h>
@@ -40,38 +47,71 @@
 #include <fcntl.h>
 #include <unistd.h>
 
+// size of a single read from the fifos
+static const int READ_CHUNK = 64 * 1024;
+// read at most this much per notification, so the event loop keeps running
+static const int READ_LIMIT = 1024 * 1024;
+// appends to the output are coalesced to at most one per interval (ms)
+static const int FLUSH_INTERVAL = 50;
+// output beyond this, that piled up between two flushes, is dropped
+static const int MAX_PENDING = 4 * 1024 * 1024;
+// the output only keeps the most recent lines
+static const int MAX_LINES = 10000;
+
 IOView::IOView(QWidget *parent)
-:   QWidget(parent)
+:   QWidget(parent),
+    m_stdoutNotifier(0),
+    m_stderrNotifier(0),
+    m_rateBytes(0),
+    m_droppedBytes(0),
+    m_droppedPending(0)
 {
-    m_output = new QTextEdit();
+    m_output = new QPlainTextEdit();
     m_output->setReadOnly(true);
     m_output->setUndoRedoEnabled(false);
-    m_output->setAcceptRichText(false);
+    m_output->setMaximumBlockCount(MAX_LINES);
     // fixed wide font, like konsole
     m_output->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
     // alternate color scheme, like konsole
     KColorScheme schemeView(QPalette::Active, KColorScheme::View);
-    m_output->setTextBackgroundColor(schemeView.foreground().color());
-    m_output->setTextColor(schemeView.background().color());
     QPalette p = m_output->palette ();
     p.setColor(QPalette::Base, schemeView.foreground().color());
+    p.setColor(QPalette::Text, schemeView.background().color());
     m_output->setPalette(p);
 
+    m_throughput = new QLabel();
+    m_throughput->hide();
+
     m_input = new QLineEdit();
     m_output->setFocusProxy(m_input); // take the focus from the output
 
     QVBoxLayout *layout = new QVBoxLayout(this);
     layout->addWidget(m_output, 10);
+    layout->addWidget(m_throughput, 0);
     layout->addWidget(m_input, 0);
     layout->setContentsMargins(0,0,0,0);
     layout->setSpacing(0);
 
+    // decoders keep multi byte characters split between two reads intact
+    m_stdoutDecoder = QTextCodec::codecForLocale()->makeDecoder();
+    m_stderrDecoder = QTextCodec::codecForLocale()->makeDecoder();
+
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(FLUSH_INTERVAL);
+    connect(&m_flushTimer, SIGNAL(timeout()), this, SLOT(flushOutput()));
+
+    m_rateTimer.setInterval(1000);
+    connect(&m_rateTimer, SIGNAL(timeout()), this, SLOT(updateThroughput()));
+
     connect(m_input, SIGNAL(returnPressed()), this, SLOT(returnPressed()));
     createFifos();
 }
 
 IOView::~IOView()
 {
+    delete m_stdoutDecoder;
+    delete m_stderrDecoder;
+
     m_stdin.close();
 
     m_stdout.close();
@@ -135,48 +175,94 @@ void IOView::returnPressed()
 void IOView::readOutput()
 {
     m_stdoutNotifier->setEnabled(false);
-    qint64 res;
-    char chData[256];
-    QByteArray data;
-
-    do {
-        res = m_stdout.read(chData, 255);
-        if (res <= 0) {
-            m_stdoutD.flush();
-        }
-        else {
-            data.append(chData, res);
-        }
-        
-    } while (res == 255);
-    
-    if (data.size() > 0) {
-        emit stdOutText(QString::fromLocal8Bit(data));
-    }
+    readFifo(m_stdout, m_stdoutD, m_stdoutPending);
     m_stdoutNotifier->setEnabled(true);
 }
 
 void IOView::readErrors()
 {
     m_stderrNotifier->setEnabled(false);
+    readFifo(m_stderr, m_stderrD, m_stderrPending);
+    m_stderrNotifier->setEnabled(true);
+}
+
+void IOView::readFifo(QFile &fifo, QFile &dummy, QByteArray &pending)
+{
     qint64 res;
-    char chData[256];
-    QByteArray data;
+    qint64 total = 0;
 
     do {
-        res = m_stderr.read(chData, 255);
+        const int oldSize = pending.size();
+        pending.resize(oldSize + READ_CHUNK);
+        res = fifo.read(pending.data() + oldSize, READ_CHUNK);
+        pending.resize(oldSize + qMax<qint64>(res, 0));
         if (res <= 0) {
-            m_stderrD.flush();
+            dummy.flush();
         }
         else {
-            data.append(chData, res);
+            total += res;
         }
-    } while (res == 255);
+    } while ((res > 0) && (total < READ_LIMIT));
 
-    if (data.size() > 0) {
-        emit stdErrText(QString::fromLocal8Bit(data));
+    if (total == 0) {
+        return;
+    }
+
+    // the debuggee is faster than we can show, keep the newest output
+    if (pending.size() > MAX_PENDING) {
+        int cut = pending.indexOf('\n', pending.size() - MAX_PENDING);
+        cut = (cut < 0) ? pending.size() - MAX_PENDING : cut + 1;
+        pending.remove(0, cut);
+        m_droppedPending += cut;
+    }
+
+    m_rateBytes += total;
+    if (!m_rateTimer.isActive()) {
+        m_rateElapsed.start();
+        m_rateTimer.start();
+    }
+    if (!m_flushTimer.isActive()) {
+        m_flushTimer.start();
     }
-    m_stderrNotifier->setEnabled(true);
+}
+
+void IOView::flushOutput()
+{
+    if (m_droppedPending > 0) {
+        emit stdErrText(i18n("[%1 of output dropped]\n", KFormat().formatByteSize(m_droppedPending)));
+        m_droppedBytes += m_droppedPending;
+        m_droppedPending = 0;
+    }
+    if (!m_stdoutPending.isEmpty()) {
+        emit stdOutText(m_stdoutDecoder->toUnicode(m_stdoutPending));
+        m_stdoutPending.clear();
+    }
+    if (!m_stderrPending.isEmpty()) {
+        emit stdErrText(m_stderrDecoder->toUnicode(m_stderrPending));
+        m_stderrPending.clear();
+    }
+}
+
+void IOView::updateThroughput()
+{
+    const qint64 elapsed = qMax<qint64>(m_rateElapsed.restart(), 1);
+    const qint64 rate = m_rateBytes * 1000 / elapsed;
+    if (m_rateBytes == 0) {
+        // nothing arrived during the last second, stop measuring
+        m_rateTimer.stop();
+    }
+    m_rateBytes = 0;
+
+    KFormat format;
+    if (m_droppedBytes + m_droppedPending > 0) {
+        m_throughput->setText(i18n("Output: %1/s, %2 dropped",
+                                   format.formatByteSize(rate),
+                                   format.formatByteSize(m_droppedBytes + m_droppedPending)));
+    }
+    else {
+        m_throughput->setText(i18n("Output: %1/s", format.formatByteSize(rate)));
+    }
+    m_throughput->show();
 }
 
 void IOView::addStdOutText(const QString &text)
@@ -187,7 +273,7 @@ void IOView::addStdOutText(const QString &text)
 
     QTextCursor cursor = m_output->textCursor();
     if (!cursor.atEnd()) cursor.movePosition(QTextCursor::End);
-    cursor.insertText(text);
+    cursor.insertText(text, QTextCharFormat());
 
     if (atEnd) {
         scrollb->setValue(scrollb->maximum());
@@ -196,9 +282,19 @@ void IOView::addStdOutText(const QString &text)
 
 void IOView::addStdErrText(const QString &text)
 {
-    m_output->setFontItalic(true);
-    addStdOutText(text);
-    m_output->setFontItalic(false);
+    QScrollBar *scrollb = m_output->verticalScrollBar();
+    if (!scrollb) return;
+    bool atEnd = (scrollb->value() == scrollb->maximum());
+
+    QTextCharFormat format;
+    format.setFontItalic(true);
+    QTextCursor cursor = m_output->textCursor();
+    if (!cursor.atEnd()) cursor.movePosition(QTextCursor::End);
+    cursor.insertText(text, format);
+
+    if (atEnd) {
+        scrollb->setValue(scrollb->maximum());
+    }
 }
 
 QString IOView::createFifo(const QString &prefix)
@@ -215,5 +311,13 @@ const QString IOView::stderrFifo() { return m_stderrFifo; }
 
 void IOView::enableInput(bool enable) { m_input->setEnabled(enable); }
 
-void IOView::clearOutput() { m_output->clear(); }
+void IOView::clearOutput()
+{
+    m_output->clear();
+    m_rateTimer.stop();
+    m_rateBytes = 0;
+    m_droppedBytes = 0;
+    m_droppedPending = 0;
+    m_throughput->hide();
+}
 
@@ -25,10 +25,15 @@
 
 #include <QWidget>
 #include <QFile>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QTimer>
 
-class QTextEdit;
+class QPlainTextEdit;
 class QLineEdit;
+class QLabel;
 class QSocketNotifier;
+class QTextDecoder;
 
 class IOView : public QWidget
 {
@@ -53,6 +58,8 @@ private Q_SLOTS:
     void returnPressed();
     void readOutput();
     void readErrors();
+    void flushOutput();
+    void updateThroughput();
 
 Q_SIGNALS:
     void stdOutText(const QString &text);
@@ -61,9 +68,11 @@ Q_SIGNALS:
 private:
     void createFifos();
     QString createFifo(const QString &prefix);
+    void readFifo(QFile &fifo, QFile &dummy, QByteArray &pending);
 
-    QTextEdit       *m_output;
+    QPlainTextEdit  *m_output;
     QLineEdit       *m_input;
+    QLabel          *m_throughput;
 
     QString          m_stdinFifo;
     QString          m_stdoutFifo;
@@ -81,6 +90,19 @@ private:
 
     QSocketNotifier *m_stdoutNotifier;
     QSocketNotifier *m_stderrNotifier;
+
+    // output is collected here and appended at most once per flush interval
+    QByteArray       m_stdoutPending;
+    QByteArray       m_stderrPending;
+    QTextDecoder    *m_stdoutDecoder;
+    QTextDecoder    *m_stderrDecoder;
+    QTimer           m_flushTimer;
+
+    QTimer           m_rateTimer;
+    QElapsedTimer    m_rateElapsed;
+    qint64           m_rateBytes;
+    qint64           m_droppedBytes;
+    qint64           m_droppedPending;
 };
 
 #endif
@@ -18,19 +18,30 @@
 //  Boston, MA 02110-1301, USA.
 
 #include "localsview.h"
-#include <QLabel>
-#include <QDebug>
 #include <klocalizedstring.h>
 
+enum {
+    VarObjRole = Qt::UserRole,
+    ChildCountRole,
+    FetchedRole,
+    NextChildRole
+};
 
 LocalsView::LocalsView(QWidget *parent)
-:   QTreeWidget(parent), m_allAdded(true)
+:   QTreeWidget(parent)
 {
     QStringList headers;
     headers << i18n("Symbol");
     headers << i18n("Value");
     setHeaderLabels(headers);
     setAutoScroll(false);
+
+    connect(this, SIGNAL(itemExpanded(QTreeWidgetItem*)),
+            this, SLOT(slotItemExpanded(QTreeWidgetItem*)));
+    connect(this, SIGNAL(itemCollapsed(QTreeWidgetItem*)),
+            this, SLOT(slotItemCollapsed(QTreeWidgetItem*)));
+    connect(this, SIGNAL(itemActivated(QTreeWidgetItem*,int)),
+            this, SLOT(slotItemActivated(QTreeWidgetItem*)));
 }
 
 LocalsView::~LocalsView()
@@ -47,221 +58,143 @@ void LocalsView::hideEvent(QHideEvent *)
     emit localsVisible(false);
 }
 
-void LocalsView::createWrappedItem(QTreeWidgetItem *parent, const QString &name, const QString &value)
+static QString itemPath(QTreeWidgetItem *item)
 {
-    QTreeWidgetItem *item = new QTreeWidgetItem(parent, QStringList(name));
-    QLabel *label = new QLabel(value);
-    label->setWordWrap(true);
-    setItemWidget(item, 1, label);
-    item->setData(1, Qt::UserRole, value);
+    QString path = item->text(0);
+    while ((item = item->parent())) {
+        path.prepend(item->text(0) + QLatin1Char('/'));
+    }
+    return path;
 }
 
-void LocalsView::createWrappedItem(QTreeWidget *parent, const QString &name, const QString &value)
+void LocalsView::clear()
 {
-    QTreeWidgetItem *item = new QTreeWidgetItem(parent, QStringList(name));
-    QLabel *label = new QLabel(value);
-    label->setWordWrap(true);
-    setItemWidget(item, 1, label);
+    m_items.clear();
+    QTreeWidget::clear();
 }
 
-void LocalsView::addLocal(const QString &vString)
+void LocalsView::addVariable(const QString &parent, const QString &varobj, const QString &name,
+                             const QString &type, const QString &value, int numChildren)
 {
-    static QRegExp isValue(QStringLiteral("(\\S*)\\s=\\s(.*)"));
-    static QRegExp isStruct(QStringLiteral("\\{\\S*\\s=\\s.*"));
-    static QRegExp isStartPartial(QStringLiteral("\\S*\\s=\\s\\S*\\s=\\s\\{"));
-    static QRegExp isPrettyQList(QStringLiteral("\\s*\\[\\S*\\]\\s=\\s\\S*"));
-    static QRegExp isPrettyValue(QStringLiteral("(\\S*)\\s=\\s(\\S*)\\s=\\s(.*)"));
-    static QRegExp isThisValue(QStringLiteral("\\$\\d+"));
-
-    if (m_allAdded) {
-        clear();
-        m_allAdded = false;
-    }
-    
-    if (vString.isEmpty()) {
-        m_allAdded = true;
+    QTreeWidgetItem *parentItem = parent.isEmpty() ? invisibleRootItem() : m_items.value(parent);
+    if (!parentItem || m_items.contains(varobj)) {
         return;
     }
-    if (isStartPartial.exactMatch(vString)) {
-        m_local = vString;
-        return;
+
+    // array elements are named by their index only
+    bool isIndex = false;
+    name.toInt(&isIndex);
+
+    QStringList columns;
+    columns << (isIndex ? QStringLiteral("[%1]").arg(name) : name);
+    columns << value;
+    QTreeWidgetItem *item = new QTreeWidgetItem(parentItem, columns);
+    item->setToolTip(0, type);
+    item->setToolTip(1, value);
+    item->setData(0, VarObjRole, varobj);
+    item->setData(0, ChildCountRole, numChildren);
+    item->setChildIndicatorPolicy(numChildren != 0 ? QTreeWidgetItem::ShowIndicator
+                                                   : QTreeWidgetItem::DontShowIndicatorWhenChildless);
+    m_items.insert(varobj, item);
+
+    if ((numChildren != 0) && m_expanded.contains(itemPath(item))) {
+        item->setExpanded(true);
     }
-    if (isPrettyQList.exactMatch(vString)) {
-        m_local += vString.trimmed();
-        if (m_local.endsWith(QLatin1Char(','))) m_local += QLatin1Char(' ');
-        return;
+}
+
+void LocalsView::updateVariable(const QString &varobj, const QString &value)
+{
+    QTreeWidgetItem *item = m_items.value(varobj);
+    if (item) {
+        item->setText(1, value);
+        item->setToolTip(1, value);
     }
-    if (vString == QLatin1String("}")) {
-        m_local += vString;
+}
+
+void LocalsView::resetChildren(const QString &varobj, int numChildren)
+{
+    QTreeWidgetItem *item = m_items.value(varobj);
+    if (!item) {
+        return;
     }
 
-    QStringList symbolAndValue;
-    QString value;
-    
-    if (m_local.isEmpty()) {
-        if (vString == QLatin1String("No symbol table info available.")) {
-            return; /* this is not an error */
-        }
-        if (!isValue.exactMatch(vString)) {
-            qDebug() << "Could not parse:" << vString;
-            return;
-        }
-        symbolAndValue << isValue.cap(1);
-        // check out for "print *this"
-        if (isThisValue.exactMatch(symbolAndValue[0])) {
-            symbolAndValue[0] = QLatin1String("*this");
-        }
-        value = isValue.cap(2);
+    forgetChildren(item);
+    qDeleteAll(item->takeChildren());
+    item->setData(0, ChildCountRole, numChildren);
+    item->setData(0, FetchedRole, false);
+    item->setChildIndicatorPolicy(numChildren != 0 ? QTreeWidgetItem::ShowIndicator
+                                                   : QTreeWidgetItem::DontShowIndicatorWhenChildless);
+
+    if (item->isExpanded() && (numChildren != 0)) {
+        requestChildren(item);
     }
-    else {
-        if (!isPrettyValue.exactMatch(m_local)) {
-            qDebug() << "Could not parse:" << m_local;
-            m_local.clear();
-            return;
-        }
-        symbolAndValue << isPrettyValue.cap(1) << isPrettyValue.cap(2);
-        value = isPrettyValue.cap(3);
+}
+
+void LocalsView::childrenListed(const QString &varobj, int next, bool hasMore)
+{
+    QTreeWidgetItem *item = m_items.value(varobj);
+    if (!item) {
+        return;
     }
 
-    QTreeWidgetItem *item;
-    if (value[0] == QLatin1Char('{')) {
-        if (value[1] == QLatin1Char('{')) {
-            item = new QTreeWidgetItem(this, symbolAndValue);
-            addArray(item, value.mid(1, value.size()-2));
-        }
-        else {
-            if (isStruct.exactMatch(value)) {
-                item = new QTreeWidgetItem(this, symbolAndValue);
-                addStruct(item, value.mid(1, value.size()-2));
-            }
-            else {
-                createWrappedItem(this, symbolAndValue[0], value);
-            }
-        }
+    const int count = item->data(0, ChildCountRole).toInt();
+    if (hasMore || ((count > 0) && (next < count))) {
+        QTreeWidgetItem *more = new QTreeWidgetItem(item, QStringList(QStringLiteral("...")));
+        more->setToolTip(0, i18n("Activate to show more elements"));
+        more->setData(0, NextChildRole, next);
     }
-    else {
-        createWrappedItem(this, symbolAndValue[0], value);
+}
+
+void LocalsView::removeVariable(const QString &varobj)
+{
+    QTreeWidgetItem *item = m_items.take(varobj);
+    if (item) {
+        forgetChildren(item);
+        delete item;
     }
+}
 
-    m_local.clear();
+void LocalsView::slotItemExpanded(QTreeWidgetItem *item)
+{
+    m_expanded.insert(itemPath(item));
+    if (!item->data(0, FetchedRole).toBool()) {
+        requestChildren(item);
+    }
 }
 
+void LocalsView::slotItemCollapsed(QTreeWidgetItem *item)
+{
+    m_expanded.remove(itemPath(item));
+}
 
-void LocalsView::addStruct(QTreeWidgetItem *parent, const QString &vString)
+void LocalsView::slotItemActivated(QTreeWidgetItem *item)
 {
-    static QRegExp isArray(QStringLiteral("\\{\\.*\\s=\\s.*"));
-    static QRegExp isStruct(QStringLiteral("\\.*\\s=\\s.*"));
-    QTreeWidgetItem *item;
-    QStringList symbolAndValue;
-    QString subValue;
-    int start = 0;
-    int end;
-    while (start < vString.size()) {
-        // Symbol
-        symbolAndValue.clear();
-        end = vString.indexOf(QStringLiteral(" = "), start);
-        if (end < 0) {
-            // error situation -> bail out
-            createWrappedItem(parent, QString(), vString.right(start));
-            break;
-        }
-        symbolAndValue << vString.mid(start, end-start);
-        //qDebug() << symbolAndValue;
-        // Value
-        start = end + 3;
-        end = start;
-        if (start < 0 || start >= vString.size()) {
-            qDebug() << vString << start;
-            break;
-        }
-        if (vString[start] == QLatin1Char('{')) {
-            start++;
-            end++;
-            int count = 1;
-            bool inComment = false;
-            // search for the matching }
-            while(end < vString.size()) {
-                if (!inComment) {
-                    if (vString[end] == QLatin1Char('"')) inComment = true;
-                    else if (vString[end] == QLatin1Char('}')) count--;
-                    else if (vString[end] == QLatin1Char('{')) count++;
-                    if (count == 0) break;
-                }
-                else {
-                    if ((vString[end] == QLatin1Char('"')) && (vString[end-1] != QLatin1Char('\\'))) {
-                        inComment = false;
-                    }
-                }
-                end++;
-            }
-            subValue = vString.mid(start, end-start);
-            if (isArray.exactMatch(subValue)) {
-                item = new QTreeWidgetItem(parent, symbolAndValue);
-                addArray(item, subValue);
-            }
-            else if (isStruct.exactMatch(subValue)) {
-                item = new QTreeWidgetItem(parent, symbolAndValue);
-                addStruct(item, subValue);
-            }
-            else {
-                createWrappedItem(parent, symbolAndValue[0], vString.mid(start, end-start));
-            }
-            start = end + 3; // },_
-        }
-        else {
-            // look for the end of the value in the vString
-            bool inComment = false;
-            while(end < vString.size()) {
-                if (!inComment) {
-                    if (vString[end] == QLatin1Char('"')) inComment = true;
-                    else if (vString[end] == QLatin1Char(',')) break;
-                }
-                else {
-                    if ((vString[end] == QLatin1Char('"')) && (vString[end-1] != QLatin1Char('\\'))) {
-                        inComment = false;
-                    }
-                }
-                end++;
-            }
-            createWrappedItem(parent, symbolAndValue[0], vString.mid(start, end-start));
-            start = end + 2; // ,_
-        }
+    // only the "..." items of long lists react
+    QTreeWidgetItem *parent = item->parent();
+    if (!parent || !item->data(0, NextChildRole).isValid()) {
+        return;
     }
+
+    const int next = item->data(0, NextChildRole).toInt();
+    delete item;
+    emit childrenRequested(parent->data(0, VarObjRole).toString(), next);
 }
 
-void LocalsView::addArray(QTreeWidgetItem *parent, const QString &vString)
+void LocalsView::forgetChildren(QTreeWidgetItem *item)
 {
-    // getting here we have this kind of string:
-    // "{...}" or "{...}, {...}" or ...
-    QTreeWidgetItem *item;
-    int count = 1;
-    bool inComment = false;
-    int index = 0;
-    int start = 1;
-    int end = 1;
-
-    while (end < vString.size()) {
-        if (!inComment) {
-            if (vString[end] == QLatin1Char('"')) inComment = true;
-            else if (vString[end] == QLatin1Char('}')) count--;
-            else if (vString[end] == QLatin1Char('{')) count++;
-            if (count == 0) {
-                QStringList name;
-                name << QStringLiteral("[%1]").arg(index);
-                index++;
-                item = new QTreeWidgetItem(parent, name);
-                addStruct(item, vString.mid(start, end-start));
-                end += 4; // "}, {"
-                start = end;
-                count = 1;
-            }
-        }
-        else {
-            if ((vString[end] == QLatin1Char('"')) && (vString[end-1] != QLatin1Char('\\'))) {
-                inComment = false;
-            }
-        }
-        end++;
+    for (int i = 0; i < item->childCount(); i++) {
+        QTreeWidgetItem *child = item->child(i);
+        m_items.remove(child->data(0, VarObjRole).toString());
+        forgetChildren(child);
     }
 }
 
+void LocalsView::requestChildren(QTreeWidgetItem *item)
+{
+    const QString varobj = item->data(0, VarObjRole).toString();
+    if (varobj.isEmpty()) {
+        return;
+    }
+    item->setData(0, FetchedRole, true);
+    emit childrenRequested(varobj, 0);
+}
@@ -22,8 +22,17 @@
 
 #include <QTreeWidget>
 #include <QTreeWidgetItem>
+#include <QHash>
+#include <QSet>
 
 
+/**
+ * Shows the gdb variable objects of the current frame.
+ *
+ * Children are only requested when an item is expanded, a page at a time,
+ * and items are updated in place between steps so that the expansion
+ * state survives.
+ */
 class LocalsView : public QTreeWidget
 {
 Q_OBJECT
@@ -32,23 +41,33 @@ public:
     ~LocalsView();
 
 public Q_SLOTS:
-    // An empty value string ends the locals
-    void addLocal(const QString &vString);
-    void addStruct(QTreeWidgetItem *parent, const QString &vString);
-    void addArray(QTreeWidgetItem *parent, const QString &vString);
+    void clear();
+    void addVariable(const QString &parent, const QString &varobj, const QString &name,
+                     const QString &type, const QString &value, int numChildren);
+    void updateVariable(const QString &varobj, const QString &value);
+    void resetChildren(const QString &varobj, int numChildren);
+    void childrenListed(const QString &varobj, int next, bool hasMore);
+    void removeVariable(const QString &varobj);
 
 Q_SIGNALS:
     void localsVisible(bool visible);
+    void childrenRequested(const QString &varobj, int from);
 
 protected:
     void showEvent(QShowEvent *event);
     void hideEvent(QHideEvent *event);
 
+private Q_SLOTS:
+    void slotItemExpanded(QTreeWidgetItem *item);
+    void slotItemCollapsed(QTreeWidgetItem *item);
+    void slotItemActivated(QTreeWidgetItem *item);
+
 private:
-    void createWrappedItem(QTreeWidgetItem *parent, const QString &name, const QString &value);
-    void createWrappedItem(QTreeWidget *parent, const QString &name, const QString &value);
-    bool    m_allAdded;
-    QString m_local;
+    void forgetChildren(QTreeWidgetItem *item);
+    void requestChildren(QTreeWidgetItem *item);
+
+    QHash<QString, QTreeWidgetItem*> m_items;
+    QSet<QString>                    m_expanded; // paths of the expanded items
 };
 
 #endif
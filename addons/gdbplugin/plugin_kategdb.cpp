@@ -202,8 +202,23 @@ KatePluginGDBView::KatePluginGDBView(KTextEditor::Plugin *plugin, KTextEditor::M
     connect(m_debugView, SIGNAL(stackFrameChanged(int)),
              this,        SLOT(stackFrameChanged(int)));
 
-    connect(m_debugView,  SIGNAL(infoLocal(QString)),
-             m_localsView, SLOT(addLocal(QString)));
+    connect(m_debugView,  SIGNAL(variableCreated(QString,QString,QString,QString,QString,int)),
+             m_localsView, SLOT(addVariable(QString,QString,QString,QString,QString,int)));
+
+    connect(m_debugView,  SIGNAL(variableChanged(QString,QString)),
+             m_localsView, SLOT(updateVariable(QString,QString)));
+
+    connect(m_debugView,  SIGNAL(variableChildrenChanged(QString,int)),
+             m_localsView, SLOT(resetChildren(QString,int)));
+
+    connect(m_debugView,  SIGNAL(variableChildrenListed(QString,int,bool)),
+             m_localsView, SLOT(childrenListed(QString,int,bool)));
+
+    connect(m_debugView,  SIGNAL(variableDeleted(QString)),
+             m_localsView, SLOT(removeVariable(QString)));
+
+    connect(m_localsView, SIGNAL(childrenRequested(QString,int)),
+             m_debugView,  SLOT(slotListChildren(QString,int)));
 
     connect(m_debugView, SIGNAL(threadInfo(int,bool)),
              this,        SLOT(insertThread(int,bool)));
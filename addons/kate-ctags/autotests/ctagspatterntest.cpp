@@ -0,0 +1,97 @@
+/* Description : Kate CTags plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ctagspatterntest.h"
+#include "ctagspattern.h"
+
+#include <QtTest>
+
+#include <KTextEditor/Document>
+#include <KTextEditor/Editor>
+
+QTEST_MAIN(KateCTagsPatternTest)
+
+// size of the generated header the benchmarks jump into
+static const int GENERATED_LINES = 100000;
+
+void KateCTagsPatternTest::initTestCase()
+{
+    m_doc = KTextEditor::Editor::instance()->createDocument(0);
+
+    QStringList lines;
+    lines.reserve(GENERATED_LINES);
+    for (int i = 0; i < GENERATED_LINES; ++i) {
+        lines << QStringLiteral("int generated_function_%1(int a, int b);").arg(i);
+    }
+    m_doc->setText(lines);
+}
+
+void KateCTagsPatternTest::cleanupTestCase()
+{
+    delete m_doc;
+}
+
+void KateCTagsPatternTest::testFindLine()
+{
+    const QString pattern = QStringLiteral("/^int generated_function_500(int a, int b);$/");
+
+    // without a line number, with the right one and with a stale one
+    QCOMPARE(CTagsPattern::findLine(m_doc, pattern), 500);
+    QCOMPARE(CTagsPattern::findLine(m_doc, pattern, 500), 500);
+    QCOMPARE(CTagsPattern::findLine(m_doc, pattern, 470), 500);
+    QCOMPARE(CTagsPattern::findLine(m_doc, pattern, 90000), 500);
+    QCOMPARE(CTagsPattern::findLine(m_doc, pattern, GENERATED_LINES + 10), 500);
+
+    // macro patterns only anchor the start of the line
+    QCOMPARE(CTagsPattern::findLine(m_doc, QStringLiteral("/^int generated_function_42(/")), 42);
+
+    // the end anchor must not match a longer line
+    QCOMPARE(CTagsPattern::findLine(m_doc, QStringLiteral("/^int generated_function_4$/")), -1);
+
+    // escaped slashes
+    m_doc->insertLine(0, QStringLiteral("int *divide(int a, int b); // a/b"));
+    QCOMPARE(CTagsPattern::findLine(m_doc, QStringLiteral("/^int *divide(int a, int b); \\/\\/ a\\/b$/")), 0);
+    m_doc->removeLine(0);
+
+    QCOMPARE(CTagsPattern::findLine(m_doc, QStringLiteral("/^does not exist$/"), 10), -1);
+    QCOMPARE(CTagsPattern::findLine(m_doc, QString()), -1);
+}
+
+void KateCTagsPatternTest::benchmarkFindLine_data()
+{
+    QTest::addColumn<int>("expectedLine");
+
+    QTest::newRow("full scan") << -1;
+    QTest::newRow("exact line") << GENERATED_LINES - 10;
+    QTest::newRow("stale line") << GENERATED_LINES - 60;
+}
+
+void KateCTagsPatternTest::benchmarkFindLine()
+{
+    QFETCH(int, expectedLine);
+
+    // jump to a symbol near the end of the generated header
+    const QString pattern = QStringLiteral("/^int generated_function_%1(int a, int b);$/").arg(GENERATED_LINES - 10);
+
+    int line = -1;
+    QBENCHMARK {
+        line = CTagsPattern::findLine(m_doc, pattern, expectedLine);
+    }
+    QCOMPARE(line, GENERATED_LINES - 10);
+}
@@ -0,0 +1,47 @@
+/* Description : Kate CTags plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KATE_CTAGS_PATTERN_TEST_H
+#define KATE_CTAGS_PATTERN_TEST_H
+
+#include <QObject>
+
+namespace KTextEditor
+{
+class Document;
+}
+
+class KateCTagsPatternTest : public QObject
+{
+    Q_OBJECT
+
+public Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+private Q_SLOTS:
+    void testFindLine();
+    void benchmarkFindLine_data();
+    void benchmarkFindLine();
+
+private:
+    KTextEditor::Document *m_doc;
+};
+
+#endif
@@ -0,0 +1,432 @@
+/* Description : Kate CTags plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ctagsdbupdater.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QSaveFile>
+#include <QTemporaryFile>
+
+#include <klocalizedstring.h>
+
+#include <algorithm>
+
+#ifndef Q_OS_WIN
+#include <stdio.h>
+#endif
+
+// bump when the layout of the state file changes
+static const quint32 STATE_VERSION = 1;
+
+/******************************************************************/
+static QByteArray fileOfTagLine(const QByteArray &line)
+{
+    // tag lines look like "name<TAB>file<TAB>address;"<TAB>fields"
+    const int start = line.indexOf('\t') + 1;
+    if (start <= 0) {
+        return QByteArray();
+    }
+    const int end = line.indexOf('\t', start);
+    if (end < 0) {
+        return QByteArray();
+    }
+    return line.mid(start, end - start);
+}
+
+/******************************************************************/
+CTagsDbUpdater::CTagsDbUpdater(QObject *parent)
+: QThread(parent)
+, m_cancel(0)
+, m_recurse(false)
+{
+}
+
+/******************************************************************/
+CTagsDbUpdater::~CTagsDbUpdater()
+{
+    cancel();
+    wait();
+}
+
+/******************************************************************/
+void CTagsDbUpdater::update(const QString &command, const QString &tagsFile, const QStringList &targets)
+{
+    if (isRunning()) {
+        return;
+    }
+
+    m_command = command;
+    m_tagsFile = tagsFile;
+    m_targets = targets;
+    m_error.clear();
+    m_cancel.store(0);
+
+    // ctags matches --exclude patterns against the name and the path of a file
+    m_recurse = false;
+    m_excludes.clear();
+    foreach (const QString &arg, command.split(QRegExp(QStringLiteral("\\s+")), QString::SkipEmptyParts)) {
+        if (arg == QLatin1String("-R") || arg == QLatin1String("--recurse") || arg == QLatin1String("--recurse=yes")) {
+            m_recurse = true;
+        } else if (arg == QLatin1String("--recurse=no")) {
+            m_recurse = false;
+        } else if (arg.startsWith(QLatin1String("--exclude="))) {
+            QString pattern = arg.mid(10);
+            if (pattern.size() > 1 && (pattern.startsWith(QLatin1Char('"')) || pattern.startsWith(QLatin1Char('\''))) && pattern.endsWith(pattern.at(0))) {
+                pattern = pattern.mid(1, pattern.size() - 2);
+            }
+            m_excludes << QRegExp(pattern, Qt::CaseSensitive, QRegExp::Wildcard);
+        }
+    }
+
+    start(QThread::LowPriority);
+}
+
+/******************************************************************/
+QString CTagsDbUpdater::errorString() const
+{
+    return m_error;
+}
+
+/******************************************************************/
+void CTagsDbUpdater::cancel()
+{
+    m_cancel.store(1);
+}
+
+/******************************************************************/
+void CTagsDbUpdater::run()
+{
+    Q_EMIT progress(0, 0);
+
+    FileTimes oldTimes;
+    const bool incremental = QFile::exists(m_tagsFile) && readState(&oldTimes);
+
+    // scan before tagging, a file modified while ctags runs is re-tagged next time
+    const FileTimes newTimes = scanTargets();
+    if (m_cancel.load()) {
+        return;
+    }
+
+    const bool ok = incremental ? incrementalUpdate(oldTimes, newTimes) : fullUpdate();
+    if (ok && !m_cancel.load()) {
+        writeState(newTimes);
+    }
+}
+
+/******************************************************************/
+CTagsDbUpdater::FileTimes CTagsDbUpdater::scanTargets() const
+{
+    FileTimes times;
+    foreach (const QString &target, m_targets) {
+        const QFileInfo info(target);
+        if (info.isFile()) {
+            times.insert(target, info.lastModified().toMSecsSinceEpoch());
+        } else if (info.isDir() && m_recurse) {
+            // without -R ctags skips directories given as targets
+            scanDir(target, &times);
+        }
+    }
+    return times;
+}
+
+/******************************************************************/
+void CTagsDbUpdater::scanDir(const QString &dir, FileTimes *times) const
+{
+    QDirIterator it(dir, QDir::Files | QDir::Dirs | QDir::Hidden | QDir::NoDotAndDotDot);
+    while (it.hasNext() && !m_cancel.load()) {
+        it.next();
+        const QFileInfo info = it.fileInfo();
+        if (isExcluded(info)) {
+            continue;
+        }
+        if (info.isDir()) {
+            if (!info.isSymLink()) {
+                scanDir(it.filePath(), times);
+            }
+        } else {
+            times->insert(it.filePath(), info.lastModified().toMSecsSinceEpoch());
+        }
+    }
+}
+
+/******************************************************************/
+bool CTagsDbUpdater::isExcluded(const QFileInfo &info) const
+{
+    foreach (const QRegExp &exclude, m_excludes) {
+        if (exclude.exactMatch(info.fileName()) || exclude.exactMatch(info.filePath())) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/******************************************************************/
+static bool replaceFile(const QString &source, const QString &target)
+{
+#ifdef Q_OS_WIN
+    // no atomic overwrite here, lookups may miss the database for a moment
+    QFile::remove(target);
+    return QFile::rename(source, target);
+#else
+    // rename(2) swaps the file in one step, readers get either database
+    return ::rename(QFile::encodeName(source).constData(), QFile::encodeName(target).constData()) == 0;
+#endif
+}
+
+/******************************************************************/
+bool CTagsDbUpdater::fullUpdate()
+{
+    // generate next to the old database, so lookups keep working until it is replaced
+    const QString newDb = m_tagsFile + QLatin1String(".new");
+    QFile::remove(newDb);
+
+    const QString command = QStringLiteral("%1 -f %2 %3").arg(m_command).arg(newDb).arg(m_targets.join(QLatin1Char(' ')));
+
+    QProcess proc;
+    proc.setStandardOutputFile(QProcess::nullDevice());
+    proc.start(command);
+    if (!waitForProcess(&proc, command)) {
+        QFile::remove(newDb);
+        return false;
+    }
+
+    if (!replaceFile(newDb, m_tagsFile)) {
+        QFile::remove(newDb);
+        return false;
+    }
+    return true;
+}
+
+/******************************************************************/
+bool CTagsDbUpdater::incrementalUpdate(const FileTimes &oldTimes, const FileTimes &newTimes)
+{
+    QStringList changed;
+    QSet<QByteArray> dropped;
+
+    for (FileTimes::const_iterator it = newTimes.constBegin(); it != newTimes.constEnd(); ++it) {
+        if (oldTimes.value(it.key(), -1) != it.value()) {
+            changed << it.key();
+            dropped << it.key().toLocal8Bit();
+        }
+    }
+    for (FileTimes::const_iterator it = oldTimes.constBegin(); it != oldTimes.constEnd(); ++it) {
+        if (!newTimes.contains(it.key())) {
+            dropped << it.key().toLocal8Bit();
+        }
+    }
+
+    if (dropped.isEmpty()) {
+        return true;
+    }
+
+    QList<QByteArray> newLines;
+    if (!changed.isEmpty() && !tagFiles(changed, &newLines)) {
+        return false;
+    }
+
+    return splice(dropped, newLines);
+}
+
+/******************************************************************/
+bool CTagsDbUpdater::tagFiles(const QStringList &files, QList<QByteArray> *lines)
+{
+    const int jobs = qBound(1, QThread::idealThreadCount(), files.size());
+    const int chunkSize = (files.size() + jobs - 1) / jobs;
+
+    QList<QTemporaryFile *> fileLists;
+    QList<QTemporaryFile *> outputs;
+    QList<QProcess *> procs;
+    QStringList commands;
+
+    for (int i = 0; i < files.size(); i += chunkSize) {
+        QTemporaryFile *fileList = new QTemporaryFile();
+        QTemporaryFile *output = new QTemporaryFile();
+        fileLists << fileList;
+        outputs << output;
+        if (!fileList->open() || !output->open()) {
+            m_error = i18n("Failed to create a temporary file.");
+            break;
+        }
+        fileList->write(files.mid(i, chunkSize).join(QLatin1Char('\n')).toLocal8Bit());
+        fileList->close();
+        output->close();
+
+        const QString command = QStringLiteral("%1 -f %2 -L %3").arg(m_command).arg(output->fileName()).arg(fileList->fileName());
+        QProcess *proc = new QProcess();
+        proc->setStandardOutputFile(QProcess::nullDevice());
+        proc->start(command);
+        procs << proc;
+        commands << command;
+    }
+
+    bool ok = m_error.isEmpty();
+    for (int i = 0; i < procs.size(); ++i) {
+        ok = ok && waitForProcess(procs[i], commands[i]);
+        if (!ok) {
+            procs[i]->kill();
+            procs[i]->waitForFinished();
+            continue;
+        }
+        Q_EMIT progress(i + 1, procs.size() + 1);
+    }
+
+    for (int i = 0; ok && i < outputs.size(); ++i) {
+        QFile output(outputs[i]->fileName());
+        if (!output.open(QIODevice::ReadOnly)) {
+            m_error = i18n("Failed to read \"%1\".", output.fileName());
+            ok = false;
+            break;
+        }
+        while (!output.atEnd()) {
+            QByteArray line = output.readLine();
+            if (line.startsWith("!_")) {
+                continue;
+            }
+            if (!line.endsWith('\n')) {
+                line += '\n';
+            }
+            lines->append(line);
+        }
+    }
+
+    qDeleteAll(procs);
+    qDeleteAll(outputs);
+    qDeleteAll(fileLists);
+
+    std::sort(lines->begin(), lines->end());
+    return ok;
+}
+
+/******************************************************************/
+bool CTagsDbUpdater::splice(const QSet<QByteArray> &dropped, const QList<QByteArray> &newLines)
+{
+    QFile oldDb(m_tagsFile);
+    QSaveFile newDb(m_tagsFile);
+    if (!oldDb.open(QIODevice::ReadOnly) || !newDb.open(QIODevice::WriteOnly)) {
+        m_error = i18n("Failed to update \"%1\".", m_tagsFile);
+        return false;
+    }
+
+    // both the database and the new lines are sorted, merge them
+    QList<QByteArray>::const_iterator next = newLines.constBegin();
+    while (!oldDb.atEnd() && !m_cancel.load()) {
+        const QByteArray line = oldDb.readLine();
+        if (line.startsWith("!_")) {
+            newDb.write(line);
+            continue;
+        }
+        if (dropped.contains(fileOfTagLine(line))) {
+            continue;
+        }
+        while (next != newLines.constEnd() && *next < line) {
+            newDb.write(*next++);
+        }
+        newDb.write(line);
+    }
+    while (next != newLines.constEnd()) {
+        newDb.write(*next++);
+    }
+
+    if (m_cancel.load()) {
+        newDb.cancelWriting();
+        return false;
+    }
+
+    if (!newDb.commit()) {
+        m_error = i18n("Failed to update \"%1\".", m_tagsFile);
+        return false;
+    }
+    return true;
+}
+
+/******************************************************************/
+bool CTagsDbUpdater::waitForProcess(QProcess *proc, const QString &command)
+{
+    if (!proc->waitForStarted(500)) {
+        m_error = i18n("Failed to run \"%1\". exitStatus = %2", command, proc->exitStatus());
+        return false;
+    }
+
+    // waitForFinished() also fails for an already finished process
+    while (proc->state() != QProcess::NotRunning && !proc->waitForFinished(100)) {
+        if (m_cancel.load()) {
+            proc->kill();
+            proc->waitForFinished();
+            return false;
+        }
+    }
+
+    if (proc->exitStatus() == QProcess::CrashExit) {
+        m_error = i18n("The CTags executable crashed.");
+        return false;
+    }
+    if (proc->exitCode() != 0) {
+        m_error = i18n("The CTags program exited with code %1: %2"
+        , proc->exitCode()
+        , QString::fromLocal8Bit(proc->readAllStandardError()));
+        return false;
+    }
+    return true;
+}
+
+/******************************************************************/
+QString CTagsDbUpdater::stateFile() const
+{
+    return m_tagsFile + QLatin1String(".mtimes");
+}
+
+/******************************************************************/
+bool CTagsDbUpdater::readState(FileTimes *times) const
+{
+    QFile file(stateFile());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    quint32 version;
+    QString command;
+    QStringList targets;
+    stream >> version;
+    if (version != STATE_VERSION) {
+        return false;
+    }
+    stream >> command >> targets >> *times;
+
+    // a different command or target list invalidates every tag
+    return stream.status() == QDataStream::Ok && command == m_command && targets == m_targets;
+}
+
+/******************************************************************/
+void CTagsDbUpdater::writeState(const FileTimes &times) const
+{
+    QSaveFile file(stateFile());
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream << STATE_VERSION << m_command << m_targets << times;
+    file.commit();
+}
@@ -0,0 +1,100 @@
+#ifndef CTAGS_DB_UPDATER_H
+#define CTAGS_DB_UPDATER_H
+/* Description : Kate CTags plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QAtomicInt>
+#include <QThread>
+#include <QHash>
+#include <QRegExp>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+class QFileInfo;
+class QProcess;
+
+/**
+ * Regenerates a CTags database in the background.
+ *
+ * The modification time of every indexed file is remembered next to the
+ * database. As long as the command and the targets stay the same, only the
+ * files changed since the last run are re-tagged, spread over several ctags
+ * processes, and the result is spliced into the sorted database, which is
+ * replaced atomically.
+ */
+class CTagsDbUpdater : public QThread
+{
+    Q_OBJECT
+
+public:
+    CTagsDbUpdater(QObject *parent = 0);
+    ~CTagsDbUpdater();
+
+    /**
+     * Start updating @p tagsFile for @p targets using the ctags @p command.
+     * Does nothing if an update is already running.
+     */
+    void update(const QString &command, const QString &tagsFile, const QStringList &targets);
+
+    /**
+     * @return the error of the last update or an empty string on success
+     */
+    QString errorString() const;
+
+public Q_SLOTS:
+    void cancel();
+
+Q_SIGNALS:
+    /**
+     * Reports @p done of @p total steps, a @p total of 0 means busy.
+     */
+    void progress(int done, int total);
+
+protected:
+    void run();
+
+private:
+    typedef QHash<QString, qint64> FileTimes;
+
+    FileTimes scanTargets() const;
+    void scanDir(const QString &dir, FileTimes *times) const;
+    bool isExcluded(const QFileInfo &info) const;
+    bool fullUpdate();
+    bool incrementalUpdate(const FileTimes &oldTimes, const FileTimes &newTimes);
+    bool tagFiles(const QStringList &files, QList<QByteArray> *lines);
+    bool splice(const QSet<QByteArray> &dropped, const QList<QByteArray> &newLines);
+    bool waitForProcess(QProcess *proc, const QString &command);
+
+    QString stateFile() const;
+    bool readState(FileTimes *times) const;
+    void writeState(const FileTimes &times) const;
+
+    QString     m_command;
+    QString     m_tagsFile;
+    QStringList m_targets;
+    QString     m_error;
+    QAtomicInt  m_cancel;
+
+    // what the command makes ctags index, so only those files are looked at
+    bool           m_recurse;
+    QList<QRegExp> m_excludes;
+};
+
+#endif
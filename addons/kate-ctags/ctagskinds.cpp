@@ -11,6 +11,8 @@
 
 #include "ctagskinds.h"
 
+#include <QHash>
+
 #include <klocalizedstring.h>
 
 struct CTagsKindMapping {
@@ -274,7 +276,8 @@ static CTagsExtensionMapping extensionMapping[] = {
 
 static CTagsKindMapping *findKindMapping(const QString &extension)
 {
-    const char *pextension = extension.toLocal8Bit().constData();
+    const QByteArray extensionBArray = extension.toLocal8Bit(); // for holding the char *
+    const char *pextension = extensionBArray.constData();
 
     CTagsExtensionMapping *pem = extensionMapping;
     while (pem->extension != 0) {
@@ -291,15 +294,28 @@ QString CTagsKinds::findKind( const char * kindChar, const QString &extension )
 {
     if ( kindChar == 0 ) return QString();
 
+    // every hit of a lookup asks for one of a handful of kinds, remember the
+    // translated names instead of walking the mapping tables again
+    static QHash<QString, QString> kindCache;
+
+    const QString key = extension + QLatin1Char(*kindChar);
+    QHash<QString, QString>::const_iterator it = kindCache.constFind(key);
+    if (it != kindCache.constEnd())
+        return it.value();
+
+    QString kind;
     CTagsKindMapping *kindMapping = findKindMapping(extension);
     if (kindMapping) {
         CTagsKindMapping *pkm = kindMapping;
         while (pkm->verbose != 0) {
-            if (pkm->abbrev == *kindChar)
-                return i18nc("Tag Type", pkm->verbose);
+            if (pkm->abbrev == *kindChar) {
+                kind = i18nc("Tag Type", pkm->verbose);
+                break;
+            }
             ++pkm;
         }
     }
 
-    return QString();
+    kindCache.insert(key, kind);
+    return kind;
 }
@@ -0,0 +1,71 @@
+/* Description : Kate CTags plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ctagspattern.h"
+
+#include <KTextEditor/Document>
+
+// number of lines checked on each side of the expected line
+static const int SEARCH_WINDOW = 100;
+
+static bool matches(const QString &line, const QString &text, bool wholeLine)
+{
+    return wholeLine ? line == text : line.startsWith(text);
+}
+
+int CTagsPattern::findLine(const KTextEditor::Document *doc, const QString &pattern, int expectedLine)
+{
+    if (!doc || pattern.length() < 3) {
+        return -1;
+    }
+
+    // ctags interestingly escapes "/", but apparently nothing else. lets revert that
+    QString unescaped = pattern;
+    unescaped.replace( QStringLiteral("\\/"), QStringLiteral("/") );
+
+    // most of the time, the ctags pattern has the form /^foo$/
+    // but this isn't true for some macro definitions
+    // where the form is only /^foo/
+    // both are anchored literal strings, so no regexp is needed to match them
+    const bool wholeLine = unescaped.endsWith(QStringLiteral("$/"));
+    const QString text = wholeLine ? unescaped.mid(2, unescaped.length() - 4) : unescaped.mid(2, unescaped.length() - 3);
+
+    const int lines = doc->lines();
+
+    if (expectedLine >= 0) {
+        for (int offset = 0; offset <= SEARCH_WINDOW; ++offset) {
+            const int before = expectedLine - offset;
+            if (before >= 0 && before < lines && matches(doc->line(before), text, wholeLine)) {
+                return before;
+            }
+            const int after = expectedLine + offset;
+            if (offset > 0 && after < lines && matches(doc->line(after), text, wholeLine)) {
+                return after;
+            }
+        }
+    }
+
+    for (int line = 0; line < lines; ++line) {
+        if (matches(doc->line(line), text, wholeLine)) {
+            return line;
+        }
+    }
+
+    return -1;
+}
@@ -0,0 +1,43 @@
+#ifndef CTAGS_PATTERN_H
+#define CTAGS_PATTERN_H
+/* Description : Kate CTags plugin
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QString>
+
+namespace KTextEditor
+{
+class Document;
+}
+
+namespace CTagsPattern
+{
+
+/**
+ * Find the line of @p doc matching the ctags search @p pattern.
+ * If the tags file contains line numbers (--fields=+n), pass the 0-based
+ * @p expectedLine, the lines around it are checked before the whole document
+ * is scanned, as the document may have changed since it was indexed.
+ * @return the matching line or -1 if there is none
+ */
+int findLine(const KTextEditor::Document *doc, const QString &pattern, int expectedLine = -1);
+
+}
+
+#endif
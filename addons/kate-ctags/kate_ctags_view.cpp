@@ -20,6 +20,7 @@
  */
 
 #include "kate_ctags_view.h"
+#include "ctagspattern.h"
 
 #include <QFileInfo>
 #include <QFileDialog>
@@ -38,7 +39,6 @@
 /******************************************************************/
 KateCTagsView::KateCTagsView(KTextEditor::Plugin *plugin, KTextEditor::MainWindow *mainWin)
 : QObject(mainWin)
-, m_proc(0)
 {
     KXMLGUIClient::setComponentName (QLatin1String("katectags"), i18n ("Kate CTag"));
     setXMLFile( QLatin1String("ui.rc") );
@@ -101,8 +101,9 @@ KateCTagsView::KateCTagsView(KTextEditor::Plugin *plugin, KTextEditor::MainWindo
     connect(m_ctagsUi.delButton, SIGNAL(clicked()), this, SLOT(delTagTarget()));
     connect(m_ctagsUi.updateButton,  SIGNAL(clicked()), this, SLOT(updateSessionDB()));
     connect(m_ctagsUi.updateButton2,  SIGNAL(clicked()), this, SLOT(updateSessionDB()));
-    connect(&m_proc, SIGNAL(finished(int,QProcess::ExitStatus)),
-            this, SLOT(updateDone(int,QProcess::ExitStatus)));
+    connect(&m_updater, SIGNAL(progress(int,int)), this, SLOT(updateProgress(int,int)));
+    connect(&m_updater, SIGNAL(finished()), this, SLOT(updateDone()));
+    m_ctagsUi.updateProgress->hide();
 
     connect(m_ctagsUi.inputEdit, SIGNAL(textChanged(QString)), this, SLOT(startEditTmr()));
 
@@ -126,6 +127,9 @@ KateCTagsView::KateCTagsView(KTextEditor::Plugin *plugin, KTextEditor::MainWindo
 /******************************************************************/
 KateCTagsView::~KateCTagsView()
 {
+    m_updater.cancel();
+    m_updater.wait();
+
     m_mWin->guiFactory()->removeClient( this );
 
     delete m_toolView;
@@ -287,11 +291,11 @@ void KateCTagsView::gotoTagForTypes(const QString &word, const QStringList &type
 
     if (list.count() == 1) {
         Tags::TagEntry tag = list.first();
-        jumpToTag(tag.file, tag.pattern, word);
+        jumpToTag(tag.file, tag.pattern, word, tag.line);
     }
     else {
         Tags::TagEntry tag = list.first();
-        jumpToTag(tag.file, tag.pattern, word);
+        jumpToTag(tag.file, tag.pattern, word, tag.line);
         m_ctagsUi.tabWidget->setCurrentIndex(0);
         m_mWin->showToolView(m_toolView);
     }
@@ -321,6 +325,7 @@ void KateCTagsView::displayHits(const Tags::TagList &list)
         item->setText(1, list[i].type);
         item->setText(2, list[i].file);
         item->setData(0, Qt::UserRole, list[i].pattern);
+        item->setData(1, Qt::UserRole, list[i].line);
 
         QString pattern = list[i].pattern;
         pattern.replace( QStringLiteral("\\/"), QStringLiteral("/"));
@@ -341,8 +346,9 @@ void KateCTagsView::tagHitClicked(QTreeWidgetItem *item)
     const QString file = item->data(2, Qt::DisplayRole).toString();
     const QString pattern = item->data(0, Qt::UserRole).toString();
     const QString word = item->data(0, Qt::DisplayRole).toString();
+    const int line = item->data(1, Qt::UserRole).toInt();
 
-    jumpToTag(file, pattern, word);
+    jumpToTag(file, pattern, word, line);
 }
 
 /******************************************************************/
@@ -403,37 +409,10 @@ QString KateCTagsView::currentWord( )
 }
 
 /******************************************************************/
-void KateCTagsView::jumpToTag(const QString &file, const QString &pattern, const QString &word)
+void KateCTagsView::jumpToTag(const QString &file, const QString &pattern, const QString &word, int expectedLine)
 {
     if (pattern.isEmpty()) return;
 
-    // generate a regexp from the pattern
-    // ctags interestingly escapes "/", but apparently nothing else. lets revert that
-    QString unescaped = pattern;
-    unescaped.replace( QStringLiteral("\\/"), QStringLiteral("/") );
-
-    // most of the time, the ctags pattern has the form /^foo$/
-    // but this isn't true for some macro definitions
-    // where the form is only /^foo/
-    // I have no idea if this is a ctags bug or not, but we have to deal with it
-
-    QString reduced;
-    QString escaped;
-    QString re_string;
-
-    if (unescaped.endsWith(QStringLiteral("$/"))) {
-        reduced = unescaped.mid(2, unescaped.length() - 4);
-        escaped = QRegExp::escape(reduced);
-        re_string = QStringLiteral("^%1$").arg(escaped);
-    }
-    else {
-        reduced = unescaped.mid( 2, unescaped.length() -3 );
-        escaped = QRegExp::escape(reduced);
-        re_string = QStringLiteral("^%1").arg(escaped);
-    }
-
-    QRegExp re(re_string);
-
     // save current location
     TagJump from;
     from.url    = m_mWin->activeView()->document()->url();
@@ -451,17 +430,12 @@ void KateCTagsView::jumpToTag(const QString &file, const QString &pattern, const
     }
 
     // look for the line
-    QString linestr;
-    int line;
-    for (line =0; line < m_mWin->activeView()->document()->lines(); line++) {
-        linestr = m_mWin->activeView()->document()->line(line);
-        if (linestr.indexOf(re) > -1) break;
-    }
+    const int line = CTagsPattern::findLine(m_mWin->activeView()->document(), pattern, expectedLine);
 
     // activate the line
-    if (line != m_mWin->activeView()->document()->lines()) {
+    if (line >= 0) {
         // line found now look for the column
-        int column = linestr.indexOf(word) + (word.length()/2);
+        int column = m_mWin->activeView()->document()->line(line).indexOf(word) + (word.length()/2);
         m_mWin->activeView()->setCursorPosition(KTextEditor::Cursor(line, column));
     }
     m_mWin->activeView()->setFocus();
@@ -481,18 +455,18 @@ void KateCTagsView::startEditTmr()
 /******************************************************************/
 void KateCTagsView::updateSessionDB()
 {
-    if (m_proc.state() != QProcess::NotRunning) {
+    if (m_updater.isRunning()) {
         return;
     }
 
-    QString targets;
+    QStringList targets;
     QString target;
     for (int i=0; i<m_ctagsUi.targetList->count(); i++) {
       target = m_ctagsUi.targetList->item(i)->text();
       if (target.endsWith(QLatin1Char('/')) || target.endsWith(QLatin1Char('\\'))) {
         target = target.left(target.size() - 1);
       }
-      targets += target + QLatin1Char(' ');
+      targets << target;
     }
 
     QString pluginFolder = QStandardPaths::writableLocation(QStandardPaths::DataLocation) + QLatin1String("/katectags");
@@ -511,35 +485,32 @@ void KateCTagsView::updateSessionDB()
         return;
     }
 
+    m_updater.update(m_ctagsUi.cmdEdit->text(), m_ctagsUi.tagsFile->text(), targets);
 
-    QString command = QStringLiteral("%1 -f %2 %3").arg(m_ctagsUi.cmdEdit->text()).arg(m_ctagsUi.tagsFile->text()).arg(targets);
-
-    m_proc.start(command);
-
-    if(!m_proc.waitForStarted(500)) {
-        KMessageBox::error(0, i18n("Failed to run \"%1\". exitStatus = %2", command, m_proc.exitStatus()));
-        return;
-    }
-    QApplication::setOverrideCursor(QCursor(Qt::BusyCursor));
     m_ctagsUi.updateButton->setDisabled(true);
     m_ctagsUi.updateButton2->setDisabled(true);
 }
 
 
 /******************************************************************/
-void KateCTagsView::updateDone(int exitCode, QProcess::ExitStatus status)
+void KateCTagsView::updateProgress(int done, int total)
+{
+    m_ctagsUi.updateProgress->setRange(0, total);
+    m_ctagsUi.updateProgress->setValue(done);
+    m_ctagsUi.updateProgress->show();
+}
+
+
+/******************************************************************/
+void KateCTagsView::updateDone()
 {
-    if (status == QProcess::CrashExit) {
-        KMessageBox::error(m_toolView, i18n("The CTags executable crashed."));
-    } else if (exitCode != 0) {
-        KMessageBox::error(m_toolView, i18n("The CTags program exited with code %1: %2"
-        , exitCode
-        , QString::fromLocal8Bit(m_proc.readAllStandardError())));
+    if (!m_updater.errorString().isEmpty()) {
+        KMessageBox::error(m_toolView, m_updater.errorString());
     }
 
+    m_ctagsUi.updateProgress->hide();
     m_ctagsUi.updateButton->setDisabled(false);
     m_ctagsUi.updateButton2->setDisabled(false);
-    QApplication::restoreOverrideCursor();
 }
 
 /******************************************************************/
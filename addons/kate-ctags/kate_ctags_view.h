@@ -38,10 +38,11 @@
 #include <QPointer>
 
 #include "tags.h"
+#include "ctagsdbupdater.h"
 
 #include "ui_kate_ctags.h"
 
-const static QString DEFAULT_CTAGS_CMD = QLatin1String("ctags -R --c++-types=+px --extra=+q --excmd=pattern --exclude=Makefile --exclude=.");
+const static QString DEFAULT_CTAGS_CMD = QLatin1String("ctags -R --c++-types=+px --extra=+q --excmd=pattern --fields=+n --exclude=Makefile --exclude=.");
 
 typedef struct
 {
@@ -77,7 +78,8 @@ public Q_SLOTS:
     void delTagTarget();
     
     void updateSessionDB();
-    void updateDone(int exitCode, QProcess::ExitStatus status);
+    void updateProgress(int done, int total);
+    void updateDone();
 
 protected:
     bool eventFilter(QObject *obj, QEvent *ev);
@@ -95,7 +97,7 @@ private:
     void displayHits(const Tags::TagList &list);
     
     void gotoTagForTypes(const QString &tag, QStringList const &types);
-    void jumpToTag(const QString &file, const QString &pattern, const QString &word);
+    void jumpToTag(const QString &file, const QString &pattern, const QString &word, int line = -1);
     
 
     KTextEditor::MainWindow *m_mWin;
@@ -107,7 +109,7 @@ private:
     QAction               *m_gotoDec;
     QAction               *m_lookup;
 
-    QProcess               m_proc;
+    CTagsDbUpdater         m_updater;
     QString                m_commonDB;
 
     QTimer                 m_editTimer;
@@ -11,6 +11,10 @@
 #include "tags.h"
 #include <stdio.h>
 
+#include <QDateTime>
+#include <QFileInfo>
+#include <QHash>
+
 namespace ctags
 {
 #include "readtags.h"
@@ -20,38 +24,92 @@ namespace ctags
 
 QString Tags::_tagsfile;
 
-Tags::TagEntry::TagEntry() {}
+namespace
+{
+
+/**
+ * Keeps the tag files open between lookups, so lookup-as-you-type only pays
+ * for the binary search and not for opening the file and reading its header.
+ * A handle is reopened as soon as the file on disk changed.
+ */
+class TagsFileCache
+{
+public:
+	~TagsFileCache()
+	{
+		foreach ( const CachedFile & cached, m_files )
+		{
+			ctags::tagsClose( cached.file );
+		}
+	}
+
+	ctags::tagFile * file( const QString & fileName )
+	{
+		if ( fileName.isEmpty() ) return 0;
+
+		const QFileInfo fileInfo( fileName );
+		QHash<QString, CachedFile>::iterator it = m_files.find( fileName );
+
+		if ( it != m_files.end() )
+		{
+			if ( fileInfo.exists() && it->modified == fileInfo.lastModified() && it->size == fileInfo.size() )
+			{
+				return it->file;
+			}
+			ctags::tagsClose( it->file );
+			m_files.erase( it );
+		}
+
+		if ( !fileInfo.exists() ) return 0;
+
+		ctags::tagFileInfo info;
+		ctags::tagFile * file = ctags::tagsOpen( fileName.toLocal8Bit().constData(), &info );
+		if ( !file ) return 0;
 
-Tags::TagEntry::TagEntry( const QString & tag, const QString & type, const QString & file, const QString & pattern )
-	: tag(tag), type(type), file(file), pattern(pattern)
+		CachedFile cached;
+		cached.file = file;
+		cached.modified = fileInfo.lastModified();
+		cached.size = fileInfo.size();
+		m_files.insert( fileName, cached );
+
+		return file;
+	}
+
+private:
+	struct CachedFile
+	{
+		ctags::tagFile * file;
+		QDateTime modified;
+		qint64 size;
+	};
+
+	QHash<QString, CachedFile> m_files;
+};
+
+Q_GLOBAL_STATIC( TagsFileCache, s_tagsFileCache )
+
+}
+
+Tags::TagEntry::TagEntry() : line(-1) {}
+
+Tags::TagEntry::TagEntry( const QString & tag, const QString & type, const QString & file, const QString & pattern, int line )
+	: tag(tag), type(type), file(file), pattern(pattern), line(line)
 {}
 
 
 bool Tags::hasTag( const QString & tag )
 {
-	ctags::tagFileInfo info;
-	ctags::tagFile * file = ctags::tagsOpen( _tagsfile.toLocal8Bit().constData(), &info );
+	ctags::tagFile * file = s_tagsFileCache->file( _tagsfile );
 	ctags::tagEntry entry;
 
-	bool found = ( ctags::tagsFind( file, &entry, tag.toLocal8Bit().constData(), TAG_FULLMATCH | TAG_OBSERVECASE ) == ctags::TagSuccess );
-
-	ctags::tagsClose( file );
-
-	return found;
+	QByteArray tagBArray = tag.toLocal8Bit(); // for holding the char *
+	return ( ctags::tagsFind( file, &entry, tagBArray.constData(), TAG_FULLMATCH | TAG_OBSERVECASE ) == ctags::TagSuccess );
 }
 
 bool Tags::hasTag( const QString & fileName, const QString & tag )
 {
 	setTagsFile( fileName );
-	ctags::tagFileInfo info;
-	ctags::tagFile * file = ctags::tagsOpen( _tagsfile.toLocal8Bit().constData(), &info );
-	ctags::tagEntry entry;
-
-	bool found = ( ctags::tagsFind( file, &entry, tag.toLocal8Bit().constData(), TAG_FULLMATCH | TAG_OBSERVECASE ) == ctags::TagSuccess );
-
-	ctags::tagsClose( file );
-
-	return found;
+	return hasTag( tag );
 }
 
 unsigned int Tags::numberOfMatches( const QString & tagpart, bool partial )
@@ -60,8 +118,7 @@ unsigned int Tags::numberOfMatches( const QString & tagpart, bool partial )
 
 	if ( tagpart.isEmpty() ) return 0;
 
-	ctags::tagFileInfo info;
-	ctags::tagFile * file = ctags::tagsOpen( _tagsfile.toLocal8Bit().constData(), &info );
+	ctags::tagFile * file = s_tagsFileCache->file( _tagsfile );
 	ctags::tagEntry entry;
 
 	QByteArray tagpartBArray = tagpart.toLocal8Bit(); // for holding the char *
@@ -74,8 +131,6 @@ unsigned int Tags::numberOfMatches( const QString & tagpart, bool partial )
 		while ( ctags::tagsFindNext( file, &entry ) == ctags::TagSuccess );
 	}
 
-	ctags::tagsClose( file );
-
 	return n;
 }
 
@@ -85,8 +140,7 @@ Tags::TagList Tags::getMatches( const QString & tagpart, bool partial, const QSt
 
 	if ( tagpart.isEmpty() ) return list;
 
-	ctags::tagFileInfo info;
-	ctags::tagFile * file = ctags::tagsOpen( _tagsfile.toLocal8Bit().constData(), &info );
+	ctags::tagFile * file = s_tagsFileCache->file( _tagsfile );
 	ctags::tagEntry entry;
 
 	QByteArray tagpartBArray = tagpart.toLocal8Bit(); // for holding the char *
@@ -94,8 +148,8 @@ Tags::TagList Tags::getMatches( const QString & tagpart, bool partial, const QSt
 	{
 		do
 		{
-			QString type( CTagsKinds::findKind( entry.kind, QString::fromLocal8Bit(entry.file).section( QLatin1Char('.') , -1 ) ) );
 			QString file = QString::fromLocal8Bit( entry.file );
+			QString type( CTagsKinds::findKind( entry.kind, file.section( QLatin1Char('.') , -1 ) ) );
 
 			if ( type.isEmpty() && file.endsWith( QLatin1String("Makefile") ) )
 			{
@@ -103,14 +157,13 @@ Tags::TagList Tags::getMatches( const QString & tagpart, bool partial, const QSt
 			}
 			if ( types.isEmpty() || types.contains( QString::fromLocal8Bit(entry.kind) ) )
 			{
-				list << TagEntry( QString::fromLocal8Bit( entry.name ), type, file, QString::fromLocal8Bit( entry.address.pattern ) );
+				const int line = entry.address.lineNumber > 0 ? int( entry.address.lineNumber ) - 1 : -1;
+				list << TagEntry( QString::fromLocal8Bit( entry.name ), type, file, QString::fromLocal8Bit( entry.address.pattern ), line );
 			}
 		}
 		while ( ctags::tagsFindNext( file, &entry ) == ctags::TagSuccess );
 	}
 
-	ctags::tagsClose( file );
-
 	return list;
 }
 
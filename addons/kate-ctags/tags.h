@@ -23,12 +23,13 @@ public:
 	struct TagEntry
 	{
 		TagEntry();
-		TagEntry( const QString & tag, const QString & type, const QString & file, const QString & pattern );
+		TagEntry( const QString & tag, const QString & type, const QString & file, const QString & pattern, int line = -1 );
 
 		QString tag;
 		QString type;
 		QString file;
 		QString pattern;
+		int line; ///< 0-based line of the tag, -1 if the tags file has no line numbers
 	};
 
 	typedef QList<TagEntry> TagList;
@@ -0,0 +1,160 @@
+/*
+   Copyright (C) 2010  Marco Mentasti  <marcomentasti@gmail.com>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License version 2 as published by the Free Software Foundation.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "sqlcolumntest.h"
+#include "sqlcolumn.h"
+
+#include <QtTest>
+
+QTEST_MAIN(SQLColumnTest)
+
+void SQLColumnTest::testTypedValues()
+{
+  SQLColumn column;
+  column.append(QVariant(1));
+  column.append(QVariant(QVariant::Int));
+  column.append(QVariant(-3));
+
+  QCOMPARE(column.count(), 3);
+  QVERIFY(!column.isNull(0));
+  QVERIFY(column.isNull(1));
+  QVERIFY(!column.isNull(2));
+
+  QCOMPARE(column.value(0), QVariant(1));
+  QCOMPARE(column.value(0).type(), QVariant::Int);
+  QVERIFY(column.value(1).isNull());
+  QCOMPARE(column.value(1).type(), QVariant::Int);
+  QCOMPARE(column.value(2), QVariant(-3));
+
+  QCOMPARE(column.kind(0), SQLColumn::Number);
+  QCOMPARE(column.kind(1), SQLColumn::Number);
+
+  SQLColumn bools;
+  bools.append(QVariant(true));
+  bools.append(QVariant(false));
+
+  QCOMPARE(bools.value(0), QVariant(true));
+  QCOMPARE(bools.value(1), QVariant(false));
+  QCOMPARE(bools.kind(0), SQLColumn::Bool);
+}
+
+void SQLColumnTest::testLeadingNulls()
+{
+  SQLColumn column;
+  column.append(QVariant());
+  column.append(QVariant());
+  column.append(QVariant(QStringLiteral("text")));
+
+  QCOMPARE(column.count(), 3);
+  QVERIFY(column.isNull(0));
+  QVERIFY(column.isNull(1));
+  QVERIFY(column.value(1).isNull());
+  QCOMPARE(column.value(2), QVariant(QStringLiteral("text")));
+  QCOMPARE(column.kind(0), SQLColumn::Text);
+}
+
+void SQLColumnTest::testMixedTypes()
+{
+  SQLColumn column;
+  column.append(QVariant(1));
+  column.append(QVariant(QVariant::Int));
+  column.append(QVariant(QStringLiteral("two")));
+  column.append(QVariant(QByteArray("three")));
+
+  QCOMPARE(column.count(), 4);
+  QCOMPARE(column.value(0), QVariant(1));
+  QVERIFY(column.isNull(1));
+  QCOMPARE(column.value(2), QVariant(QStringLiteral("two")));
+  QCOMPARE(column.value(3), QVariant(QByteArray("three")));
+
+  QCOMPARE(column.kind(0), SQLColumn::Number);
+  QCOMPARE(column.kind(2), SQLColumn::Text);
+  QCOMPARE(column.kind(3), SQLColumn::Blob);
+}
+
+void SQLColumnTest::testAppendColumn()
+{
+  // batch sizes not aligned to the 32 bit words of the null bitmap
+  SQLColumn column;
+  SQLColumn expected;
+
+  for (int batch = 0; batch < 3; ++batch)
+  {
+    SQLColumn rows;
+
+    for (int i = 0; i < 45; ++i)
+    {
+      const QVariant value = ((i + batch) % 7 == 0) ? QVariant(QVariant::Double) : QVariant(i * 0.5);
+      rows.append(value);
+      expected.append(value);
+    }
+
+    column.append(rows);
+  }
+
+  QCOMPARE(column.count(), 135);
+
+  for (int i = 0; i < column.count(); ++i)
+  {
+    QCOMPARE(column.isNull(i), expected.isNull(i));
+    QCOMPARE(column.value(i), expected.value(i));
+  }
+
+  // a batch of nulls only
+  SQLColumn nulls;
+  nulls.append(QVariant());
+  nulls.append(QVariant());
+  column.append(nulls);
+
+  QCOMPARE(column.count(), 137);
+  QVERIFY(column.isNull(135));
+  QVERIFY(column.isNull(136));
+  QCOMPARE(column.value(136).type(), QVariant::Double);
+}
+
+void SQLColumnTest::testAppendOtherType()
+{
+  SQLColumn column;
+  column.append(QVariant(qlonglong(7)));
+
+  SQLColumn strings;
+  strings.append(QVariant(QStringLiteral("seven")));
+  strings.append(QVariant());
+
+  column.append(strings);
+
+  QCOMPARE(column.count(), 3);
+  QCOMPARE(column.value(0), QVariant(qlonglong(7)));
+  QCOMPARE(column.value(1), QVariant(QStringLiteral("seven")));
+  QVERIFY(column.isNull(2));
+  QCOMPARE(column.kind(0), SQLColumn::Number);
+  QCOMPARE(column.kind(1), SQLColumn::Text);
+}
+
+void SQLColumnTest::benchmarkAppend()
+{
+  SQLColumn rows;
+  for (int i = 0; i < 1000; ++i)
+    rows.append((i % 10 == 0) ? QVariant(QVariant::Int) : QVariant(i));
+
+  QBENCHMARK {
+    SQLColumn column;
+    for (int i = 0; i < 1000; ++i)
+      column.append(rows);
+  }
+}
@@ -0,0 +1,77 @@
+/*
+   Copyright (C) 2010  Marco Mentasti  <marcomentasti@gmail.com>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License version 2 as published by the Free Software Foundation.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "sqlexportertest.h"
+#include "sqlexporter.h"
+
+#include <QtTest>
+
+QTEST_MAIN(SQLExporterTest)
+
+void SQLExporterTest::testPlain()
+{
+  QString text;
+  QTextStream stream(&text);
+
+  SQLExportFormat format;
+  format.columnNames = true;
+
+  SQLExporter exporter(stream, format);
+  exporter.writeColumnNames(QStringList() << QStringLiteral("id") << QStringLiteral("name"));
+  exporter.writeRow(1, QVariantList() << QVariant(1) << QVariant(QStringLiteral("one")));
+  exporter.writeRow(2, QVariantList() << QVariant(QVariant::Int) << QVariant());
+  stream.flush();
+
+  QCOMPARE(text, QStringLiteral("id\tname\n1\tone\n\t\n"));
+}
+
+void SQLExporterTest::testQuoted()
+{
+  QString text;
+  QTextStream stream(&text);
+
+  SQLExportFormat format;
+  format.stringsQuoteChar = QLatin1Char('"');
+  format.numbersQuoteChar = QLatin1Char('\'');
+  format.fieldDelimiter = QStringLiteral(",");
+
+  SQLExporter exporter(stream, format);
+  exporter.writeRow(1, QVariantList() << QVariant(2.5) << QVariant(QStringLiteral("say \"hi\"")) << QVariant(true));
+  stream.flush();
+
+  QCOMPARE(text, QStringLiteral("'2.5',\"say \"\"hi\"\"\",'true'\n"));
+}
+
+void SQLExporterTest::testLineNumbers()
+{
+  QString text;
+  QTextStream stream(&text);
+
+  // the wizard passes escape sequences as typed
+  SQLExportFormat format;
+  format.fieldDelimiter = QStringLiteral("\\t");
+  format.columnNames = true;
+  format.lineNumbers = true;
+
+  SQLExporter exporter(stream, format);
+  exporter.writeColumnNames(QStringList() << QStringLiteral("a"));
+  exporter.writeRow(7, QVariantList() << QVariant(QStringLiteral("x")));
+  stream.flush();
+
+  QCOMPARE(text, QStringLiteral("\ta\n7\tx\n"));
+}
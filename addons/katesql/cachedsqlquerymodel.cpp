@@ -18,12 +18,26 @@ Boston, MA 02110-1301, USA.
 
 #include "cachedsqlquerymodel.h"
 
-#include <QDebug>
+CachedSqlQueryModel::CachedSqlQueryModel(QObject *parent)
+: QAbstractTableModel(parent)
+, m_rowCount(0)
+{
+}
 
-CachedSqlQueryModel::CachedSqlQueryModel(QObject *parent, int cacheCapacity)
-: QSqlQueryModel(parent)
-, cache(cacheCapacity)
+int CachedSqlQueryModel::rowCount(const QModelIndex &parent) const
 {
+  if (parent.isValid())
+    return 0;
+
+  return m_rowCount;
+}
+
+int CachedSqlQueryModel::columnCount(const QModelIndex &parent) const
+{
+  if (parent.isValid())
+    return 0;
+
+  return m_columns.count();
 }
 
 QVariant CachedSqlQueryModel::data(const QModelIndex &item, int role) const
@@ -31,87 +45,55 @@ QVariant CachedSqlQueryModel::data(const QModelIndex &item, int role) const
   if (!item.isValid())
     return QVariant();
 
-  if (role == Qt::EditRole)
-    return QSqlQueryModel::data(item, role);
-
-  if (role != Qt::DisplayRole)
+  if (role != Qt::DisplayRole && role != Qt::EditRole)
     return QVariant();
 
-  const int row = item.row();
-
-  return record(row).value(item.column());
+  return m_data.at(item.column()).value(item.row());
 }
 
-QSqlRecord CachedSqlQueryModel::record(int row) const
+QVariant CachedSqlQueryModel::headerData(int section, Qt::Orientation orientation, int role) const
 {
-  // if cache capacity is set to 0, don't use cache
-  if (cacheCapacity() == 0)
-    return QSqlQueryModel::record(row);
-
-  const int lookAhead = cacheCapacity() / 5;
-  const int halfLookAhead = lookAhead / 2;
-
-  if (row > cache.lastIndex())
-  {
-    if (row - cache.lastIndex() > lookAhead)
-      cacheRecords(row - halfLookAhead, qMin(rowCount(), row + halfLookAhead));
-    else
-    {
-      int until = qMin(rowCount(), cache.lastIndex() + lookAhead);
-
-      while (cache.lastIndex() < until)
-        cache.append(QSqlQueryModel::record(cache.lastIndex() + 1));
-    }
-  }
-  else if (row < cache.firstIndex())
-  {
-    if (cache.firstIndex() - row > lookAhead)
-      cacheRecords(qMax(0, row - halfLookAhead), row + halfLookAhead);
-    else
-    {
-      int until = qMax(0, cache.firstIndex() - lookAhead);
-
-      while (cache.firstIndex() > until)
-        cache.prepend(QSqlQueryModel::record(cache.firstIndex() - 1));
-    }
-  }
-
-  return cache.at(row);
+  if (orientation == Qt::Horizontal && role == Qt::DisplayRole && section < m_columns.count())
+    return m_columns.at(section);
+
+  return QAbstractTableModel::headerData(section, orientation, role);
 }
 
-void CachedSqlQueryModel::clear()
+void CachedSqlQueryModel::setColumns(const QStringList &columns)
 {
-  clearCache();
+  beginResetModel();
 
-  QSqlQueryModel::clear();
+  m_columns = columns;
+  m_data = QVector<SQLColumn>(columns.count());
+  m_rowCount = 0;
+
+  endResetModel();
 }
 
-void CachedSqlQueryModel::cacheRecords(int from, int to) const
+void CachedSqlQueryModel::appendRows(const SQLRowBatch &rows)
 {
-  qDebug() << "caching records from" << from << "to" << to;
+  if (rows.count() != m_data.count() || rows.isEmpty() || rows.first().count() == 0)
+    return;
 
-  for (int i = from; i <= to; ++i)
-    cache.insert(i, QSqlQueryModel::record(i));
-}
+  const int count = rows.first().count();
 
-void CachedSqlQueryModel::clearCache()
-{
-  cache.clear();
-}
+  beginInsertRows(QModelIndex(), m_rowCount, m_rowCount + count - 1);
 
-int CachedSqlQueryModel::cacheCapacity() const
-{
-  return cache.capacity();
-}
+  for (int i = 0; i < m_data.count(); ++i)
+    m_data[i].append(rows.at(i));
 
-void CachedSqlQueryModel::setCacheCapacity(int capacity)
-{
-  qDebug() << "cache capacity set to" << capacity;
+  m_rowCount += count;
 
-  cache.setCapacity(capacity);
+  endInsertRows();
 }
 
-void CachedSqlQueryModel::queryChange()
+void CachedSqlQueryModel::clear()
 {
-  clearCache();
+  beginResetModel();
+
+  m_columns.clear();
+  m_data.clear();
+  m_rowCount = 0;
+
+  endResetModel();
 }
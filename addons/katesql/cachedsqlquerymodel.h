@@ -19,33 +19,34 @@ Boston, MA 02110-1301, USA.
 #ifndef CACHEDSQLQUERYMODEL_H
 #define CACHEDSQLQUERYMODEL_H
 
-#include <qsqlquerymodel.h>
-#include <qsqlrecord.h>
-#include <qcontiguouscache.h>
+#include "sqlqueryworker.h"
 
-class CachedSqlQueryModel : public QSqlQueryModel
+#include <qabstractitemmodel.h>
+
+/// holds the rows of a result set, filled in batches while the query runs
+///
+/// The values are kept column by column, see SQLColumn.
+class CachedSqlQueryModel : public QAbstractTableModel
 {
   Q_OBJECT
 public:
-  explicit CachedSqlQueryModel(QObject *parent = 0, int cacheCapacity = 1000);
+  explicit CachedSqlQueryModel(QObject *parent = 0);
 
+  int rowCount(const QModelIndex &parent = QModelIndex()) const;
+  int columnCount(const QModelIndex &parent = QModelIndex()) const;
   QVariant data(const QModelIndex &item, int role = Qt::DisplayRole) const;
-  QSqlRecord record(int row) const;
-  void clear();
-
-  int cacheCapacity() const;
+  QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
 
-public Q_SLOTS:
-  void clearCache();
-  void setCacheCapacity(int);
+  void setColumns(const QStringList &columns);
+  void appendRows(const SQLRowBatch &rows);
+  void clear();
 
-  protected:
-    virtual void queryChange();
+  const SQLColumn &column(int column) const { return m_data.at(column); }
 
 private:
-  void cacheRecords(int from, int to) const;
-
-  mutable QContiguousCache<QSqlRecord> cache;
+  QStringList m_columns;
+  QVector<SQLColumn> m_data;
+  int m_rowCount;
 };
 
 #endif // CACHEDSQLQUERYMODEL_H
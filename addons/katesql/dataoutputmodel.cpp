@@ -27,14 +27,8 @@
 #include <QFontDatabase>
 #include <QLocale>
 
-inline bool isNumeric(const QVariant::Type type)
-{
-  return (type > 1 && type < 7);
-}
-
-
 DataOutputModel::DataOutputModel(QObject *parent)
-: CachedSqlQueryModel(parent, 1000)
+: CachedSqlQueryModel(parent)
 {
   m_useSystemLocale = false;
 
@@ -45,6 +39,13 @@ DataOutputModel::DataOutputModel(QObject *parent)
   m_styles.insert(QLatin1String ("datetime"), new OutputStyle());
   m_styles.insert(QLatin1String ("bool"),     new OutputStyle());
 
+  m_kindStyles[SQLColumn::Text]     = m_styles.value(QLatin1String ("text"));
+  m_kindStyles[SQLColumn::Number]   = m_styles.value(QLatin1String ("number"));
+  m_kindStyles[SQLColumn::Bool]     = m_styles.value(QLatin1String ("bool"));
+  m_kindStyles[SQLColumn::DateTime] = m_styles.value(QLatin1String ("datetime"));
+  m_kindStyles[SQLColumn::Blob]     = m_styles.value(QLatin1String ("blob"));
+  m_nullStyle                       = m_styles.value(QLatin1String ("null"));
+
   readConfig();
 }
 
@@ -55,16 +56,6 @@ DataOutputModel::~DataOutputModel()
 }
 
 
-void DataOutputModel::clear()
-{
-  beginResetModel();
-
-  CachedSqlQueryModel::clear();
-
-  endResetModel();
-}
-
-
 void DataOutputModel::readConfig()
 {
   KConfigGroup config(KSharedConfig::openConfig(), "KateSQLPlugin");
@@ -113,81 +104,66 @@ void DataOutputModel::setUseSystemLocale( bool useSystemLocale )
 
 QVariant DataOutputModel::data(const QModelIndex &index, int role) const
 {
+  if (!index.isValid())
+    return QVariant();
+
   if (role == Qt::EditRole)
     return CachedSqlQueryModel::data(index, role);
 
-  const QVariant value(CachedSqlQueryModel::data(index, Qt::DisplayRole));
-  const QVariant::Type type = value.type();
+  const SQLColumn &values = column(index.column());
+  const int row = index.row();
+  const bool null = values.isNull(row);
+  const SQLColumn::Kind kind = values.kind(row);
 
-  if (value.isNull())
-  {
-    if (role == Qt::FontRole)
-      return QVariant(m_styles.value(QLatin1String ("null"))->font);
-    if (role == Qt::ForegroundRole)
-      return QVariant(m_styles.value(QLatin1String ("null"))->foreground);
-    if (role == Qt::BackgroundRole)
-      return QVariant(m_styles.value(QLatin1String ("null"))->background);
-    if (role == Qt::DisplayRole)
-      return QVariant(QLatin1String ("NULL"));
-  }
+  const OutputStyle *style = null ? m_nullStyle : m_kindStyles[kind];
 
-  if (type == QVariant::ByteArray)
+  switch (role)
   {
-    if (role == Qt::FontRole)
-      return QVariant(m_styles.value(QLatin1String ("blob"))->font);
-    if (role == Qt::ForegroundRole)
-      return QVariant(m_styles.value(QLatin1String ("blob"))->foreground);
-    if (role == Qt::BackgroundRole)
-      return QVariant(m_styles.value(QLatin1String ("blob"))->background);
-    if (role == Qt::DisplayRole)
-      return QVariant(value.toByteArray().left(255));
+    case Qt::FontRole:
+      return QVariant(style->font);
+    case Qt::ForegroundRole:
+      return QVariant(style->foreground);
+    case Qt::BackgroundRole:
+      return QVariant(style->background);
+    case Qt::TextAlignmentRole:
+      if (kind == SQLColumn::Number)
+        return QVariant(Qt::AlignRight | Qt::AlignVCenter);
+      return QVariant(Qt::AlignVCenter);
+    case Qt::DisplayRole:
+    case Qt::UserRole:
+      break;
+    default:
+      return QVariant();
   }
 
-  if (isNumeric(type))
+  if (null && role == Qt::DisplayRole)
+    return QVariant(QLatin1String ("NULL"));
+
+  const QVariant value(values.value(row));
+
+  switch (kind)
   {
-    if (role == Qt::FontRole)
-      return QVariant(m_styles.value(QLatin1String ("number"))->font);
-    if (role == Qt::ForegroundRole)
-      return QVariant(m_styles.value(QLatin1String ("number"))->foreground);
-    if (role == Qt::BackgroundRole)
-      return QVariant(m_styles.value(QLatin1String ("number"))->background);
-    if (role == Qt::TextAlignmentRole)
-      return QVariant(Qt::AlignRight | Qt::AlignVCenter);
-    if (role == Qt::DisplayRole || role == Qt::UserRole)
-    {
+    case SQLColumn::Blob:
+      if (role == Qt::DisplayRole)
+        return QVariant(value.toByteArray().left(255));
+      return value;
+
+    case SQLColumn::Number:
       if (useSystemLocale())
         return QVariant(value.toString()); //FIXME KF5 KGlobal::locale()->formatNumber(value.toString(), false));
       else
         return QVariant(value.toString());
-    }
-  }
 
-  if (type == QVariant::Bool)
-  {
-    if (role == Qt::FontRole)
-      return QVariant(m_styles.value(QLatin1String ("bool"))->font);
-    if (role == Qt::ForegroundRole)
-      return QVariant(m_styles.value(QLatin1String ("bool"))->foreground);
-    if (role == Qt::BackgroundRole)
-      return QVariant(m_styles.value(QLatin1String ("bool"))->background);
-    if (role == Qt::DisplayRole)
-      return QVariant(value.toBool() ? QLatin1String ("True") : QLatin1String ("False"));
-  }
+    case SQLColumn::Bool:
+      if (role == Qt::DisplayRole)
+        return QVariant(value.toBool() ? QLatin1String ("True") : QLatin1String ("False"));
+      return value;
 
-  if (type == QVariant::Date ||
-      type == QVariant::Time ||
-      type == QVariant::DateTime )
-  {
-    if (role == Qt::FontRole)
-      return QVariant(m_styles.value(QLatin1String ("datetime"))->font);
-    if (role == Qt::ForegroundRole)
-      return QVariant(m_styles.value(QLatin1String ("datetime"))->foreground);
-    if (role == Qt::BackgroundRole)
-      return QVariant(m_styles.value(QLatin1String ("datetime"))->background);
-    if (role == Qt::DisplayRole || role == Qt::UserRole)
-    {
+    case SQLColumn::DateTime:
       if (useSystemLocale())
       {
+        const QVariant::Type type = value.type();
+
         if (type == QVariant::Date)
           return QVariant(QLocale().toString(value.toDate(), QLocale::ShortFormat));
         if (type == QVariant::Time)
@@ -195,23 +171,12 @@ QVariant DataOutputModel::data(const QModelIndex &index, int role) const
         if (type == QVariant::DateTime)
           return QVariant(QLocale().toString(value.toDateTime(), QLocale::ShortFormat));
       }
-      else // return sql server format
-        return QVariant(value.toString());
-    }
-  }
+      // return sql server format
+      return QVariant(value.toString());
 
-  if (role == Qt::FontRole)
-    return QVariant(m_styles.value(QLatin1String ("text"))->font);
-  if (role == Qt::ForegroundRole)
-    return QVariant(m_styles.value(QLatin1String ("text"))->foreground);
-  if (role == Qt::BackgroundRole)
-    return QVariant(m_styles.value(QLatin1String ("text"))->background);
-  if (role == Qt::TextAlignmentRole)
-    return QVariant(Qt::AlignVCenter);
-  if (role == Qt::DisplayRole)
-    return value.toString();
-  if (role == Qt::UserRole)
-    return value;
-
-  return CachedSqlQueryModel::data(index, role);
+    default:
+      if (role == Qt::DisplayRole)
+        return value.toString();
+      return value;
+  }
 }
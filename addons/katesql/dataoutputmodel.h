@@ -41,11 +41,15 @@ class DataOutputModel : public CachedSqlQueryModel
 
     QVariant data ( const QModelIndex & index, int role = Qt::DisplayRole ) const;
 
-    void clear();
     void readConfig();
 
   private:
     QHash<QString,OutputStyle*> m_styles;
+
+    /// the entries of m_styles by value kind, data() runs for every painted cell
+    OutputStyle *m_kindStyles[SQLColumn::KindCount];
+    OutputStyle *m_nullStyle;
+
     bool m_useSystemLocale;
 };
 
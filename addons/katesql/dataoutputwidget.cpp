@@ -34,23 +34,30 @@
 #include <kmessagebox.h>
 
 #include <qheaderview.h>
+#include <qlabel.h>
 #include <qlayout.h>
-#include <qsqlquery.h>
-#include <qsqlerror.h>
 #include <qsize.h>
 #include <qclipboard.h>
 #include <qtextstream.h>
-#include <qfile.h>
+#include <qsavefile.h>
 #include <qtimer.h>
 #include <QApplication>
 #include <QClipboard>
+#include <QLocale>
 #include <QTime>
 
+#include <algorithm>
+
 DataOutputWidget::DataOutputWidget(QWidget *parent)
 : QWidget(parent)
 , m_model(new DataOutputModel(this))
 , m_view(new DataOutputView(this))
+, m_progress(new QLabel(this))
+, m_exportAction(0)
 , m_isEmpty(true)
+, m_resizePending(false)
+, m_streamExport(false)
+, m_fetching(false)
 {
   m_view->setModel(m_model);
 
@@ -79,10 +86,10 @@ DataOutputWidget::DataOutputWidget(QWidget *parent)
   m_view->addAction(action);
   connect(action, SIGNAL(triggered()), this, SLOT(slotCopySelected()));
 
-  action = new QAction( QIcon::fromTheme(QLatin1String("document-export-table")), i18nc("@action:intoolbar", "Export..."), this);
-  toolbar->addAction(action);
-  m_view->addAction(action);
-  connect(action, SIGNAL(triggered()), this, SLOT(slotExport()));
+  m_exportAction = new QAction( QIcon::fromTheme(QLatin1String("document-export-table")), i18nc("@action:intoolbar", "Export..."), this);
+  toolbar->addAction(m_exportAction);
+  m_view->addAction(m_exportAction);
+  connect(m_exportAction, SIGNAL(triggered()), this, SLOT(slotExport()));
 
   action = new QAction( QIcon::fromTheme(QLatin1String("edit-clear")), i18nc("@action:intoolbar", "Clear"), this);
   toolbar->addAction(action);
@@ -95,6 +102,7 @@ DataOutputWidget::DataOutputWidget(QWidget *parent)
   connect(toggleAction, SIGNAL(triggered()), this, SLOT(slotToggleLocale()));
 
   m_dataLayout->addWidget(m_view);
+  m_dataLayout->addWidget(m_progress);
 
   layout->addWidget(toolbar);
   layout->addLayout(m_dataLayout);
@@ -109,35 +117,68 @@ DataOutputWidget::~DataOutputWidget()
 }
 
 
-void DataOutputWidget::showQueryResultSets(QSqlQuery &query)
+void DataOutputWidget::showQueryResultSets(const QStringList &columns)
 {
   /// TODO: loop resultsets if > 1
   /// NOTE from Qt Documentation:
   /// When one of the statements is a non-select statement a count of affected rows
   /// may be available instead of a result set.
 
-  if (!query.isSelect() || query.lastError().isValid())
-    return;
-
-  m_model->setQuery(query);
+  m_model->setColumns(columns);
 
   m_isEmpty = false;
+  m_resizePending = true;
 
-  QTimer::singleShot(0, this, SLOT(resizeColumnsToContents()));
+  m_progress->setText(i18nc("@info", "Fetching rows..."));
 
   raise();
 }
 
 
+void DataOutputWidget::appendRows(const SQLRowBatch &rows)
+{
+  m_model->appendRows(rows);
+
+  // size the columns on the first rows, later batches would make them jump around
+  if (m_resizePending)
+  {
+    m_resizePending = false;
+
+    QTimer::singleShot(0, this, SLOT(resizeColumnsToContents()));
+  }
+}
+
+
+void DataOutputWidget::showProgress(int rows, qint64 msecs)
+{
+  const QLocale locale;
+  const QString seconds = locale.toString(msecs / 1000.0, 'f', 2);
+
+  if (msecs > 0)
+    m_progress->setText(i18ncp("@info", "%1 row in %2 seconds (%3 rows/s)", "%1 rows in %2 seconds (%3 rows/s)", rows, seconds, locale.toString(qint64(rows) * 1000 / msecs)));
+  else
+    m_progress->setText(i18ncp("@info", "%1 row", "%1 rows", rows));
+}
+
+
+void DataOutputWidget::showExportProgress(int rows, qint64 msecs)
+{
+  const QLocale locale;
+
+  m_progress->setText(i18ncp("@info", "%1 row exported in %2 seconds", "%1 rows exported in %2 seconds", rows, locale.toString(msecs / 1000.0, 'f', 2)));
+}
+
+
 void DataOutputWidget::clearResults()
 {
-  // avoid crash when calling QSqlQueryModel::clear() after removing connection from the QSqlDatabase list
   if (m_isEmpty)
     return;
 
   m_model->clear();
+  m_progress->clear();
 
   m_isEmpty = true;
+  m_resizePending = false;
 
   /// HACK needed to refresh headers. please correct if there's a better way
   m_view->horizontalHeader()->hide();
@@ -148,6 +189,35 @@ void DataOutputWidget::clearResults()
 }
 
 
+void DataOutputWidget::setStreamExport(bool stream)
+{
+  m_streamExport = stream;
+}
+
+
+void DataOutputWidget::setFetching(bool fetching)
+{
+  m_fetching = fetching;
+
+  // the shown rows are not complete yet, an export would cut them short
+  m_exportAction->setEnabled(!fetching);
+}
+
+
+bool DataOutputWidget::exportsAllResults() const
+{
+  const QItemSelection selection = m_view->selectionModel()->selection();
+
+  if (selection.count() != 1)
+    return false;
+
+  const QItemSelectionRange &range = selection.first();
+
+  return range.top() == 0 && range.bottom() == m_model->rowCount() - 1
+      && range.left() == 0 && range.right() == m_model->columnCount() - 1;
+}
+
+
 void DataOutputWidget::resizeColumnsToContents()
 {
   if (m_model->rowCount() == 0)
@@ -182,9 +252,6 @@ void DataOutputWidget::slotCopySelected()
   if (m_model->rowCount() <= 0)
     return;
 
-  while (m_model->canFetchMore())
-    m_model->fetchMore();
-
   if (!m_view->selectionModel()->hasSelection())
     m_view->selectAll();
 
@@ -200,12 +267,9 @@ void DataOutputWidget::slotCopySelected()
 
 void DataOutputWidget::slotExport()
 {
-  if (m_model->rowCount() <= 0)
+  if (m_fetching || m_model->rowCount() <= 0)
     return;
 
-  while (m_model->canFetchMore())
-    m_model->fetchMore();
-
   if (!m_view->selectionModel()->hasSelection())
     m_view->selectAll();
 
@@ -263,20 +327,40 @@ void DataOutputWidget::slotExport()
   }
   else if (outputInFile)
   {
-    QString url = wizard.field(QLatin1String ("outFileUrl")).toString();
-    QFile data(url);
-    if (data.open(QFile::WriteOnly | QFile::Truncate))
+    const QString url = wizard.field(QLatin1String ("outFileUrl")).toString();
+
+    if (m_streamExport && exportsAllResults())
     {
-      QTextStream stream(&data);
+      // written by a worker thread straight from the query, the results
+      // shown here may be only part of a much larger result set
+      SQLExportFormat format;
+      format.stringsQuoteChar = stringsQuoteChar;
+      format.numbersQuoteChar = numbersQuoteChar;
+      format.fieldDelimiter = fieldDelimiter;
+      format.columnNames = exportColumnNames;
+      format.lineNumbers = exportLineNumbers;
+
+      emit exportRequested(url, format);
+      return;
+    }
 
-      exportData(stream, stringsQuoteChar, numbersQuoteChar, fieldDelimiter, opt);
+    // a selection, or a statement that must not run twice: write the shown rows
+    QSaveFile file(url);
 
-      stream.flush();
-    }
-    else
+    if (!file.open(QFile::WriteOnly))
     {
       KMessageBox::error(this, xi18nc("@info", "Unable to open file <filename>%1</filename>", url));
+      return;
     }
+
+    QTextStream stream(&file);
+
+    exportData(stream, stringsQuoteChar, numbersQuoteChar, fieldDelimiter, opt);
+
+    stream.flush();
+
+    if (stream.status() != QTextStream::Ok || !file.commit())
+      KMessageBox::error(this, xi18nc("@info", "Unable to write file <filename>%1</filename>", url));
   }
 }
 
@@ -292,87 +376,72 @@ void DataOutputWidget::exportData(QTextStream &stream,
   if (!selectionModel->hasSelection())
     return;
 
-  QString fixedFieldDelimiter = fieldDelimiter;
-
-  /// FIXME: ugly workaround...
-  fixedFieldDelimiter = fixedFieldDelimiter.replace(QLatin1String ("\\t"), QLatin1String ("\t"));
-  fixedFieldDelimiter = fixedFieldDelimiter.replace(QLatin1String ("\\r"), QLatin1String ("\r"));
-  fixedFieldDelimiter = fixedFieldDelimiter.replace(QLatin1String ("\\n"), QLatin1String ("\n"));
-
   QTime t;
   t.start();
 
-  QSet<int> columns;
-  QSet<int> rows;
-  QHash<QPair<int,int>,QString> snapshot;
+  const QItemSelection selection = selectionModel->selection();
 
-  const QModelIndexList selectedIndexes = selectionModel->selectedIndexes();
+  // the columns and row spans of the selection, in model order
+  QList<int> columns;
+  QList<QPair<int,int> > rowSpans;
 
-  snapshot.reserve(selectedIndexes.count());
-
-  foreach (const QModelIndex& index, selectedIndexes)
+  foreach (const QItemSelectionRange &range, selection)
   {
-    const QVariant data = index.data(Qt::UserRole);
-
-    const int col = index.column();
-    const int row = index.row();
-
-    if (!columns.contains(col))
-      columns.insert(col);
-    if (!rows.contains(row))
-      rows.insert(row);
-
-    if (data.type() < 7) // is numeric or boolean
+    for (int col = range.left(); col <= range.right(); ++col)
     {
-      if (numbersQuoteChar != QLatin1Char ('\0'))
-        snapshot[qMakePair(row,col)] = numbersQuoteChar + data.toString() + numbersQuoteChar;
-      else
-        snapshot[qMakePair(row,col)] = data.toString();
-    }
-    else
-    {
-      if (stringsQuoteChar != QLatin1Char ('\0'))
-        snapshot[qMakePair(row,col)] = stringsQuoteChar + data.toString() + stringsQuoteChar;
-      else
-        snapshot[qMakePair(row,col)] = data.toString();
+      if (!columns.contains(col))
+        columns << col;
     }
+    rowSpans << qMakePair(range.top(), range.bottom());
   }
 
-  if (opt.testFlag(ExportColumnNames))
-  {
-    if (opt.testFlag(ExportLineNumbers))
-      stream << fixedFieldDelimiter;
+  std::sort(columns.begin(), columns.end());
+  std::sort(rowSpans.begin(), rowSpans.end());
 
-    QSetIterator<int> j(columns);
-    while (j.hasNext())
-    {
-      const QVariant data = m_model->headerData(j.next(), Qt::Horizontal);
+  SQLExportFormat format;
+  format.stringsQuoteChar = stringsQuoteChar;
+  format.numbersQuoteChar = numbersQuoteChar;
+  format.fieldDelimiter = fieldDelimiter;
+  format.columnNames = opt.testFlag(ExportColumnNames);
+  format.lineNumbers = opt.testFlag(ExportLineNumbers);
 
-      if (stringsQuoteChar != QLatin1Char ('\0'))
-        stream << stringsQuoteChar + data.toString() + stringsQuoteChar;
-      else
-        stream << data.toString();
+  SQLExporter exporter(stream, format);
 
-      if (j.hasNext())
-        stream << fixedFieldDelimiter;
-    }
-    stream << "\n";
+  if (format.columnNames)
+  {
+    QStringList names;
+    foreach (const int col, columns)
+      names << m_model->headerData(col, Qt::Horizontal).toString();
+
+    exporter.writeColumnNames(names);
   }
 
-  foreach(const int row, rows)
-  {
-    if (opt.testFlag(ExportLineNumbers))
-      stream << row + 1 << fixedFieldDelimiter;
+  // cells of the spanned rows and columns outside of the selection stay empty
+  const bool rectangular = (selection.count() == 1);
+
+  QVariantList values;
+  int nextRow = 0;
 
-    QSetIterator<int> j(columns);
-    while (j.hasNext())
+  for (int i = 0; i < rowSpans.count(); ++i)
+  {
+    for (int row = qMax(nextRow, rowSpans.at(i).first); row <= rowSpans.at(i).second; ++row)
     {
-      stream << snapshot.value(qMakePair(row,j.next()));
+      values.clear();
+
+      foreach (const int col, columns)
+      {
+        const QModelIndex index = m_model->index(row, col);
 
-      if (j.hasNext())
-        stream << fixedFieldDelimiter;
+        if (rectangular || selectionModel->isSelected(index))
+          values << index.data(Qt::EditRole);
+        else
+          values << QVariant();
+      }
+
+      exporter.writeRow(row + 1, values);
     }
-    stream << "\n";
+
+    nextRow = qMax(nextRow, rowSpans.at(i).second + 1);
   }
 
   qDebug() << "Export in" << t.elapsed() << "msecs";
@@ -21,10 +21,14 @@
 
 class QTextStream;
 class QVBoxLayout;
-class QSqlQuery;
+class QLabel;
+class QAction;
 class DataOutputModel;
 class DataOutputView;
 
+#include "sqlexporter.h"
+#include "sqlqueryworker.h"
+
 #include <qwidget.h>
 
 class DataOutputWidget : public QWidget
@@ -53,23 +57,41 @@ class DataOutputWidget : public QWidget
     DataOutputView  *view()  const { return m_view; }
 
   public Q_SLOTS:
-    void showQueryResultSets(QSqlQuery &query);
+    void showQueryResultSets(const QStringList &columns);
+    void appendRows(const SQLRowBatch &rows);
+    void showProgress(int rows, qint64 msecs);
+    void showExportProgress(int rows, qint64 msecs);
     void resizeColumnsToContents();
     void resizeRowsToContents();
     void clearResults();
+    void setStreamExport(bool stream);
+    void setFetching(bool fetching);
 
     void slotToggleLocale();
     void slotCopySelected();
     void slotExport();
 
+  Q_SIGNALS:
+    /// the whole result set should be written to @p fileName
+    void exportRequested(const QString &fileName, const SQLExportFormat &format);
+
   private:
+    bool exportsAllResults() const;
+
     QVBoxLayout *m_dataLayout;
 
     /// TODO: manage multiple views for query with multiple resultsets
     DataOutputModel *m_model;
     DataOutputView *m_view;
+    QLabel *m_progress;
+    QAction *m_exportAction;
 
     bool m_isEmpty;
+    bool m_resizePending;
+
+    /// files get the whole result set by running the query again
+    bool m_streamExport;
+    bool m_fetching;
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(DataOutputWidget::Options)
@@ -46,7 +46,7 @@
 
 #include <qmenu.h>
 #include <qstring.h>
-#include <qsqlquery.h>
+#include <qsqldatabase.h>
 #include <QVBoxLayout>
 #include <QApplication>
 
@@ -54,6 +54,7 @@ KateSQLView::KateSQLView(KTextEditor::Plugin *plugin, KTextEditor::MainWindow *m
 : QObject (mw)
 , KXMLGUIClient()
 , m_manager (new SQLManager(this))
+, m_queryHasResults (false)
 , m_mainWindow (mw)
 {
   KXMLGUIClient::setComponentName (QLatin1String("katesql"), i18n ("Kate SQL Plugin"));
@@ -94,12 +95,19 @@ KateSQLView::KateSQLView(KTextEditor::Plugin *plugin, KTextEditor::MainWindow *m
 
   connect(m_manager, SIGNAL(error(QString)), this, SLOT(slotError(QString)));
   connect(m_manager, SIGNAL(success(QString)), this, SLOT(slotSuccess(QString)));
-  connect(m_manager, SIGNAL(queryActivated(QSqlQuery&,QString)), this, SLOT(slotQueryActivated(QSqlQuery&,QString)));
+  connect(m_manager, SIGNAL(queryActivated(QStringList,QString)), this, SLOT(slotQueryActivated(QStringList,QString)));
+  connect(m_manager, SIGNAL(rowsFetched(SQLRowBatch)), m_outputWidget->dataOutputWidget(), SLOT(appendRows(SQLRowBatch)));
+  connect(m_manager, SIGNAL(queryProgress(int,qint64)), m_outputWidget->dataOutputWidget(), SLOT(showProgress(int,qint64)));
+  connect(m_manager, SIGNAL(queryRunning(bool)), this, SLOT(slotQueryRunning(bool)));
+  connect(m_manager, SIGNAL(exportProgress(int,qint64)), m_outputWidget->dataOutputWidget(), SLOT(showExportProgress(int,qint64)));
+  connect(m_outputWidget->dataOutputWidget(), SIGNAL(exportRequested(QString,SQLExportFormat)), m_manager, SLOT(exportResults(QString,SQLExportFormat)));
   connect(m_manager, SIGNAL(connectionCreated(QString)), this, SLOT(slotConnectionCreated(QString)));
   connect(m_manager, SIGNAL(connectionAboutToBeClosed(QString)), this, SLOT(slotConnectionAboutToBeClosed(QString)));
   connect(m_connectionsComboBox, SIGNAL(currentIndexChanged(QString)), this, SLOT(slotConnectionChanged(QString)));
 
   stateChanged(QLatin1String ("has_connection_selected"), KXMLGUIClient::StateReverse);
+
+  slotQueryRunning(false);
 }
 
 
@@ -150,12 +158,11 @@ void KateSQLView::setupActions()
   collection->setDefaultShortcut(action, QKeySequence(Qt::CTRL + Qt::Key_E) );
   connect( action , SIGNAL(triggered()) , this , SLOT(slotRunQuery()));
 
-  /// TODO: stop sql query
-  //   action = collection->addAction("sql_stop");
-  //   action->setText( i18n("Stop query") );
-  //   action->setIcon( KIcon("process-stop") );
-  //   action->setShortcut( QKeySequence(Qt::ALT + Qt::Key_F5) );
-  //   connect( action , SIGNAL(triggered()) , this , SLOT(stopQuery()));
+  action = collection->addAction(QLatin1String ("query_stop"));
+  action->setText( i18nc("@action:inmenu", "Stop query") );
+  action->setIcon( QIcon::fromTheme (QLatin1String ("process-stop")) );
+  collection->setDefaultShortcut(action, QKeySequence(Qt::ALT + Qt::Key_F5) );
+  connect( action , SIGNAL(triggered()) , m_manager , SLOT(cancelQuery()));
 }
 
 
@@ -314,7 +321,7 @@ void KateSQLView::slotConnectionReconnect()
 
 void KateSQLView::slotConnectionAboutToBeClosed (const QString& name)
 {
-  /// must delete the QSqlQuery object inside the model before closing connection
+  /// the shown results belong to the connection going away
 
   if (name == m_currentResultsetConnection)
     m_outputWidget->dataOutputWidget()->clearResults();
@@ -345,6 +352,8 @@ void KateSQLView::slotRunQuery()
   if (text.isEmpty())
     return;
 
+  m_queryHasResults = false;
+
   m_manager->runQuery(text, connection);
 }
 
@@ -361,23 +370,32 @@ void KateSQLView::slotError(const QString &message)
 void KateSQLView::slotSuccess(const QString &message)
 {
   m_outputWidget->textOutputWidget()->showSuccessMessage(message);
-  m_outputWidget->setCurrentWidget(m_outputWidget->textOutputWidget());
+
+  if (!m_queryHasResults)
+    m_outputWidget->setCurrentWidget(m_outputWidget->textOutputWidget());
+
   m_mainWindow->showToolView(m_outputToolView);
 
 }
 
 
-void KateSQLView::slotQueryActivated(QSqlQuery &query, const QString &connection)
+void KateSQLView::slotQueryActivated(const QStringList &columns, const QString &connection)
 {
-  if (query.isSelect())
-  {
-    m_currentResultsetConnection = connection;
+  m_currentResultsetConnection = connection;
+  m_queryHasResults = true;
 
-    m_outputWidget->dataOutputWidget()->showQueryResultSets(query);
-    m_outputWidget->setCurrentWidget(m_outputWidget->dataOutputWidget());
-    m_mainWindow->showToolView(m_outputToolView);
-    
-  }
+  m_outputWidget->dataOutputWidget()->showQueryResultSets(columns);
+  m_outputWidget->dataOutputWidget()->setStreamExport(m_manager->canExportResults());
+  m_outputWidget->setCurrentWidget(m_outputWidget->dataOutputWidget());
+  m_mainWindow->showToolView(m_outputToolView);
+}
+
+
+void KateSQLView::slotQueryRunning(bool running)
+{
+  action("query_stop")->setEnabled(running);
+
+  m_outputWidget->dataOutputWidget()->setFetching(running);
 }
 
 
@@ -26,7 +26,6 @@ class SQLManager;
 class KConfigBase;
 class KComboBox;
 
-class QSqlQuery;
 class QActionGroup;
 
 #include <KXMLGUIClient>
@@ -56,7 +55,8 @@ class KateSQLView : public QObject, public KXMLGUIClient
     void slotRunQuery();
     void slotError(const QString &message);
     void slotSuccess(const QString &message);
-    void slotQueryActivated(QSqlQuery &query, const QString &connection);
+    void slotQueryActivated(const QStringList &columns, const QString &connection);
+    void slotQueryRunning(bool running);
     void slotConnectionCreated(const QString &name);
     void slotGlobalSettingsChanged();
     void slotSQLMenuAboutToShow();
@@ -81,6 +81,9 @@ class KateSQLView : public QObject, public KXMLGUIClient
 
     QString m_currentResultsetConnection;
 
+    /// the last query returned rows, its messages stay behind the results
+    bool m_queryHasResults;
+
     KTextEditor::MainWindow *m_mainWindow;
 };
 
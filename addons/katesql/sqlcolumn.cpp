@@ -0,0 +1,278 @@
+/*
+   Copyright (C) 2010  Marco Mentasti  <marcomentasti@gmail.com>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License version 2 as published by the Free Software Foundation.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "sqlcolumn.h"
+
+SQLColumn::SQLColumn()
+: m_storage(Undecided)
+, m_type(QVariant::Invalid)
+, m_kind(Text)
+, m_count(0)
+{
+}
+
+
+void SQLColumn::append(const QVariant &value)
+{
+  const bool null = value.isNull();
+
+  if (!null && m_storage != Variants)
+  {
+    const QVariant::Type type = value.type();
+
+    if (m_storage == Undecided)
+      setStorage(storageOf(type), type);
+    else if (type != m_type)
+      toVariants();
+  }
+
+  const int row = m_count++;
+
+  if ((row & 31) == 0)
+    m_nulls << 0;
+
+  if (null)
+    m_nulls[row >> 5] |= 1u << (row & 31);
+
+  switch (m_storage)
+  {
+    case Undecided:
+      break;
+    case Integers:
+      m_integers << value.toLongLong();
+      break;
+    case Reals:
+      m_reals << value.toDouble();
+      break;
+    case Strings:
+      m_strings << value.toString();
+      break;
+    case Bytes:
+      m_bytes << value.toByteArray();
+      break;
+    case Variants:
+      m_variants << value;
+      break;
+  }
+}
+
+
+void SQLColumn::append(const SQLColumn &other)
+{
+  if (other.m_count == 0)
+    return;
+
+  if (m_count == 0)
+  {
+    *this = other;
+    return;
+  }
+
+  if (m_storage == Undecided && other.m_storage != Undecided)
+    setStorage(other.m_storage, other.m_type);
+
+  if (other.m_storage != Undecided && (other.m_storage != m_storage || other.m_type != m_type))
+    toVariants();
+
+  // shift the bitmap of other behind the last row
+  const int shift = m_count & 31;
+  const int first = m_count >> 5;
+
+  m_nulls.resize((m_count + other.m_count + 31) >> 5);
+
+  for (int i = 0; i < other.m_nulls.size(); ++i)
+  {
+    const quint32 bits = other.m_nulls.at(i);
+
+    if (!bits)
+      continue;
+
+    m_nulls[first + i] |= bits << shift;
+
+    if (shift && first + i + 1 < m_nulls.size())
+      m_nulls[first + i + 1] |= bits >> (32 - shift);
+  }
+
+  if (other.m_storage == Undecided)
+    resizeStorage(m_count + other.m_count);
+  else
+  {
+    switch (m_storage)
+    {
+      case Undecided:
+        break;
+      case Integers:
+        m_integers += other.m_integers;
+        break;
+      case Reals:
+        m_reals += other.m_reals;
+        break;
+      case Strings:
+        m_strings += other.m_strings;
+        break;
+      case Bytes:
+        m_bytes += other.m_bytes;
+        break;
+      case Variants:
+        if (other.m_storage == Variants)
+          m_variants += other.m_variants;
+        else
+        {
+          m_variants.reserve(m_count + other.m_count);
+
+          for (int i = 0; i < other.m_count; ++i)
+            m_variants << other.value(i);
+        }
+        break;
+    }
+  }
+
+  m_count += other.m_count;
+}
+
+
+QVariant SQLColumn::value(int row) const
+{
+  if (m_storage == Variants)
+    return m_variants.at(row);
+
+  if (isNull(row))
+    return QVariant(m_type);
+
+  switch (m_storage)
+  {
+    case Integers:
+      if (m_type == QVariant::Bool)
+        return QVariant(m_integers.at(row) != 0);
+      if (m_type == QVariant::Int)
+        return QVariant(int(m_integers.at(row)));
+      if (m_type == QVariant::UInt)
+        return QVariant(uint(m_integers.at(row)));
+      return QVariant(qlonglong(m_integers.at(row)));
+    case Reals:
+      return QVariant(m_reals.at(row));
+    case Strings:
+      return QVariant(m_strings.at(row));
+    case Bytes:
+      return QVariant(m_bytes.at(row));
+    default:
+      return QVariant();
+  }
+}
+
+
+SQLColumn::Kind SQLColumn::kindOf(QVariant::Type type)
+{
+  switch (type)
+  {
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+    case QVariant::Double:
+      return Number;
+    case QVariant::Bool:
+      return Bool;
+    case QVariant::Date:
+    case QVariant::Time:
+    case QVariant::DateTime:
+      return DateTime;
+    case QVariant::ByteArray:
+      return Blob;
+    default:
+      return Text;
+  }
+}
+
+
+SQLColumn::Storage SQLColumn::storageOf(QVariant::Type type)
+{
+  switch (type)
+  {
+    case QVariant::Bool:
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+      return Integers;
+    case QVariant::Double:
+      return Reals;
+    case QVariant::String:
+      return Strings;
+    case QVariant::ByteArray:
+      return Bytes;
+    default:
+      return Variants;
+  }
+}
+
+
+void SQLColumn::setStorage(Storage storage, QVariant::Type type)
+{
+  m_storage = storage;
+  m_type = type;
+  m_kind = kindOf(type);
+
+  // all rows so far are null
+  resizeStorage(m_count);
+}
+
+
+void SQLColumn::resizeStorage(int size)
+{
+  switch (m_storage)
+  {
+    case Undecided:
+      break;
+    case Integers:
+      m_integers.resize(size);
+      break;
+    case Reals:
+      m_reals.resize(size);
+      break;
+    case Strings:
+      m_strings.resize(size);
+      break;
+    case Bytes:
+      m_bytes.resize(size);
+      break;
+    case Variants:
+      m_variants.resize(size);
+      break;
+  }
+}
+
+
+void SQLColumn::toVariants()
+{
+  if (m_storage == Variants)
+    return;
+
+  QVector<QVariant> variants;
+  variants.reserve(m_count);
+
+  for (int i = 0; i < m_count; ++i)
+    variants << value(i);
+
+  m_integers.clear();
+  m_reals.clear();
+  m_strings.clear();
+  m_bytes.clear();
+
+  m_variants = variants;
+  m_storage = Variants;
+}
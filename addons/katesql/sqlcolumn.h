@@ -0,0 +1,103 @@
+/*
+   Copyright (C) 2010  Marco Mentasti  <marcomentasti@gmail.com>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License version 2 as published by the Free Software Foundation.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef SQLCOLUMN_H
+#define SQLCOLUMN_H
+
+#include <qbytearray.h>
+#include <qmetatype.h>
+#include <qstring.h>
+#include <qvariant.h>
+#include <qvector.h>
+
+/// the values of one result column, in a typed array plus a null bitmap
+///
+/// The first non null value decides the storage. A value of another type
+/// turns the column into a plain QVariant array, so mixed columns (sqlite
+/// has no column types) still keep every value as it came from the driver.
+class SQLColumn
+{
+  public:
+    /// how a value is displayed, one output style each
+    enum Kind
+    {
+      Text = 0,
+      Number,
+      Bool,
+      DateTime,
+      Blob,
+      KindCount
+    };
+
+    SQLColumn();
+
+    int count() const { return m_count; }
+
+    void append(const QVariant &value);
+    void append(const SQLColumn &other);
+
+    bool isNull(int row) const
+    {
+      return m_nulls.at(row >> 5) & (1u << (row & 31));
+    }
+
+    QVariant value(int row) const;
+
+    /// the kind of the value in @p row, for nulls the kind of the column
+    Kind kind(int row) const
+    {
+      return (m_storage == Variants) ? kindOf(m_variants.at(row).type()) : m_kind;
+    }
+
+    static Kind kindOf(QVariant::Type type);
+
+  private:
+    enum Storage
+    {
+      Undecided,
+      Integers,
+      Reals,
+      Strings,
+      Bytes,
+      Variants
+    };
+
+    static Storage storageOf(QVariant::Type type);
+
+    void setStorage(Storage storage, QVariant::Type type);
+    void resizeStorage(int size);
+    void toVariants();
+
+  private:
+    Storage m_storage;
+    QVariant::Type m_type;
+    Kind m_kind;
+    int m_count;
+
+    QVector<quint32> m_nulls;
+
+    QVector<qint64>     m_integers;
+    QVector<double>     m_reals;
+    QVector<QString>    m_strings;
+    QVector<QByteArray> m_bytes;
+    QVector<QVariant>   m_variants;
+};
+
+Q_DECLARE_METATYPE(SQLColumn)
+
+#endif // SQLCOLUMN_H
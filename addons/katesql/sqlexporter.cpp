@@ -0,0 +1,91 @@
+/*
+   Copyright (C) 2010  Marco Mentasti  <marcomentasti@gmail.com>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License version 2 as published by the Free Software Foundation.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "sqlexporter.h"
+#include "sqlcolumn.h"
+
+#include <qtextstream.h>
+
+SQLExporter::SQLExporter(QTextStream &stream, const SQLExportFormat &format)
+: m_stream(stream)
+, m_format(format)
+, m_delimiter(format.fieldDelimiter)
+{
+  /// FIXME: ugly workaround...
+  m_delimiter.replace(QLatin1String ("\\t"), QLatin1String ("\t"));
+  m_delimiter.replace(QLatin1String ("\\r"), QLatin1String ("\r"));
+  m_delimiter.replace(QLatin1String ("\\n"), QLatin1String ("\n"));
+}
+
+
+void SQLExporter::writeColumnNames(const QStringList &names)
+{
+  if (m_format.lineNumbers)
+    m_stream << m_delimiter;
+
+  for (int i = 0; i < names.count(); ++i)
+  {
+    if (i > 0)
+      m_stream << m_delimiter;
+
+    writeQuoted(names.at(i), m_format.stringsQuoteChar);
+  }
+
+  m_stream << '\n';
+}
+
+
+void SQLExporter::writeRow(int line, const QVariantList &values)
+{
+  if (m_format.lineNumbers)
+    m_stream << line << m_delimiter;
+
+  for (int i = 0; i < values.count(); ++i)
+  {
+    if (i > 0)
+      m_stream << m_delimiter;
+
+    const QVariant &value = values.at(i);
+
+    if (value.isNull())
+      continue;
+
+    const SQLColumn::Kind kind = SQLColumn::kindOf(value.type());
+    const bool number = (kind == SQLColumn::Number || kind == SQLColumn::Bool);
+
+    writeQuoted(value.toString(), number ? m_format.numbersQuoteChar : m_format.stringsQuoteChar);
+  }
+
+  m_stream << '\n';
+}
+
+
+void SQLExporter::writeQuoted(const QString &text, const QChar quote)
+{
+  if (quote == QLatin1Char ('\0'))
+  {
+    m_stream << text;
+    return;
+  }
+
+  // quotes inside the value are doubled, as csv readers expect
+  QString escaped(text);
+  escaped.replace(quote, QString(2, quote));
+
+  m_stream << quote << escaped << quote;
+}
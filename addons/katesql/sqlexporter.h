@@ -0,0 +1,68 @@
+/*
+   Copyright (C) 2010  Marco Mentasti  <marcomentasti@gmail.com>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License version 2 as published by the Free Software Foundation.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef SQLEXPORTER_H
+#define SQLEXPORTER_H
+
+class QTextStream;
+
+#include <qchar.h>
+#include <qstring.h>
+#include <qstringlist.h>
+#include <qvariant.h>
+
+/// how the values of a result set are written
+struct SQLExportFormat
+{
+  SQLExportFormat()
+  : stringsQuoteChar(QLatin1Char ('\0'))
+  , numbersQuoteChar(QLatin1Char ('\0'))
+  , fieldDelimiter(QLatin1String ("\t"))
+  , columnNames(false)
+  , lineNumbers(false)
+  {
+  }
+
+  QChar stringsQuoteChar;
+  QChar numbersQuoteChar;
+  QString fieldDelimiter;
+  bool columnNames;
+  bool lineNumbers;
+};
+
+/// writes rows as delimited text, one row at a time
+class SQLExporter
+{
+  public:
+    SQLExporter(QTextStream &stream, const SQLExportFormat &format);
+
+    void writeColumnNames(const QStringList &names);
+
+    /// a null value is written as an empty, unquoted field
+    void writeRow(int line, const QVariantList &values);
+
+  private:
+    void writeQuoted(const QString &text, const QChar quote);
+
+  private:
+    QTextStream &m_stream;
+    SQLExportFormat m_format;
+    QString m_delimiter;
+};
+
+#endif // SQLEXPORTER_H
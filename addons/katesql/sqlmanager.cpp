@@ -24,6 +24,8 @@
 #include <kconfiggroup.h>
 
 #include <QDebug>
+#include <QLocale>
+#include <QRegExp>
 #include <qsqldatabase.h>
 #include <qsqlquery.h>
 #include <qsqlerror.h>
@@ -35,12 +37,26 @@ SQLManager::SQLManager(QObject *parent)
 : QObject(parent)
 , m_model(new ConnectionModel(this))
 , m_wallet(0)
+, m_queryId(0)
+, m_queryRows(0)
+, m_exportWorker(0)
 {
 }
 
 
 SQLManager::~SQLManager()
 {
+  // cancel everything first, so the threads wind down together instead of
+  // each one waiting for the fetch of the one before to stop
+  foreach (SQLQueryWorker *worker, m_workers)
+    worker->stop();
+
+  if (m_exportWorker)
+    m_exportWorker->stop();
+
+  qDeleteAll(m_workers);
+  delete m_exportWorker;
+
   for(int i = 0; i < m_model->rowCount(); i++)
   {
     QString connection =m_model->data(m_model->index(i), Qt::DisplayRole).toString();
@@ -176,6 +192,8 @@ void SQLManager::reopenConnection (const QString& name)
 {
   emit connectionAboutToBeClosed(name);
 
+  removeWorker(name);
+
   QSqlDatabase db = QSqlDatabase::database(name);
 
   db.close();
@@ -262,6 +280,8 @@ void SQLManager::removeConnection(const QString &name)
 {
   emit connectionAboutToBeClosed(name);
 
+  removeWorker(name);
+
   m_model->removeConnection(name);
 
   QSqlDatabase::removeDatabase(name);
@@ -330,6 +350,30 @@ void SQLManager::saveConnection(KConfigGroup *connectionsGroup, const Connection
 }
 
 
+static QString elapsedSeconds(qint64 msecs)
+{
+  return QLocale().toString(msecs / 1000.0, 'f', 2);
+}
+
+
+/// only a single select without side effects may run again for an export
+static bool isPlainSelect(const QString &text)
+{
+  QString query = text.trimmed();
+
+  if (query.endsWith(QLatin1Char(';')))
+    query.chop(1);
+
+  if (query.contains(QLatin1Char(';')))
+    return false;
+
+  if (!query.contains(QRegExp(QLatin1String("^select\\b"), Qt::CaseInsensitive)))
+    return false;
+
+  return !query.contains(QRegExp(QLatin1String("\\binto\\b|\\bfor\\s+update\\b"), Qt::CaseInsensitive));
+}
+
+
 void SQLManager::runQuery(const QString &text, const QString &connection)
 {
   qDebug() << "connection:" << connection;
@@ -341,51 +385,254 @@ void SQLManager::runQuery(const QString &text, const QString &connection)
   if (!isValidAndOpen(connection))
     return;
 
-  QSqlDatabase db = QSqlDatabase::database(connection);
-  QSqlQuery query(db);
+  // the results view shows a single result set, a new query replaces the running one
+  if (!m_queryConnection.isEmpty() && m_queryConnection != connection)
+    m_workers.value(m_queryConnection)->cancel();
+
+  SQLQueryWorker *worker = m_workers.value(connection);
 
-  if (!query.prepare(text))
+  if (!worker)
   {
-    QSqlError err = query.lastError();
+    worker = newWorker(connection);
 
-    if (err.type() == QSqlError::ConnectionError)
-      m_model->setStatus(connection, Connection::OFFLINE);
+    connect(worker, SIGNAL(columnsReady(int,QStringList)), this, SLOT(slotColumnsReady(int,QStringList)));
+    connect(worker, SIGNAL(rowsReady(int,SQLRowBatch)), this, SLOT(slotRowsReady(int,SQLRowBatch)));
+    connect(worker, SIGNAL(queryFinished(int,bool,int)), this, SLOT(slotQueryFinished(int,bool,int)));
+    connect(worker, SIGNAL(queryFailed(int,QString,bool)), this, SLOT(slotQueryFailed(int,QString,bool)));
 
-    emit error(err.text());
-    return;
+    m_workers.insert(connection, worker);
   }
 
-  if (!query.exec())
+  m_queryConnection = connection;
+  m_queryText = text;
+  m_queryId++;
+  m_queryRows = 0;
+  m_queryTimer.start();
+
+  worker->runQuery(text, m_queryId);
+
+  emit queryRunning(true);
+}
+
+
+void SQLManager::cancelQuery()
+{
+  if (m_exportWorker)
   {
-    QSqlError err = query.lastError();
+    stopExport();
 
-    if (err.type() == QSqlError::ConnectionError)
-      m_model->setStatus(connection, Connection::OFFLINE);
+    emit error(i18nc("@info", "Export cancelled"));
+  }
 
-    emit error(err.text());
+  if (m_queryConnection.isEmpty())
     return;
-  }
+
+  m_workers.value(m_queryConnection)->cancel();
+
+  const qint64 msecs = m_queryTimer.elapsed();
+
+  emit queryProgress(m_queryRows, msecs);
+  emit error(i18nc("@info", "Query cancelled after %1 seconds", elapsedSeconds(msecs)));
+
+  finishQuery();
+}
+
+
+void SQLManager::finishQuery()
+{
+  m_queryConnection.clear();
+
+  emit queryRunning(m_exportWorker != 0);
+}
+
+
+SQLQueryWorker *SQLManager::newWorker(const QString &connection)
+{
+  // the worker opens its own connection with the parameters of the one
+  // opened here, including a password read from the wallet
+  QSqlDatabase db = QSqlDatabase::database(connection);
+
+  Connection conn;
+  conn.name     = connection;
+  conn.driver   = db.driverName();
+  conn.hostname = db.hostName();
+  conn.username = db.userName();
+  conn.password = db.password();
+  conn.database = db.databaseName();
+  conn.options  = db.connectOptions();
+  conn.port     = db.port();
+  conn.status   = Connection::ONLINE;
+
+  SQLQueryWorker *worker = new SQLQueryWorker(conn, this);
+  worker->start();
+
+  return worker;
+}
+
+
+void SQLManager::removeWorker(const QString &connection)
+{
+  SQLQueryWorker *worker = m_workers.take(connection);
+
+  if (!worker)
+    return;
+
+  if (connection == m_queryConnection)
+    finishQuery();
+
+  if (connection == m_resultConnection)
+    m_resultText.clear();
+
+  // a statement still executing on the server can keep the thread busy,
+  // let it finish on its own instead of blocking here
+  worker->disconnect(this);
+  connect(worker, SIGNAL(finished()), worker, SLOT(deleteLater()));
+  worker->stop();
+}
+
+
+void SQLManager::slotColumnsReady(int id, const QStringList &columns)
+{
+  if (id != m_queryId || m_queryConnection.isEmpty())
+    return;
+
+  m_resultConnection = m_queryConnection;
+  m_resultText = isPlainSelect(m_queryText) ? m_queryText : QString();
+
+  emit queryActivated(columns, m_queryConnection);
+}
+
+
+void SQLManager::slotRowsReady(int id, const SQLRowBatch &rows)
+{
+  if (id != m_queryId || m_queryConnection.isEmpty())
+    return;
+
+  if (!rows.isEmpty())
+    m_queryRows += rows.first().count();
+
+  emit rowsFetched(rows);
+  emit queryProgress(m_queryRows, m_queryTimer.elapsed());
+}
+
+
+void SQLManager::slotQueryFinished(int id, bool isSelect, int rows)
+{
+  if (id != m_queryId || m_queryConnection.isEmpty())
+    return;
+
+  const qint64 msecs = m_queryTimer.elapsed();
+  const QString seconds = elapsedSeconds(msecs);
 
   QString message;
 
-  /// TODO: improve messages
-  if (query.isSelect())
+  if (isSelect)
   {
-    if (!query.driver()->hasFeature(QSqlDriver::QuerySize))
-      message = i18nc("@info", "Query completed successfully");
-    else
-    {
-      int nRowsSelected = query.size();
-      message = i18ncp("@info", "%1 record selected", "%1 records selected", nRowsSelected);
-    }
+    emit queryProgress(rows, msecs);
+
+    message = i18ncp("@info", "%1 record selected in %2 seconds", "%1 records selected in %2 seconds", rows, seconds);
+
+    if (msecs > 0)
+      message = i18nc("@info query result and fetch rate", "%1 (%2 rows/s)", message, QLocale().toString(qint64(rows) * 1000 / msecs));
   }
   else
   {
-    int nRowsAffected = query.numRowsAffected();
-    message = i18ncp("@info", "%1 row affected", "%1 rows affected", nRowsAffected);
+    message = i18ncp("@info", "%1 row affected in %2 seconds", "%1 rows affected in %2 seconds", rows, seconds);
   }
 
+  finishQuery();
+
   emit success(message);
-  emit queryActivated(query, connection);
 }
 
+
+void SQLManager::slotQueryFailed(int id, const QString &message, bool connectionError)
+{
+  if (id != m_queryId || m_queryConnection.isEmpty())
+    return;
+
+  if (connectionError)
+    m_model->setStatus(m_queryConnection, Connection::OFFLINE);
+
+  finishQuery();
+
+  emit error(message);
+}
+
+
+bool SQLManager::canExportResults() const
+{
+  return !m_resultText.isEmpty();
+}
+
+
+void SQLManager::exportResults(const QString &fileName, const SQLExportFormat &format)
+{
+  if (m_resultText.isEmpty())
+    return;
+
+  if (!isValidAndOpen(m_resultConnection))
+    return;
+
+  stopExport();
+
+  m_exportWorker = newWorker(m_resultConnection);
+  m_exportFile = fileName;
+  m_exportTimer.start();
+
+  connect(m_exportWorker, SIGNAL(exportProgress(int,int)), this, SLOT(slotExportProgress(int,int)));
+  connect(m_exportWorker, SIGNAL(queryFinished(int,bool,int)), this, SLOT(slotExportFinished(int,bool,int)));
+  connect(m_exportWorker, SIGNAL(queryFailed(int,QString,bool)), this, SLOT(slotExportFailed(int,QString)));
+
+  // the result set came from a plain select, running it again changes nothing
+  m_exportWorker->exportQuery(m_resultText, 0, fileName, format);
+
+  emit exportProgress(0, 0);
+  emit queryRunning(true);
+}
+
+
+void SQLManager::stopExport()
+{
+  if (!m_exportWorker)
+    return;
+
+  m_exportWorker->disconnect(this);
+  connect(m_exportWorker, SIGNAL(finished()), m_exportWorker, SLOT(deleteLater()));
+  m_exportWorker->stop();
+  m_exportWorker = 0;
+
+  emit queryRunning(!m_queryConnection.isEmpty());
+}
+
+
+void SQLManager::slotExportProgress(int id, int rows)
+{
+  Q_UNUSED(id);
+
+  emit exportProgress(rows, m_exportTimer.elapsed());
+}
+
+
+void SQLManager::slotExportFinished(int id, bool isSelect, int rows)
+{
+  Q_UNUSED(id);
+  Q_UNUSED(isSelect);
+
+  const qint64 msecs = m_exportTimer.elapsed();
+
+  stopExport();
+
+  emit exportProgress(rows, msecs);
+  emit success(xi18ncp("@info", "%1 record exported to <filename>%2</filename> in %3 seconds", "%1 records exported to <filename>%2</filename> in %3 seconds", rows, m_exportFile, elapsedSeconds(msecs)));
+}
+
+
+void SQLManager::slotExportFailed(int id, const QString &message)
+{
+  Q_UNUSED(id);
+
+  stopExport();
+
+  emit error(message);
+}
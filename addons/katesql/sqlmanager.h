@@ -23,8 +23,11 @@ class ConnectionModel;
 class KConfigGroup;
 
 #include "connection.h"
+#include "sqlqueryworker.h"
 #include <kwallet.h>
 #include <qsqlquery.h>
+#include <qhash.h>
+#include <qelapsedtimer.h>
 
 class SQLManager : public QObject
 {
@@ -39,6 +42,9 @@ class SQLManager : public QObject
     bool testConnection(const Connection &conn, QSqlError &error);
     bool isValidAndOpen(const QString &connection);
 
+    /// true if the shown result set can be streamed to a file by running its query again
+    bool canExportResults() const;
+
     KWallet::Wallet * openWallet();
     int storeCredentials(const Connection &conn);
     int readCredentials(const QString &name, QString &password);
@@ -49,16 +55,35 @@ class SQLManager : public QObject
     void loadConnections(KConfigGroup *connectionsGroup);
     void saveConnections(KConfigGroup *connectionsGroup);
     void runQuery(const QString &text, const QString &connection );
+    void cancelQuery();
+    void exportResults(const QString &fileName, const SQLExportFormat &format);
 
   protected:
     void saveConnection(KConfigGroup *connectionsGroup, const Connection &conn);
+    SQLQueryWorker *newWorker(const QString &connection);
+    void removeWorker(const QString &connection);
+    void finishQuery();
+    void stopExport();
+
+  protected Q_SLOTS:
+    void slotColumnsReady(int id, const QStringList &columns);
+    void slotRowsReady(int id, const SQLRowBatch &rows);
+    void slotQueryFinished(int id, bool isSelect, int rows);
+    void slotQueryFailed(int id, const QString &message, bool connectionError);
+    void slotExportProgress(int id, int rows);
+    void slotExportFinished(int id, bool isSelect, int rows);
+    void slotExportFailed(int id, const QString &message);
 
   Q_SIGNALS:
     void connectionCreated(const QString &name);
     void connectionRemoved(const QString &name);
     void connectionAboutToBeClosed(const QString &name);
 
-    void queryActivated(QSqlQuery &query, const QString &connection);
+    void queryActivated(const QStringList &columns, const QString &connection);
+    void rowsFetched(const SQLRowBatch &rows);
+    void queryProgress(int rows, qint64 msecs);
+    void queryRunning(bool running);
+    void exportProgress(int rows, qint64 msecs);
 
     void error(const QString &message);
     void success(const QString &message);
@@ -66,6 +91,25 @@ class SQLManager : public QObject
   private:
     ConnectionModel *m_model;
     KWallet::Wallet *m_wallet;
+
+    /// one worker thread per connection, started by the first query
+    QHash<QString, SQLQueryWorker*> m_workers;
+
+    /// the running query, m_queryConnection is empty if there is none
+    QString m_queryConnection;
+    QString m_queryText;
+    int m_queryId;
+    int m_queryRows;
+    QElapsedTimer m_queryTimer;
+
+    /// the query of the shown result set, exports run it again
+    QString m_resultConnection;
+    QString m_resultText;
+
+    /// exports get a worker of their own, so queries can run meanwhile
+    SQLQueryWorker *m_exportWorker;
+    QString m_exportFile;
+    QElapsedTimer m_exportTimer;
 };
 
 #endif // SQLMANAGER_H
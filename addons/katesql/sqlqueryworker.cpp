@@ -0,0 +1,328 @@
+/*
+   Copyright (C) 2010  Marco Mentasti  <marcomentasti@gmail.com>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License version 2 as published by the Free Software Foundation.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "sqlqueryworker.h"
+
+#include <klocalizedstring.h>
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QSaveFile>
+#include <QTextStream>
+#include <qsqldatabase.h>
+#include <qsqlquery.h>
+#include <qsqlrecord.h>
+#include <qsqlerror.h>
+
+// a batch is handed out when it is full or when the oldest row waited this long
+static const int BATCH_SIZE = 1000;
+static const int BATCH_INTERVAL = 100;
+
+SQLQueryWorker::SQLQueryWorker(const Connection &conn, QObject *parent)
+: QThread(parent)
+, m_connection(conn)
+, m_id(-1)
+, m_cancel(0)
+, m_quit(false)
+{
+  qRegisterMetaType<SQLRowBatch>("SQLRowBatch");
+}
+
+
+SQLQueryWorker::~SQLQueryWorker()
+{
+  stop();
+  wait();
+}
+
+
+void SQLQueryWorker::runQuery(const QString &text, int id)
+{
+  QMutexLocker locker(&m_mutex);
+
+  m_cancel.store(1);
+  m_text = text;
+  m_id = id;
+  m_exportFile.clear();
+
+  m_wakeUp.wakeOne();
+}
+
+
+void SQLQueryWorker::exportQuery(const QString &text, int id, const QString &fileName, const SQLExportFormat &format)
+{
+  QMutexLocker locker(&m_mutex);
+
+  m_cancel.store(1);
+  m_text = text;
+  m_id = id;
+  m_exportFile = fileName;
+  m_exportFormat = format;
+
+  m_wakeUp.wakeOne();
+}
+
+
+void SQLQueryWorker::cancel()
+{
+  QMutexLocker locker(&m_mutex);
+
+  m_cancel.store(1);
+  m_id = -1;
+}
+
+
+void SQLQueryWorker::stop()
+{
+  QMutexLocker locker(&m_mutex);
+
+  m_cancel.store(1);
+  m_quit = true;
+
+  m_wakeUp.wakeOne();
+}
+
+
+void SQLQueryWorker::run()
+{
+  const QString name = QString::fromLatin1("katesql-worker-%1").arg(quintptr(this));
+
+  {
+    QSqlDatabase db = QSqlDatabase::addDatabase(m_connection.driver, name);
+
+    db.setHostName(m_connection.hostname);
+    db.setUserName(m_connection.username);
+    db.setPassword(m_connection.password);
+    db.setDatabaseName(m_connection.database);
+    db.setConnectOptions(m_connection.options);
+
+    if (m_connection.port > 0)
+      db.setPort(m_connection.port);
+
+    forever
+    {
+      m_mutex.lock();
+
+      while (m_id < 0 && !m_quit)
+        m_wakeUp.wait(&m_mutex);
+
+      if (m_quit)
+      {
+        m_mutex.unlock();
+        break;
+      }
+
+      const QString text = m_text;
+      const int id = m_id;
+      const QString exportFile = m_exportFile;
+      const SQLExportFormat exportFormat = m_exportFormat;
+
+      m_id = -1;
+      m_cancel.store(0);
+
+      m_mutex.unlock();
+
+      if (exportFile.isEmpty())
+        execute(db, text, id);
+      else
+        exportTo(db, text, id, exportFile, exportFormat);
+    }
+  }
+
+  QSqlDatabase::removeDatabase(name);
+}
+
+
+void SQLQueryWorker::execute(QSqlDatabase &db, const QString &text, int id)
+{
+  if (!db.isOpen() && !db.open())
+  {
+    emit queryFailed(id, db.lastError().text(), true);
+    return;
+  }
+
+  /// NOTE: the drivers offer no way to abort a statement already sent to
+  /// the server, a cancelled query is only dropped once exec() returns
+  QSqlQuery query(db);
+  query.setForwardOnly(true);
+
+  if (!query.prepare(text) || !query.exec())
+  {
+    QSqlError err = query.lastError();
+
+    emit queryFailed(id, err.text(), err.type() == QSqlError::ConnectionError);
+    return;
+  }
+
+  if (m_cancel.load())
+    return;
+
+  if (!query.isSelect())
+  {
+    emit queryFinished(id, false, query.numRowsAffected());
+    return;
+  }
+
+  const QSqlRecord record = query.record();
+  const int columnCount = record.count();
+
+  QStringList columns;
+  for (int i = 0; i < columnCount; ++i)
+    columns << record.fieldName(i);
+
+  emit columnsReady(id, columns);
+
+  SQLRowBatch batch(columnCount);
+  int batchRows = 0;
+  int rows = 0;
+
+  QElapsedTimer sinceLastBatch;
+  sinceLastBatch.start();
+
+  while (!m_cancel.load() && query.next())
+  {
+    for (int i = 0; i < columnCount; ++i)
+      batch[i].append(query.value(i));
+
+    ++batchRows;
+    ++rows;
+
+    if (batchRows >= BATCH_SIZE || sinceLastBatch.elapsed() >= BATCH_INTERVAL)
+    {
+      emit rowsReady(id, batch);
+
+      batch = SQLRowBatch(columnCount);
+      batchRows = 0;
+      sinceLastBatch.restart();
+    }
+  }
+
+  if (m_cancel.load())
+  {
+    qDebug() << "query" << id << "cancelled after" << rows << "rows";
+    return;
+  }
+
+  if (batchRows > 0)
+    emit rowsReady(id, batch);
+
+  // a fetch error ends next() like the end of the result set does
+  if (query.lastError().isValid())
+  {
+    QSqlError err = query.lastError();
+
+    emit queryFailed(id, err.text(), err.type() == QSqlError::ConnectionError);
+    return;
+  }
+
+  emit queryFinished(id, true, rows);
+}
+
+
+void SQLQueryWorker::exportTo(QSqlDatabase &db, const QString &text, int id, const QString &fileName, const SQLExportFormat &format)
+{
+  if (!db.isOpen() && !db.open())
+  {
+    emit queryFailed(id, db.lastError().text(), true);
+    return;
+  }
+
+  QSaveFile file(fileName);
+
+  if (!file.open(QIODevice::WriteOnly))
+  {
+    emit queryFailed(id, xi18nc("@info", "Unable to open file <filename>%1</filename>", fileName), false);
+    return;
+  }
+
+  QSqlQuery query(db);
+  query.setForwardOnly(true);
+
+  if (!query.prepare(text) || !query.exec())
+  {
+    QSqlError err = query.lastError();
+
+    file.cancelWriting();
+    emit queryFailed(id, err.text(), err.type() == QSqlError::ConnectionError);
+    return;
+  }
+
+  // QTextStream buffers the output, every row is formatted and dropped right away
+  QTextStream stream(&file);
+  SQLExporter exporter(stream, format);
+
+  const QSqlRecord record = query.record();
+  const int columnCount = record.count();
+
+  if (format.columnNames)
+  {
+    QStringList columns;
+    for (int i = 0; i < columnCount; ++i)
+      columns << record.fieldName(i);
+
+    exporter.writeColumnNames(columns);
+  }
+
+  QVariantList values;
+  int rows = 0;
+
+  QElapsedTimer sinceLastProgress;
+  sinceLastProgress.start();
+
+  while (!m_cancel.load() && query.next())
+  {
+    values.clear();
+
+    for (int i = 0; i < columnCount; ++i)
+      values << query.value(i);
+
+    exporter.writeRow(++rows, values);
+
+    if (sinceLastProgress.elapsed() >= BATCH_INTERVAL)
+    {
+      emit exportProgress(id, rows);
+
+      sinceLastProgress.restart();
+    }
+  }
+
+  stream.flush();
+
+  if (m_cancel.load())
+  {
+    file.cancelWriting();
+    return;
+  }
+
+  if (query.lastError().isValid())
+  {
+    QSqlError err = query.lastError();
+
+    file.cancelWriting();
+    emit queryFailed(id, err.text(), err.type() == QSqlError::ConnectionError);
+    return;
+  }
+
+  if (!file.commit())
+  {
+    emit queryFailed(id, xi18nc("@info", "Unable to write file <filename>%1</filename>", fileName), false);
+    return;
+  }
+
+  emit queryFinished(id, true, rows);
+}
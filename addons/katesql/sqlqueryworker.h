@@ -0,0 +1,92 @@
+/*
+   Copyright (C) 2010  Marco Mentasti  <marcomentasti@gmail.com>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License version 2 as published by the Free Software Foundation.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef SQLQUERYWORKER_H
+#define SQLQUERYWORKER_H
+
+class QSqlDatabase;
+
+#include "connection.h"
+#include "sqlcolumn.h"
+#include "sqlexporter.h"
+
+#include <qatomic.h>
+#include <qmutex.h>
+#include <qstringlist.h>
+#include <qthread.h>
+#include <qvector.h>
+#include <qwaitcondition.h>
+
+/// rows fetched by a worker, stored column by column
+typedef QVector<SQLColumn> SQLRowBatch;
+
+/// runs the queries of one connection on its own thread
+///
+/// The thread opens a private copy of the connection, a QSqlDatabase can
+/// only be used from the thread that created it. Results are fetched
+/// forward-only and handed out in batches, every signal carries the id
+/// given to runQuery() so results of a superseded query can be dropped.
+class SQLQueryWorker : public QThread
+{
+  Q_OBJECT
+
+  public:
+    SQLQueryWorker(const Connection &conn, QObject *parent = 0);
+    ~SQLQueryWorker();
+
+    /// queue @p text, a query still running is cancelled
+    void runQuery(const QString &text, int id);
+
+    /// like runQuery(), but the rows are written to @p fileName as they are fetched
+    void exportQuery(const QString &text, int id, const QString &fileName, const SQLExportFormat &format);
+
+    /// stop fetching the running query and drop the queued one
+    void cancel();
+
+    /// cancel and let the thread finish
+    void stop();
+
+  Q_SIGNALS:
+    void columnsReady(int id, const QStringList &columns);
+    void rowsReady(int id, const SQLRowBatch &rows);
+    void queryFinished(int id, bool isSelect, int rows);
+    void queryFailed(int id, const QString &message, bool connectionError);
+    void exportProgress(int id, int rows);
+
+  protected:
+    void run();
+
+  private:
+    void execute(QSqlDatabase &db, const QString &text, int id);
+    void exportTo(QSqlDatabase &db, const QString &text, int id, const QString &fileName, const SQLExportFormat &format);
+
+  private:
+    Connection m_connection;
+
+    QMutex m_mutex;
+    QWaitCondition m_wakeUp;
+    QString m_text;
+    int m_id;
+    QString m_exportFile;
+    SQLExportFormat m_exportFormat;
+
+    QAtomicInt m_cancel;
+    bool m_quit;
+};
+
+#endif // SQLQUERYWORKER_H
@@ -27,10 +27,44 @@
 #include <klocalizedstring.h>
 
 
+QByteArray documentSource(Document* document, const Cursor& cursor, int* offset)
+{
+    const QString text = document->text();
+
+    int position = cursor.column();
+    for (int line = 0; line < cursor.line(); ++line) {
+        position += document->lineLength(line) + 1;
+    }
+    position = qMin(position, text.size());
+
+    // UTF-8 length of the text before the cursor, without converting it separately
+    int bytes = 0;
+    for (int i = 0; i < position; ++i) {
+        const ushort c = text.at(i).unicode();
+        if (c < 0x80) {
+            bytes += 1;
+        } else if (c < 0x800) {
+            bytes += 2;
+        } else if (QChar::isHighSurrogate(c) && i + 1 < text.size() && QChar::isLowSurrogate(text.at(i + 1).unicode())) {
+            bytes += 4;
+            ++i;
+        } else {
+            bytes += 3;
+        }
+    }
+    *offset = bytes;
+
+    return text.toUtf8();
+}
+
+
 LumenCompletionModel::LumenCompletionModel(QObject* parent, DCD* dcd)
     : CodeCompletionModel(parent)
+    , m_requestId(0)
 {
     m_dcd = dcd;
+
+    connect(m_dcd, &DCD::completionReady, this, &LumenCompletionModel::completionReady);
 }
 
 LumenCompletionModel::~LumenCompletionModel()
@@ -53,24 +87,62 @@ bool LumenCompletionModel::shouldStartCompletion(View* view, const QString& inse
 void LumenCompletionModel::completionInvoked(View* view, const Range& range, CodeCompletionModel::InvocationType invocationType)
 {
     Q_UNUSED(invocationType);
-    KTextEditor::Document* document = view->document();
 
-    KTextEditor::Cursor cursor = range.end();
-    KTextEditor::Cursor cursorEnd = document->documentEnd();
-    KTextEditor::Range range0c = KTextEditor::Range(0, 0, cursor.line(), cursor.column());
-    KTextEditor::Range rangece = KTextEditor::Range(cursor.line(), cursor.column(),
-                                                    cursorEnd.line(), cursorEnd.column());
-    QString text0c = document->text(range0c, false);
-    QByteArray utf8 = text0c.toUtf8();
-    int offset = utf8.length();
-    utf8.append(document->text(rangece, false).toUtf8());
+    int offset;
+    QByteArray utf8 = documentSource(view->document(), range.end(), &offset);
 
-    m_data = m_dcd->complete(utf8, offset);
-    setRowCount(m_data.completions.length());
+    // results of the previous request are dropped once this one is sent
+    m_requestId = m_dcd->requestCompletion(utf8, offset);
 
+    m_items.clear();
+    setRowCount(0);
     setHasGroups(false);
 }
 
+void LumenCompletionModel::completionReady(int id, const DCDCompletion& completion)
+{
+    if (id != m_requestId) {
+        return;
+    }
+
+    static const QRegularExpression funcRE(QStringLiteral("^\\s*(\\w+)\\s+(\\w+\\s*\\(.*\\))\\s*$"));
+
+    QVector<LumenCompletionItem> items;
+    items.reserve(completion.completions.size());
+
+    foreach(const DCDCompletionItem& completionItem, completion.completions) {
+        LumenCompletionItem item;
+        item.type = completionItem.type;
+        item.icon = completionItem.icon();
+        item.properties = NoProperty;
+
+        if (item.type == DCDCompletionItemType::Calltip) {
+            QRegularExpressionMatch match = funcRE.match(completionItem.name);
+            if (match.hasMatch()) {
+                item.prefix = match.captured(1);
+                item.name = match.captured(2);
+            } else {
+                item.name = completionItem.name;
+            }
+        } else {
+            item.name = completionItem.name;
+        }
+
+        switch (item.type) {
+            case DCDCompletionItemType::FunctionName: item.properties |= Function; break;
+            case DCDCompletionItemType::VariableName: item.properties |= Variable; break;
+            default: break;
+        }
+
+        items.append(item);
+    }
+
+    beginResetModel();
+    m_items = items;
+    setRowCount(m_items.size());
+    endResetModel();
+}
+
 
 void LumenCompletionModel::executeCompletionItem(View* view, const Range& word, const QModelIndex& index) const
 {
@@ -89,26 +161,23 @@ void LumenCompletionModel::executeCompletionItem(View* view, const Range& word,
 
 QVariant LumenCompletionModel::data(const QModelIndex& index, int role) const
 {
-    DCDCompletionItem item = m_data.completions[index.row()];
+    const LumenCompletionItem& item = m_items.at(index.row());
 
     switch (role)
     {
         case Qt::DecorationRole:
         {
             if(index.column() == Icon) {
-                return item.icon();
+                return item.icon;
             }
             break;
         }
         case Qt::DisplayRole:
         {
             if(item.type == DCDCompletionItemType::Calltip) {
-                QRegularExpression funcRE(QStringLiteral("^\\s*(\\w+)\\s+(\\w+\\s*\\(.*\\))\\s*$"));
-                QStringList matches = funcRE.match(item.name).capturedTexts();
-
                 switch(index.column()) {
-                    case Prefix: return matches[1];
-                    case Name: return matches[2];
+                    case Prefix: return item.prefix;
+                    case Name: return item.name;
                 }
             } else {
                 if(index.column() == Name) {
@@ -119,13 +188,7 @@ QVariant LumenCompletionModel::data(const QModelIndex& index, int role) const
         }
         case CompletionRole:
         {
-            int p = NoProperty;
-            switch (item.type) {
-                case DCDCompletionItemType::FunctionName: p |= Function; break;
-                case DCDCompletionItemType::VariableName: p |= Variable; break;
-                default: break;
-            }
-            return p;
+            return item.properties;
         }
         case BestMatchesCount:
         {
@@ -22,10 +22,24 @@
 #define LUMEN_COMPLETION_H
 #include <KTextEditor/CodeCompletionModel>
 #include <KTextEditor/CodeCompletionModelControllerInterface>
+#include <QtCore/QVector>
 #include "dcd.h"
 
 using namespace KTextEditor;
 
+/**
+ * The document as UTF-8 for DCD, with the byte offset of @p cursor in it.
+ */
+QByteArray documentSource(Document* document, const Cursor& cursor, int* offset);
+
+struct LumenCompletionItem {
+    DCDCompletionItemType::DCDCompletionItemType type;
+    QString prefix;
+    QString name;
+    QIcon icon;
+    int properties;
+};
+
 class LumenCompletionModel
     : public CodeCompletionModel
     , public KTextEditor::CodeCompletionModelControllerInterface
@@ -40,9 +54,12 @@ public:
     void completionInvoked(View* view, const Range& range, InvocationType invocationType) Q_DECL_OVERRIDE;
     void executeCompletionItem(View *view, const Range &word, const QModelIndex &index) const Q_DECL_OVERRIDE;
     QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const Q_DECL_OVERRIDE;
+private Q_SLOTS:
+    void completionReady(int id, const DCDCompletion& completion);
 private:
     DCD* m_dcd;
-    DCDCompletion m_data;
+    int m_requestId;
+    QVector<LumenCompletionItem> m_items;
 };
 
 
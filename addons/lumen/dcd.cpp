@@ -22,7 +22,9 @@
 #include <QtCore/QDebug>
 #include <QtCore/QProcess>
 #include <QtCore/QFile>
-#include <QtCore/QRegularExpression>
+#include <QtCore/QTimer>
+#include <QtNetwork/QHostAddress>
+#include <QtNetwork/QTcpSocket>
 #include <QtGui/QIcon>
 
 
@@ -128,17 +130,232 @@ QString DCDCompletionItem::typeLong() const
 
 
 static const int TIMEOUT_START_SERVER = 200;
-static const int TIMEOUT_COMPLETE = 200;
-static const int TIMEOUT_IMPORTPATH = 200;
+static const int TIMEOUT_COMPLETE = 2000;
+static const int TIMEOUT_DOC = 200;
 static const int TIMEOUT_SHUTDOWN = 350;
 static const int TIMEOUT_SHUTDOWN_SERVER = 200;
 
 
-DCD::DCD(int port, const QString& server, const QString& client)
+// Request kinds of the DCD protocol, these are bit flags.
+namespace DCDRequestKind {
+    enum DCDRequestKind {
+        Autocomplete = 1,
+        ClearCache = 2,
+        AddImport = 4,
+        Shutdown = 8,
+        SymbolLocation = 16,
+        Doc = 32
+    };
+}
+
+
+// Just enough msgpack for the messages DCD exchanges. Strings and the
+// source code are written as raw/str, which old and new versions of
+// msgpack-d both accept.
+static void packArray(QByteArray& out, quint32 size)
+{
+    if (size < 16) {
+        out.append(char(0x90 | size));
+    } else if (size < 0x10000) {
+        out.append(char(0xdc));
+        out.append(char(size >> 8));
+        out.append(char(size));
+    } else {
+        out.append(char(0xdd));
+        for (int shift = 24; shift >= 0; shift -= 8)
+            out.append(char(size >> shift));
+    }
+}
+
+static void packUInt(QByteArray& out, quint64 value)
+{
+    if (value < 0x80) {
+        out.append(char(value));
+    } else if (value < 0x100) {
+        out.append(char(0xcc));
+        out.append(char(value));
+    } else if (value < 0x10000) {
+        out.append(char(0xcd));
+        out.append(char(value >> 8));
+        out.append(char(value));
+    } else {
+        out.append(char(0xcf));
+        for (int shift = 56; shift >= 0; shift -= 8)
+            out.append(char(value >> shift));
+    }
+}
+
+static void packRaw(QByteArray& out, const QByteArray& data)
+{
+    const quint32 size = data.size();
+    if (size < 32) {
+        out.append(char(0xa0 | size));
+    } else if (size < 0x10000) {
+        out.append(char(0xda));
+        out.append(char(size >> 8));
+        out.append(char(size));
+    } else {
+        out.append(char(0xdb));
+        for (int shift = 24; shift >= 0; shift -= 8)
+            out.append(char(size >> shift));
+    }
+    out.append(data);
+}
+
+/**
+ * Builds an AutocompleteRequest, prefixed with its length like dcd-client
+ * sends it. The fields follow the layout of DCD 0.5 and later.
+ */
+static QByteArray packRequest(int kind, const QByteArray& source = QByteArray(), int cursor = 0,
+                              const QStringList& importPaths = QStringList())
+{
+    QByteArray message;
+    packArray(message, 6);
+    packRaw(message, QByteArray("stdin"));
+    packUInt(message, kind);
+    packArray(message, importPaths.size());
+    foreach(const QString& path, importPaths) {
+        packRaw(message, path.toUtf8());
+    }
+    packRaw(message, source);
+    packUInt(message, cursor);
+    packRaw(message, QByteArray()); // searchName
+
+    // the server reads a size_t in host byte order first
+    const quint64 size = message.size();
+    QByteArray request(reinterpret_cast<const char*>(&size), sizeof(size));
+    request.append(message);
+    return request;
+}
+
+class MsgPackReader
+{
+    public:
+        explicit MsgPackReader(const QByteArray& data) : m_data(data), m_pos(0), m_ok(true) {}
+
+        bool ok() const { return m_ok; }
+
+        bool nextIsArray() const
+        {
+            if (m_pos >= m_data.size())
+                return false;
+            const quint8 c = m_data.at(m_pos);
+            return (c & 0xf0) == 0x90 || c == 0xdc || c == 0xdd;
+        }
+
+        int readArray()
+        {
+            const quint8 c = readByte();
+            if ((c & 0xf0) == 0x90) return c & 0x0f;
+            if (c == 0xdc) return readBigEndian(2);
+            if (c == 0xdd) return readBigEndian(4);
+            return fail();
+        }
+
+        quint64 readUInt()
+        {
+            const quint8 c = readByte();
+            if (c < 0x80) return c;
+            if (c >= 0xcc && c <= 0xcf) return readBigEndian(1 << (c - 0xcc));
+            return fail();
+        }
+
+        QByteArray readRaw()
+        {
+            const quint8 c = readByte();
+            int size;
+            if ((c & 0xe0) == 0xa0) size = c & 0x1f;
+            else if (c == 0xd9 || c == 0xc4) size = readBigEndian(1);
+            else if (c == 0xda || c == 0xc5) size = readBigEndian(2);
+            else if (c == 0xdb || c == 0xc6) size = readBigEndian(4);
+            else if (c == 0xc0) return QByteArray();
+            else { fail(); return QByteArray(); }
+
+            if (!need(size))
+                return QByteArray();
+            const QByteArray raw = m_data.mid(m_pos, size);
+            m_pos += size;
+            return raw;
+        }
+
+        QList<QByteArray> readRawArray()
+        {
+            QList<QByteArray> list;
+            const int size = readArray();
+            for (int i = 0; m_ok && i < size; ++i)
+                list.append(readRaw());
+            return list;
+        }
+
+        void skip()
+        {
+            const quint8 c = readByte();
+            if (!m_ok) return;
+            if (c < 0x80 || c >= 0xe0 || c == 0xc0 || c == 0xc2 || c == 0xc3) return;
+            if ((c & 0xe0) == 0xa0) { m_pos--; readRaw(); return; }
+            if ((c & 0xf0) == 0x90 || c == 0xdc || c == 0xdd) { m_pos--; skipItems(readArray()); return; }
+            if ((c & 0xf0) == 0x80) { skipItems(2 * (c & 0x0f)); return; }
+            if (c == 0xde) { skipItems(2 * readBigEndian(2)); return; }
+            if (c == 0xdf) { skipItems(2 * readBigEndian(4)); return; }
+            if (c >= 0xcc && c <= 0xcf) { skipBytes(1 << (c - 0xcc)); return; }
+            if (c >= 0xd0 && c <= 0xd3) { skipBytes(1 << (c - 0xd0)); return; }
+            if (c == 0xca) { skipBytes(4); return; }
+            if (c == 0xcb) { skipBytes(8); return; }
+            if ((c >= 0xc4 && c <= 0xc6) || (c >= 0xd9 && c <= 0xdb)) { m_pos--; readRaw(); return; }
+            fail();
+        }
+
+    private:
+        int fail() { m_ok = false; return 0; }
+
+        bool need(int size)
+        {
+            if (size < 0 || m_pos + size > m_data.size())
+                fail();
+            return m_ok;
+        }
+
+        quint8 readByte()
+        {
+            if (!need(1))
+                return 0xc1; // never used
+            return m_data.at(m_pos++);
+        }
+
+        quint64 readBigEndian(int size)
+        {
+            quint64 value = 0;
+            if (!need(size))
+                return 0;
+            for (int i = 0; i < size; ++i)
+                value = (value << 8) | quint8(m_data.at(m_pos++));
+            return value;
+        }
+
+        void skipBytes(int size)
+        {
+            if (need(size))
+                m_pos += size;
+        }
+
+        void skipItems(quint64 count)
+        {
+            for (quint64 i = 0; m_ok && i < count; ++i)
+                skip();
+        }
+
+        const QByteArray& m_data;
+        int m_pos;
+        bool m_ok;
+};
+
+
+DCD::DCD(int port, const QString& server, QObject* parent)
+    : QObject(parent)
+    , m_port(port)
+    , m_server(server)
+    , m_lastRequest(0)
 {
-    m_port = port;
-    m_server = server;
-    m_client = client;
 }
 
 int DCD::port() const
@@ -169,116 +386,188 @@ bool DCD::startServer()
 }
 
 
-DCDCompletion DCD::complete(const QString& file, int offset)
+QTcpSocket* DCD::sendRequest(const QByteArray& request)
+{
+    QTcpSocket* socket = new QTcpSocket(this);
+    socket->connectToHost(QHostAddress::LocalHost, m_port);
+    // buffered until the connection is established
+    socket->write(request);
+    return socket;
+}
+
+QByteArray DCD::sendRequestAndWait(const QByteArray& request, int timeout)
 {
-    QProcess proc;
-    proc.setProcessChannelMode(QProcess::MergedChannels);
-    proc.start(m_client,
-        QStringList()
-            << QStringLiteral("-p%1").arg(m_port)
-            << QStringLiteral("-c%1").arg(offset)
-            << file
-    );
-    proc.waitForFinished(TIMEOUT_COMPLETE);
-    proc.terminate();
-
-    if (proc.exitStatus() != QProcess::NormalExit || proc.exitCode() != 0) {
-        qWarning() << "unable to complete:" << proc.exitCode();
-        qWarning() << proc.readAllStandardOutput();
-        return DCDCompletion();
+    QTcpSocket socket;
+    socket.connectToHost(QHostAddress::LocalHost, m_port);
+    socket.write(request);
+
+    if (!socket.waitForConnected(timeout) || !socket.waitForBytesWritten(timeout)) {
+        qWarning() << "unable to send request to completion-server:" << socket.errorString();
+        return QByteArray();
     }
 
-    return processCompletion(QString::fromUtf8(proc.readAllStandardOutput()));
+    // the server closes the connection after its answer
+    QByteArray reply;
+    while (socket.waitForReadyRead(timeout)) {
+        reply.append(socket.readAll());
+    }
+    reply.append(socket.readAll());
+
+    if (socket.state() != QAbstractSocket::UnconnectedState) {
+        qWarning() << "completion-server didn't answer in time";
+        return QByteArray();
+    }
+    return reply;
 }
 
-DCDCompletion DCD::complete(const QByteArray& data, int offset)
+
+int DCD::requestCompletion(const QByteArray& data, int offset)
 {
-    QProcess proc;
-    proc.setProcessChannelMode(QProcess::MergedChannels);
-    proc.start(m_client,
-        QStringList()
-            << QStringLiteral("-p%1").arg(m_port)
-            << QStringLiteral("-c%1").arg(offset)
-    );
-    proc.write(data);
-    proc.closeWriteChannel();
-    if (!proc.waitForFinished(TIMEOUT_COMPLETE)) {
-        qWarning() << "unable to complete: client didn't finish in time";
-        proc.close();
-    } else if (proc.exitCode() != 0) {
-        qWarning() << "unable to complete:" << proc.exitCode();
-        qWarning() << proc.readAllStandardOutput();
-    } else {
-        // everything Ok
-        return processCompletion(QString::fromUtf8(proc.readAllStandardOutput()));
+    const int id = ++m_lastRequest;
+
+    QTcpSocket* socket = sendRequest(packRequest(DCDRequestKind::Autocomplete, data, offset));
+    m_completionRequests.insert(socket, id);
+
+    connect(socket, SIGNAL(disconnected()), this, SLOT(completionReplyFinished()));
+    connect(socket, SIGNAL(error(QAbstractSocket::SocketError)), this, SLOT(completionReplyError()));
+
+    // owned by the socket, gone with it once the reply is handled
+    QTimer* timer = new QTimer(socket);
+    timer->setSingleShot(true);
+    connect(timer, SIGNAL(timeout()), this, SLOT(completionReplyTimeout()));
+    timer->start(TIMEOUT_COMPLETE);
+
+    return id;
+}
+
+void DCD::completionReplyFinished()
+{
+    QTcpSocket* socket = static_cast<QTcpSocket*>(sender());
+    if (!m_completionRequests.contains(socket)) {
+        return;
     }
 
-    return DCDCompletion();
+    const int id = m_completionRequests.take(socket);
+    const QByteArray reply = socket->readAll();
+    socket->deleteLater();
+
+    emit completionReady(id, processCompletion(reply));
+}
+
+void DCD::completionReplyError()
+{
+    QTcpSocket* socket = static_cast<QTcpSocket*>(sender());
+
+    // the normal end of a reply, handled by completionReplyFinished()
+    if (socket->error() == QAbstractSocket::RemoteHostClosedError) {
+        return;
+    }
+    if (!m_completionRequests.contains(socket)) {
+        return;
+    }
+
+    qWarning() << "unable to complete:" << socket->errorString();
+
+    const int id = m_completionRequests.take(socket);
+    socket->deleteLater();
+
+    emit completionReady(id, DCDCompletion());
+}
+
+void DCD::completionReplyTimeout()
+{
+    QTcpSocket* socket = static_cast<QTcpSocket*>(sender()->parent());
+    if (!m_completionRequests.contains(socket)) {
+        return;
+    }
+
+    qWarning() << "unable to complete: completion-server didn't answer in time";
+
+    const int id = m_completionRequests.take(socket);
+    socket->abort();
+    socket->deleteLater();
+
+    emit completionReady(id, DCDCompletion());
 }
 
 QString DCD::doc(const QByteArray& data, int offset)
 {
-    QProcess proc;
-    proc.setProcessChannelMode(QProcess::MergedChannels);
-    proc.start(m_client,
-        QStringList()
-            << QStringLiteral("-p%1").arg(m_port)
-            << QStringLiteral("-c%1").arg(offset)
-            << QStringLiteral("--doc")
-    );
-
-    proc.write(data);
-    proc.closeWriteChannel();
-    if (!proc.waitForFinished(TIMEOUT_COMPLETE)) {
-        qWarning() << "unable to lookup documentation: client didn't finish in time";
-        proc.close();
-    } else if (proc.exitCode() != 0) {
-        qWarning() << "unable to lookup documentation:" << proc.exitCode();
-        qWarning() << proc.readAllStandardOutput();
-    } else {
-        return QString::fromUtf8(proc.readAllStandardOutput());
+    const QByteArray reply = sendRequestAndWait(packRequest(DCDRequestKind::Doc, data, offset), TIMEOUT_DOC);
+    if (reply.isEmpty()) {
+        return QString();
     }
 
-    return QString();
+    // completionType, symbolFilePath, symbolLocation, docComments, ...
+    MsgPackReader reader(reply);
+    const int fields = reader.readArray();
+    reader.skip();
+    reader.skip();
+    reader.skip();
+    const QList<QByteArray> comments = reader.readRawArray();
+
+    if (!reader.ok() || fields < 4) {
+        qWarning() << "unable to lookup documentation: invalid reply";
+        return QString();
+    }
+
+    QStringList docs;
+    foreach(const QByteArray& comment, comments) {
+        docs.append(QString::fromUtf8(comment));
+    }
+    return docs.join(QStringLiteral("\n"));
 }
 
 
-DCDCompletion DCD::processCompletion(const QString& data)
+DCDCompletion DCD::processCompletion(const QByteArray& reply)
 {
     DCDCompletion completion;
 
-    QStringList lines = data.split(QRegularExpression(QStringLiteral("[\r\n]")), QString::SkipEmptyParts);
-    if (lines.length() == 0) {
-        return completion;
+    // completionType, symbolFilePath, symbolLocation, docComments, completions, completionKinds, ...
+    MsgPackReader reader(reply);
+    const int fields = reader.readArray();
+    const QByteArray type = reader.readRaw();
+    reader.skip();
+    reader.skip();
+    reader.skip();
+    const QList<QByteArray> completions = reader.readRawArray();
+
+    QByteArray kinds;
+    if (reader.nextIsArray()) {
+        const int size = reader.readArray();
+        for (int i = 0; reader.ok() && i < size; ++i)
+            kinds.append(char(reader.readUInt()));
+    } else {
+        kinds = reader.readRaw();
     }
 
-    QString type = lines.front();
-    if (type == QStringLiteral("identifiers")) { completion.type = DCDCompletionType::Identifiers; }
-    else if (type == QStringLiteral("calltips")) { completion.type = DCDCompletionType::Calltips; }
-    else {
-        qWarning() << "Invalid type:" << type;
+    if (!reader.ok() || fields < 6) {
+        qWarning() << "invalid completion data";
         return completion;
     }
-    lines.pop_front();
 
-    foreach(QString line, lines) {
-        if (line.trimmed().length() == 0) {
-            continue;
+    if (type == "identifiers") { completion.type = DCDCompletionType::Identifiers; }
+    else if (type == "calltips") { completion.type = DCDCompletionType::Calltips; }
+    else {
+        if (!type.isEmpty()) {
+            qWarning() << "Invalid type:" << type;
         }
+        return completion;
+    }
 
-        QStringList kv = line.split(QRegularExpression(QStringLiteral("\\s+")), QString::SkipEmptyParts);
-        if (kv.length() != 2 && completion.type != DCDCompletionType::Calltips) {
-            qWarning() << "invalid completion data:" << kv.length() << completion.type;
-            continue;
-        }
+    if (completion.type == DCDCompletionType::Identifiers && kinds.size() != completions.size()) {
+        qWarning() << "invalid completion data:" << kinds.size() << completions.size();
+        return completion;
+    }
 
+    completion.completions.reserve(completions.size());
+    for (int i = 0; i < completions.size(); ++i) {
         if (completion.type == DCDCompletionType::Identifiers) {
             completion.completions.append(DCDCompletionItem(
-                DCDCompletionItemType::fromChar(kv[1].at(0).toLatin1()), kv[0]
+                DCDCompletionItemType::fromChar(kinds.at(i)), QString::fromUtf8(completions.at(i))
             ));
         } else {
             completion.completions.append(DCDCompletionItem(
-                DCDCompletionItemType::Calltip, line
+                DCDCompletionItemType::Calltip, QString::fromUtf8(completions.at(i))
             ));
         }
     }
@@ -294,41 +583,30 @@ void DCD::addImportPath(const QString& path)
 
 void DCD::addImportPath(const QStringList& paths)
 {
-    if (paths.isEmpty()) {
-        return;
-    }
-
-    QStringList arguments = QStringList(QStringLiteral("-p%1").arg(m_port));
+    QStringList existing;
     foreach(QString path, paths) {
         if (QFile::exists(path))
-            arguments << QStringLiteral("-I%1").arg(path);
+            existing << path;
     }
 
-    QProcess proc;
-    proc.setProcessChannelMode(QProcess::MergedChannels);
-    proc.start(m_client, arguments);
-    proc.waitForFinished(TIMEOUT_IMPORTPATH);
-
-    if (proc.exitStatus() != QProcess::NormalExit || proc.exitCode() != 0) {
-        qWarning() << "unable to add importpath(s)" << paths << ":" << proc.exitCode();
-        qWarning() << proc.readAll();
+    if (existing.isEmpty()) {
+        return;
     }
+
+    // nothing to wait for, the server answers with an ack at most
+    QTcpSocket* socket = sendRequest(packRequest(DCDRequestKind::AddImport, QByteArray(), 0, existing));
+    connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+    connect(socket, SIGNAL(error(QAbstractSocket::SocketError)), socket, SLOT(deleteLater()));
 }
 
 void DCD::shutdown()
 {
-    QProcess proc;
-    proc.setProcessChannelMode(QProcess::MergedChannels);
-    proc.start(m_client,
-        QStringList()
-            << QStringLiteral("-p%1").arg(m_port)
-            << QStringLiteral("--shutdown")
-    );
-    proc.waitForFinished(TIMEOUT_SHUTDOWN);
-
-    if (proc.exitStatus() != QProcess::NormalExit || proc.exitCode() != 0) {
-        qWarning() << "unable to shutdown dcd:" << proc.exitCode();
-        qWarning() << proc.readAllStandardOutput();
+    QTcpSocket socket;
+    socket.connectToHost(QHostAddress::LocalHost, m_port);
+    socket.write(packRequest(DCDRequestKind::Shutdown));
+
+    if (!socket.waitForConnected(TIMEOUT_SHUTDOWN) || !socket.waitForBytesWritten(TIMEOUT_SHUTDOWN)) {
+        qWarning() << "unable to shutdown dcd:" << socket.errorString();
     }
 }
 
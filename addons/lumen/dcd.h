@@ -26,8 +26,11 @@
 #include <QtCore/QFile>
 #include <QtCore/QObject>
 #include <QtCore/QMap>
+#include <QtCore/QHash>
 #include <QtGui/QIcon>
 
+class QTcpSocket;
+
 
 namespace DCDCompletionType { enum DCDCompletionType { Identifiers, Calltips }; }
 namespace DCDCompletionItemType {
@@ -69,27 +72,44 @@ struct DCDCompletion {
     QList<DCDCompletionItem> completions;
 };
 
-class DCD
+/**
+ * Client for dcd-server.
+ *
+ * Requests are msgpack encoded and sent over a TCP connection to the
+ * server, the way dcd-client does it, so no process has to be started
+ * per request. The server answers a single request per connection.
+ */
+class DCD : public QObject
 {
+    Q_OBJECT
     public:
-        DCD(int, const QString&, const QString&);
+        DCD(int port, const QString& server, QObject* parent = 0);
         virtual ~DCD();
         int port() const;
         bool running();
         bool startServer();
         bool stopServer();
-        DCDCompletion complete(const QString&, int);
-        DCDCompletion complete(const QByteArray&, int);
-        QString doc(const QByteArray&, int);
+        /// Sends a completion request, the result is delivered with completionReady().
+        int requestCompletion(const QByteArray& data, int offset);
+        QString doc(const QByteArray& data, int offset);
         void shutdown();
         void addImportPath(const QString&);
         void addImportPath(const QStringList&);
+    Q_SIGNALS:
+        void completionReady(int id, const DCDCompletion& completion);
+    private Q_SLOTS:
+        void completionReplyFinished();
+        void completionReplyError();
+        void completionReplyTimeout();
     private:
-        DCDCompletion processCompletion(const QString&);
+        QTcpSocket* sendRequest(const QByteArray& request);
+        QByteArray sendRequestAndWait(const QByteArray& request, int timeout);
+        static DCDCompletion processCompletion(const QByteArray& reply);
         int m_port;
         QString m_server;
-        QString m_client;
         QProcess m_sproc;
+        int m_lastRequest;
+        QHash<QTcpSocket*, int> m_completionRequests;
 };
 
 #endif
\ No newline at end of file
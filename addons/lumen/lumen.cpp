@@ -146,25 +146,17 @@ LumenHintProvider::LumenHintProvider(LumenPlugin* plugin)
 
 QString LumenHintProvider::textHint(View* view, const Cursor& position)
 {
-    KTextEditor::Document* document = view->document();
-
-    KTextEditor::Cursor cursorEnd = document->documentEnd();
-    KTextEditor::Range range0c = KTextEditor::Range(0, 0, position.line(), position.column());
-    KTextEditor::Range rangece = KTextEditor::Range(position.line(), position.column(),
-                                                    cursorEnd.line(), cursorEnd.column());
-    QString text0c = document->text(range0c, false);
-    QByteArray utf8 = text0c.toUtf8();
-    int offset = utf8.length();
-    utf8.append(document->text(rangece, false).toUtf8());
-
-    return m_plugin->dcd()->doc(utf8, offset).trimmed().replace(QStringLiteral("\\n"), QStringLiteral("\n"));
+    int offset;
+    QByteArray utf8 = documentSource(view->document(), position, &offset);
+
+    return m_plugin->dcd()->doc(utf8, offset).trimmed();
 }
 
 
 LumenPlugin::LumenPlugin(QObject *parent, const QList<QVariant> &)
     : Plugin(parent)
 {
-    m_dcd = new DCD(9166, QStringLiteral("dcd-server"), QStringLiteral("dcd-client"));
+    m_dcd = new DCD(9166, QStringLiteral("dcd-server"));
     m_dcd->startServer();
 }
 
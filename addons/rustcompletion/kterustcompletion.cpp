@@ -20,20 +20,20 @@
  ***************************************************************************/
 
 #include "kterustcompletion.h"
+#include "kterustcompletiondaemon.h"
 #include "kterustcompletionplugin.h"
 
-#include <QProcessEnvironment>
-#include <QTemporaryFile>
-#include <QTextStream>
-
 #include <KTextEditor/Cursor>
 #include <KTextEditor/Document>
 #include <KTextEditor/View>
 
 KTERustCompletion::KTERustCompletion(KTERustCompletionPlugin *plugin)
     : KTextEditor::CodeCompletionModel(0)
+    , m_requestId(-1)
     , m_plugin(plugin)
 {
+    connect(m_plugin->daemon(), &KTERustCompletionDaemon::matchesReady,
+        this, &KTERustCompletion::matchesReady);
 }
 
 KTERustCompletion::~KTERustCompletion()
@@ -96,100 +96,39 @@ void KTERustCompletion::completionInvoked(KTextEditor::View *view, const KTextEd
 
     beginResetModel();
 
-    m_matches = getMatches(view->document(), Complete, range.end());
+    // racer answers asynchronously, the previous matches are stale by now
+    m_matches.clear();
+    m_requestId = m_plugin->daemon()->request(view->document(), Complete, range.end());
 
-    setRowCount(m_matches.size());
+    setRowCount(0);
     setHasGroups(false);
 
     endResetModel();
 }
 
-void KTERustCompletion::aborted(KTextEditor::View *view)
+void KTERustCompletion::matchesReady(int id, const QList<CompletionMatch> &matches)
 {
-    Q_UNUSED(view);
+    if (id != m_requestId) {
+        return;
+    }
 
     beginResetModel();
 
-    m_matches.clear();
+    m_matches = matches;
+    setRowCount(m_matches.size());
 
     endResetModel();
 }
 
-QList<CompletionMatch> KTERustCompletion::getMatches(const KTextEditor::Document *document, MatchAction action, const KTextEditor::Cursor &position)
+void KTERustCompletion::aborted(KTextEditor::View *view)
 {
-    QList<CompletionMatch> matches;
-
-    if (!m_plugin->configOk()) {
-        return matches;
-    }
-
-    QTemporaryFile file;
-
-    if (file.open()) {
-        {
-            QTextStream out(&file);
-            out.setCodec("UTF-8");
-            out << document->text();
-        }
-
-        QProcess proc;
-
-        QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
-        env.insert(QStringLiteral("LC_ALL"), QStringLiteral("C"));
-        env.insert(QStringLiteral("RUST_SRC_PATH"), m_plugin->rustSrcPath().toLocalFile());
-        proc.setProcessEnvironment(env);
-
-        QStringList args;
-        args << (action == Complete ? QStringLiteral("complete") : QStringLiteral("find-definition"));
-        args << QString::number(position.line() + 1);
-        args << QString::number(position.column());
-        args << file.fileName();
-
-        proc.start(m_plugin->racerCmd(), args, QIODevice::ReadOnly);
-
-        if (proc.waitForFinished(1000)) {
-            const QString &output = QString::fromUtf8(proc.readAllStandardOutput());
-
-            QStringList lines(output.split(QStringLiteral("\n"), QString::SkipEmptyParts));
-
-            foreach(QString line, lines) {
-                if (line.startsWith(QStringLiteral("MATCH "))) {
-                    line = line.mid(6);
-
-                    CompletionMatch match;
-                    match.text = line.section(QStringLiteral(","), 0, 0);
-
-                    const QString &type = line.section(QStringLiteral(","), 4, 4);
-                    match.depth = (type == QStringLiteral("StructField")) ? 1 : 0;
-                    addType(match, type);
-
-                    QString path = line.section(QStringLiteral(","), 3, 3);
-
-                    if (path == file.fileName()) {
-                        match.url = document->url();
-                    } else {
-                        match.url = QUrl::fromLocalFile(path);
-                    }
-
-                    bool ok = false;
-
-                    int row = line.section(QStringLiteral(","), 1, 1).toInt(&ok);
-                    if (ok) match.line = row - 1;
-
-                    int col = line.section(QStringLiteral(","), 2, 2).toInt(&ok);
-                    if (ok) match.col = col;
+    Q_UNUSED(view);
 
-                    matches.append(match);
+    beginResetModel();
 
-                    if (action == FindDefinition) {
-                        break;
-                    }
-                }
-            }
-        }
-    }
+    m_matches.clear();
 
-    return matches;
+    endResetModel();
 }
 
 void KTERustCompletion::addType(CompletionMatch &match, const QString &type)
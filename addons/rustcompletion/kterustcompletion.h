@@ -67,12 +67,14 @@ class KTERustCompletion : public KTextEditor::CodeCompletionModel, public KTextE
 
         QVariant data(const QModelIndex &index, int role) const;
 
-        QList<CompletionMatch> getMatches(const KTextEditor::Document *document, MatchAction action, const KTextEditor::Cursor &position);
-
-    private:
         static void addType(CompletionMatch &match, const QString &type);
 
+    private Q_SLOTS:
+        void matchesReady(int id, const QList<CompletionMatch> &matches);
+
+    private:
         QList<CompletionMatch> m_matches;
+        int m_requestId;
 
         KTERustCompletionPlugin *m_plugin;
 };
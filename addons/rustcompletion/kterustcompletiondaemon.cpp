@@ -0,0 +1,302 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+#include "kterustcompletiondaemon.h"
+#include "kterustcompletionplugin.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QProcess>
+#include <QProcessEnvironment>
+
+#include <KTextEditor/Cursor>
+#include <KTextEditor/Document>
+
+// racer has to load the standard library sources on its first request
+static const int REQUEST_TIMEOUT = 5000;
+
+KTERustCompletionDaemon::KTERustCompletionDaemon(KTERustCompletionPlugin *plugin, QObject *parent)
+    : QObject(parent)
+    , m_plugin(plugin)
+    , m_process(0)
+    , m_busy(false)
+    , m_currentStale(false)
+    , m_lastId(0)
+{
+    m_timeout.setSingleShot(true);
+    m_timeout.setInterval(REQUEST_TIMEOUT);
+    connect(&m_timeout, &QTimer::timeout, this, &KTERustCompletionDaemon::requestTimedOut);
+}
+
+KTERustCompletionDaemon::~KTERustCompletionDaemon()
+{
+    if (m_process) {
+        m_process->disconnect(this);
+        m_process->kill();
+        m_process->waitForFinished(100);
+    }
+}
+
+int KTERustCompletionDaemon::request(const KTextEditor::Document *document, KTERustCompletion::MatchAction action,
+                                     const KTextEditor::Cursor &position)
+{
+    if (!m_plugin->configOk()) {
+        return -1;
+    }
+
+    Request request;
+    request.id = ++m_lastId;
+    request.action = action;
+    request.url = document->url();
+    request.text = document->text().toUtf8();
+    request.line = position.line();
+    request.col = position.column();
+
+    // racer resolves the crate from the path, the contents are read from stdin
+    if (request.url.isLocalFile()) {
+        request.fileName = request.url.toLocalFile();
+    }
+
+    if (request.fileName.isEmpty() || request.fileName.contains(QLatin1Char(' '))) {
+        request.fileName = QDir::temp().filePath(QStringLiteral("kterustcompletion.rs"));
+    }
+
+    if (action == KTERustCompletion::Complete) {
+        for (int i = m_queue.size() - 1; i >= 0; --i) {
+            if (m_queue.at(i).action == KTERustCompletion::Complete) {
+                m_queue.removeAt(i);
+            }
+        }
+
+        if (m_busy && m_current.action == KTERustCompletion::Complete) {
+            m_currentStale = true;
+        }
+    }
+
+    m_queue.append(request);
+    sendNext();
+
+    return request.id;
+}
+
+void KTERustCompletionDaemon::stop()
+{
+    if (!m_process) {
+        return;
+    }
+
+    m_process->disconnect(this);
+    m_process->kill();
+    m_process->waitForFinished(100);
+    m_process->deleteLater();
+    m_process = 0;
+
+    m_buffer.clear();
+
+    if (m_busy) {
+        finishRequest();
+    }
+}
+
+bool KTERustCompletionDaemon::startProcess()
+{
+    if (m_process) {
+        return true;
+    }
+
+    m_process = new QProcess(this);
+
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    env.insert(QStringLiteral("LC_ALL"), QStringLiteral("C"));
+    env.insert(QStringLiteral("RUST_SRC_PATH"), m_plugin->rustSrcPath().toLocalFile());
+    m_process->setProcessEnvironment(env);
+    m_process->setStandardErrorFile(QProcess::nullDevice());
+
+    connect(m_process, SIGNAL(readyReadStandardOutput()), this, SLOT(readOutput()));
+    connect(m_process, SIGNAL(finished(int,QProcess::ExitStatus)), this, SLOT(processFinished()));
+
+    m_process->start(m_plugin->racerCmd(), QStringList(QStringLiteral("daemon")));
+
+    if (!m_process->waitForStarted(1000)) {
+        qWarning() << "unable to start racer:" << m_process->errorString();
+
+        delete m_process;
+        m_process = 0;
+        return false;
+    }
+
+    return true;
+}
+
+void KTERustCompletionDaemon::sendNext()
+{
+    if (m_busy || m_queue.isEmpty()) {
+        return;
+    }
+
+    if (!startProcess()) {
+        while (!m_queue.isEmpty()) {
+            emit matchesReady(m_queue.takeFirst().id, QList<CompletionMatch>());
+        }
+        return;
+    }
+
+    m_current = m_queue.takeFirst();
+    m_busy = true;
+    m_currentStale = false;
+    m_matches.clear();
+
+    QByteArray command = (m_current.action == KTERustCompletion::Complete) ? "complete " : "find-definition ";
+    command += QByteArray::number(m_current.line + 1);
+    command += ' ';
+    command += QByteArray::number(m_current.col);
+    command += ' ';
+    command += m_current.fileName.toUtf8();
+
+    // "-" makes racer read the buffer from stdin, up to an EOT byte
+    command += " -\n";
+
+    m_process->write(command);
+    m_process->write(m_current.text);
+    m_process->write("\x04");
+
+    // the text is in the write buffer of QProcess now
+    m_current.text.clear();
+
+    m_timeout.start();
+}
+
+void KTERustCompletionDaemon::finishRequest()
+{
+    m_timeout.stop();
+    m_busy = false;
+
+    const int id = m_current.id;
+    const QList<CompletionMatch> matches = m_matches;
+    m_matches.clear();
+
+    emit matchesReady(id, matches);
+
+    sendNext();
+}
+
+void KTERustCompletionDaemon::readOutput()
+{
+    m_buffer.append(m_process->readAllStandardOutput());
+
+    int start = 0;
+    int end;
+
+    while ((end = m_buffer.indexOf('\n', start)) >= 0) {
+        QByteArray line = m_buffer.mid(start, end - start);
+        start = end + 1;
+
+        if (line.endsWith('\r')) {
+            line.chop(1);
+        }
+
+        if (m_busy) {
+            parseLine(line);
+        }
+
+        // finishing a request may have stopped racer
+        if (!m_process) {
+            return;
+        }
+    }
+
+    m_buffer.remove(0, start);
+}
+
+void KTERustCompletionDaemon::parseLine(const QByteArray &line)
+{
+    if (line == "END") {
+        finishRequest();
+        return;
+    }
+
+    if (m_currentStale || !line.startsWith("MATCH ")) {
+        return;
+    }
+
+    if (m_current.action == KTERustCompletion::FindDefinition && !m_matches.isEmpty()) {
+        return;
+    }
+
+    // MATCH text,line,col,path,type,context - only the context may contain commas
+    QByteArray fields[5];
+    int start = 6;
+
+    for (int i = 0; i < 5; ++i) {
+        int end = line.indexOf(',', start);
+
+        if (end < 0) {
+            if (i < 4) {
+                return;
+            }
+            end = line.size();
+        }
+
+        fields[i] = line.mid(start, end - start);
+        start = end + 1;
+    }
+
+    CompletionMatch match;
+    match.text = QString::fromUtf8(fields[0]);
+
+    const QString type = QString::fromLatin1(fields[4]);
+    match.depth = (type == QStringLiteral("StructField")) ? 1 : 0;
+    KTERustCompletion::addType(match, type);
+
+    const QString path = QString::fromUtf8(fields[3]);
+
+    if (path == m_current.fileName) {
+        match.url = m_current.url;
+    } else {
+        match.url = QUrl::fromLocalFile(path);
+    }
+
+    bool ok = false;
+
+    int row = fields[1].toInt(&ok);
+    if (ok) match.line = row - 1;
+
+    int col = fields[2].toInt(&ok);
+    if (ok) match.col = col;
+
+    m_matches.append(match);
+}
+
+void KTERustCompletionDaemon::processFinished()
+{
+    qWarning() << "racer exited unexpectedly";
+
+    m_process->deleteLater();
+    m_process = 0;
+    m_buffer.clear();
+
+    if (m_busy) {
+        finishRequest();
+    }
+}
+
+void KTERustCompletionDaemon::requestTimedOut()
+{
+    qWarning() << "racer didn't answer in time, restarting it";
+
+    stop();
+}
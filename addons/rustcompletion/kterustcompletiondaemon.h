@@ -0,0 +1,102 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+#ifndef KTERUSTCOMPLETIONDAEMON_H
+#define KTERUSTCOMPLETIONDAEMON_H
+
+#include "kterustcompletion.h"
+
+#include <QByteArray>
+#include <QList>
+#include <QObject>
+#include <QTimer>
+#include <QUrl>
+
+class QProcess;
+
+namespace KTextEditor {
+    class Cursor;
+    class Document;
+}
+
+/**
+ * Keeps a "racer daemon" process running and feeds it one request at a time.
+ *
+ * The buffer is passed on stdin, so unsaved changes are seen without writing
+ * them to a file. A completion request that is still queued is dropped when
+ * a newer one arrives, the matches of one already sent to racer are not parsed.
+ */
+class KTERustCompletionDaemon : public QObject
+{
+    Q_OBJECT
+
+    public:
+        KTERustCompletionDaemon(KTERustCompletionPlugin *plugin, QObject *parent = 0);
+        ~KTERustCompletionDaemon();
+
+        /**
+         * Queues a request, the matches are delivered with matchesReady().
+         * Returns the id of the request.
+         */
+        int request(const KTextEditor::Document *document, KTERustCompletion::MatchAction action,
+                    const KTextEditor::Cursor &position);
+
+        /**
+         * Terminates racer, e.g. after a configuration change. It is started
+         * again by the next request.
+         */
+        void stop();
+
+    Q_SIGNALS:
+        void matchesReady(int id, const QList<CompletionMatch> &matches);
+
+    private Q_SLOTS:
+        void readOutput();
+        void processFinished();
+        void requestTimedOut();
+
+    private:
+        struct Request {
+            int id;
+            KTERustCompletion::MatchAction action;
+            QString fileName;
+            QUrl url;
+            QByteArray text;
+            int line;
+            int col;
+        };
+
+        bool startProcess();
+        void sendNext();
+        void finishRequest();
+        void parseLine(const QByteArray &line);
+
+        KTERustCompletionPlugin *m_plugin;
+        QProcess *m_process;
+        QTimer m_timeout;
+
+        QList<Request> m_queue;
+        Request m_current;
+        bool m_busy;
+        bool m_currentStale;
+        QByteArray m_buffer;
+        QList<CompletionMatch> m_matches;
+
+        int m_lastId;
+};
+
+#endif
@@ -18,6 +18,7 @@
  ***************************************************************************/
 
 #include "kterustcompletionplugin.h"
+#include "kterustcompletiondaemon.h"
 #include "kterustcompletionpluginview.h"
 #include "kterustcompletionconfigpage.h"
 
@@ -32,6 +33,7 @@ K_PLUGIN_FACTORY_WITH_JSON(KTERustCompletionPluginFactory, "kterustcompletionplu
 
 KTERustCompletionPlugin::KTERustCompletionPlugin(QObject *parent, const QList<QVariant> &)
     : KTextEditor::Plugin(parent),
+    m_daemon(new KTERustCompletionDaemon(this, this)),
     m_completion(this),
     m_rustSrcWatch(0),
     m_configOk(false)
@@ -67,6 +69,11 @@ KTERustCompletion *KTERustCompletionPlugin::completion()
     return &m_completion;
 }
 
+KTERustCompletionDaemon *KTERustCompletionPlugin::daemon()
+{
+    return m_daemon;
+}
+
 QString KTERustCompletionPlugin::racerCmd() const
 {
     return m_racerCmd;
@@ -79,6 +86,8 @@ void KTERustCompletionPlugin::setRacerCmd(const QString &cmd)
 
         writeConfig();
         updateConfigOk();
+
+        m_daemon->stop();
     }
 }
 
@@ -94,6 +103,8 @@ void KTERustCompletionPlugin::setRustSrcPath(const QUrl &path)
 
         writeConfig();
         updateConfigOk();
+
+        m_daemon->stop();
     }
 }
 
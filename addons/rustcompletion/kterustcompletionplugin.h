@@ -28,6 +28,7 @@
 #include <KTextEditor/Plugin>
 
 class KDirWatch;
+class KTERustCompletionDaemon;
 
 class KTERustCompletionPlugin : public KTextEditor::Plugin
 {
@@ -43,6 +44,7 @@ class KTERustCompletionPlugin : public KTextEditor::Plugin
         virtual KTextEditor::ConfigPage *configPage(int number = 0, QWidget *parent = 0);
 
         KTERustCompletion *completion();
+        KTERustCompletionDaemon *daemon();
 
         QString racerCmd() const;
         void setRacerCmd(const QString &cmd);
@@ -59,6 +61,8 @@ class KTERustCompletionPlugin : public KTextEditor::Plugin
         void readConfig();
         void writeConfig();
 
+        // created first, the completion model connects to it
+        KTERustCompletionDaemon *m_daemon;
         KTERustCompletion m_completion;
 
         QString m_racerCmd;
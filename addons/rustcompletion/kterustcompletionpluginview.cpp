@@ -19,6 +19,7 @@
 
 #include "kterustcompletionpluginview.h"
 #include "kterustcompletionplugin.h"
+#include "kterustcompletiondaemon.h"
 
 #include <QAction>
 
@@ -36,12 +37,14 @@ KTERustCompletionPluginView::KTERustCompletionPluginView(KTERustCompletionPlugin
     : QObject(mainWin)
     , m_plugin(plugin)
     , m_mainWindow(mainWin)
+    , m_definitionRequest(-1)
 {
     KXMLGUIClient::setComponentName(QStringLiteral("kterustcompletion"), i18n("Rust code completion"));
     setXMLFile(QStringLiteral("ui.rc"));
 
     connect(m_mainWindow, &KTextEditor::MainWindow::viewChanged, this, &KTERustCompletionPluginView::viewChanged);
     connect(m_mainWindow, &KTextEditor::MainWindow::viewCreated, this, &KTERustCompletionPluginView::viewCreated);
+    connect(m_plugin->daemon(), &KTERustCompletionDaemon::matchesReady, this, &KTERustCompletionPluginView::definitionFound);
 
     foreach(KTextEditor::View *view, m_mainWindow->views()) {
         viewCreated(view);
@@ -67,11 +70,25 @@ void KTERustCompletionPluginView::goToDefinition()
         return;
     }
 
-    const KTextEditor::Document *document = activeView->document();
-    const KTextEditor::Cursor cursor = activeView->cursorPosition();
+    m_definitionView = activeView;
+    m_definitionRequest = m_plugin->daemon()->request(activeView->document(),
+        KTERustCompletion::FindDefinition, activeView->cursorPosition());
+}
+
+void KTERustCompletionPluginView::definitionFound(int id, const QList<CompletionMatch> &matches)
+{
+    if (id != m_definitionRequest) {
+        return;
+    }
 
-    QList<CompletionMatch> matches = m_plugin->completion()->getMatches(document,
-        KTERustCompletion::FindDefinition, cursor);
+    m_definitionRequest = -1;
+
+    // the view may be gone by the time racer answers
+    KTextEditor::View *activeView = m_definitionView;
+
+    if (!activeView) {
+        return;
+    }
 
     if (matches.count()) {
         const CompletionMatch &match = matches.at(0);
@@ -82,7 +99,7 @@ void KTERustCompletionPluginView::goToDefinition()
 
         KTextEditor::Cursor def(match.line, match.col);
 
-        if (match.url == document->url()) {
+        if (match.url == activeView->document()->url()) {
             activeView->setCursorPosition(def);
         } else if (match.url.isValid()) {
             KTextEditor::View *view = m_mainWindow->openUrl(match.url);
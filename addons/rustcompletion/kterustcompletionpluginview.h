@@ -20,7 +20,10 @@
 #ifndef KTERUSTCOMPLETIONPLUGINVIEW_H
 #define KTERUSTCOMPLETIONPLUGINVIEW_H
 
+#include "kterustcompletion.h"
+
 #include <QObject>
+#include <QPointer>
 #include <QSet>
 
 #include <KXMLGUIClient>
@@ -47,6 +50,7 @@ class KTERustCompletionPluginView : public QObject, public KXMLGUIClient
         void viewCreated(KTextEditor::View *view);
         void viewDestroyed(QObject *view);
         void documentChanged(KTextEditor::Document *document);
+        void definitionFound(int id, const QList<CompletionMatch> &matches);
 
     private:
         void registerCompletion(KTextEditor::View *view);
@@ -56,6 +60,9 @@ class KTERustCompletionPluginView : public QObject, public KXMLGUIClient
         KTERustCompletionPlugin *m_plugin;
         KTextEditor::MainWindow *m_mainWindow;
         QSet<KTextEditor::View *> m_completionViews;
+
+        int m_definitionRequest;
+        QPointer<KTextEditor::View> m_definitionView;
 };
 
 #endif
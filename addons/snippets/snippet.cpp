@@ -52,6 +52,8 @@ QString Snippet::snippet() const
 void Snippet::setSnippet(const QString& snippet)
 {
     m_snippet = snippet;
+    // the text is not item data, let the completion index know anyway
+    emitDataChanged();
 }
 
 void Snippet::registerActionForView(QWidget* view)
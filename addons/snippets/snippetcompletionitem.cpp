@@ -44,6 +44,7 @@ SnippetCompletionItem::SnippetCompletionItem( Snippet* snippet, SnippetRepositor
         m_name.prepend( QLatin1String(":") );
         m_name.prepend( repo->completionNamespace() );
     }
+    m_key = m_name.toCaseFolded();
 }
 
 SnippetCompletionItem::~SnippetCompletionItem()
@@ -47,9 +47,13 @@ public:
     void execute(KTextEditor::View* view, const KTextEditor::Range& word);
     QVariant data( const QModelIndex& index, int role, const KTextEditor::CodeCompletionModel* model ) const;
 
+    /// the case folded name, used to sort and look up items
+    const QString& key() const { return m_key; }
+
 private:
     // we copy since the snippet itself can be deleted at any time
     QString m_name;
+    QString m_key;
     QString m_snippet;
     SnippetRepository* m_repo;
 };
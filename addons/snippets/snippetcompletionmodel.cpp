@@ -32,16 +32,41 @@
 
 #include <KLocalizedString>
 
+#include <algorithm>
+
+static bool keyLessThan(const SnippetCompletionItem* item, const QString& key)
+{
+    return item->key() < key;
+}
+
+static bool itemLessThan(const SnippetCompletionItem* a, const SnippetCompletionItem* b)
+{
+    return a->key() < b->key();
+}
+
 SnippetCompletionModel::SnippetCompletionModel()
     : KTextEditor::CodeCompletionModel(0)
+    , m_indexValid(false)
+    , m_first(0)
+    , m_count(0)
 {
     setHasGroups(false);
+
+    // any change to the repositories or their snippets invalidates the index
+    SnippetStore* store = SnippetStore::self();
+    connect(store, SIGNAL(rowsInserted(QModelIndex,int,int)), this, SLOT(invalidateIndex()));
+    connect(store, SIGNAL(rowsRemoved(QModelIndex,int,int)), this, SLOT(invalidateIndex()));
+    connect(store, SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)), this, SLOT(invalidateIndex()));
+    connect(store, SIGNAL(dataChanged(QModelIndex,QModelIndex)), this, SLOT(invalidateIndex()));
+    connect(store, SIGNAL(layoutChanged()), this, SLOT(invalidateIndex()));
+    connect(store, SIGNAL(modelReset()), this, SLOT(invalidateIndex()));
 }
 
 SnippetCompletionModel::~SnippetCompletionModel()
 {
-    qDeleteAll(m_snippets);
-    m_snippets.clear();
+    foreach ( const RepositoryItems& repo, m_repositories ) {
+        qDeleteAll(repo.items);
+    }
 }
 
 QVariant SnippetCompletionModel::data( const QModelIndex& idx, int role ) const
@@ -60,28 +85,27 @@ QVariant SnippetCompletionModel::data( const QModelIndex& idx, int role ) const
         return QVariant();
     }
     // snippets
-    if( !idx.isValid() || idx.row() < 0 || idx.row() >= m_snippets.count() ) {
+    if( !idx.isValid() || idx.row() < 0 || idx.row() >= m_count ) {
         return QVariant();
     } else {
-        return m_snippets.at( idx.row() )->data(idx, role, 0);
+        return m_snippets.at( m_first + idx.row() )->data(idx, role, 0);
     }
 }
 
 void SnippetCompletionModel::executeCompletionItem (KTextEditor::View *view, const KTextEditor::Range &word, const QModelIndex &index) const
 {
     if ( index.parent().isValid() ) {
-        m_snippets[index.row()]->execute(view, word);
+        m_snippets[m_first + index.row()]->execute(view, word);
     }
 }
 
 void SnippetCompletionModel::completionInvoked(KTextEditor::View *view, const KTextEditor::Range &range, InvocationType invocationType)
 {
-    Q_UNUSED( range );
     Q_UNUSED( invocationType );
-    initData(view);
+    initData(view, view->document()->text(range));
 }
 
-void SnippetCompletionModel::initData(KTextEditor::View* view)
+void SnippetCompletionModel::initData(KTextEditor::View* view, const QString& word)
 {
     QString mode = view->document()->highlightingModeAt(view->cursorPosition());
     if ( mode.isEmpty() ) {
@@ -90,8 +114,49 @@ void SnippetCompletionModel::initData(KTextEditor::View* view)
 
     beginResetModel();
 
-    qDeleteAll(m_snippets);
+    m_snippets = itemsForMode(mode);
+    m_first = 0;
+    m_count = m_snippets.count();
+
+    // only narrow down to the first character, the completion widget does the
+    // actual matching and also accepts abbreviations of the typed word
+    if ( !word.isEmpty() ) {
+        const QString first = word.left(1).toCaseFolded();
+        QVector<SnippetCompletionItem*>::const_iterator begin =
+            std::lower_bound(m_snippets.constBegin(), m_snippets.constEnd(), first, keyLessThan);
+        QVector<SnippetCompletionItem*>::const_iterator end = begin;
+        while ( end != m_snippets.constEnd() && (*end)->key().startsWith(first) ) {
+            ++end;
+        }
+        m_first = begin - m_snippets.constBegin();
+        m_count = end - begin;
+    }
+
+    endResetModel();
+}
+
+void SnippetCompletionModel::invalidateIndex()
+{
+    if ( !m_indexValid ) {
+        return;
+    }
+
+    beginResetModel();
     m_snippets.clear();
+    m_first = 0;
+    m_count = 0;
+    endResetModel();
+
+    foreach ( const RepositoryItems& repo, m_repositories ) {
+        qDeleteAll(repo.items);
+    }
+    m_repositories.clear();
+    m_modeItems.clear();
+    m_indexValid = false;
+}
+
+void SnippetCompletionModel::buildIndex()
+{
     SnippetStore* store = SnippetStore::self();
     for(int i = 0; i < store->rowCount(); i++ )
     {
@@ -99,17 +164,42 @@ void SnippetCompletionModel::initData(KTextEditor::View* view)
             continue;
         }
         SnippetRepository* repo = dynamic_cast<SnippetRepository*>( store->item( i, 0 ) );
-        if( repo && (repo->fileTypes().isEmpty() || repo->fileTypes().contains(mode)) )
-        {
-            for ( int j = 0; j < repo->rowCount(); ++j ) {
-                if ( Snippet* snippet = dynamic_cast<Snippet*>(repo->child(j)) ) {
-                    m_snippets << new SnippetCompletionItem(snippet, repo);
-                }
+        if ( !repo ) {
+            continue;
+        }
+        RepositoryItems items;
+        items.fileTypes = repo->fileTypes();
+        items.items.reserve(repo->rowCount());
+        for ( int j = 0; j < repo->rowCount(); ++j ) {
+            if ( Snippet* snippet = dynamic_cast<Snippet*>(repo->child(j)) ) {
+                items.items << new SnippetCompletionItem(snippet, repo);
             }
         }
+        m_repositories << items;
     }
+    m_indexValid = true;
+}
 
-    endResetModel();
+const QVector<SnippetCompletionItem*>& SnippetCompletionModel::itemsForMode(const QString& mode)
+{
+    if ( !m_indexValid ) {
+        buildIndex();
+    }
+
+    QHash<QString, QVector<SnippetCompletionItem*> >::const_iterator it = m_modeItems.constFind(mode);
+    if ( it != m_modeItems.constEnd() ) {
+        return it.value();
+    }
+
+    QVector<SnippetCompletionItem*> items;
+    foreach ( const RepositoryItems& repo, m_repositories ) {
+        if ( repo.fileTypes.isEmpty() || repo.fileTypes.contains(mode) ) {
+            items += repo.items;
+        }
+    }
+    std::sort(items.begin(), items.end(), itemLessThan);
+
+    return m_modeItems.insert(mode, items).value();
 }
 
 QModelIndex SnippetCompletionModel::parent(const QModelIndex& index) const {
@@ -131,7 +221,7 @@ QModelIndex SnippetCompletionModel::index(int row, int column, const QModelIndex
         return QModelIndex();
     }
 
-    if (row < 0 || row >= m_snippets.count() || column < 0 || column >= ColumnCount ) {
+    if (row < 0 || row >= m_count || column < 0 || column >= ColumnCount ) {
         return QModelIndex();
     }
 
@@ -139,12 +229,12 @@ QModelIndex SnippetCompletionModel::index(int row, int column, const QModelIndex
 }
 
 int SnippetCompletionModel::rowCount (const QModelIndex & parent) const {
-    if (!parent.isValid() && !m_snippets.isEmpty()) {
+    if (!parent.isValid() && m_count > 0) {
         return 1; //one toplevel node (group header)
     } else if(parent.parent().isValid()) {
         return 0; //we don't have sub children
     } else {
-        return m_snippets.count(); // only the children
+        return m_count; // only the children
     }
 }
 KTextEditor::Range SnippetCompletionModel::completionRange(KTextEditor::View* view, const KTextEditor::Cursor& position)
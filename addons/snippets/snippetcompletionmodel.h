@@ -26,7 +26,10 @@
 #include <ktexteditor/codecompletionmodel.h>
 #include <ktexteditor/codecompletionmodelcontrollerinterface.h>
 
+#include <QHash>
 #include <QPointer>
+#include <QStringList>
+#include <QVector>
 
 namespace KTextEditor
 {
@@ -55,9 +58,31 @@ public:
 
     virtual KTextEditor::Range completionRange(KTextEditor::View* view, const KTextEditor::Cursor& position);
     virtual bool shouldAbortCompletion(KTextEditor::View* view, const KTextEditor::Range& range, const QString& currentCompletion);
+private Q_SLOTS:
+    /// drops the index, the next completion builds it again
+    void invalidateIndex();
+
 private:
-    void initData(KTextEditor::View* view);
-    QList<SnippetCompletionItem*> m_snippets;
+    void initData(KTextEditor::View* view, const QString& word);
+    void buildIndex();
+    const QVector<SnippetCompletionItem*>& itemsForMode(const QString& mode);
+
+    struct RepositoryItems
+    {
+        QStringList fileTypes;
+        QVector<SnippetCompletionItem*> items;
+    };
+
+    /// the snippets of all checked repositories, items are owned
+    QVector<RepositoryItems> m_repositories;
+    /// the items applicable to a mode sorted by key, filled on first use
+    QHash<QString, QVector<SnippetCompletionItem*> > m_modeItems;
+    bool m_indexValid;
+
+    /// the current completion, m_count items of m_snippets from m_first on
+    QVector<SnippetCompletionItem*> m_snippets;
+    int m_first;
+    int m_count;
 };
 
 #endif
@@ -24,8 +24,8 @@
 #include "snippetrepository.h"
 
 #include "snippet.h"
+#include "snippetrepositoryloader.h"
 
-#include <QTimer>
 #include <QFile>
 #include <QFileInfo>
 #include <QAction>
@@ -64,8 +64,10 @@ SnippetRepository::SnippetRepository(const QString& file)
     setCheckState(activated ? Qt::Checked : Qt::Unchecked);
 
     if ( QFile::exists(file) ) {
-        // Tell the new repository to load it's snippets
-        QTimer::singleShot(0, this, SLOT(slotParseFile()));
+        // Tell the new repository to load it's snippets, repositories are parsed in parallel
+        SnippetRepositoryLoader* loader = new SnippetRepositoryLoader(file);
+        connect(loader, &SnippetRepositoryLoader::loaded, this, &SnippetRepository::slotLoaded);
+        SnippetRepositoryLoader::start(loader);
     }
 
     qDebug() << "created new snippet repo" << file << this;
@@ -132,6 +134,7 @@ void SnippetRepository::setFileTypes(const QStringList& filetypes)
     } else {
         m_filetypes = filetypes;
     }
+    emitDataChanged();
 }
 
 QString SnippetRepository::license() const
@@ -152,6 +155,7 @@ QString SnippetRepository::completionNamespace() const
 void SnippetRepository::setCompletionNamespace(const QString& completionNamespace)
 {
     m_namespace = completionNamespace;
+    emitDataChanged();
 }
 
 QString SnippetRepository::script() const
@@ -162,6 +166,7 @@ QString SnippetRepository::script() const
 void SnippetRepository::setScript(const QString& script)
 {
     m_script = script;
+    emitDataChanged();
 }
 
 void SnippetRepository::remove()
@@ -271,92 +276,48 @@ void SnippetRepository::save()
     config.sync();
 }
 
-void SnippetRepository::slotParseFile()
+void SnippetRepository::slotLoaded(const SnippetRepositoryData& data)
 {
-    ///based on the code from snippets_tng/lib/completionmodel.cpp
-    ///@copyright 2009 Joseph Wenninger <jowenn@kde.org>
-
-    QFile f(m_file);
-
-    if ( !f.open(QIODevice::ReadOnly) ) {
-        KMessageBox::error( QApplication::activeWindow(), i18n("Cannot open snippet repository %1.", m_file) );
+    if ( !data.error.isEmpty() ) {
+        KMessageBox::error( QApplication::activeWindow(), data.error );
         return;
     }
 
-    QDomDocument doc;
-    QString errorMsg;
-    int line, col;
-    bool success = doc.setContent(&f, &errorMsg, &line, &col);
-    f.close();
-
-    if (!success) {
-        KMessageBox::error( QApplication::activeWindow(),
-                           i18n("<qt>The error <b>%4</b><br /> has been detected in the file %1 at %2/%3</qt>",
-                                m_file, line, col, i18nc("QXml", errorMsg.toUtf8().data())) );
-        return;
+    setLicense(data.license);
+    setAuthors(data.authors);
+    setFileTypes(data.fileTypes);
+    setText(data.name);
+    setCompletionNamespace(data.completionNamespace);
+    if ( data.hasScript ) {
+        setScript(data.script);
     }
 
-    // parse root item
-    const QDomElement& docElement = doc.documentElement();
-    if (docElement.tagName() != QLatin1String("snippets")) {
-        KMessageBox::error( QApplication::activeWindow(), i18n("Invalid XML snippet file: %1", m_file) );
-        return;
-    }
-    setLicense(docElement.attribute(QLatin1String("license")));
-    setAuthors(docElement.attribute(QLatin1String("authors")));
-    setFileTypes(docElement.attribute(QLatin1String("filetypes")).split(QLatin1Char(';'), QString::SkipEmptyParts));
-    setText(docElement.attribute(QLatin1String("name")));
-    setCompletionNamespace(docElement.attribute(QLatin1String("namespace")));
-
     // load shortcuts
     KConfigGroup config = SnippetStore::self()->getConfig().group(QLatin1String("repository ") + m_file);
 
-    // parse children, i.e. <item>'s
-    const QDomNodeList& nodes = docElement.childNodes();
-    for(int i = 0; i < nodes.size(); ++i ) {
-        const QDomNode& node = nodes.at(i);
-        if ( !node.isElement() ) {
-            continue;
-        }
-        const QDomElement& item = node.toElement();
-        if ( item.tagName() == QLatin1String("script") ) {
-            setScript(item.text());
-        }
-        if ( item.tagName() != QLatin1String("item") ) {
-            continue;
-        }
-        Snippet* snippet = new Snippet;
-        const QDomNodeList& children = node.childNodes();
-        for(int j = 0; j < children.size(); ++j) {
-            const QDomNode& childNode = children.at(j);
-            if ( !childNode.isElement() ) {
-                continue;
-            }
-            const QDomElement& child = childNode.toElement();
-            if ( child.tagName() == QLatin1String("match") ) {
-                snippet->setText(child.text());
-            } else if ( child.tagName() == QLatin1String("fillin") ) {
-                snippet->setSnippet(child.text());
-            }
-        }
-        // require at least a non-empty name and snippet
-        if ( snippet->text().isEmpty() || snippet->snippet().isEmpty() ) {
-            delete snippet;
-            continue;
-        } else {
-            const QStringList shortcuts = config.readEntry(QLatin1String("shortcut ") + snippet->text(), QStringList());
+    QList<QStandardItem*> snippets;
+    snippets.reserve(data.matches.size());
 
-            QList<QKeySequence> sequences;
+    for ( int i = 0; i < data.matches.size(); ++i ) {
+        Snippet* snippet = new Snippet;
+        snippet->setText(data.matches.at(i));
+        snippet->setSnippet(data.fillins.at(i));
 
-            foreach ( const QString &shortcut, shortcuts ) {
-              sequences << QKeySequence::fromString( shortcut );
-            }
+        const QStringList shortcuts = config.readEntry(QLatin1String("shortcut ") + snippet->text(), QStringList());
 
-            snippet->action()->setShortcuts( sequences );
+        QList<QKeySequence> sequences;
 
-            appendRow(snippet);
+        foreach ( const QString &shortcut, shortcuts ) {
+          sequences << QKeySequence::fromString( shortcut );
         }
+
+        snippet->action()->setShortcuts( sequences );
+
+        snippets << snippet;
     }
+
+    // one insertion for the whole repository
+    insertRows(rowCount(), snippets);
 }
 
 QVariant SnippetRepository::data(int role) const
@@ -29,6 +29,8 @@
 #include <QStringList>
 #include <QDir>
 
+struct SnippetRepositoryData;
+
 namespace KTextEditor
 {
 }
@@ -144,8 +146,8 @@ public:
     virtual void setData(const QVariant& value, int role = Qt::UserRole + 1);
 
 private Q_SLOTS:
-    /// parses the XML file and load the containing snippets.
-    void slotParseFile();
+    /// takes over the data of the repository file and creates the snippets.
+    void slotLoaded(const SnippetRepositoryData& data);
 
 private:
     /// path to the repository file
@@ -0,0 +1,221 @@
+/*  This file is part of the Kate project.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.LIB.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ */
+
+#include "snippetrepositoryloader.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThreadPool>
+#include <QXmlStreamReader>
+
+#include <KLocalizedString>
+
+/// bump whenever SnippetRepositoryData or its stream format changes
+static const quint32 cacheMagic = 0x534e4950; // "SNIP"
+static const quint32 cacheVersion = 1;
+
+SnippetRepositoryData SnippetRepositoryData::parse(QIODevice* device, const QString& file)
+{
+    ///based on the code from snippets_tng/lib/completionmodel.cpp
+    ///@copyright 2009 Joseph Wenninger <jowenn@kde.org>
+    SnippetRepositoryData data;
+    QXmlStreamReader xml(device);
+
+    // parse root item
+    if ( !xml.readNextStartElement() || xml.name() != QLatin1String("snippets") ) {
+        if ( !xml.hasError() ) {
+            data.error = i18n("Invalid XML snippet file: %1", file);
+            return data;
+        }
+    } else {
+        const QXmlStreamAttributes attributes = xml.attributes();
+        data.license = attributes.value(QLatin1String("license")).toString();
+        data.authors = attributes.value(QLatin1String("authors")).toString();
+        data.fileTypes = attributes.value(QLatin1String("filetypes")).toString().split(QLatin1Char(';'), QString::SkipEmptyParts);
+        data.name = attributes.value(QLatin1String("name")).toString();
+        data.completionNamespace = attributes.value(QLatin1String("namespace")).toString();
+
+        // parse children, i.e. <item>'s
+        while ( xml.readNextStartElement() ) {
+            if ( xml.name() == QLatin1String("script") ) {
+                data.hasScript = true;
+                data.script = xml.readElementText(QXmlStreamReader::IncludeChildElements);
+                continue;
+            }
+            if ( xml.name() != QLatin1String("item") ) {
+                xml.skipCurrentElement();
+                continue;
+            }
+
+            QString match;
+            QString fillin;
+            while ( xml.readNextStartElement() ) {
+                if ( xml.name() == QLatin1String("match") ) {
+                    match = xml.readElementText(QXmlStreamReader::IncludeChildElements);
+                } else if ( xml.name() == QLatin1String("fillin") ) {
+                    fillin = xml.readElementText(QXmlStreamReader::IncludeChildElements);
+                } else {
+                    xml.skipCurrentElement();
+                }
+            }
+
+            // require at least a non-empty name and snippet
+            if ( !match.isEmpty() && !fillin.isEmpty() ) {
+                data.matches << match;
+                data.fillins << fillin;
+            }
+        }
+
+        // check the rest of the document for errors, like QDomDocument does
+        while ( !xml.atEnd() ) {
+            xml.readNext();
+        }
+    }
+
+    if ( xml.hasError() ) {
+        data = SnippetRepositoryData();
+        data.error = i18n("<qt>The error <b>%4</b><br /> has been detected in the file %1 at %2/%3</qt>",
+                          file, xml.lineNumber(), xml.columnNumber(), xml.errorString());
+    }
+
+    return data;
+}
+
+QDataStream& operator<<(QDataStream& out, const SnippetRepositoryData& data)
+{
+    out << data.name << data.license << data.authors << data.completionNamespace
+        << data.fileTypes << data.hasScript << data.script
+        << data.matches << data.fillins;
+    return out;
+}
+
+QDataStream& operator>>(QDataStream& in, SnippetRepositoryData& data)
+{
+    in >> data.name >> data.license >> data.authors >> data.completionNamespace
+       >> data.fileTypes >> data.hasScript >> data.script
+       >> data.matches >> data.fillins;
+    return in;
+}
+
+SnippetRepositoryLoader::SnippetRepositoryLoader(const QString& file)
+    : m_file(file)
+{
+    // deleted with deleteLater() once the receivers are connected up
+    setAutoDelete(false);
+
+    qRegisterMetaType<SnippetRepositoryData>();
+
+    QDir dir(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation));
+    const QString subdir = QLatin1String("ktexteditor_snippets");
+    if ( dir.mkpath(subdir) ) {
+        const QByteArray key = QCryptographicHash::hash(file.toUtf8(), QCryptographicHash::Sha1).toHex();
+        m_cacheFile = dir.absoluteFilePath(subdir + QLatin1Char('/') + QString::fromLatin1(key) + QLatin1String(".cache"));
+    }
+}
+
+void SnippetRepositoryLoader::start(SnippetRepositoryLoader* loader)
+{
+    QThreadPool::globalInstance()->start(loader);
+}
+
+void SnippetRepositoryLoader::run()
+{
+    SnippetRepositoryData data;
+
+    const QFileInfo info(m_file);
+    const qint64 modified = info.lastModified().toMSecsSinceEpoch();
+    const qint64 size = info.size();
+
+    if ( !readCache(modified, size, data) ) {
+        QFile f(m_file);
+
+        if ( !f.open(QIODevice::ReadOnly) ) {
+            data.error = i18n("Cannot open snippet repository %1.", m_file);
+        } else {
+            data = SnippetRepositoryData::parse(&f, m_file);
+            f.close();
+
+            if ( data.error.isEmpty() ) {
+                writeCache(modified, size, data);
+            }
+        }
+    }
+
+    emit loaded(data);
+
+    deleteLater();
+}
+
+bool SnippetRepositoryLoader::readCache(qint64 modified, qint64 size, SnippetRepositoryData& data) const
+{
+    if ( m_cacheFile.isEmpty() ) {
+        return false;
+    }
+
+    QFile f(m_cacheFile);
+    if ( !f.open(QIODevice::ReadOnly) ) {
+        return false;
+    }
+
+    QDataStream in(&f);
+    in.setVersion(QDataStream::Qt_5_2);
+
+    quint32 magic, version;
+    qint64 cachedModified, cachedSize;
+    QString file;
+    in >> magic >> version;
+
+    if ( magic != cacheMagic || version != cacheVersion ) {
+        return false;
+    }
+
+    in >> file >> cachedModified >> cachedSize;
+
+    // the file name guards against hash collisions
+    if ( file != m_file || cachedModified != modified || cachedSize != size ) {
+        return false;
+    }
+
+    in >> data;
+
+    return in.status() == QDataStream::Ok;
+}
+
+void SnippetRepositoryLoader::writeCache(qint64 modified, qint64 size, const SnippetRepositoryData& data) const
+{
+    if ( m_cacheFile.isEmpty() ) {
+        return;
+    }
+
+    QSaveFile f(m_cacheFile);
+    if ( !f.open(QIODevice::WriteOnly) ) {
+        return;
+    }
+
+    QDataStream out(&f);
+    out.setVersion(QDataStream::Qt_5_2);
+    out << cacheMagic << cacheVersion << m_file << modified << size << data;
+
+    f.commit();
+}
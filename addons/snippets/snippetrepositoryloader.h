@@ -0,0 +1,101 @@
+/*  This file is part of the Kate project.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.LIB.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __SNIPPETREPOSITORYLOADER_H__
+#define __SNIPPETREPOSITORYLOADER_H__
+
+#include <QMetaType>
+#include <QObject>
+#include <QRunnable>
+#include <QStringList>
+
+class QDataStream;
+class QIODevice;
+
+/**
+ * The contents of a repository file, without any item or GUI state, so it
+ * can be filled on another thread.
+ */
+struct SnippetRepositoryData
+{
+    SnippetRepositoryData() : hasScript(false) {}
+
+    QString name;
+    QString license;
+    QString authors;
+    QString completionNamespace;
+    QStringList fileTypes;
+    /// the default script is kept when the file has no <script>
+    bool hasScript;
+    QString script;
+
+    /// names and contents of the snippets, same order
+    QStringList matches;
+    QStringList fillins;
+
+    /// message for the user when the file could not be read or parsed
+    QString error;
+
+    /**
+     * Parse a repository file in the format written by SnippetRepository::save().
+     * @p file is only used for error messages.
+     */
+    static SnippetRepositoryData parse(QIODevice* device, const QString& file);
+};
+
+QDataStream& operator<<(QDataStream& out, const SnippetRepositoryData& data);
+QDataStream& operator>>(QDataStream& in, SnippetRepositoryData& data);
+
+Q_DECLARE_METATYPE(SnippetRepositoryData)
+
+/**
+ * Loads a repository file on the global thread pool.
+ *
+ * The parsed data is kept in a binary cache file next to the other caches,
+ * valid as long as modification time and size of the repository file match.
+ * A warm start therefore does not parse any XML.
+ *
+ * loaded() is emitted on the pool thread, receivers in the GUI thread get it queued.
+ * The loader deletes itself afterwards.
+ */
+class SnippetRepositoryLoader : public QObject, public QRunnable
+{
+    Q_OBJECT
+
+public:
+    explicit SnippetRepositoryLoader(const QString& file);
+
+    /**
+     * Queue @p loader on the global thread pool.
+     */
+    static void start(SnippetRepositoryLoader* loader);
+
+    virtual void run();
+
+Q_SIGNALS:
+    void loaded(const SnippetRepositoryData& data);
+
+private:
+    bool readCache(qint64 modified, qint64 size, SnippetRepositoryData& data) const;
+    void writeCache(qint64 modified, qint64 size, const SnippetRepositoryData& data) const;
+
+    QString m_file;
+    QString m_cacheFile;
+};
+
+#endif
@@ -22,11 +22,8 @@
 
 #include "plugin_katesymbolviewer.h"
 
-void KatePluginSymbolViewerView::parseBashSymbols(void)
+void KatePluginSymbolViewerParser::parseBashSymbols(void)
 {
-       if (!m_mainWindow->activeView())
-               return;
-
        QString currline;
        QString funcStr(QLatin1String("function "));
 
@@ -37,29 +34,29 @@ void KatePluginSymbolViewerView::parseBashSymbols(void)
        QTreeWidgetItem *funcNode = NULL;
        QTreeWidgetItem *lastFuncNode = NULL;
 
-       QPixmap func( ( const char** ) class_xpm );
+       QImage func(class_xpm);
 
        //It is necessary to change names
-       m_func->setText(i18n("Show Functions"));
+       m_funcText = i18n("Show Functions");
 
-       if(m_plugin->treeOn)
+       if(m_options.treeOn)
        {
-               funcNode = new QTreeWidgetItem(m_symbols, QStringList(i18n("Functions") ) );
-               funcNode->setIcon(0, QIcon(func));
+               funcNode = new QTreeWidgetItem(m_parseTree, QStringList(i18n("Functions") ) );
+               funcNode->setData(0, Qt::DecorationRole, func);
 
-               if (m_plugin->expandedOn)
+               if (m_options.expandedOn)
                {
-                       m_symbols->expandItem(funcNode);
+                       expandItem(funcNode);
                }
 
                lastFuncNode = funcNode;
 
-               m_symbols->setRootIsDecorated(1);
+               setRootIsDecorated(1);
        }
        else
-               m_symbols->setRootIsDecorated(0);
+               setRootIsDecorated(0);
 
-       KTextEditor::Document *kDoc = m_mainWindow->activeView()->document();
+       const KatePluginSymbolViewerText *kDoc = &m_text;
 
        for (i = 0; i < kDoc->lines(); i++)
        {
@@ -90,16 +87,16 @@ void KatePluginSymbolViewerView::parseBashSymbols(void)
                                continue;
                        funcName.append(QLatin1String("()"));
 
-                       if (m_plugin->treeOn)
+                       if (m_options.treeOn)
                        {
                                node = new QTreeWidgetItem(funcNode, lastFuncNode);
                                lastFuncNode = node;
                        }
                        else
-                               node = new QTreeWidgetItem(m_symbols);
+                               node = new QTreeWidgetItem(m_parseTree);
 
                        node->setText(0, funcName);
-                       node->setIcon(0, QIcon(func));
+                       node->setData(0, Qt::DecorationRole, func);
                        node->setText(1, QString::number( i, 10));
                }
        } //for i loop
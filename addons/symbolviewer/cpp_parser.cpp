@@ -15,11 +15,8 @@
  ***************************************************************************/
 #include "plugin_katesymbolviewer.h"
 
-void KatePluginSymbolViewerView::parseCppSymbols(void)
+void KatePluginSymbolViewerParser::parseCppSymbols(void)
 {
-  if (!m_mainWindow->activeView())
-   return;
-
  QString cl; // Current Line
  QString stripped;
  int i, j, tmpPos = 0;
@@ -27,45 +24,45 @@ void KatePluginSymbolViewerView::parseCppSymbols(void)
  char mclass = 0, block = 0, comment = 0; // comment: 0-no comment 1-inline comment 2-multiline comment 3-string
  char macro = 0/*, macro_pos = 0*/, func_close = 0;
  bool structure = false;
- QPixmap cls( ( const char** ) class_xpm );
- QPixmap sct( ( const char** ) struct_xpm );
- QPixmap mcr( ( const char** ) macro_xpm );
- QPixmap mtd( ( const char** ) method_xpm );
+ QImage cls(class_xpm);
+ QImage sct(struct_xpm);
+ QImage mcr(macro_xpm);
+ QImage mtd(method_xpm);
 
  //It is necessary to change names to defaults
- m_macro->setText(i18n("Show Macros"));
- m_struct->setText(i18n("Show Structures"));
- m_func->setText(i18n("Show Functions"));
+ m_macroText = i18n("Show Macros");
+ m_structText = i18n("Show Structures");
+ m_funcText = i18n("Show Functions");
 
  QTreeWidgetItem *node = NULL;
  QTreeWidgetItem *mcrNode = NULL, *sctNode = NULL, *clsNode = NULL, *mtdNode = NULL;
  QTreeWidgetItem *lastMcrNode = NULL, *lastSctNode = NULL, *lastClsNode = NULL, *lastMtdNode = NULL;
 
- KTextEditor::Document *kv = m_mainWindow->activeView()->document();
+ const KatePluginSymbolViewerText *kv = &m_text;
 
  //qDebug(13000)<<"Lines counted :"<<kv->lines();
- if(m_plugin->treeOn)
+ if(m_options.treeOn)
    {
-    mcrNode = new QTreeWidgetItem(m_symbols, QStringList( i18n("Macros") ) );
-    sctNode = new QTreeWidgetItem(m_symbols, QStringList( i18n("Structures") ) );
-    clsNode = new QTreeWidgetItem(m_symbols, QStringList( i18n("Functions") ) );
-    mcrNode->setIcon(0, QIcon(mcr));
-    sctNode->setIcon(0, QIcon(sct));
-    clsNode->setIcon(0, QIcon(cls));
-    if (m_plugin->expandedOn)
+    mcrNode = new QTreeWidgetItem(m_parseTree, QStringList( i18n("Macros") ) );
+    sctNode = new QTreeWidgetItem(m_parseTree, QStringList( i18n("Structures") ) );
+    clsNode = new QTreeWidgetItem(m_parseTree, QStringList( i18n("Functions") ) );
+    mcrNode->setData(0, Qt::DecorationRole, mcr);
+    sctNode->setData(0, Qt::DecorationRole, sct);
+    clsNode->setData(0, Qt::DecorationRole, cls);
+    if (m_options.expandedOn)
       {
-       m_symbols->expandItem(mcrNode);
-       m_symbols->expandItem(sctNode);
-       m_symbols->expandItem(clsNode);
+       expandItem(mcrNode);
+       expandItem(sctNode);
+       expandItem(clsNode);
       }
     lastMcrNode = mcrNode;
     lastSctNode = sctNode;
     lastClsNode = clsNode;
     mtdNode = clsNode;
     lastMtdNode = clsNode;
-    m_symbols->setRootIsDecorated(1);
+    setRootIsDecorated(1);
    }
- else m_symbols->setRootIsDecorated(0);
+ else setRootIsDecorated(0);
 
  for (i=0; i<kv->lines(); i++)
    {
@@ -84,11 +81,13 @@ void KatePluginSymbolViewerView::parseCppSymbols(void)
        if(macro == 1)
          {
           //macro_pos = cl.indexOf(QLatin1Char('#'));
+          // only the first "define" of the line counts, look it up once and not for every column
+          const int definePos = cl.indexOf(QLatin1String("define"));
+          const bool isDefined = definePos >= 0 && cl.indexOf(QLatin1String("defined")) == definePos;
           for (j = 0; j < cl.length(); j++)
              {
               if ( ((j+1) <cl.length()) &&  (cl.at(j)==QLatin1Char('/') && cl.at(j+1)==QLatin1Char('/'))) { macro = 4; break; }
-              if (  cl.indexOf(QLatin1String("define")) == j &&
-                 !(cl.indexOf(QLatin1String("defined")) == j))
+              if (  definePos == j && !isDefined)
                     {
                      macro = 2;
                      j += 6; // skip the word "define"
@@ -110,14 +109,14 @@ void KatePluginSymbolViewerView::parseCppSymbols(void)
               stripped = stripped.trimmed();
               if (macro_on == true)
                  {
-                  if (m_plugin->treeOn)
+                  if (m_options.treeOn)
                     {
                      node = new QTreeWidgetItem(mcrNode, lastMcrNode);
                      lastMcrNode = node;
                     }
-                  else node = new QTreeWidgetItem(m_symbols);
+                  else node = new QTreeWidgetItem(m_parseTree);
                   node->setText(0, stripped);
-                  node->setIcon(0, QIcon(mcr));
+                  node->setData(0, Qt::DecorationRole, mcr);
                   node->setText(1, QString::number( i, 10));
                  }
               macro = 0;
@@ -148,17 +147,17 @@ void KatePluginSymbolViewerView::parseCppSymbols(void)
              }
           if(func_on == true)
             {
-             if (m_plugin->treeOn)
+             if (m_options.treeOn)
                {
                 node = new QTreeWidgetItem(clsNode, lastClsNode);
-                if (m_plugin->expandedOn) m_symbols->expandItem(node);
+                if (m_options.expandedOn) expandItem(node);
                 lastClsNode = node;
                 mtdNode = lastClsNode;
                 lastMtdNode = lastClsNode;
                }
-             else node = new QTreeWidgetItem(m_symbols);
+             else node = new QTreeWidgetItem(m_parseTree);
              node->setText(0, stripped);
-             node->setIcon(0, QIcon(cls));
+             node->setData(0, Qt::DecorationRole, cls);
              node->setText(1, QString::number( i, 10));
              stripped.clear();
              if (mclass == 1) mclass = 3;
@@ -193,9 +192,9 @@ void KatePluginSymbolViewerView::parseCppSymbols(void)
                { j+=2; if (j>=cl.length()) break;}
 
              // Skip char declarations that could be interpreted as range start/end
-             if ( ((cl.indexOf(QStringLiteral("'\"'"), j) == j) ||
-                 (cl.indexOf(QStringLiteral("'{'"), j) == j) ||
-                 (cl.indexOf(QStringLiteral("'}'"), j) == j)) && comment != 3 )
+             if ( ((cl.midRef(j, 3) == QLatin1String("'\"'")) ||
+                 (cl.midRef(j, 3) == QLatin1String("'{'")) ||
+                 (cl.midRef(j, 3) == QLatin1String("'}'"))) && comment != 3 )
                { j+=3; if (j>=cl.length()) break;}
 
 
@@ -243,7 +242,7 @@ void KatePluginSymbolViewerView::parseCppSymbols(void)
                       if(func_on == true)
                         {
                          QString strippedWithTypes = stripped;
-                         if (m_plugin->typesOn == false)
+                         if (m_options.typesOn == false)
                            {
                             while (stripped.indexOf(QLatin1Char('(')) >= 0)
                               stripped = stripped.left(stripped.indexOf(QLatin1Char('(')));
@@ -260,7 +259,7 @@ void KatePluginSymbolViewerView::parseCppSymbols(void)
                                   )
                               ) stripped=stripped.right(stripped.length()-1);
                            }
-                         if (m_plugin->treeOn)
+                         if (m_options.treeOn)
                            {
                             if (mclass == 4)
                               {
@@ -274,10 +273,10 @@ void KatePluginSymbolViewerView::parseCppSymbols(void)
                               }
                            }
                          else
-                             node = new QTreeWidgetItem(m_symbols);
+                             node = new QTreeWidgetItem(m_parseTree);
                          node->setText(0, stripped);
-                         if (mclass == 4) node->setIcon(0, QIcon(mtd));
-                         else node->setIcon(0, QIcon(cls));
+                         if (mclass == 4) node->setData(0, Qt::DecorationRole, mtd);
+                         else node->setData(0, Qt::DecorationRole, cls);
                          node->setText(1, QString::number( tmpPos, 10));
                          node->setToolTip(0, strippedWithTypes);
                         }
@@ -324,14 +323,14 @@ void KatePluginSymbolViewerView::parseCppSymbols(void)
                       stripped.replace(QLatin1Char('}'), QLatin1String(" "));
                       if(struct_on == true)
                         {
-                         if (m_plugin->treeOn)
+                         if (m_options.treeOn)
                            {
                             node = new QTreeWidgetItem(sctNode, lastSctNode);
                             lastSctNode = node;
                            }
-                         else node = new QTreeWidgetItem(m_symbols);
+                         else node = new QTreeWidgetItem(m_parseTree);
                          node->setText(0, stripped);
-                         node->setIcon(0, QIcon(sct));
+                         node->setData(0, Qt::DecorationRole, sct);
                          node->setText(1, QString::number( tmpPos, 10));
                         }
                       //qDebug(13000)<<"Structure -- Inserted : "<<stripped<<" at row : "<<i;
@@ -358,7 +357,7 @@ void KatePluginSymbolViewerView::parseCppSymbols(void)
       } // Comment != 1
    } // for kv->numlines
 
- //for (i= 0; i < (m_symbols->itemIndex(node) + 1); i++)
+ //for (i= 0; i < (m_parseTree->itemIndex(node) + 1); i++)
  //    qDebug(13000)<<"Symbol row :"<<positions.at(i);
 }
 
@@ -15,11 +15,8 @@
  ***************************************************************************/
 #include "plugin_katesymbolviewer.h"
 
-void KatePluginSymbolViewerView::parseEcmaSymbols(void)
+void KatePluginSymbolViewerParser::parseEcmaSymbols(void)
 {
-  // make sure there is an active view to attach to
-  if (!m_mainWindow->activeView()) return;
-
   // the current line
   QString cl;
   // the current line stripped of all comments and strings
@@ -39,19 +36,19 @@ void KatePluginSymbolViewerView::parseEcmaSymbols(void)
   // a list of inserted nodes with the index being the brace depth at insertion
   QList<QTreeWidgetItem *> nodes;
 
-  QPixmap cls( ( const char** ) class_xpm );
-  QPixmap mtd( ( const char** ) method_xpm );
+  QImage cls(class_xpm);
+  QImage mtd(method_xpm);
   QTreeWidgetItem *node = NULL;
 
-  if (m_plugin->treeOn) {
-    m_symbols->setRootIsDecorated(1);
+  if (m_options.treeOn) {
+    setRootIsDecorated(1);
   }
   else {
-    m_symbols->setRootIsDecorated(0);
+    setRootIsDecorated(0);
   }
 
   // read the document line by line
-  KTextEditor::Document *kv = m_mainWindow->activeView()->document();
+  const KatePluginSymbolViewerText *kv = &m_text;
   for (line=0; line < kv->lines(); line++) {
     // get a line to process, trimming off whitespace
     cl = kv->line(line);
@@ -129,18 +126,18 @@ void KatePluginSymbolViewerView::parseEcmaSymbols(void)
         // trim whitespace
         identifier = identifier.trimmed();
         // get the node to add the class entry to
-        if ((m_plugin->treeOn) && (! nodes.isEmpty())) {
+        if ((m_options.treeOn) && (! nodes.isEmpty())) {
           node = new QTreeWidgetItem(nodes.last());
-          if (m_plugin->expandedOn) m_symbols->expandItem(node);
+          if (m_options.expandedOn) expandItem(node);
         }
         else {
-          node = new QTreeWidgetItem(m_symbols);
+          node = new QTreeWidgetItem(m_parseTree);
         }
         // add an entry for the class
         node->setText(0, identifier);
-        node->setIcon(0, QIcon(cls));
+        node->setData(0, Qt::DecorationRole, cls);
         node->setText(1, QString::number(line, 10));
-        if (m_plugin->expandedOn) m_symbols->expandItem(node);
+        if (m_options.expandedOn) expandItem(node);
       } // (look for classes)
       
       // look for function definitions
@@ -205,24 +202,24 @@ void KatePluginSymbolViewerView::parseEcmaSymbols(void)
           if (! nodes.isEmpty()) {
             parent = nodes.last();
           }
-          if ((m_plugin->treeOn) && (parent != NULL))
+          if ((m_options.treeOn) && (parent != NULL))
             node = new QTreeWidgetItem(parent);
           else
-            node = new QTreeWidgetItem(m_symbols);
+            node = new QTreeWidgetItem(m_parseTree);
           // mark the parent as a class (if it's not the root level)
           if (parent != NULL) {
-            parent->setIcon(0, QIcon(cls));
+            parent->setData(0, Qt::DecorationRole, cls);
             // mark this function as a method of the parent
-            node->setIcon(0, QIcon(mtd));
+            node->setData(0, Qt::DecorationRole, mtd);
           }
           // mark root-level functions as classes
           else {
-            node->setIcon(0, QIcon(cls));
+            node->setData(0, Qt::DecorationRole, cls);
           }
           // add the function
           node->setText(0, identifier);
           node->setText(1, QString::number(line, 10));
-          if (m_plugin->expandedOn) m_symbols->expandItem(node);
+          if (m_options.expandedOn) expandItem(node);
         }
       } // (look for functions)
 
@@ -252,18 +249,18 @@ void KatePluginSymbolViewerView::parseEcmaSymbols(void)
           if (! nodes.isEmpty()) {
             parent = nodes.last();
           }
-          if ((m_plugin->treeOn) && (parent != NULL))
+          if ((m_options.treeOn) && (parent != NULL))
             node = new QTreeWidgetItem(parent);
           else
-            node = new QTreeWidgetItem(m_symbols);
+            node = new QTreeWidgetItem(m_parseTree);
 
           // mark the node as a class
-          node->setIcon(0, QIcon(cls));
+          node->setData(0, Qt::DecorationRole, cls);
 
           // add the id
           node->setText(0, identifier);
           node->setText(1, QString::number(line, 10));
-          if (m_plugin->expandedOn) m_symbols->expandItem(node);
+          if (m_options.expandedOn) expandItem(node);
         }
       }
 
@@ -16,11 +16,8 @@
 
 #include "plugin_katesymbolviewer.h"
 
-void KatePluginSymbolViewerView::parseFortranSymbols(void)
+void KatePluginSymbolViewerParser::parseFortranSymbols(void)
 {
- if (!m_mainWindow->activeView())
-   return;
-
  QString currline;
  QString subrStr(QLatin1String("subroutine "));
  QString funcStr(QLatin1String("function "));
@@ -35,40 +32,40 @@ void KatePluginSymbolViewerView::parseFortranSymbols(void)
  QTreeWidgetItem *subrNode = NULL, *funcNode = NULL, *modNode = NULL;
  QTreeWidgetItem *lastSubrNode = NULL, *lastFuncNode = NULL, *lastModNode = NULL;
 
- QPixmap func( ( const char** ) class_xpm );
- QPixmap subr( ( const char** ) macro_xpm );
- QPixmap mod( ( const char** ) struct_xpm );
+ QImage func(class_xpm);
+ QImage subr(macro_xpm);
+ QImage mod(struct_xpm);
 
  //It is necessary to change names
- m_macro->setText(i18n("Show Subroutines"));
- m_struct->setText(i18n("Show Modules"));
- m_func->setText(i18n("Show Functions"));
+ m_macroText = i18n("Show Subroutines");
+ m_structText = i18n("Show Modules");
+ m_funcText = i18n("Show Functions");
 
- if(m_plugin->treeOn)
+ if(m_options.treeOn)
   {
-   funcNode = new QTreeWidgetItem(m_symbols, QStringList(i18n("Functions") ) );
-   subrNode = new QTreeWidgetItem(m_symbols, QStringList( i18n("Subroutines") ) );
-   modNode = new QTreeWidgetItem(m_symbols, QStringList( i18n("Modules") ) );
-   funcNode->setIcon(0, QIcon(func));
-   modNode->setIcon(0, QIcon(mod));
-   subrNode->setIcon(0, QIcon(subr));
-
-   if (m_plugin->expandedOn)
+   funcNode = new QTreeWidgetItem(m_parseTree, QStringList(i18n("Functions") ) );
+   subrNode = new QTreeWidgetItem(m_parseTree, QStringList( i18n("Subroutines") ) );
+   modNode = new QTreeWidgetItem(m_parseTree, QStringList( i18n("Modules") ) );
+   funcNode->setData(0, Qt::DecorationRole, func);
+   modNode->setData(0, Qt::DecorationRole, mod);
+   subrNode->setData(0, Qt::DecorationRole, subr);
+
+   if (m_options.expandedOn)
       {
-       m_symbols->expandItem(funcNode);
-       m_symbols->expandItem(subrNode);
-       m_symbols->expandItem(modNode);
+       expandItem(funcNode);
+       expandItem(subrNode);
+       expandItem(modNode);
       }
 
    lastSubrNode = subrNode;
    lastFuncNode = funcNode;
    lastModNode = modNode;
-   m_symbols->setRootIsDecorated(1);
+   setRootIsDecorated(1);
   }
  else
-   m_symbols->setRootIsDecorated(0);
+   setRootIsDecorated(0);
 
- KTextEditor::Document *kDoc = m_mainWindow->activeView()->document();
+ const KatePluginSymbolViewerText *kDoc = &m_text;
 
  for (i = 0; i < kDoc->lines(); i++)
    {
@@ -150,15 +147,15 @@ void KatePluginSymbolViewerView::parseFortranSymbols(void)
                     stripped.prepend(QLatin1String("Main: "));
                 if(stripped.indexOf(QLatin1Char('='))==-1)
                   {
-                   if (m_plugin->treeOn)
+                   if (m_options.treeOn)
                      {
                       node = new QTreeWidgetItem(subrNode, lastSubrNode);
                       lastSubrNode = node;
                      }
                    else
-                      node = new QTreeWidgetItem(m_symbols);
+                      node = new QTreeWidgetItem(m_parseTree);
                    node->setText(0, stripped);
-                   node->setIcon(0, QIcon(subr));
+                   node->setData(0, Qt::DecorationRole, subr);
                    node->setText(1, QString::number( i, 10));
                   }
                 stripped.clear();
@@ -190,15 +187,15 @@ void KatePluginSymbolViewerView::parseFortranSymbols(void)
               }
             if(stripped.indexOf(QLatin1Char('='))==-1)
               {
-               if (m_plugin->treeOn)
+               if (m_options.treeOn)
                  {
                   node = new QTreeWidgetItem(modNode, lastModNode);
                   lastModNode = node;
                  }
                else
-                  node = new QTreeWidgetItem(m_symbols);
+                  node = new QTreeWidgetItem(m_parseTree);
                node->setText(0, stripped);
-               node->setIcon(0, QIcon(mod));
+               node->setData(0, Qt::DecorationRole, mod);
                node->setText(1, QString::number( i, 10));
               }
             stripped.clear();
@@ -231,15 +228,15 @@ void KatePluginSymbolViewerView::parseFortranSymbols(void)
             if(paro==parc && stripped.endsWith(QLatin1Char('&'))==false)
               {
                stripped.remove(QLatin1Char('&'));
-              if (m_plugin->treeOn)
+              if (m_options.treeOn)
                 {
                  node = new QTreeWidgetItem(funcNode, lastFuncNode);
                  lastFuncNode = node;
                 }
               else
-                 node = new QTreeWidgetItem(m_symbols);
+                 node = new QTreeWidgetItem(m_parseTree);
               node->setText(0, stripped);
-              node->setIcon(0, QIcon(func));
+              node->setData(0, Qt::DecorationRole, func);
               node->setText(1, QString::number( i, 10));
               stripped.clear();
               block=0;
@@ -15,50 +15,47 @@
  ***************************************************************************/
 #include "plugin_katesymbolviewer.h"
 
-void KatePluginSymbolViewerView::parsePerlSymbols(void)
+void KatePluginSymbolViewerParser::parsePerlSymbols(void)
 {
- if (!m_mainWindow->activeView())
-   return;
-
- m_macro->setText(i18n("Show Uses"));
- m_struct->setText(i18n("Show Pragmas"));
- m_func->setText(i18n("Show Subroutines"));
+ m_macroText = i18n("Show Uses");
+ m_structText = i18n("Show Pragmas");
+ m_funcText = i18n("Show Subroutines");
  QString cl; // Current Line
  QString stripped;
  char comment = 0;
- QPixmap cls( ( const char** ) class_xpm );
- QPixmap sct( ( const char** ) struct_xpm );
- QPixmap mcr( ( const char** ) macro_xpm );
- QPixmap cls_int( ( const char** ) class_int_xpm );
+ QImage cls(class_xpm);
+ QImage sct(struct_xpm);
+ QImage mcr(macro_xpm);
+ QImage cls_int(class_int_xpm);
  QTreeWidgetItem *node = NULL;
  QTreeWidgetItem *mcrNode = NULL, *sctNode = NULL, *clsNode = NULL;
  QTreeWidgetItem *lastMcrNode = NULL, *lastSctNode = NULL, *lastClsNode = NULL;
 
- KTextEditor::Document *kv = m_mainWindow->activeView()->document();
+ const KatePluginSymbolViewerText *kv = &m_text;
 
      //kdDebug(13000)<<"Lines counted :"<<kv->numLines()<<endl;
- if(m_plugin->treeOn)
+ if(m_options.treeOn)
    {
-    mcrNode = new QTreeWidgetItem(m_symbols, QStringList( i18n("Uses") ) );
-    sctNode = new QTreeWidgetItem(m_symbols, QStringList( i18n("Pragmas") ) );
-    clsNode = new QTreeWidgetItem(m_symbols, QStringList( i18n("Subroutines") ) );
-    mcrNode->setIcon(0, QIcon(mcr));
-    sctNode->setIcon(0, QIcon(sct));
-    clsNode->setIcon(0, QIcon(cls));
+    mcrNode = new QTreeWidgetItem(m_parseTree, QStringList( i18n("Uses") ) );
+    sctNode = new QTreeWidgetItem(m_parseTree, QStringList( i18n("Pragmas") ) );
+    clsNode = new QTreeWidgetItem(m_parseTree, QStringList( i18n("Subroutines") ) );
+    mcrNode->setData(0, Qt::DecorationRole, mcr);
+    sctNode->setData(0, Qt::DecorationRole, sct);
+    clsNode->setData(0, Qt::DecorationRole, cls);
 
-    if (m_plugin->expandedOn)
+    if (m_options.expandedOn)
       {
-       m_symbols->expandItem(mcrNode);
-       m_symbols->expandItem(sctNode);
-       m_symbols->expandItem(clsNode);
+       expandItem(mcrNode);
+       expandItem(sctNode);
+       expandItem(clsNode);
       }
     lastMcrNode = mcrNode;
     lastSctNode = sctNode;
     lastClsNode = clsNode;
-    m_symbols->setRootIsDecorated(1);
+    setRootIsDecorated(1);
    }
  else
-    m_symbols->setRootIsDecorated(0);
+    setRootIsDecorated(0);
 
  for (int i=0; i<kv->lines(); i++)
    {
@@ -83,16 +80,16 @@ void KatePluginSymbolViewerView::parsePerlSymbols(void)
        QString stripped=cl.remove( QRegExp(QLatin1String("^use +")) );
        //stripped=stripped.replace( QRegExp(QLatin1String(";$")), "" ); // Doesn't work ??
        stripped = stripped.left(stripped.indexOf(QLatin1Char(';')));
-       if (m_plugin->treeOn)
+       if (m_options.treeOn)
          {
           node = new QTreeWidgetItem(mcrNode, lastMcrNode);
           lastMcrNode = node;
          }
        else
-          node = new QTreeWidgetItem(m_symbols);
+          node = new QTreeWidgetItem(m_parseTree);
 
        node->setText(0, stripped);
-       node->setIcon(0, QIcon(mcr));
+       node->setData(0, Qt::DecorationRole, mcr);
        node->setText(1, QString::number( i, 10));
       }
 #if 1
@@ -100,16 +97,16 @@ void KatePluginSymbolViewerView::parsePerlSymbols(void)
       {
        QString stripped=cl.remove( QRegExp(QLatin1String("^use +")) );
        stripped=stripped.remove( QRegExp(QLatin1String(";$")) );
-       if (m_plugin->treeOn)
+       if (m_options.treeOn)
          {
           node = new QTreeWidgetItem(sctNode, lastSctNode);
           lastMcrNode = node;
          }
        else
-          node = new QTreeWidgetItem(m_symbols);
+          node = new QTreeWidgetItem(m_parseTree);
 
        node->setText(0, stripped);
-       node->setIcon(0, QIcon(sct));
+       node->setData(0, Qt::DecorationRole, sct);
        node->setText(1, QString::number( i, 10));
       }
 #endif
@@ -118,19 +115,19 @@ void KatePluginSymbolViewerView::parsePerlSymbols(void)
       {
        QString stripped=cl.remove( QRegExp(QLatin1String("^sub +")) );
        stripped=stripped.remove( QRegExp(QLatin1String("[{;] *$")) );
-       if (m_plugin->treeOn)
+       if (m_options.treeOn)
          {
           node = new QTreeWidgetItem(clsNode, lastClsNode);
           lastClsNode = node;
          }
        else
-          node = new QTreeWidgetItem(m_symbols);
+          node = new QTreeWidgetItem(m_parseTree);
         node->setText(0, stripped);
 
         if (!stripped.isEmpty() && stripped.at(0)==QLatin1Char('_'))
-             node->setIcon(0, QIcon(cls_int));
+             node->setData(0, Qt::DecorationRole, cls_int);
         else
-             node->setIcon(0, QIcon(cls));
+             node->setData(0, Qt::DecorationRole, cls);
 
         node->setText(1, QString::number( i, 10));
        }
@@ -65,6 +65,10 @@
 #include <QMenu>
 #include <QPainter>
 #include <QTimer>
+#include <QHeaderView>
+#include <QThreadPool>
+
+#include <algorithm>
 
 K_PLUGIN_FACTORY_WITH_JSON (KatePluginSymbolViewerFactory, "katesymbolviewerplugin.json", registerPlugin<KatePluginSymbolViewer>();)
 
@@ -80,6 +84,7 @@ KatePluginSymbolViewerView::KatePluginSymbolViewerView(KTextEditor::Plugin *plug
 
   mw->guiFactory()->addClient (this);
   m_symbols = 0;
+  m_parseSerial = 0;
 
   m_popup = new QMenu(m_symbols);
   m_popup->addAction(i18n("Refresh List"), this, SLOT(slotRefreshSymbol()));
@@ -192,9 +197,7 @@ void KatePluginSymbolViewerView::slotRefreshSymbol()
     return slotEnableSorting();
   }
   
- m_symbols->clear();
  parseSymbols();
- updateCurrTreeItem();
 }
 
 void KatePluginSymbolViewerView::slotChangeMode()
@@ -323,8 +326,179 @@ void KatePluginSymbolViewerView::parseSymbols(void)
   if (!doc)
     return;
 
+  KatePluginSymbolViewerParser::Options options;
+  options.typesOn = m_plugin->typesOn;
+  options.expandedOn = m_plugin->expandedOn;
+  options.treeOn = m_plugin->treeOn;
+  options.macroOn = macro_on;
+  options.structOn = struct_on;
+  options.funcOn = func_on;
+  options.sortOn = m_symbols->isSortingEnabled();
+  options.sortColumn = m_symbols->sortColumn();
+  options.sortOrder = m_symbols->header()->sortIndicatorOrder();
+  options.rootIsDecorated = m_symbols->rootIsDecorated();
+
+  // copying the lines is cheap, their text is shared with the document
+  QStringList lines;
+  lines.reserve(doc->lines());
+  for (int i = 0; i < doc->lines(); i++)
+    lines << doc->line(i);
+
+  // a parse still running is not stopped, its result is dropped once it arrives
+  KatePluginSymbolViewerParser *parser = new KatePluginSymbolViewerParser(++m_parseSerial, doc->mode(), lines, options);
+  connect(parser, SIGNAL(done(KatePluginSymbolViewerParser*)), this, SLOT(slotSymbolsParsed(KatePluginSymbolViewerParser*)));
+  QThreadPool::globalInstance()->start(parser);
+}
+
+void KatePluginSymbolViewerView::slotSymbolsParsed(KatePluginSymbolViewerParser *parser)
+{
+  if (parser->serial() != m_parseSerial)
+    return;
+
+  if (!parser->macroText().isEmpty()) m_macro->setText(parser->macroText());
+  if (!parser->structText().isEmpty()) m_struct->setText(parser->structText());
+  if (!parser->funcText().isEmpty()) m_func->setText(parser->funcText());
+
+  // the parsed symbols are merged into m_symbols,
+  // so refreshing keeps the expansion, selection and scroll position
+  QTreeWidgetItem *symbols = parser->takeSymbols();
+  QHash<qint64, QIcon> icons;
+  setSymbolIcons(symbols, icons);
+
+  m_symbols->setRootIsDecorated(parser->rootIsDecorated());
+  syncSymbols(m_symbols->invisibleRootItem(), symbols);
+  delete symbols;
+
+  updateCurrTreeItem();
+}
+
+void KatePluginSymbolViewerView::setSymbolIcons(QTreeWidgetItem *item, QHash<qint64, QIcon> &icons)
+{
+  // pixmaps can only be created on the GUI thread, the parsers leave images
+  const QVariant decoration = item->data(0, Qt::DecorationRole);
+  if (decoration.type() == QVariant::Image) {
+    const QImage image = decoration.value<QImage>();
+    if (!icons.contains(image.cacheKey()))
+      icons.insert(image.cacheKey(), QIcon(QPixmap::fromImage(image)));
+    item->setIcon(0, icons.value(image.cacheKey()));
+  }
+
+  for (int i = 0; i < item->childCount(); i++) {
+    setSymbolIcons(item->child(i), icons);
+  }
+}
+
+void KatePluginSymbolViewerView::syncSymbols(QTreeWidgetItem *target, QTreeWidgetItem *source)
+{
+  // how far to look ahead for a symbol that is still there
+  static const int lookAhead = 8;
+
+  int i;
+  for (i = 0; i < source->childCount(); i++) {
+    QTreeWidgetItem *from = source->child(i);
+
+    // skip symbols that vanished from the document
+    int match = -1;
+    for (int j = i; j < target->childCount() && j < i + lookAhead; j++) {
+      if (target->child(j)->text(0) == from->text(0)) {
+        match = j;
+        break;
+      }
+    }
+
+    if (match < 0) {
+      QTreeWidgetItem *item = from->clone();
+      target->insertChild(i, item);
+      copyExpansion(item, from);
+      continue;
+    }
+
+    for (int j = i; j < match; j++) {
+      delete target->takeChild(i);
+    }
+
+    // same symbol, only refresh its data
+    QTreeWidgetItem *item = target->child(i);
+    if (item->text(1) != from->text(1)) item->setText(1, from->text(1));
+    if (item->toolTip(0) != from->toolTip(0)) item->setToolTip(0, from->toolTip(0));
+    item->setIcon(0, from->icon(0));
+    syncSymbols(item, from);
+  }
+
+  while (target->childCount() > i) {
+    delete target->takeChild(i);
+  }
+}
+
+void KatePluginSymbolViewerView::copyExpansion(QTreeWidgetItem *target, QTreeWidgetItem *source)
+{
+  target->setExpanded(source->data(0, KatePluginSymbolViewerParser::ExpandedRole).toBool());
+  for (int i = 0; i < source->childCount() && i < target->childCount(); i++) {
+    copyExpansion(target->child(i), source->child(i));
+  }
+}
+
+void KatePluginSymbolViewerView::goToSymbol(QTreeWidgetItem *it)
+{
+  KTextEditor::View *kv = m_mainWindow->activeView();
+
+  // be sure we really have a view !
+  if (!kv)
+    return;
+
+  //qDebug()<<"Slot Activated at pos: "<<m_symbols->indexOfTopLevelItem(it);
+
+  kv->setCursorPosition (KTextEditor::Cursor (it->text(1).toInt(NULL, 10), 0));
+}
+
+namespace {
+struct SymbolLessThan
+{
+  SymbolLessThan(int column, Qt::SortOrder order) : column(column), order(order) {}
+
+  bool operator()(const QTreeWidgetItem *a, const QTreeWidgetItem *b) const
+  {
+    return order == Qt::AscendingOrder ? a->text(column) < b->text(column) : b->text(column) < a->text(column);
+  }
+
+  int column;
+  Qt::SortOrder order;
+};
+}
+
+KatePluginSymbolViewerParser::KatePluginSymbolViewerParser(int serial, const QString &mode, const QStringList &lines, const Options &options)
+: QObject()
+, m_serial(serial)
+, m_mode(mode)
+, m_options(options)
+, macro_on(options.macroOn)
+, struct_on(options.structOn)
+, func_on(options.funcOn)
+, m_parseTree(new QTreeWidgetItem())
+, m_rootIsDecorated(options.rootIsDecorated)
+{
+  m_text.m_lines = lines;
+
+  // deleted by itself after done() was emitted
+  setAutoDelete(false);
+}
+
+KatePluginSymbolViewerParser::~KatePluginSymbolViewerParser()
+{
+  delete m_parseTree;
+}
+
+QTreeWidgetItem *KatePluginSymbolViewerParser::takeSymbols()
+{
+  QTreeWidgetItem *symbols = m_parseTree;
+  m_parseTree = 0;
+  return symbols;
+}
+
+void KatePluginSymbolViewerParser::run()
+{
   /** Get the current highlighting mode */
-  QString hlModeName = doc->mode();
+  const QString &hlModeName = m_mode;
 
   if (hlModeName.contains(QLatin1String("C++")) || hlModeName == QLatin1String("C") || hlModeName == QLatin1String("ANSI C89"))
      parseCppSymbols();
@@ -351,20 +525,30 @@ void KatePluginSymbolViewerView::parseSymbols(void)
     hlModeName == QLatin1String("QML"))
      parseEcmaSymbols();
   else
-    new QTreeWidgetItem(m_symbols,  QStringList(i18n("Sorry. Language not supported yet") ) );
+    new QTreeWidgetItem(m_parseTree,  QStringList(i18n("Sorry. Language not supported yet") ) );
+
+  if (m_options.sortOn)
+    sortSymbols(m_parseTree);
+
+  emit done(this);
+  deleteLater();
 }
 
-void KatePluginSymbolViewerView::goToSymbol(QTreeWidgetItem *it)
+void KatePluginSymbolViewerParser::expandItem(QTreeWidgetItem *item)
 {
-  KTextEditor::View *kv = m_mainWindow->activeView();
-
-  // be sure we really have a view !
-  if (!kv)
-    return;
+  item->setData(0, ExpandedRole, true);
+}
 
-  //qDebug()<<"Slot Activated at pos: "<<m_symbols->indexOfTopLevelItem(it);
+void KatePluginSymbolViewerParser::sortSymbols(QTreeWidgetItem *item)
+{
+  // like QTreeWidget::sortItems(), which needs a tree widget
+  QList<QTreeWidgetItem *> children = item->takeChildren();
+  std::stable_sort(children.begin(), children.end(), SymbolLessThan(m_options.sortColumn, m_options.sortOrder));
+  item->addChildren(children);
 
-  kv->setCursorPosition (KTextEditor::Cursor (it->text(1).toInt(NULL, 10), 0));
+  for (int i = 0; i < children.size(); i++) {
+    sortSymbols(children.at(i));
+  }
 }
 
 KatePluginSymbolViewer::KatePluginSymbolViewer( QObject* parent, const QList<QVariant>& )
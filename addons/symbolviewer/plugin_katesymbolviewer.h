@@ -28,11 +28,16 @@
 #include <QMenu>
 #include <QCheckBox>
 
+#include <QHash>
+#include <QIcon>
+#include <QImage>
 #include <QPixmap>
 #include <QLabel>
 #include <QResizeEvent>
 #include <QTreeWidget>
 #include <QList>
+#include <QRunnable>
+#include <QStringList>
 #include <QTimer>
 
 #include <klocalizedstring.h>
@@ -82,6 +87,91 @@ class KatePluginSymbolViewerConfigPage : public KTextEditor::ConfigPage
 
 class KatePluginSymbolViewer;
 
+/**
+ * The lines of a document, copied for a parser running on another thread
+ */
+class KatePluginSymbolViewerText
+{
+  public:
+    int lines() const { return m_lines.size(); }
+    QString line(int line) const { return m_lines.value(line); }
+
+    QStringList m_lines;
+};
+
+/**
+ * Parses a copy of a document on the thread pool.
+ *
+ * The symbols are collected below a root item that belongs to no tree
+ * widget, icons are stored as images and set by the view. done() is
+ * delivered to the GUI thread, the parser deletes itself afterwards.
+ */
+class KatePluginSymbolViewerParser : public QObject, public QRunnable
+{
+  Q_OBJECT
+
+  public:
+    struct Options {
+      bool typesOn;
+      bool expandedOn;
+      bool treeOn;
+      bool macroOn;
+      bool structOn;
+      bool funcOn;
+      bool sortOn;
+      int sortColumn;
+      Qt::SortOrder sortOrder;
+      bool rootIsDecorated;
+    };
+
+    /// set on items that are expanded when they are added to the list
+    static const int ExpandedRole = Qt::UserRole + 1;
+
+    KatePluginSymbolViewerParser(int serial, const QString &mode, const QStringList &lines, const Options &options);
+    ~KatePluginSymbolViewerParser();
+
+    void run();
+
+    int serial() const { return m_serial; }
+    bool rootIsDecorated() const { return m_rootIsDecorated; }
+    QString macroText() const { return m_macroText; }
+    QString structText() const { return m_structText; }
+    QString funcText() const { return m_funcText; }
+
+    /// the parsed symbols, owned by the caller
+    QTreeWidgetItem *takeSymbols();
+
+  Q_SIGNALS:
+    void done(KatePluginSymbolViewerParser *parser);
+
+  private:
+    void expandItem(QTreeWidgetItem *item);
+    void setRootIsDecorated(bool decorated) { m_rootIsDecorated = decorated; }
+    void sortSymbols(QTreeWidgetItem *item);
+
+    void parseCppSymbols(void);
+    void parseTclSymbols(void);
+    void parseFortranSymbols(void);
+    void parsePerlSymbols(void);
+    void parsePythonSymbols(void);
+    void parseRubySymbols(void);
+    void parseXsltSymbols(void);
+    void parsePhpSymbols(void);
+    void parseBashSymbols(void);
+    void parseEcmaSymbols(void);
+
+  private:
+    int m_serial;
+    QString m_mode;
+    KatePluginSymbolViewerText m_text;
+    Options m_options;
+    bool macro_on, struct_on, func_on;
+
+    QTreeWidgetItem *m_parseTree;
+    bool m_rootIsDecorated;
+    QString m_macroText, m_structText, m_funcText;
+};
+
 class KatePluginSymbolViewerView :  public QObject, public KXMLGUIClient
 {
   Q_OBJECT
@@ -106,6 +196,7 @@ class KatePluginSymbolViewerView :  public QObject, public KXMLGUIClient
     QTreeWidgetItem *newActveItem(int &currMinLine, int currLine, QTreeWidgetItem *item);
     void updateCurrTreeItem();
     void slotDocEdited();
+    void slotSymbolsParsed(KatePluginSymbolViewerParser *parser);
 
   protected:
     bool eventFilter(QObject *obj, QEvent *ev);
@@ -116,6 +207,7 @@ class KatePluginSymbolViewerView :  public QObject, public KXMLGUIClient
     QMenu       *m_popup;
     QWidget     *m_toolview;
     QTreeWidget *m_symbols;
+    int m_parseSerial;
     QAction *m_macro, *m_struct, *m_func, *m_sort;
     bool macro_on, struct_on, func_on;
 
@@ -123,18 +215,9 @@ class KatePluginSymbolViewerView :  public QObject, public KXMLGUIClient
     QTimer m_currItemTimer;
 
     void updatePixmapScroll();
-
-    void parseCppSymbols(void);
-    void parseTclSymbols(void);
-    void parseFortranSymbols(void);
-    void parsePerlSymbols(void);
-    void parsePythonSymbols(void);
-    void parseRubySymbols(void);
-    void parseXsltSymbols(void);
-    void parsePhpSymbols(void);
-    void parseBashSymbols(void);
-    void parseEcmaSymbols(void);
-
+    void syncSymbols(QTreeWidgetItem *target, QTreeWidgetItem *source);
+    void copyExpansion(QTreeWidgetItem *target, QTreeWidgetItem *source);
+    void setSymbolIcons(QTreeWidgetItem *item, QHash<qint64, QIcon> &icons);
 };
 
 class KatePluginSymbolViewer : public KTextEditor::Plugin
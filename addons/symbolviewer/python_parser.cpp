@@ -15,19 +15,16 @@
  ***************************************************************************/
 #include "plugin_katesymbolviewer.h"
 
-void KatePluginSymbolViewerView::parsePythonSymbols(void)
+void KatePluginSymbolViewerParser::parsePythonSymbols(void)
 {
-  if (!m_mainWindow->activeView())
-   return;
-
-  m_macro->setText(i18n("Show Globals"));
-  m_struct->setText(i18n("Show Methods"));
-  m_func->setText(i18n("Show Classes"));
+  m_macroText = i18n("Show Globals");
+  m_structText = i18n("Show Methods");
+  m_funcText = i18n("Show Classes");
 
   QString cl; // Current Line
-  QPixmap cls( ( const char** ) class_xpm );
-  QPixmap mtd( ( const char** ) method_xpm );
-  QPixmap mcr( ( const char** ) macro_xpm );
+  QImage cls(class_xpm);
+  QImage mtd(method_xpm);
+  QImage mcr(macro_xpm);
   
   int in_class = 0, state = 0, j;
   QString name;
@@ -36,29 +33,29 @@ void KatePluginSymbolViewerView::parsePythonSymbols(void)
   QTreeWidgetItem *mcrNode = NULL, *mtdNode = NULL, *clsNode = NULL;
   QTreeWidgetItem *lastMcrNode = NULL, *lastMtdNode = NULL, *lastClsNode = NULL;
   
-  KTextEditor::Document *kv = m_mainWindow->activeView()->document();
+  const KatePluginSymbolViewerText *kv = &m_text;
 
  //kdDebug(13000)<<"Lines counted :"<<kv->numLines()<<endl;
-  if(m_plugin->treeOn)
+  if(m_options.treeOn)
     {
-      clsNode = new QTreeWidgetItem(m_symbols, QStringList( i18n("Classes") ) );
-      mcrNode = new QTreeWidgetItem(m_symbols, QStringList( i18n("Globals") ) );
-      mcrNode->setIcon(0, QIcon(mcr));
-      clsNode->setIcon(0, QIcon(cls));
+      clsNode = new QTreeWidgetItem(m_parseTree, QStringList( i18n("Classes") ) );
+      mcrNode = new QTreeWidgetItem(m_parseTree, QStringList( i18n("Globals") ) );
+      mcrNode->setData(0, Qt::DecorationRole, mcr);
+      clsNode->setData(0, Qt::DecorationRole, cls);
   
-      if (m_plugin->expandedOn)
+      if (m_options.expandedOn)
         {
-        m_symbols->expandItem(mcrNode);
-        m_symbols->expandItem(clsNode);
+        expandItem(mcrNode);
+        expandItem(clsNode);
         }
       lastClsNode = clsNode;
       lastMcrNode = mcrNode;
       mtdNode = clsNode;
       lastMtdNode = clsNode;
-      m_symbols->setRootIsDecorated(1);
+      setRootIsDecorated(1);
     }
   else
-      m_symbols->setRootIsDecorated(0);
+      setRootIsDecorated(0);
 
 for (int i=0; i<kv->lines(); i++)
  {
@@ -111,46 +108,46 @@ for (int i=0; i<kv->lines(); i++)
 
           if (func_on == true && in_class == 1)
             {
-             if (m_plugin->treeOn)
+             if (m_options.treeOn)
                {
                 node = new QTreeWidgetItem(clsNode, lastClsNode);
-                if (m_plugin->expandedOn) m_symbols->expandItem(node);
+                if (m_options.expandedOn) expandItem(node);
                 lastClsNode = node;
                 mtdNode = lastClsNode;
                 lastMtdNode = lastClsNode;
                }
-             else node = new QTreeWidgetItem(m_symbols);
+             else node = new QTreeWidgetItem(m_parseTree);
 
              node->setText(0, name);
-             node->setIcon(0, QIcon(cls));
+             node->setData(0, Qt::DecorationRole, cls);
              node->setText(1, QString::number( line, 10));
             }
 
          if (struct_on == true && in_class == 2)
            {
-            if (m_plugin->treeOn)
+            if (m_options.treeOn)
               {
                node = new QTreeWidgetItem(mtdNode, lastMtdNode);
                lastMtdNode = node;
               }
-            else node = new QTreeWidgetItem(m_symbols);
+            else node = new QTreeWidgetItem(m_parseTree);
 
             node->setText(0, name);
-            node->setIcon(0, QIcon(mtd));
+            node->setData(0, Qt::DecorationRole, mtd);
             node->setText(1, QString::number( line, 10));
            }
 
           if (macro_on == true && in_class == 0)
             {
-             if (m_plugin->treeOn)
+             if (m_options.treeOn)
                {
                 node = new QTreeWidgetItem(mcrNode, lastMcrNode);
                 lastMcrNode = node;
                }
-             else node = new QTreeWidgetItem(m_symbols);
+             else node = new QTreeWidgetItem(m_parseTree);
 
              node->setText(0, name);
-             node->setIcon(0, QIcon(mcr));
+             node->setData(0, Qt::DecorationRole, mcr);
              node->setText(1, QString::number( line, 10));
             }
 
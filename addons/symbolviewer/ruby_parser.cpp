@@ -15,19 +15,16 @@
  ***************************************************************************/
 #include "plugin_katesymbolviewer.h"
 
-void KatePluginSymbolViewerView::parseRubySymbols(void)
+void KatePluginSymbolViewerParser::parseRubySymbols(void)
 {
-  if (!m_mainWindow->activeView())
-   return;
-
- m_macro->setText(i18n("Show Globals"));
- m_struct->setText(i18n("Show Methods"));
- m_func->setText(i18n("Show Classes"));
+ m_macroText = i18n("Show Globals");
+ m_structText = i18n("Show Methods");
+ m_funcText = i18n("Show Classes");
 
  QString cl; // Current Line
- QPixmap cls( ( const char** ) class_xpm );
- QPixmap mtd( ( const char** ) method_xpm );
- QPixmap mcr( ( const char** ) macro_xpm );
+ QImage cls(class_xpm);
+ QImage mtd(method_xpm);
+ QImage mcr(macro_xpm);
 
  int i;
  QString name;
@@ -36,22 +33,22 @@ void KatePluginSymbolViewerView::parseRubySymbols(void)
  QTreeWidgetItem *mtdNode = NULL, *clsNode = NULL;
  QTreeWidgetItem *lastMtdNode = NULL, *lastClsNode = NULL;
 
- KTextEditor::Document *kv = m_mainWindow->activeView()->document();
+ const KatePluginSymbolViewerText *kv = &m_text;
  //kdDebug(13000)<<"Lines counted :"<<kv->numLines()<<endl;
 
- if(m_plugin->treeOn)
+ if(m_options.treeOn)
    {
-    clsNode = new QTreeWidgetItem(m_symbols);
+    clsNode = new QTreeWidgetItem(m_parseTree);
     clsNode->setText(0, i18n("Classes"));
-    clsNode->setIcon(0, QIcon(cls));
-    if (m_plugin->expandedOn) m_symbols->expandItem(clsNode);
+    clsNode->setData(0, Qt::DecorationRole, cls);
+    if (m_options.expandedOn) expandItem(clsNode);
     lastClsNode = clsNode;
     mtdNode = clsNode;
     lastMtdNode = clsNode;
-    m_symbols->setRootIsDecorated(1);
+    setRootIsDecorated(1);
    }
  else
-     m_symbols->setRootIsDecorated(0);
+     setRootIsDecorated(0);
 
  for (i=0; i<kv->lines(); i++)
    {
@@ -62,17 +59,17 @@ void KatePluginSymbolViewerView::parseRubySymbols(void)
        {
           if (func_on == true)
             {
-             if (m_plugin->treeOn)
+             if (m_options.treeOn)
                {
                 node = new QTreeWidgetItem(clsNode, lastClsNode);
-                if (m_plugin->expandedOn) m_symbols->expandItem(node);
+                if (m_options.expandedOn) expandItem(node);
                 lastClsNode = node;
                 mtdNode = lastClsNode;
                 lastMtdNode = lastClsNode;
                }
-             else node = new QTreeWidgetItem(m_symbols);
+             else node = new QTreeWidgetItem(m_parseTree);
              node->setText(0, cl.mid(6));
-             node->setIcon(0, QIcon(cls));
+             node->setData(0, Qt::DecorationRole, cls);
              node->setText(1, QString::number( i, 10));
             }
        }
@@ -80,21 +77,21 @@ void KatePluginSymbolViewerView::parseRubySymbols(void)
        {
         if (struct_on == true)
           {
-           if (m_plugin->treeOn)
+           if (m_options.treeOn)
              {
               node = new QTreeWidgetItem(mtdNode, lastMtdNode);
               lastMtdNode = node;
              }
-           else node = new QTreeWidgetItem(m_symbols);
+           else node = new QTreeWidgetItem(m_parseTree);
            
            name = cl.mid(4);
            node->setToolTip(0, name);
-           if (m_plugin->typesOn == false)
+           if (m_options.typesOn == false)
             {
             name = name.left(name.indexOf(QLatin1Char('(')));
             }
            node->setText(0, name);
-           node->setIcon(0, QIcon(mtd));
+           node->setData(0, Qt::DecorationRole, mtd);
            node->setText(1, QString::number( i, 10));
           }
        }
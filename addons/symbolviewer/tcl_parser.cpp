@@ -15,13 +15,10 @@
  ***************************************************************************/
 
 #include "plugin_katesymbolviewer.h"
-#include <QPixmap>
+#include <QImage>
 
-void KatePluginSymbolViewerView::parseTclSymbols(void)
+void KatePluginSymbolViewerParser::parseTclSymbols(void)
 {
-  if (!m_mainWindow->activeView())
-   return;
-
  QString currline, prevline;
  bool    prevComment = false;
  QString varStr(QLatin1String("set "));
@@ -34,32 +31,32 @@ void KatePluginSymbolViewerView::parseTclSymbols(void)
  QTreeWidgetItem *mcrNode = NULL, *clsNode = NULL;
  QTreeWidgetItem *lastMcrNode = NULL, *lastClsNode = NULL;
 
- QPixmap mcr( ( const char** ) macro_xpm );
- QPixmap cls( ( const char** ) class_xpm );
+ QImage mcr(macro_xpm);
+ QImage cls(class_xpm);
 
- if(m_plugin->treeOn)
+ if(m_options.treeOn)
   {
-   clsNode = new QTreeWidgetItem(m_symbols, QStringList( i18n("Functions") ) );
-   mcrNode = new QTreeWidgetItem(m_symbols, QStringList( i18n("Globals") ) );
-   clsNode->setIcon(0, QIcon(cls));
-   mcrNode->setIcon(0, QIcon(mcr));
+   clsNode = new QTreeWidgetItem(m_parseTree, QStringList( i18n("Functions") ) );
+   mcrNode = new QTreeWidgetItem(m_parseTree, QStringList( i18n("Globals") ) );
+   clsNode->setData(0, Qt::DecorationRole, cls);
+   mcrNode->setData(0, Qt::DecorationRole, mcr);
 
    lastMcrNode = mcrNode;
    lastClsNode = clsNode;
 
-   if (m_plugin->expandedOn)
+   if (m_options.expandedOn)
       {
-       m_symbols->expandItem(clsNode);
-       m_symbols->expandItem(mcrNode);
+       expandItem(clsNode);
+       expandItem(mcrNode);
       }
-   m_symbols->setRootIsDecorated(1);
+   setRootIsDecorated(1);
   }
  else
-   m_symbols->setRootIsDecorated(0);
+   setRootIsDecorated(0);
 
- KTextEditor::Document *kDoc = m_mainWindow->activeView()->document();
+ const KatePluginSymbolViewerText *kDoc = &m_text;
 
- //positions.resize(kDoc->numLines() + 3); // Maximum m_symbols number o.O
+ //positions.resize(kDoc->numLines() + 3); // Maximum m_parseTree number o.O
  //positions.fill(0);
 
  for (i = 0; i<kDoc->lines(); i++)
@@ -90,15 +87,15 @@ void KatePluginSymbolViewerView::parseTclSymbols(void)
              //fnd = stripped.indexOf(QLatin1Char(';'));
              if(fnd > 0) stripped = stripped.left(fnd);
 
-             if (m_plugin->treeOn)
+             if (m_options.treeOn)
                {
                 node = new QTreeWidgetItem(mcrNode, lastMcrNode);
                 lastMcrNode = node;
                }
              else
-                node = new QTreeWidgetItem(m_symbols);
+                node = new QTreeWidgetItem(m_parseTree);
              node->setText(0, stripped);
-             node->setIcon(0, QIcon(mcr));
+             node->setData(0, Qt::DecorationRole, mcr);
              node->setText(1, QString::number( i, 10));
              stripped.clear();
             }//macro
@@ -131,15 +128,15 @@ void KatePluginSymbolViewerView::parseTclSymbols(void)
                              //stripped = stripped.simplified();
                              if(func_on == true)
                                {
-                                if (m_plugin->treeOn)
+                                if (m_options.treeOn)
                                   {
                                    node = new QTreeWidgetItem(clsNode, lastClsNode);
                                    lastClsNode = node;
                                   }
                                 else
-                                   node = new QTreeWidgetItem(m_symbols);
+                                   node = new QTreeWidgetItem(m_parseTree);
                                 node->setText(0, stripped);
-                                node->setIcon(0, QIcon(cls));
+                                node->setData(0, Qt::DecorationRole, cls);
                                 node->setText(1, QString::number( i, 10));
                                }
                              stripped.clear();
@@ -152,6 +149,6 @@ void KatePluginSymbolViewerView::parseTclSymbols(void)
       } // not a comment
     } //for i loop
 
- //positions.resize(m_symbols->itemIndex(node) + 1);
+ //positions.resize(m_parseTree->itemIndex(node) + 1);
 }
 
@@ -16,14 +16,11 @@
 
 #include "plugin_katesymbolviewer.h"
 
-void KatePluginSymbolViewerView::parseXsltSymbols(void)
+void KatePluginSymbolViewerParser::parseXsltSymbols(void)
 {
-  if (!m_mainWindow->activeView())
-   return;
-
- m_macro->setText(i18n("Show Params"));
- m_struct->setText(i18n("Show Variables"));
- m_func->setText(i18n("Show Templates"));
+ m_macroText = i18n("Show Params");
+ m_structText = i18n("Show Variables");
+ m_funcText = i18n("Show Templates");
 
  QString cl; // Current Line
  QString stripped;
@@ -32,44 +29,44 @@ void KatePluginSymbolViewerView::parseXsltSymbols(void)
  char templ = 0;
  int i;
 
- QPixmap cls( ( const char** ) class_xpm );
- QPixmap sct( ( const char** ) struct_xpm );
- QPixmap mcr( ( const char** ) macro_xpm );
- QPixmap cls_int( ( const char** ) class_int_xpm );
+ QImage cls(class_xpm);
+ QImage sct(struct_xpm);
+ QImage mcr(macro_xpm);
+ QImage cls_int(class_int_xpm);
 
  QTreeWidgetItem *node = NULL;
  QTreeWidgetItem *mcrNode = NULL, *sctNode = NULL, *clsNode = NULL;
  QTreeWidgetItem *lastMcrNode = NULL, *lastSctNode = NULL, *lastClsNode = NULL;
 
- KTextEditor::Document *kv = m_mainWindow->activeView()->document();
+ const KatePluginSymbolViewerText *kv = &m_text;
  //kdDebug(13000)<<"Lines counted :"<<kv->numLines()<<endl;
 
 
- if(m_plugin->treeOn)
+ if(m_options.treeOn)
    {
-    mcrNode = new QTreeWidgetItem(m_symbols, QStringList( i18n("Params") ) );
-    sctNode = new QTreeWidgetItem(m_symbols, QStringList( i18n("Variables") ) );
-    clsNode = new QTreeWidgetItem(m_symbols, QStringList( i18n("Templates") ) );
-    mcrNode->setIcon(0, QIcon(mcr));
-    sctNode->setIcon(0, QIcon(sct));
-    clsNode->setIcon(0, QIcon(cls));
-
-    if (m_plugin->expandedOn) 
+    mcrNode = new QTreeWidgetItem(m_parseTree, QStringList( i18n("Params") ) );
+    sctNode = new QTreeWidgetItem(m_parseTree, QStringList( i18n("Variables") ) );
+    clsNode = new QTreeWidgetItem(m_parseTree, QStringList( i18n("Templates") ) );
+    mcrNode->setData(0, Qt::DecorationRole, mcr);
+    sctNode->setData(0, Qt::DecorationRole, sct);
+    clsNode->setData(0, Qt::DecorationRole, cls);
+
+    if (m_options.expandedOn) 
       {
-       m_symbols->expandItem(mcrNode);
-       m_symbols->expandItem(sctNode);
-       m_symbols->expandItem(clsNode);
+       expandItem(mcrNode);
+       expandItem(sctNode);
+       expandItem(clsNode);
       }
 
     lastMcrNode = mcrNode;
     lastSctNode = sctNode;
     lastClsNode = clsNode;
 
-    m_symbols->setRootIsDecorated(1);
+    setRootIsDecorated(1);
    }
  else
    {
-    m_symbols->setRootIsDecorated(0);
+    setRootIsDecorated(0);
    }
 
  for (i=0; i<kv->lines(); i++)
@@ -90,14 +87,14 @@ void KatePluginSymbolViewerView::parseXsltSymbols(void)
         QString stripped = cl.remove(QRegExp(QLatin1String("^<xsl:param +name=\"")));
         stripped = stripped.remove(QRegExp(QLatin1String("\".*")));
 
-        if (m_plugin->treeOn)
+        if (m_options.treeOn)
           {
            node = new QTreeWidgetItem(mcrNode, lastMcrNode);
            lastMcrNode = node;
           }
-        else node = new QTreeWidgetItem(m_symbols);
+        else node = new QTreeWidgetItem(m_parseTree);
         node->setText(0, stripped);
-        node->setIcon(0, QIcon(mcr));
+        node->setData(0, Qt::DecorationRole, mcr);
         node->setText(1, QString::number( i, 10));
        }
 
@@ -106,14 +103,14 @@ void KatePluginSymbolViewerView::parseXsltSymbols(void)
         QString stripped = cl.remove(QRegExp(QLatin1String("^<xsl:variable +name=\"")));
         stripped = stripped.remove(QRegExp(QLatin1String("\".*")));
 
-        if (m_plugin->treeOn)
+        if (m_options.treeOn)
           {
            node = new QTreeWidgetItem(sctNode, lastSctNode);
            lastSctNode = node;
           }
-        else node = new QTreeWidgetItem(m_symbols);
+        else node = new QTreeWidgetItem(m_parseTree);
         node->setText(0, stripped);
-        node->setIcon(0, QIcon(sct));
+        node->setData(0, Qt::DecorationRole, sct);
         node->setText(1, QString::number( i, 10));
        }
 
@@ -122,14 +119,14 @@ void KatePluginSymbolViewerView::parseXsltSymbols(void)
         QString stripped = cl.remove(QRegExp(QLatin1String("^<xsl:template +match=\"")));
         stripped = stripped.remove(QRegExp(QLatin1String("\".*")));
 
-        if (m_plugin->treeOn)
+        if (m_options.treeOn)
           {
            node = new QTreeWidgetItem(clsNode, lastClsNode);
            lastClsNode = node;
           }
-        else node = new QTreeWidgetItem(m_symbols);
+        else node = new QTreeWidgetItem(m_parseTree);
         node->setText(0, stripped);
-        node->setIcon(0, QIcon(cls_int));
+        node->setData(0, Qt::DecorationRole, cls_int);
         node->setText(1, QString::number( i, 10));
        }
 
@@ -138,14 +135,14 @@ void KatePluginSymbolViewerView::parseXsltSymbols(void)
         QString stripped = cl.remove(QRegExp(QLatin1String("^<xsl:template +name=\"")));
         stripped = stripped.remove(QRegExp(QLatin1String("\".*")));
 
-        if (m_plugin->treeOn)
+        if (m_options.treeOn)
           {
            node = new QTreeWidgetItem(clsNode, lastClsNode);
            lastClsNode = node;
           }
-        else node = new QTreeWidgetItem(m_symbols);
+        else node = new QTreeWidgetItem(m_parseTree);
         node->setText(0, stripped);
-        node->setIcon(0, QIcon(cls));
+        node->setData(0, Qt::DecorationRole, cls);
         node->setText(1, QString::number( i, 10));
 
        }
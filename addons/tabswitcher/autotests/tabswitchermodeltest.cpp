@@ -0,0 +1,142 @@
+/* This file is part of the KDE project
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "tabswitchermodeltest.h"
+#include "tabswitchermodel.h"
+#include "document_dummy.h"
+
+#include <QSignalSpy>
+#include <QtTest>
+
+QTEST_MAIN(TabSwitcherModelTest)
+
+void TabSwitcherModelTest::initTestCase()
+{
+    // for the signal spies
+    qRegisterMetaType<QModelIndex>();
+}
+
+void TabSwitcherModelTest::testAddRemove()
+{
+    TabSwitcherModel model;
+    DummyDocument a("file:///a.txt");
+    DummyDocument b("file:///b.txt");
+
+    model.addDocument(&a);
+    model.addDocument(&b);
+    QCOMPARE(model.rowCount(), 2);
+    QCOMPARE(model.document(0), &b);
+    QCOMPARE(model.document(1), &a);
+    QCOMPARE(model.data(model.index(0)).toString(), QStringLiteral("b.txt"));
+    QCOMPARE(model.data(model.index(1), TabSwitcherModel::DocumentRole).value<KTextEditor::Document *>(), &a);
+
+    model.removeDocument(&b);
+    QCOMPARE(model.rowCount(), 1);
+    QCOMPARE(model.document(0), &a);
+    QVERIFY(!model.contains(&b));
+
+    // unknown documents are ignored
+    model.removeDocument(&b);
+    QCOMPARE(model.rowCount(), 1);
+}
+
+void TabSwitcherModelTest::testRaise()
+{
+    TabSwitcherModel model;
+    DummyDocument a("file:///a.txt");
+    DummyDocument b("file:///b.txt");
+    DummyDocument c("file:///c.txt");
+    model.addDocument(&a);
+    model.addDocument(&b);
+    model.addDocument(&c);
+
+    QSignalSpy moved(&model, SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)));
+    QSignalSpy removed(&model, SIGNAL(rowsRemoved(QModelIndex,int,int)));
+    QSignalSpy inserted(&model, SIGNAL(rowsInserted(QModelIndex,int,int)));
+
+    model.raiseDocument(&a);
+    QCOMPARE(model.document(0), &a);
+    QCOMPARE(model.document(1), &c);
+    QCOMPARE(model.document(2), &b);
+
+    model.raiseDocument(&c);
+    QCOMPARE(model.document(0), &c);
+    QCOMPARE(model.document(1), &a);
+    QCOMPARE(model.document(2), &b);
+
+    // already on top: nothing to do
+    model.raiseDocument(&c);
+
+    QCOMPARE(moved.count(), 2);
+    QCOMPARE(moved.at(0).at(1).toInt(), 2);
+    QCOMPARE(moved.at(1).at(1).toInt(), 1);
+    QCOMPARE(removed.count(), 0);
+    QCOMPARE(inserted.count(), 0);
+}
+
+void TabSwitcherModelTest::testUpdate()
+{
+    TabSwitcherModel model;
+    DummyDocument a("file:///a.txt");
+    DummyDocument b("file:///b.txt");
+    model.addDocument(&a);
+    model.addDocument(&b);
+
+    QSignalSpy changed(&model, SIGNAL(dataChanged(QModelIndex,QModelIndex,QVector<int>)));
+    model.updateDocument(&a);
+    QCOMPARE(changed.count(), 1);
+    QCOMPARE(changed.at(0).at(0).value<QModelIndex>().row(), 1);
+}
+
+void TabSwitcherModelTest::benchmarkSwitchRecent()
+{
+    TabSwitcherModel model;
+    QList<DummyDocument *> documents;
+    for (int i = 0; i < 1000; ++i) {
+        documents.append(new DummyDocument(QStringLiteral("file:///%1.txt").arg(i)));
+        model.addDocument(documents.last());
+    }
+
+    // Ctrl+Tab: back and forth between the last two documents
+    QBENCHMARK {
+        for (int i = 0; i < 1000; ++i) {
+            model.raiseDocument(model.document(1));
+        }
+    }
+
+    qDeleteAll(documents);
+}
+
+void TabSwitcherModelTest::benchmarkSwitchAll()
+{
+    TabSwitcherModel model;
+    QList<DummyDocument *> documents;
+    for (int i = 0; i < 1000; ++i) {
+        documents.append(new DummyDocument(QStringLiteral("file:///%1.txt").arg(i)));
+        model.addDocument(documents.last());
+    }
+
+    // worst case: always raise the least recently used document
+    QBENCHMARK {
+        for (int i = 0; i < 1000; ++i) {
+            model.raiseDocument(model.document(999));
+        }
+    }
+
+    qDeleteAll(documents);
+}
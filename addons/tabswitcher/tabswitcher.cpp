@@ -19,6 +19,7 @@
 */
 
 #include "tabswitcher.h"
+#include "tabswitchermodel.h"
 #include "tabswitchertreeview.h"
 
 #include <KTextEditor/Application>
@@ -32,9 +33,7 @@
 #include <KXMLGUIFactory>
 
 #include <QAction>
-#include <QMimeDatabase>
 #include <QScrollBar>
-#include <QStandardItemModel>
 
 K_PLUGIN_FACTORY_WITH_JSON(TabSwitcherPluginFactory, "tabswitcherplugin.json", registerPlugin<TabSwitcherPlugin>();)
 
@@ -56,7 +55,7 @@ TabSwitcherPluginView::TabSwitcherPluginView(TabSwitcherPlugin *plugin, KTextEdi
     // register this view
     m_plugin->m_views.append(this);
 
-    m_model = new QStandardItemModel(this);
+    m_model = new TabSwitcherModel(this);
     m_treeView = new TabSwitcherTreeView();
     m_treeView->setModel(m_model);
 
@@ -122,11 +121,6 @@ void TabSwitcherPluginView::setupActions()
     m_treeView->addAction(aPrev);
 }
 
-static QIcon iconForDocument(KTextEditor::Document * doc)
-{
-    return QIcon::fromTheme(QMimeDatabase().mimeTypeForUrl(doc->url()).iconName());
-}
-
 void TabSwitcherPluginView::setupModel()
 {
     // initial fill of model
@@ -137,13 +131,8 @@ void TabSwitcherPluginView::setupModel()
 
 void TabSwitcherPluginView::registerDocument(KTextEditor::Document * document)
 {
-    // insert into hash
-    m_documents.insert(document);
-
     // add to model
-    auto item = new QStandardItem(iconForDocument(document), document->documentName());
-    item->setData(QVariant::fromValue(document));
-    m_model->insertRow(0, item);
+    m_model->addDocument(document);
 
     // track document name changes
     connect(document, SIGNAL(documentNameChanged(KTextEditor::Document*)),
@@ -152,51 +141,30 @@ void TabSwitcherPluginView::registerDocument(KTextEditor::Document * document)
 
 void TabSwitcherPluginView::unregisterDocument(KTextEditor::Document * document)
 {
-    // remove from hash
-    if (!m_documents.contains(document)) {
+    if (!m_model->contains(document)) {
         return;
     }
-    m_documents.remove(document);
 
     // remove from model
-    const auto rowCount = m_model->rowCount();
-    for (int i = 0; i < rowCount; ++i) {
-        auto doc = m_model->item(i)->data().value<KTextEditor::Document*>();
-        if (doc == document) {
-            m_model->removeRow(i);
-
-            // disconnect documentNameChanged() signal
-            disconnect(document, 0, this, 0);
+    m_model->removeDocument(document);
 
-            break;
-        }
-    }
+    // disconnect documentNameChanged() signal
+    disconnect(document, 0, this, 0);
 }
 
 void TabSwitcherPluginView::updateDocumentName(KTextEditor::Document * document)
 {
-    if (!m_documents.contains(document)) {
-        return;
-    }
-
-    const auto rowCount = m_model->rowCount();
-    for (int i = 0; i < rowCount; ++i) {
-        auto doc = m_model->item(i)->data().value<KTextEditor::Document*>();
-        if (doc == document) {
-            m_model->item(i)->setText(document->documentName());
-            break;
-        }
-    }
+    m_model->updateDocument(document);
 }
 
 void TabSwitcherPluginView::raiseView(KTextEditor::View * view)
 {
-    if (!view || !m_documents.contains(view->document())) {
+    if (!view) {
         return;
     }
 
-    unregisterDocument(view->document());
-    registerDocument(view->document());
+    // a single row move, the name and icon do not change
+    m_model->raiseDocument(view->document());
 }
 
 void TabSwitcherPluginView::walk(const int from, const int to)
@@ -276,7 +244,7 @@ void TabSwitcherPluginView::activateView(const QModelIndex & index)
 
     const int row = m_treeView->selectionModel()->selectedRows().first().row();
 
-    auto doc = m_model->item(row)->data().value<KTextEditor::Document*>();
+    auto doc = m_model->document(row);
     m_mainWindow->activateView(doc);
 
     m_treeView->hide();
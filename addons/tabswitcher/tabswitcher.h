@@ -25,14 +25,13 @@
 #include <KTextEditor/MainWindow>
 
 #include <QList>
-#include <QSet>
 #include <QVariant>
 
 #include <KXMLGUIClient>
 
 class TabSwitcherPluginView;
 class TabSwitcherTreeView;
-class QStandardItemModel;
+class TabSwitcherModel;
 class QModelIndex;
 
 class TabSwitcherPlugin : public KTextEditor::Plugin
@@ -136,8 +135,7 @@ protected:
 private:
     TabSwitcherPlugin *m_plugin;
     KTextEditor::MainWindow *m_mainWindow;
-    QStandardItemModel * m_model;
-    QSet<KTextEditor::Document *> m_documents;
+    TabSwitcherModel * m_model;
     TabSwitcherTreeView * m_treeView;
 };
 
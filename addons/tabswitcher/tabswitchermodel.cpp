@@ -0,0 +1,117 @@
+/* This file is part of the KDE project
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "tabswitchermodel.h"
+
+#include <KTextEditor/Document>
+
+#include <QMimeDatabase>
+
+#include <algorithm>
+
+TabSwitcherModel::TabSwitcherModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+}
+
+void TabSwitcherModel::addDocument(KTextEditor::Document *document)
+{
+    beginInsertRows(QModelIndex(), 0, 0);
+    m_documents.prepend(document);
+    endInsertRows();
+}
+
+void TabSwitcherModel::removeDocument(KTextEditor::Document *document)
+{
+    const int row = m_documents.indexOf(document);
+    if (row < 0) {
+        return;
+    }
+
+    beginRemoveRows(QModelIndex(), row, row);
+    m_documents.remove(row);
+    m_icons.remove(document);
+    endRemoveRows();
+}
+
+void TabSwitcherModel::raiseDocument(KTextEditor::Document *document)
+{
+    // searching from the top finds recently used documents right away
+    const int row = m_documents.indexOf(document);
+    if (row <= 0) {
+        return;
+    }
+
+    // a move keeps the selection and does not reset the views
+    beginMoveRows(QModelIndex(), row, row, QModelIndex(), 0);
+    std::rotate(m_documents.begin(), m_documents.begin() + row, m_documents.begin() + row + 1);
+    endMoveRows();
+}
+
+void TabSwitcherModel::updateDocument(KTextEditor::Document *document)
+{
+    const int row = m_documents.indexOf(document);
+    if (row < 0) {
+        return;
+    }
+
+    // the url and so the mime type might have changed
+    m_icons.remove(document);
+
+    const QModelIndex idx = index(row);
+    emit dataChanged(idx, idx);
+}
+
+bool TabSwitcherModel::contains(KTextEditor::Document *document) const
+{
+    return m_documents.contains(document);
+}
+
+KTextEditor::Document *TabSwitcherModel::document(int row) const
+{
+    return m_documents.value(row);
+}
+
+int TabSwitcherModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_documents.size();
+}
+
+QVariant TabSwitcherModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_documents.size()) {
+        return QVariant();
+    }
+
+    KTextEditor::Document *doc = m_documents.at(index.row());
+    switch (role) {
+    case Qt::DisplayRole:
+        return doc->documentName();
+    case Qt::DecorationRole: {
+        QHash<KTextEditor::Document *, QIcon>::iterator it = m_icons.find(doc);
+        if (it == m_icons.end()) {
+            it = m_icons.insert(doc, QIcon::fromTheme(QMimeDatabase().mimeTypeForUrl(doc->url()).iconName()));
+        }
+        return *it;
+    }
+    case DocumentRole:
+        return QVariant::fromValue(doc);
+    default:
+        return QVariant();
+    }
+}
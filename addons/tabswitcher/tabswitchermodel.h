@@ -0,0 +1,90 @@
+/* This file is part of the KDE project
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef KTEXTEDITOR_TABSWITCHER_MODEL_H
+#define KTEXTEDITOR_TABSWITCHER_MODEL_H
+
+#include <QAbstractListModel>
+#include <QHash>
+#include <QIcon>
+#include <QVector>
+
+namespace KTextEditor
+{
+class Document;
+}
+
+/**
+ * List of documents, the most recently used one in the first row.
+ *
+ * Raising a document is a single row move. The rows are found by a scan
+ * from the top, so the cost depends on how far down the document was,
+ * which is only a few rows when switching between recently used documents.
+ */
+class TabSwitcherModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    enum Roles {
+        DocumentRole = Qt::UserRole + 1
+    };
+
+    explicit TabSwitcherModel(QObject *parent = 0);
+
+    /**
+     * Adds @p document as most recently used document.
+     */
+    void addDocument(KTextEditor::Document *document);
+
+    /**
+     * Removes @p document, if it is in the model.
+     */
+    void removeDocument(KTextEditor::Document *document);
+
+    /**
+     * Moves @p document to the first row, if it is in the model.
+     */
+    void raiseDocument(KTextEditor::Document *document);
+
+    /**
+     * Tells the views the name of @p document changed, its icon is looked up again.
+     */
+    void updateDocument(KTextEditor::Document *document);
+
+    bool contains(KTextEditor::Document *document) const;
+
+    /**
+     * Returns the document in @p row.
+     */
+    KTextEditor::Document *document(int row) const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const Q_DECL_OVERRIDE;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const Q_DECL_OVERRIDE;
+
+private:
+    QVector<KTextEditor::Document *> m_documents;
+
+    /**
+     * icons by document, looked up on first paint, the mime type lookup
+     * is too slow to be done on every paint
+     */
+    mutable QHash<KTextEditor::Document *, QIcon> m_icons;
+};
+
+#endif // KTEXTEDITOR_TABSWITCHER_MODEL_H
@@ -21,6 +21,7 @@
 
 #include <ktexteditor/editor.h>
 #include <ktexteditor/message.h>
+#include <ktexteditor/movinginterface.h>
 
 #include <QDialog>
 #include <QAction>
@@ -36,9 +37,19 @@
 #include <KXMLGUIFactory>
 #include <KConfigGroup>
 #include <KSharedConfig>
+#include <KFormat>
 
 #include <qapplication.h>
 #include <qclipboard.h>
+#include <qtextcodec.h>
+
+// input is written in chunks of this many characters, while less than
+// MAX_PENDING_INPUT bytes wait for the process to read them
+static const int INPUT_CHUNK = 64 * 1024;
+static const qint64 MAX_PENDING_INPUT = 256 * 1024;
+
+// output is inserted into the document in chunks of this many characters
+static const int OUTPUT_CHUNK = 256 * 1024;
 
 K_PLUGIN_FACTORY_WITH_JSON(TextFilterPluginFactory, "textfilterplugin.json", registerPlugin<PluginKateTextFilter>();)
 
@@ -47,19 +58,27 @@ PluginKateTextFilter::PluginKateTextFilter(QObject *parent, const QList<QVariant
     , m_pFilterProcess(Q_NULLPTR)
     , copyResult(false)
     , mergeOutput(false)
+    , m_inputPos(0)
+    , m_outputBytes(0)
+    , m_blockSelection(false)
+    , m_editing(false)
+    , m_readWrite(false)
+    , m_inputRange(Q_NULLPTR)
+    , m_insertStart(Q_NULLPTR)
+    , m_insertPos(Q_NULLPTR)
 {
     // register command
     new PluginKateTextFilterCommand(this);
+
+    m_progressTimer.setInterval(500);
+    connect(&m_progressTimer, SIGNAL(timeout()), this, SLOT(slotUpdateProgress()));
 }
 
 PluginKateTextFilter::~PluginKateTextFilter()
 {
     // cleanup the process the right way (TM)
-    if (m_pFilterProcess) {
-        m_pFilterProcess->kill();
-        m_pFilterProcess->waitForFinished();
-        delete m_pFilterProcess;
-    }
+    killFilter();
+    finishFilter();
 }
 
 QObject *PluginKateTextFilter::createView (KTextEditor::MainWindow *mainWindow)
@@ -70,22 +89,31 @@ QObject *PluginKateTextFilter::createView (KTextEditor::MainWindow *mainWindow)
 
 void PluginKateTextFilter::slotFilterReceivedStdout()
 {
-  m_strFilterOutput += QString::fromLocal8Bit(m_pFilterProcess->readAllStandardOutput());
+  receivedOutput(m_pFilterProcess->readAllStandardOutput(), false);
 }
 
 
 void PluginKateTextFilter::slotFilterReceivedStderr ()
 {
-  const QString block = QString::fromLocal8Bit(m_pFilterProcess->readAllStandardError());
-  if (mergeOutput)
-    m_strFilterOutput += block;
-  else
-    m_stderrOutput += block;
+  // with merged channels, everything arrives through stdout
+  m_stderrOutput += QString::fromLocal8Bit(m_pFilterProcess->readAllStandardError());
+}
+
+void PluginKateTextFilter::slotFilterBytesWritten()
+{
+  feedInput();
 }
 
 void PluginKateTextFilter::slotFilterProcessExited(int, QProcess::ExitStatus)
 {
-  KTextEditor::View* kv(KTextEditor::Editor::instance()->application()->activeMainWindow()->activeView());
+  // whatever is left, even if readyRead was not handled yet
+  receivedOutput(m_pFilterProcess->readAllStandardOutput(), true);
+  if (!mergeOutput)
+    m_stderrOutput += QString::fromLocal8Bit(m_pFilterProcess->readAllStandardError());
+
+  KTextEditor::View* kv = m_view;
+  finishFilter();
+
   if (!kv) return;
 
   // Is there any error output to display?
@@ -107,44 +135,177 @@ void PluginKateTextFilter::slotFilterProcessExited(int, QProcess::ExitStatus)
 
   if (copyResult) {
     QApplication::clipboard()->setText(m_strFilterOutput);
+    m_strFilterOutput.clear();
+  }
+}
+
+void PluginKateTextFilter::slotCancelFilter()
+{
+  if (!m_pFilterProcess || m_pFilterProcess->state() == QProcess::NotRunning)
     return;
+
+  killFilter();
+
+  // still inside the transaction, put the input back in place of the output
+  if (m_editing) {
+    m_document->setReadWrite(m_readWrite);
+    m_document->removeText(KTextEditor::Range(m_insertStart->toCursor(), m_insertPos->toCursor()));
+    m_document->insertText(m_insertStart->toCursor(), m_input, m_blockSelection);
+    if (m_view) {
+      m_view->setBlockSelection(m_blockSelection);
+      m_view->setSelection(m_selection);
+    }
   }
 
-  // Do not even try to change the document if no result collected...
-  if (m_strFilterOutput.isEmpty())
+  m_strFilterOutput.clear();
+  m_stderrOutput.clear();
+  finishFilter();
+}
+
+void PluginKateTextFilter::slotDocumentAboutToClose()
+{
+  // nothing to restore in a closing document
+  killFilter();
+  finishFilter();
+}
+
+void PluginKateTextFilter::slotUpdateProgress()
+{
+  if (!m_document)
     return;
 
-  KTextEditor::Document::EditingTransaction transaction(kv->document());
+  // do not keep output of a slow filter waiting for a full chunk
+  insertOutput();
+
+  const int percent = m_input.isEmpty() ? 100 : int(qint64(m_inputPos) * 100 / m_input.size());
+  const QString text = i18n("Filtering through <b>%1</b>: %2% of the input written, %3 read",
+                            m_last_command.toHtmlEscaped(),
+                            percent,
+                            KFormat().formatByteSize(m_outputBytes));
 
-  KTextEditor::Cursor start = kv->cursorPosition();
-  if (kv->selection()) {
-    start = kv->selectionRange().start();
-    kv->removeSelectionText();
+  if (m_progressMessage) {
+    m_progressMessage->setText(text);
+    return;
   }
 
-  kv->setCursorPosition(start); // for block selection
+  m_progressMessage = new KTextEditor::Message(text, KTextEditor::Message::Information);
+  m_progressMessage->setWordWrap(true);
+  if (m_view)
+    m_progressMessage->setView(m_view);
+
+  QAction *cancel = new QAction(QIcon::fromTheme(QStringLiteral("dialog-cancel")), i18n("Cancel"), Q_NULLPTR);
+  connect(cancel, SIGNAL(triggered()), this, SLOT(slotCancelFilter()));
+  m_progressMessage->addAction(cancel);
 
-  kv->insertText(m_strFilterOutput);
+  m_document->postMessage(m_progressMessage);
 }
 
+void PluginKateTextFilter::feedInput()
+{
+  if (!m_encoder || m_pFilterProcess->state() != QProcess::Running)
+    return;
+
+  // backpressure: QProcess would buffer all of the input in memory otherwise
+  while (m_pFilterProcess->bytesToWrite() < MAX_PENDING_INPUT) {
+    if (m_inputPos >= m_input.size()) {
+      m_encoder.reset();
+      m_pFilterProcess->closeWriteChannel();
+      return;
+    }
 
-static void slipInFilter(KProcess & proc, KTextEditor::View & view, QString command)
+    const int length = qMin(INPUT_CHUNK, m_input.size() - m_inputPos);
+    const QByteArray encoded = m_encoder->fromUnicode(m_input.constData() + m_inputPos, length);
+    m_inputPos += length;
+    m_pFilterProcess->write(encoded);
+  }
+}
+
+void PluginKateTextFilter::receivedOutput(const QByteArray &data, bool flush)
 {
-  QString inputText;
+  if (!m_decoder)
+    return;
+
+  m_outputBytes += data.size();
+
+  // the decoder keeps multibyte sequences split between two reads
+  m_strFilterOutput += m_decoder->toUnicode(data);
+
+  if (!copyResult && (flush || m_strFilterOutput.size() >= OUTPUT_CHUNK))
+    insertOutput();
+}
+
+void PluginKateTextFilter::insertOutput()
+{
+  if (copyResult || m_strFilterOutput.isEmpty() || !m_inputRange)
+    return;
 
-  if (view.selection()) {
-    inputText = view.selectionText();
+  // the document is read-only for the user meanwhile, the edits would
+  // end up in the undo step of the filter and get lost on cancel
+  m_document->setReadWrite(m_readWrite);
+
+  // Do not even try to change the document before a result arrives...
+  if (!m_editing) {
+    m_document->startEditing();
+    m_editing = true;
+
+    // the input range moved along with edits made since the start
+    const KTextEditor::Range input = m_inputRange->toRange();
+    m_document->removeText(input, m_blockSelection);
+
+    if (m_view)
+      m_view->setCursorPosition(input.start()); // for block selection
+
+    KTextEditor::MovingInterface *moving = qobject_cast<KTextEditor::MovingInterface *>(m_document);
+    m_insertStart = moving->newMovingCursor(input.start(), KTextEditor::MovingCursor::StayOnInsert);
+    m_insertPos = moving->newMovingCursor(input.start(), KTextEditor::MovingCursor::MoveOnInsert);
   }
 
-  proc.clearProgram ();
-  proc.setShellCommand(command);
+  m_document->insertText(m_insertPos->toCursor(), m_strFilterOutput);
+  m_strFilterOutput.clear();
 
-  proc.start();
-  QByteArray encoded = inputText.toLocal8Bit();
-  proc.write(encoded);
-  proc.closeWriteChannel();
-  //  TODO: Put up a modal dialog to defend the text from further
-  //  keystrokes while the command is out. With a cancel button...
+  m_document->setReadWrite(false);
+}
+
+void PluginKateTextFilter::finishFilter()
+{
+  m_progressTimer.stop();
+  delete m_progressMessage;
+
+  delete m_inputRange;
+  m_inputRange = Q_NULLPTR;
+  delete m_insertStart;
+  m_insertStart = Q_NULLPTR;
+  delete m_insertPos;
+  m_insertPos = Q_NULLPTR;
+
+  if (m_editing && m_document)
+    m_document->finishEditing();
+  m_editing = false;
+
+  if (m_document) {
+    m_document->setReadWrite(m_readWrite);
+    m_document->disconnect(this);
+  }
+
+  m_view = Q_NULLPTR;
+  m_document = Q_NULLPTR;
+  m_input.clear();
+  m_inputPos = 0;
+  m_encoder.reset();
+  m_decoder.reset();
+}
+
+void PluginKateTextFilter::killFilter()
+{
+  if (!m_pFilterProcess)
+    return;
+
+  // no result of a killed process is wanted
+  m_pFilterProcess->disconnect(this);
+  m_pFilterProcess->kill();
+  m_pFilterProcess->waitForFinished();
+  delete m_pFilterProcess;
+  m_pFilterProcess = Q_NULLPTR;
 }
 
 void PluginKateTextFilter::slotEditFilter()
@@ -197,6 +358,10 @@ void PluginKateTextFilter::slotEditFilter()
 
 void PluginKateTextFilter::runFilter(KTextEditor::View *kv, const QString &filter)
 {
+  // only one filter at a time
+  if (m_pFilterProcess && m_pFilterProcess->state() != QProcess::NotRunning)
+    slotCancelFilter();
+
   m_strFilterOutput.clear();
   m_stderrOutput.clear();
 
@@ -210,6 +375,9 @@ void PluginKateTextFilter::runFilter(KTextEditor::View *kv, const QString &filte
     connect (m_pFilterProcess, SIGNAL(readyReadStandardError()),
              this, SLOT(slotFilterReceivedStderr()));
 
+    connect (m_pFilterProcess, SIGNAL(bytesWritten(qint64)),
+             this, SLOT(slotFilterBytesWritten()));
+
     connect (m_pFilterProcess, SIGNAL(finished(int,QProcess::ExitStatus)),
              this, SLOT(slotFilterProcessExited(int,QProcess::ExitStatus)));
   }
@@ -217,7 +385,44 @@ void PluginKateTextFilter::runFilter(KTextEditor::View *kv, const QString &filte
       mergeOutput ? KProcess::MergedChannels : KProcess::SeparateChannels
     );
 
-  slipInFilter(*m_pFilterProcess, *kv, filter);
+  KTextEditor::MovingInterface *moving = qobject_cast<KTextEditor::MovingInterface *>(kv->document());
+  if (!moving)
+    return;
+
+  // the output replaces the selection of this view, even if another one is active by then
+  m_view = kv;
+  m_document = kv->document();
+  connect(m_document, SIGNAL(aboutToClose(KTextEditor::Document*)), this, SLOT(slotDocumentAboutToClose()));
+
+  // no edits by the user until the filter is done, see insertOutput()
+  m_readWrite = m_document->isReadWrite();
+  m_document->setReadWrite(false);
+
+  m_blockSelection = kv->blockSelection();
+  m_selection = kv->selectionRange();
+  if (kv->selection())
+    m_input = kv->selectionText();
+  m_inputRange = moving->newMovingRange(kv->selection() ? m_selection : KTextEditor::Range(kv->cursorPosition(), kv->cursorPosition()));
+  m_inputPos = 0;
+  m_outputBytes = 0;
+
+  // stateful, a multibyte sequence may be split between two chunks
+  QTextCodec *codec = QTextCodec::codecForLocale();
+  m_encoder.reset(codec->makeEncoder(QTextCodec::IgnoreHeader));
+  m_decoder.reset(codec->makeDecoder(QTextCodec::IgnoreHeader));
+
+  m_pFilterProcess->clearProgram ();
+  m_pFilterProcess->setShellCommand(filter);
+  m_pFilterProcess->start();
+  if (!m_pFilterProcess->waitForStarted()) {
+    finishFilter();
+    return;
+  }
+
+  // the rest of the input is written as the process reads it
+  feedInput();
+
+  m_progressTimer.start();
 }
 
 //BEGIN Kate::Command methods
@@ -25,7 +25,16 @@
 #include <KTextEditor/Document>
 #include <KTextEditor/Command>
 
+#include <KTextEditor/Message>
+#include <KTextEditor/MovingCursor>
+#include <KTextEditor/MovingRange>
+
 #include <KProcess>
+#include <QPointer>
+#include <QScopedPointer>
+#include <QTextDecoder>
+#include <QTextEncoder>
+#include <QTimer>
 #include <QVariantList>
 
 class PluginKateTextFilter : public KTextEditor::Plugin
@@ -44,6 +53,36 @@ class PluginKateTextFilter : public KTextEditor::Plugin
 
     void runFilter(KTextEditor::View *kv, const QString & filter);
 
+  private:
+    /**
+     * Write the next chunk of the input, as long as the process has not
+     * too much input waiting already.
+     */
+    void feedInput();
+
+    /**
+     * Decode @p data and insert it into the document, or collect it for the clipboard.
+     * The text is inserted in chunks, unless @p flush is set.
+     */
+    void receivedOutput(const QByteArray &data, bool flush);
+
+    /**
+     * Insert the output decoded so far. The first insertion starts the editing
+     * transaction and replaces the selection.
+     */
+    void insertOutput();
+
+    /**
+     * End the editing transaction, make the document writable again if it was
+     * and drop all state of the running filter.
+     */
+    void finishFilter();
+
+    /**
+     * Kill the filter process, without handling its output.
+     */
+    void killFilter();
+
   private:
     QString  m_strFilterOutput;
     QString  m_stderrOutput;
@@ -52,11 +91,35 @@ class PluginKateTextFilter : public KTextEditor::Plugin
     QStringList completionList;
     bool copyResult;
     bool mergeOutput;
+
+    // state of the running filter, the input is written and the output
+    // inserted while the process runs, in one editing transaction
+    QPointer<KTextEditor::View> m_view;
+    QPointer<KTextEditor::Document> m_document;
+    QString m_input;
+    int m_inputPos;
+    qint64 m_outputBytes;
+    QScopedPointer<QTextEncoder> m_encoder;
+    QScopedPointer<QTextDecoder> m_decoder;
+    KTextEditor::Range m_selection;
+    bool m_blockSelection;
+    bool m_editing;
+    bool m_readWrite;
+    KTextEditor::MovingRange *m_inputRange;
+    KTextEditor::MovingCursor *m_insertStart;
+    KTextEditor::MovingCursor *m_insertPos;
+    QTimer m_progressTimer;
+    QPointer<KTextEditor::Message> m_progressMessage;
+
   public Q_SLOTS:
     void slotEditFilter ();
     void slotFilterReceivedStdout();
     void slotFilterReceivedStderr();
+    void slotFilterBytesWritten();
     void slotFilterProcessExited(int exitCode, QProcess::ExitStatus exitStatus);
+    void slotCancelFilter();
+    void slotDocumentAboutToClose();
+    void slotUpdateProgress();
 };
 
 class PluginKateTextFilterCommand : public KTextEditor::Command
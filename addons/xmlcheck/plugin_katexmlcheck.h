@@ -25,8 +25,6 @@
 #ifndef PLUGIN_KATEXMLCHECK_H
 #define PLUGIN_KATEXMLCHECK_H
 
-#include <QProcess>
-
 #include <ktexteditor/plugin.h>
 #include <ktexteditor/application.h>
 #include <ktexteditor/mainwindow.h>
@@ -39,8 +37,7 @@
 
 class QTreeWidget;
 class QTreeWidgetItem;
-class QTemporaryFile;
-class QProcess;
+class XMLCheckWorker;
 
 class PluginKateXMLCheckView : public QObject, public KXMLGUIClient
 {
@@ -56,16 +53,16 @@ public:
 public Q_SLOTS:
     bool slotValidate();
     void slotClicked(QTreeWidgetItem *item, int column);
-    void slotProcExited(int exitCode, QProcess::ExitStatus exitStatus);
+    void slotDiagnostic(int id, int line, int column, const QString &message);
+    void slotCheckFinished(int id, bool validated, int errors);
     void slotUpdate();
 
 private:
-    QTemporaryFile *m_tmp_file;
+    void addItem(const QString &line, const QString &column, const QString &message);
+
     KParts::ReadOnlyPart *part;
-    bool m_validating;
-    QProcess m_proc;
-    QString m_proc_stderr;
-    QString m_dtdname;
+    XMLCheckWorker *m_worker;
+    int m_checkId;
     QTreeWidget *listview;
 };
 
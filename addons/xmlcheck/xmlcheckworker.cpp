@@ -0,0 +1,360 @@
+/***************************************************************************
+                           xmlcheckworker.cpp - validates XML with libxml2
+                           -------------------
+ ***************************************************************************/
+
+/***************************************************************************
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ ***************************************************************************/
+
+#include "xmlcheckworker.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QStringList>
+#include <QUrl>
+
+#include <libxml/parser.h>
+#include <libxml/parserInternals.h>
+#include <libxml/uri.h>
+#include <libxml/valid.h>
+#include <libxml/xmlerror.h>
+#include <libxml/xmlschemas.h>
+
+static const char XSI_NAMESPACE[] = "http://www.w3.org/2001/XMLSchema-instance";
+
+//---------------------------------
+// external entities (DTDs and the files they pull in) are loaded through this
+// cache, a DocBook DTD is read from disk only once as long as it is unchanged.
+// libxml2 has only a process wide loader, so it is installed while workers
+// exist and serves only the parser contexts of the workers.
+
+struct CachedEntity
+{
+    QByteArray data;
+    QDateTime modified;
+};
+
+static QMutex s_entityMutex;
+static QHash<QString, CachedEntity> s_entities;
+static xmlExternalEntityLoader s_defaultEntityLoader = 0;
+static int s_workers = 0;
+
+static xmlParserInputPtr cachingEntityLoader(const char *URL, const char *ID, xmlParserCtxtPtr ctxt)
+{
+    // other users of libxml2 in the process get the loader they had before
+    if (!ctxt || ctxt->_private != &s_entities) {
+        return s_defaultEntityLoader(URL, ID, ctxt);
+    }
+
+    // only local files are cached, everything else takes the usual way
+    QString path;
+    if (URL) {
+        const QUrl url(QString::fromUtf8(URL));
+        if (url.isLocalFile()) {
+            path = url.toLocalFile();
+        } else if (url.scheme().isEmpty()) {
+            path = QFile::decodeName(URL);
+        }
+    }
+
+    const QFileInfo info(path);
+    if (path.isEmpty() || !info.isFile()) {
+        return s_defaultEntityLoader(URL, ID, ctxt);
+    }
+
+    QByteArray data;
+    {
+        QMutexLocker locker(&s_entityMutex);
+        CachedEntity &entity = s_entities[info.absoluteFilePath()];
+
+        if (entity.modified != info.lastModified()) {
+            QFile file(path);
+            if (!file.open(QIODevice::ReadOnly)) {
+                s_entities.remove(info.absoluteFilePath());
+                return s_defaultEntityLoader(URL, ID, ctxt);
+            }
+            entity.data = file.readAll();
+            entity.modified = info.lastModified();
+        }
+
+        data = entity.data;
+    }
+
+    xmlParserInputBufferPtr buffer = xmlParserInputBufferCreateMem(data.constData(), data.size(), XML_CHAR_ENCODING_NONE);
+    if (!buffer) {
+        return 0;
+    }
+
+    xmlParserInputPtr input = xmlNewIOInputStream(ctxt, buffer, XML_CHAR_ENCODING_NONE);
+    if (!input) {
+        xmlFreeParserInputBuffer(buffer);
+        return 0;
+    }
+
+    // relative references inside the DTD are resolved against this
+    input->filename = reinterpret_cast<char *>(xmlStrdup(reinterpret_cast<const xmlChar *>(URL)));
+    return input;
+}
+
+static void structuredError(void *userData, xmlErrorPtr error)
+{
+    XMLCheckWorker *worker = static_cast<XMLCheckWorker *>(userData);
+
+    worker->reportError(error->file ? QFile::decodeName(error->file) : QString(),
+                        error->line, error->int2,
+                        QString::fromUtf8(error->message).trimmed());
+}
+
+
+//---------------------------------
+XMLCheckWorker::XMLCheckWorker(QObject *parent)
+    : QThread(parent)
+    , m_nextId(-1)
+    , m_quit(false)
+    , m_id(-1)
+    , m_errors(0)
+{
+    xmlInitParser();
+
+    QMutexLocker locker(&s_entityMutex);
+    if (s_workers++ == 0) {
+        s_defaultEntityLoader = xmlGetExternalEntityLoader();
+        xmlSetExternalEntityLoader(cachingEntityLoader);
+    }
+}
+
+XMLCheckWorker::~XMLCheckWorker()
+{
+    stop();
+    wait();
+
+    QMutexLocker locker(&s_entityMutex);
+    if (--s_workers == 0) {
+        // unless someone else replaced it meanwhile
+        if (xmlGetExternalEntityLoader() == cachingEntityLoader) {
+            xmlSetExternalEntityLoader(s_defaultEntityLoader);
+        }
+        s_entities.clear();
+    }
+}
+
+void XMLCheckWorker::check(int id, const QByteArray &text, const QString &fileName)
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_nextId = id;
+    m_nextText = text;
+    m_nextFileName = fileName;
+
+    m_wakeUp.wakeOne();
+}
+
+void XMLCheckWorker::stop()
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_quit = true;
+
+    m_wakeUp.wakeOne();
+}
+
+void XMLCheckWorker::reportError(const QString &file, int line, int column, const QString &message)
+{
+    ++m_errors;
+
+    // errors inside a DTD or schema are not at a line of the document
+    if (line > 0 && !file.isEmpty() && file != m_fileName) {
+        emit diagnostic(m_id, 0, 0, file + QLatin1Char(':') + QString::number(line) + QLatin1String(": ") + message);
+        return;
+    }
+
+    emit diagnostic(m_id, line, column, message);
+}
+
+void XMLCheckWorker::run()
+{
+    // the handler is per thread in libxml2
+    xmlSetStructuredErrorFunc(this, structuredError);
+
+    forever {
+        m_mutex.lock();
+
+        while (m_nextId < 0 && !m_quit) {
+            m_wakeUp.wait(&m_mutex);
+        }
+
+        if (m_quit) {
+            m_mutex.unlock();
+            break;
+        }
+
+        m_id = m_nextId;
+        const QByteArray text = m_nextText;
+        const QString fileName = m_nextFileName;
+
+        m_nextId = -1;
+        m_nextText.clear();
+
+        m_mutex.unlock();
+
+        m_errors = 0;
+        m_fileName = fileName;
+
+        const QByteArray url = QFile::encodeName(fileName);
+
+        xmlParserCtxtPtr ctxt = xmlNewParserCtxt();
+        if (!ctxt) {
+            emit checkFinished(m_id, false, 0);
+            continue;
+        }
+
+        // entities of this context go through the cache
+        ctxt->_private = &s_entities;
+
+        // load the DTD for its entities, it is validated against separately
+        xmlDocPtr doc = xmlCtxtReadMemory(ctxt, text.constData(), text.size(),
+                                          url.isEmpty() ? 0 : url.constData(), 0,
+                                          XML_PARSE_DTDLOAD | XML_PARSE_DTDATTR);
+
+        bool validated = false;
+
+        if (doc) {
+            if (doc->intSubset || doc->extSubset) {
+                validated = true;
+
+                xmlValidCtxtPtr vctxt = xmlNewValidCtxt();
+                if (vctxt) {
+                    xmlValidateDocument(vctxt, doc);
+                    xmlFreeValidCtxt(vctxt);
+                }
+            }
+
+            validated = validateSchema(doc) || validated;
+
+            xmlFreeDoc(doc);
+        }
+
+        xmlFreeParserCtxt(ctxt);
+
+        emit checkFinished(m_id, validated, m_errors);
+    }
+
+    freeSchemas();
+    xmlSetStructuredErrorFunc(0, 0);
+}
+
+bool XMLCheckWorker::validateSchema(xmlDocPtr doc)
+{
+    xmlNodePtr root = xmlDocGetRootElement(doc);
+    if (!root) {
+        return false;
+    }
+
+    const xmlChar *xsi = reinterpret_cast<const xmlChar *>(XSI_NAMESPACE);
+    QString location;
+
+    if (xmlChar *value = xmlGetNsProp(root, reinterpret_cast<const xmlChar *>("noNamespaceSchemaLocation"), xsi)) {
+        location = QString::fromUtf8(reinterpret_cast<const char *>(value)).trimmed();
+        xmlFree(value);
+    } else if (xmlChar *value = xmlGetNsProp(root, reinterpret_cast<const xmlChar *>("schemaLocation"), xsi)) {
+        // pairs of namespace and location, take the one for the root element
+        const QStringList pairs = QString::fromUtf8(reinterpret_cast<const char *>(value)).simplified().split(QLatin1Char(' '));
+        xmlFree(value);
+
+        const QString ns = (root->ns && root->ns->href) ? QString::fromUtf8(reinterpret_cast<const char *>(root->ns->href)) : QString();
+        for (int i = 0; i + 1 < pairs.size(); i += 2) {
+            if (pairs.at(i) == ns || location.isEmpty()) {
+                location = pairs.at(i + 1);
+            }
+        }
+    }
+
+    if (location.isEmpty()) {
+        return false;
+    }
+
+    // relative to the document
+    if (doc->URL) {
+        const QByteArray relative = location.toUtf8();
+        if (xmlChar *absolute = xmlBuildURI(reinterpret_cast<const xmlChar *>(relative.constData()), doc->URL)) {
+            location = QString::fromUtf8(reinterpret_cast<const char *>(absolute));
+            xmlFree(absolute);
+        }
+    }
+
+    xmlSchemaPtr compiled = schema(location);
+    if (!compiled) {
+        return false;
+    }
+
+    xmlSchemaValidCtxtPtr vctxt = xmlSchemaNewValidCtxt(compiled);
+    if (!vctxt) {
+        return false;
+    }
+
+    xmlSchemaSetValidStructuredErrors(vctxt, structuredError, this);
+    xmlSchemaValidateDoc(vctxt, doc);
+    xmlSchemaFreeValidCtxt(vctxt);
+
+    return true;
+}
+
+xmlSchemaPtr XMLCheckWorker::schema(const QString &location)
+{
+    const QUrl url(location);
+    const QFileInfo info(url.isLocalFile() ? url.toLocalFile() : location);
+    // remote schemas are kept for the lifetime of the worker
+    const QDateTime modified = info.isFile() ? info.lastModified() : QDateTime();
+
+    QHash<QString, CachedSchema>::iterator it = m_schemas.find(location);
+    if (it != m_schemas.end()) {
+        if (it->modified == modified) {
+            return it->schema;
+        }
+        xmlSchemaFree(it->schema);
+        m_schemas.erase(it);
+    }
+
+    const QByteArray encoded = location.toUtf8();
+    xmlSchemaParserCtxtPtr pctxt = xmlSchemaNewParserCtxt(encoded.constData());
+    if (!pctxt) {
+        return 0;
+    }
+
+    xmlSchemaSetParserStructuredErrors(pctxt, structuredError, this);
+    xmlSchemaPtr compiled = xmlSchemaParse(pctxt);
+    xmlSchemaFreeParserCtxt(pctxt);
+
+    // a broken schema is parsed again, so its errors are shown every time
+    if (compiled) {
+        CachedSchema cached;
+        cached.schema = compiled;
+        cached.modified = modified;
+        m_schemas.insert(location, cached);
+    }
+
+    return compiled;
+}
+
+void XMLCheckWorker::freeSchemas()
+{
+    foreach (const CachedSchema &cached, m_schemas) {
+        xmlSchemaFree(cached.schema);
+    }
+    m_schemas.clear();
+}
@@ -0,0 +1,103 @@
+/***************************************************************************
+                           xmlcheckworker.h - validates XML with libxml2
+                           -------------------
+ ***************************************************************************/
+
+/***************************************************************************
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ ***************************************************************************/
+
+#ifndef XMLCHECKWORKER_H
+#define XMLCHECKWORKER_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+
+struct _xmlDoc;
+struct _xmlSchema;
+
+/**
+ * Checks documents with libxml2 on its own thread, like "xmllint --valid" did.
+ *
+ * Every check works on a snapshot of the text. Documents with a DOCTYPE are
+ * validated against their DTD, documents naming an XML schema through
+ * xsi:schemaLocation or xsi:noNamespaceSchemaLocation against the schema.
+ * Local DTD files and compiled schemas are cached across checks until the
+ * file changes on disk.
+ *
+ * Diagnostics are published one by one while the check runs.
+ */
+class XMLCheckWorker : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit XMLCheckWorker(QObject *parent = 0);
+    ~XMLCheckWorker();
+
+    /**
+     * Queues a check of @p text, a check not yet started is replaced.
+     * @p fileName is used to resolve relative DTDs and schemas.
+     */
+    void check(int id, const QByteArray &text, const QString &fileName);
+
+    /**
+     * Lets the thread finish.
+     */
+    void stop();
+
+    /**
+     * Called by the libxml2 error handler, public for it only.
+     */
+    void reportError(const QString &file, int line, int column, const QString &message);
+
+Q_SIGNALS:
+    void diagnostic(int id, int line, int column, const QString &message);
+    /// @p validated is false when only well-formedness was checked
+    void checkFinished(int id, bool validated, int errors);
+
+protected:
+    void run();
+
+private:
+    bool validateSchema(_xmlDoc *doc);
+    _xmlSchema *schema(const QString &location);
+    void freeSchemas();
+
+    QMutex m_mutex;
+    QWaitCondition m_wakeUp;
+    int m_nextId;
+    QByteArray m_nextText;
+    QString m_nextFileName;
+    bool m_quit;
+
+    // only used on the worker thread
+    int m_id;
+    QString m_fileName;
+    int m_errors;
+
+    struct CachedSchema {
+        _xmlSchema *schema;
+        QDateTime modified;
+    };
+    QHash<QString, CachedSchema> m_schemas;
+};
+
+#endif // XMLCHECKWORKER_H
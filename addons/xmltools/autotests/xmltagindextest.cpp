@@ -0,0 +1,145 @@
+/***************************************************************************
+                           xmltagindextest.cpp - tests of the element structure index
+                           -------------------
+ ***************************************************************************/
+
+/***************************************************************************
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ ***************************************************************************/
+
+#include "xmltagindextest.h"
+#include "xml_tag_index.h"
+
+#include <QtTest>
+
+#include <KTextEditor/Document>
+#include <KTextEditor/Editor>
+
+QTEST_MAIN(XMLTagIndexTest)
+
+void XMLTagIndexTest::initTestCase()
+{
+    m_doc = KTextEditor::Editor::instance()->createDocument(0);
+}
+
+void XMLTagIndexTest::cleanupTestCase()
+{
+    delete m_doc;
+}
+
+/**
+ * The index must give the same answers after an edit as one built from
+ * scratch. Each test is set up so that the first line rescanned after the
+ * edit ends in the same state as before, the rescan stops there, and the
+ * lines after it are only right if their entries were kept in place.
+ */
+static void compareWithFreshIndex(KTextEditor::Document *doc, XMLTagIndex &index)
+{
+    XMLTagIndex fresh(doc);
+    for (int line = 0; line < doc->lines(); ++line) {
+        const KTextEditor::Cursor end(line, doc->lineLength(line));
+        QCOMPARE(index.context(end).parentElement, fresh.context(end).parentElement);
+        QCOMPARE(index.context(end).tag, fresh.context(end).tag);
+    }
+}
+
+void XMLTagIndexTest::testCommentInsert()
+{
+    m_doc->setText(QStringList() << QStringLiteral("<a>") << QStringLiteral("<!-- ab") << QStringLiteral("<q> -->") << QStringLiteral("z"));
+
+    XMLTagIndex index(m_doc);
+    QCOMPARE(index.context(KTextEditor::Cursor(3, 0)).parentElement, QStringLiteral("a"));
+
+    // closes the comment on the first line, <q> is not commented out anymore
+    m_doc->insertText(KTextEditor::Cursor(1, 4), QStringLiteral("-->\n"));
+    QCOMPARE(index.context(KTextEditor::Cursor(4, 0)).parentElement, QStringLiteral("q"));
+    compareWithFreshIndex(m_doc, index);
+
+    // and open it again over several lines
+    m_doc->insertText(KTextEditor::Cursor(2, 0), QStringLiteral("<!--\nx\n"));
+    QCOMPARE(index.context(KTextEditor::Cursor(6, 0)).parentElement, QStringLiteral("a"));
+    compareWithFreshIndex(m_doc, index);
+}
+
+void XMLTagIndexTest::testCommentRemove()
+{
+    m_doc->setText(QStringList() << QStringLiteral("<a>") << QStringLiteral("b") << QStringLiteral("<!-- c") << QStringLiteral("<q>") << QStringLiteral("-->") << QStringLiteral("z"));
+
+    XMLTagIndex index(m_doc);
+    QCOMPARE(index.context(KTextEditor::Cursor(5, 0)).parentElement, QStringLiteral("a"));
+
+    m_doc->removeText(KTextEditor::Range(1, 1, 2, 6));
+    QCOMPARE(index.context(KTextEditor::Cursor(4, 0)).parentElement, QStringLiteral("q"));
+    compareWithFreshIndex(m_doc, index);
+
+    m_doc->setText(QStringList() << QStringLiteral("<a>") << QStringLiteral("<!-- x") << QStringLiteral("y") << QStringLiteral("<q> -->") << QStringLiteral("z"));
+    QCOMPARE(index.context(KTextEditor::Cursor(4, 0)).parentElement, QStringLiteral("a"));
+
+    m_doc->removeText(KTextEditor::Range(1, 0, 3, 0));
+    QCOMPARE(index.context(KTextEditor::Cursor(2, 0)).parentElement, QStringLiteral("q"));
+    compareWithFreshIndex(m_doc, index);
+}
+
+void XMLTagIndexTest::testCDataInsert()
+{
+    m_doc->setText(QStringList() << QStringLiteral("<a>") << QStringLiteral("<![CDATA[ ab") << QStringLiteral("<q> ]]>") << QStringLiteral("z"));
+
+    XMLTagIndex index(m_doc);
+    QCOMPARE(index.context(KTextEditor::Cursor(3, 0)).parentElement, QStringLiteral("a"));
+
+    m_doc->insertText(KTextEditor::Cursor(1, 9), QStringLiteral("]]>\n"));
+    QCOMPARE(index.context(KTextEditor::Cursor(4, 0)).parentElement, QStringLiteral("q"));
+    compareWithFreshIndex(m_doc, index);
+}
+
+void XMLTagIndexTest::testCDataRemove()
+{
+    m_doc->setText(QStringList() << QStringLiteral("<a>") << QStringLiteral("b") << QStringLiteral("<![CDATA[ c") << QStringLiteral("<q>") << QStringLiteral("]]>") << QStringLiteral("z"));
+
+    XMLTagIndex index(m_doc);
+    QCOMPARE(index.context(KTextEditor::Cursor(5, 0)).parentElement, QStringLiteral("a"));
+
+    m_doc->removeText(KTextEditor::Range(1, 1, 2, 11));
+    QCOMPARE(index.context(KTextEditor::Cursor(4, 0)).parentElement, QStringLiteral("q"));
+    compareWithFreshIndex(m_doc, index);
+}
+
+void XMLTagIndexTest::testTagInsert()
+{
+    m_doc->setText(QStringList() << QStringLiteral("<a>") << QStringLiteral("<c x='1'") << QStringLiteral("y='2'>") << QStringLiteral("z"));
+
+    XMLTagIndex index(m_doc);
+    QCOMPARE(index.context(KTextEditor::Cursor(2, 1)).tag, QStringLiteral("c"));
+    QCOMPARE(index.context(KTextEditor::Cursor(3, 0)).parentElement, QStringLiteral("c"));
+
+    // the tag is closed on its first line now, the rest is text
+    m_doc->insertText(KTextEditor::Cursor(1, 8), QStringLiteral("/>\n"));
+    QCOMPARE(index.context(KTextEditor::Cursor(3, 1)).tag, QString());
+    QCOMPARE(index.context(KTextEditor::Cursor(4, 0)).parentElement, QStringLiteral("a"));
+    compareWithFreshIndex(m_doc, index);
+}
+
+void XMLTagIndexTest::testTagRemove()
+{
+    m_doc->setText(QStringList() << QStringLiteral("<a>") << QStringLiteral("<b/>") << QStringLiteral("<c x='1'") << QStringLiteral("y='2'>") << QStringLiteral("z"));
+
+    XMLTagIndex index(m_doc);
+    QCOMPARE(index.context(KTextEditor::Cursor(4, 0)).parentElement, QStringLiteral("c"));
+
+    m_doc->removeText(KTextEditor::Range(1, 4, 2, 8));
+    QCOMPARE(index.context(KTextEditor::Cursor(2, 1)).tag, QString());
+    QCOMPARE(index.context(KTextEditor::Cursor(3, 0)).parentElement, QStringLiteral("a"));
+    compareWithFreshIndex(m_doc, index);
+}
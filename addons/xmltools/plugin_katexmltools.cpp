@@ -162,31 +162,15 @@ PluginKateXMLToolsCompletionModel::PluginKateXMLToolsCompletionModel(QObject *co
 
 PluginKateXMLToolsCompletionModel::~PluginKateXMLToolsCompletionModel()
 {
-    qDeleteAll(m_dtds);
-    m_dtds.clear();
+    qDeleteAll(m_tagIndexes);
 }
 
 void PluginKateXMLToolsCompletionModel::slotDocumentDeleted(KTextEditor::Document *doc)
 {
-    // Remove the document from m_DTDs, and also delete the PseudoDTD
-    // if it becomes unused.
-    if (m_docDtds.contains(doc)) {
-        qDebug() << "XMLTools:slotDocumentDeleted: documents: " << m_docDtds.count() << ", DTDs: " << m_dtds.count();
-        PseudoDTD *dtd = m_docDtds.take(doc);
-
-        if (m_docDtds.key(dtd)) {
-            return;
-        }
-
-        QHash<QString, PseudoDTD *>::iterator it;
-        for (it = m_dtds.begin() ; it != m_dtds.end() ; ++it) {
-            if (it.value() == dtd) {
-                m_dtds.erase(it);
-                delete dtd;
-                return;
-            }
-        }
-    }
+    // Remove the document from m_DTDs, the PseudoDTD is deleted
+    // once no other document uses it.
+    m_docDtds.remove(doc);
+    delete m_tagIndexes.take(doc);
 }
 
 
@@ -200,7 +184,8 @@ void PluginKateXMLToolsCompletionModel::completionInvoked(KTextEditor::View *kv,
     qDebug() << "xml tools completionInvoked";
 
     KTextEditor::Document *doc = kv->document();
-    if (! m_docDtds[ doc ])
+    const QSharedPointer<PseudoDTD> dtd = m_docDtds.value(doc);
+    if (! dtd)
         // no meta DTD assigned yet
     {
         return;
@@ -222,13 +207,13 @@ void PluginKateXMLToolsCompletionModel::completionInvoked(KTextEditor::View *kv,
 
     if (leftCh == "&") {
         qDebug() << "Getting entities";
-        m_allowed = m_docDtds[doc]->entities(QString());
+        m_allowed = dtd->entities(QString());
         m_mode = entities;
     } else if (leftCh == "<") {
         qDebug() << "*outside tag -> get elements";
         QString parentElement = getParentElement(*kv, 1);
         qDebug() << "parent: " << parentElement;
-        m_allowed = m_docDtds[doc]->allowedElements(parentElement);
+        m_allowed = dtd->allowedElements(parentElement);
         m_mode = elements;
     } else if (leftCh == "/" && secondLeftCh == "<") {
         qDebug() << "*close parent element";
@@ -241,18 +226,16 @@ void PluginKateXMLToolsCompletionModel::completionInvoked(KTextEditor::View *kv,
     } else if (leftCh == " " || (isQuote(leftCh) && secondLeftCh == "=")) {
         // TODO: check secondLeftChar, too?! then you don't need to trigger
         // with space and we yet save CPU power
-        QString currentElement = insideTag(*kv);
-        QString currentAttribute;
-        if (! currentElement.isEmpty()) {
-            currentAttribute = insideAttribute(*kv);
-        }
+        const XMLTagIndex::Context context = tagIndex(doc)->context(curpos);
+        QString currentElement = context.tag;
+        QString currentAttribute = context.attribute;
 
         qDebug() << "Tag: " << currentElement;
         qDebug() << "Attr: " << currentAttribute;
 
         if (! currentElement.isEmpty() && ! currentAttribute.isEmpty()) {
             qDebug() << "*inside attribute -> get attribute values";
-            m_allowed = m_docDtds[doc]->attributeValues(currentElement, currentAttribute);
+            m_allowed = dtd->attributeValues(currentElement, currentAttribute);
             if (m_allowed.count() == 1 &&
                     (m_allowed[0] == "CDATA" || m_allowed[0] == "ID" || m_allowed[0] == "IDREF" ||
                      m_allowed[0] == "IDREFS" || m_allowed[0] == "ENTITY" || m_allowed[0] == "ENTITIES" ||
@@ -264,7 +247,7 @@ void PluginKateXMLToolsCompletionModel::completionInvoked(KTextEditor::View *kv,
             }
         } else if (! currentElement.isEmpty()) {
             qDebug() << "*inside tag -> get attributes";
-            m_allowed = m_docDtds[doc]->allowedAttributes(currentElement);
+            m_allowed = dtd->allowedAttributes(currentElement);
             m_mode = attributes;
         }
     }
@@ -272,9 +255,7 @@ void PluginKateXMLToolsCompletionModel::completionInvoked(KTextEditor::View *kv,
     //qDebug() << "time elapsed (ms): " << t.elapsed();
     qDebug() << "Allowed strings: " << m_allowed.count();
 
-    if (m_allowed.count() >= 1 && m_allowed[0] != "__EMPTY") {
-        m_allowed = sortQStringList(m_allowed);
-    }
+    // the DTD returns its vocabulary sorted already
     setRowCount(m_allowed.count());
     endResetModel();
 }
@@ -469,8 +450,9 @@ void PluginKateXMLToolsCompletionModel::getDTD()
 
     m_urlString = url.url();  // remember directory for next time
 
-    if (m_dtds[ m_urlString ]) {
-        assignDTD(m_dtds[ m_urlString ], kv);
+    QSharedPointer<PseudoDTD> dtd = m_dtds.value(m_urlString).toStrongRef();
+    if (dtd) {
+        assignDTD(dtd, kv);
     } else {
         m_dtdString.clear();
         m_viewToAssignTo = kv;
@@ -495,25 +477,48 @@ void PluginKateXMLToolsCompletionModel::slotFinished(KJob *job)
                                    "The server returned an error.", m_urlString),
                            i18n("XML Plugin Error"));
     } else {
-        PseudoDTD *dtd = new PseudoDTD();
-        dtd->analyzeDTD(m_urlString, m_dtdString);
-
-        m_dtds.insert(m_urlString, dtd);
-        assignDTD(dtd, m_viewToAssignTo);
+        // parsing a large meta DTD takes a while, do it off the GUI thread
+        PseudoDTDLoader *loader = new PseudoDTDLoader(m_urlString, m_dtdString);
+        connect(loader, SIGNAL(finished(QString, QSharedPointer<PseudoDTD>, QString)),
+                this, SLOT(slotDTDLoaded(QString, QSharedPointer<PseudoDTD>, QString)));
+        PseudoDTDLoader::start(loader);
 
-        // clean up a bit
-        m_viewToAssignTo = 0;
+        // the override cursor is restored once the DTD is ready
         m_dtdString.clear();
+        return;
     }
+
+    // clean up a bit
+    m_viewToAssignTo = 0;
+    m_dtdString.clear();
     QGuiApplication::restoreOverrideCursor();
 }
 
 void PluginKateXMLToolsCompletionModel::slotData(KIO::Job *, const QByteArray &data)
 {
-    m_dtdString += QString(data);
+    m_dtdString += data;
+}
+
+void PluginKateXMLToolsCompletionModel::slotDTDLoaded(const QString &url, QSharedPointer<PseudoDTD> dtd, const QString &error)
+{
+    QGuiApplication::restoreOverrideCursor();
+
+    if (!dtd) {
+        KMessageBox::error(0, error, i18n("XML Plugin Error"));
+    } else {
+        m_dtds.insert(url, dtd);
+
+        // the view may have been closed meanwhile
+        if (m_viewToAssignTo) {
+            assignDTD(dtd, m_viewToAssignTo);
+        }
+    }
+
+    // clean up a bit
+    m_viewToAssignTo = 0;
 }
 
-void PluginKateXMLToolsCompletionModel::assignDTD(PseudoDTD *dtd, KTextEditor::View *view)
+void PluginKateXMLToolsCompletionModel::assignDTD(QSharedPointer<PseudoDTD> dtd, KTextEditor::View *view)
 {
     m_docDtds.insert(view->document(), dtd);
 
@@ -547,7 +552,7 @@ void PluginKateXMLToolsCompletionModel::slotInsertElement()
     }
 
     KTextEditor::Document *doc = kv->document();
-    PseudoDTD *dtd = m_docDtds[doc];
+    QSharedPointer<PseudoDTD> dtd = m_docDtds.value(doc);
     QString parentElement = getParentElement(*kv, 0);
     QStringList allowed;
 
@@ -693,7 +698,8 @@ void PluginKateXMLToolsCompletionModel::executeCompletionItem(KTextEditor::View
     else if (m_mode == elements) {
         // anders: if the tag is marked EMPTY, insert in form <tagname/>
         QString str;
-        bool isEmptyTag = m_docDtds[document]->allowedElements(text).contains("__EMPTY");
+        const QSharedPointer<PseudoDTD> dtd = m_docDtds.value(document);
+        bool isEmptyTag = dtd->allowedElements(text).contains("__EMPTY");
         if (isEmptyTag) {
             str = text + "/>";
         } else {
@@ -703,8 +709,8 @@ void PluginKateXMLToolsCompletionModel::executeCompletionItem(KTextEditor::View
         // Place the cursor where it is most likely wanted:
         // always inside the tag if the tag is empty AND the DTD indicates that there are attribs)
         // outside for open tags, UNLESS there are mandatory attributes
-        if (m_docDtds[document]->requiredAttributes(text).count()
-                || (isEmptyTag && m_docDtds[document]->allowedAttributes(text).count())) {
+        if (dtd->requiredAttributes(text).count()
+                || (isEmptyTag && dtd->allowedAttributes(text).count())) {
             posCorrection = text.length() - str.length();
         } else if (! isEmptyTag) {
             posCorrection = text.length() - str.length() + 1;
@@ -730,111 +736,9 @@ void PluginKateXMLToolsCompletionModel::executeCompletionItem(KTextEditor::View
 // Pseudo-XML stuff:
 
 /**
- * Check if cursor is inside a tag, that is
- * if "<" occurs before ">" occurs ( on the left side of the cursor ).
- * Return the tag name, return "" if we cursor is outside a tag.
- */
-QString PluginKateXMLToolsCompletionModel::insideTag(KTextEditor::View &kv)
-{
-    int line, col;
-    kv.cursorPosition().position(line, col);
-    int y = line; // another variable because uint <-> int
-
-    do {
-        QString lineStr = kv.document()->line(y);
-        for (uint x = col; x > 0; x--) {
-            QString ch = lineStr.mid(x - 1, 1);
-            if (ch == ">") {  // cursor is outside tag
-                return QString();
-            }
-
-            if (ch == "<") {
-                QString tag;
-                // look for white space on the right to get the tag name
-                for (int z = x; z <= lineStr.length() ; ++z) {
-                    ch = lineStr.mid(z - 1, 1);
-                    if (ch.at(0).isSpace() || ch == "/" || ch == ">") {
-                        return tag.right(tag.length() - 1);
-                    }
-
-                    if (z == lineStr.length()) {
-                        tag += ch;
-                        return tag.right(tag.length() - 1);
-                    }
-
-                    tag += ch;
-                }
-            }
-        }
-        y--;
-        col = kv.document()->line(y).length();
-    } while (y >= 0);
-
-    return QString();
-}
-
-/**
- * Check if cursor is inside an attribute value, that is
- * if '="' is on the left, and if it's nearer than "<" or ">".
- *
- * @Return the attribute name or "" if we're outside an attribute
- * value.
- *
- * Note: only call when insideTag() == true.
- * TODO: allow whitespace around "="
- */
-QString PluginKateXMLToolsCompletionModel::insideAttribute(KTextEditor::View &kv)
-{
-    int line, col;
-    kv.cursorPosition().position(line, col);
-    int y = line; // another variable because uint <-> int
-    uint x = 0;
-    QString lineStr;
-    QString ch;
-
-    do {
-        lineStr = kv.document()->line(y);
-        for (x = col; x > 0; x--) {
-            ch = lineStr.mid(x - 1, 1);
-            QString chLeft = lineStr.mid(x - 2, 1);
-            // TODO: allow whitespace
-            if (isQuote(ch) && chLeft == "=") {
-                break;
-            } else if (isQuote(ch) && chLeft != "=") {
-                return QString();
-            } else if (ch == "<" || ch == ">") {
-                return QString();
-            }
-        }
-        y--;
-        col = kv.document()->line(y).length();
-    } while (!isQuote(ch));
-
-    // look for next white space on the left to get the tag name
-    QString attr;
-    for (int z = x; z >= 0; z--) {
-        ch = lineStr.mid(z - 1, 1);
-
-        if (ch.at(0).isSpace()) {
-            break;
-        }
-
-        if (z == 0) {
-            // start of line == whitespace
-            attr += ch;
-            break;
-        }
-
-        attr = ch + attr;
-    }
-
-    return attr.left(attr.length() - 2);
-}
-
-/**
- * Find the parent element for the current cursor position. That is,
- * go left and find the first opening element that's not closed yet,
- * ignoring empty elements.
+ * Find the parent element for the current cursor position, ignoring the
+ * @p skipCharacters characters left of the cursor. That is the innermost
+ * opening element that's not closed yet, ignoring empty elements.
  * Examples: If cursor is at "X", the correct parent element is "p":
  * <p> <a x="xyz"> foo <i> test </i> bar </a> X
  * <p> <a x="xyz"> foo bar </a> X
@@ -843,134 +747,20 @@ QString PluginKateXMLToolsCompletionModel::insideAttribute(KTextEditor::View &kv
  */
 QString PluginKateXMLToolsCompletionModel::getParentElement(KTextEditor::View &kv, int skipCharacters)
 {
-    enum {
-        parsingText,
-        parsingElement,
-        parsingElementBoundary,
-        parsingNonElement,
-        parsingAttributeDquote,
-        parsingAttributeSquote,
-        parsingIgnore
-    } parseState;
-    parseState = (skipCharacters > 0) ? parsingIgnore : parsingText;
-
-    int nestingLevel = 0;
+    KTextEditor::Cursor pos = kv.cursorPosition();
+    pos.setColumn(qMax(0, pos.column() - skipCharacters));
 
-    int line, col;
-    kv.cursorPosition().position(line, col);
-    QString str = kv.document()->line(line);
-
-    while (true) {
-        // move left a character
-        if (!col--) {
-            do {
-                if (!line--) {
-                    return QString();    // reached start of document
-                }
-                str = kv.document()->line(line);
-                col = str.length();
-            } while (!col);
-            --col;
-        }
-
-        ushort ch = str.at(col).unicode();
-
-        switch (parseState) {
-        case parsingIgnore:
-            // ignore the specified number of characters
-            parseState = (--skipCharacters > 0) ? parsingIgnore : parsingText;
-            break;
-
-        case parsingText:
-            switch (ch) {
-            case '<':
-                // hmm... we were actually inside an element
-                return QString();
-
-            case '>':
-                // we just hit an element boundary
-                parseState = parsingElementBoundary;
-                break;
-            }
-            break;
-
-        case parsingElement:
-            switch (ch) {
-            case '"': // attribute ( double quoted )
-                parseState = parsingAttributeDquote;
-                break;
-
-            case '\'': // attribute ( single quoted )
-                parseState = parsingAttributeSquote;
-                break;
-
-            case '/': // close tag
-                parseState = parsingNonElement;
-                ++nestingLevel;
-                break;
-
-            case '<':
-                // we just hit the start of the element...
-                if (nestingLevel--) {
-                    break;
-                }
-
-                QString tag = str.mid(col + 1);
-                for (uint pos = 0, len = tag.length(); pos < len; ++pos) {
-                    ch = tag.at(pos).unicode();
-                    if (ch == ' ' || ch == '\t' || ch == '>') {
-                        tag.truncate(pos);
-                        break;
-                    }
-                }
-                return tag;
-            }
-            break;
-
-        case parsingElementBoundary:
-            switch (ch) {
-            case '?': // processing instruction
-            case '-': // comment
-            case '/': // empty element
-                parseState = parsingNonElement;
-                break;
-
-            case '"':
-                parseState = parsingAttributeDquote;
-                break;
-
-            case '\'':
-                parseState = parsingAttributeSquote;
-                break;
-
-            case '<': // empty tag ( bad XML )
-                parseState = parsingText;
-                break;
-
-            default:
-                parseState = parsingElement;
-            }
-            break;
-
-        case parsingAttributeDquote:
-            if (ch == '"') {
-                parseState = parsingElement;
-            }
-            break;
-
-        case parsingAttributeSquote:
-            if (ch == '\'') {
-                parseState = parsingElement;
-            }
-            break;
+    return tagIndex(kv.document())->context(pos).parentElement;
+}
 
-        case parsingNonElement:
-            if (ch == '<') {
-                parseState = parsingText;
-            }
-            break;
-        }
+XMLTagIndex *PluginKateXMLToolsCompletionModel::tagIndex(KTextEditor::Document *doc)
+{
+    XMLTagIndex *index = m_tagIndexes.value(doc);
+    if (!index) {
+        index = new XMLTagIndex(doc);
+        m_tagIndexes.insert(doc, index);
     }
+    return index;
 }
 
 /**
@@ -1028,36 +818,6 @@ QString PluginKateXMLToolsCompletionModel::currentModeToString() const
     return QString();
 }
 
-/** Sort a QStringList case-insensitively. Static. TODO: make it more simple. */
-QStringList PluginKateXMLToolsCompletionModel::sortQStringList(QStringList list)
-{
-    // Sort list case-insensitive. This looks complicated but using a QMap
-    // is even suggested by the Qt documentation.
-    QMap<QString, QString> mapList;
-    for (QStringList::Iterator it = list.begin(); it != list.end(); ++it) {
-        QString str = *it;
-        if (mapList.contains(str.toLower())) {
-            // do not override a previous value, e.g. "Auml" and "auml" are two different
-            // entities, but they should be sorted next to each other.
-            // TODO: currently it's undefined if e.g. "A" or "a" comes first, it depends on
-            // the meta DTD ( really? it seems to work okay?!? )
-            mapList[str.toLower() + '_'] = str;
-        } else {
-            mapList[str.toLower()] = str;
-        }
-    }
-
-    list.clear();
-    QMap<QString, QString>::Iterator it;
-
-    // Qt doc: "the items are alphabetically sorted [by key] when iterating over the map":
-    for (it = mapList.begin(); it != mapList.end(); ++it) {
-        list.append(it.value());
-    }
-
-    return list;
-}
-
 //BEGIN InsertElement dialog
 InsertElement::InsertElement(const QStringList & completions, QWidget * parent)
     : QDialog(parent)
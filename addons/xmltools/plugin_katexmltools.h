@@ -24,6 +24,7 @@
 #define PLUGIN_KATEXMLTOOLS_H
 
 #include "pseudo_dtd.h"
+#include "xml_tag_index.h"
 
 #include <ktexteditor/application.h>
 #include <ktexteditor/codecompletioninterface.h>
@@ -34,6 +35,8 @@
 #include <ktexteditor/plugin.h>
 #include <ktexteditor/view.h>
 
+#include <QHash>
+#include <QPointer>
 #include <QString>
 #include <QVariantList>
 
@@ -93,6 +96,7 @@ public Q_SLOTS:
 
     void slotFinished(KJob *job);
     void slotData(KIO::Job *, const QByteArray &data);
+    void slotDTDLoaded(const QString &url, QSharedPointer<PseudoDTD> dtd, const QString &error);
 
     void completionInvoked(KTextEditor::View *kv, const KTextEditor::Range &range, InvocationType invocationType);
 
@@ -102,11 +106,10 @@ public Q_SLOTS:
 protected:
 
     QString currentModeToString() const;
-    static QStringList sortQStringList(QStringList list);
     //bool eventFilter( QObject *object, QEvent *event );
 
-    QString insideTag(KTextEditor::View &kv);
-    QString insideAttribute(KTextEditor::View &kv);
+    /// the element structure of @p doc, created on first use
+    XMLTagIndex *tagIndex(KTextEditor::Document *doc);
 
     static bool isOpeningTag(const QString &tag);
     static bool isClosingTag(const QString &tag);
@@ -121,12 +124,12 @@ protected:
     enum Level {groupNode = 1};
 
     /// Assign the PseudoDTD @p dtd to the Kate::View @p view
-    void assignDTD(PseudoDTD *dtd, KTextEditor::View *view);
+    void assignDTD(QSharedPointer<PseudoDTD> dtd, KTextEditor::View *view);
 
     /// temporary placeholder for the metaDTD file
-    QString m_dtdString;
+    QByteArray m_dtdString;
     /// temporary placeholder for the view to assign a DTD to while the file is loaded
-    KTextEditor::View *m_viewToAssignTo;
+    QPointer<KTextEditor::View> m_viewToAssignTo;
     /// URL of the last loaded meta DTD
     QString m_urlString;
 
@@ -139,10 +142,13 @@ protected:
     KTextEditor::CodeCompletionInterface *m_codeInterface;
 
     /// maps KTE::Document -> DTD
-    QHash<KTextEditor::Document *, PseudoDTD *> m_docDtds;
+    QHash<KTextEditor::Document *, QSharedPointer<PseudoDTD> > m_docDtds;
 
-    /// maps DTD filename -> DTD
-    QHash<QString, PseudoDTD *> m_dtds;
+    /// maps DTD filename -> DTD, a DTD is freed with the last document using it
+    QHash<QString, QWeakPointer<PseudoDTD> > m_dtds;
+
+    /// maps KTE::Document -> element structure
+    QHash<KTextEditor::Document *, XMLTagIndex *> m_tagIndexes;
 };
 
 class PluginKateXMLToolsView : public QObject, public KXMLGUIClient
@@ -22,11 +22,23 @@
 
 #include "pseudo_dtd.h"
 
-#include <qdom.h>
-#include <qregexp.h>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QSet>
+#include <QStandardPaths>
+#include <QThreadPool>
+#include <QXmlStreamReader>
+
+#include <algorithm>
 
 #include <klocalizedstring.h>
-#include <kmessagebox.h>
+
+/// bump whenever the layout written by PseudoDTD::save() changes
+static const quint32 CACHE_MAGIC = 0x4d445444; // "MDTD"
+static const quint32 CACHE_VERSION = 1;
 
 PseudoDTD::PseudoDTD()
 {
@@ -38,297 +50,326 @@ PseudoDTD::~PseudoDTD()
 {
 }
 
-void PseudoDTD::analyzeDTD(QString &metaDtdUrl, QString &metaDtd)
+PseudoDTD::Result PseudoDTD::analyzeDTD(const QByteArray &metaDtd)
 {
-    QDomDocument doc("dtdIn_xml");
-    if (! doc.setContent(metaDtd)) {
-        KMessageBox::error(0, i18n("The file '%1' could not be parsed. "
-                                   "Please check that the file is well-formed XML.", metaDtdUrl),
-                           i18n("XML Plugin Error"));
-        return;
+    m_entityList.clear();
+    m_elementsList.clear();
+    m_attributesList.clear();
+    m_attributevaluesList.clear();
+
+    // Get information from meta DTD and put it in Qt data structures for fast access,
+    // everything in one pass over the file:
+    QXmlStreamReader xml(metaDtd);
+    bool doctypeSeen = false;
+
+    while (!xml.atEnd()) {
+        xml.readNext();
+
+        if (xml.isDTD()) {
+            doctypeSeen = (xml.dtdName() == QLatin1String("dtd"));
+        } else if (xml.isStartElement()) {
+            if (!doctypeSeen) {
+                // still read it all, a broken file is reported as such
+                xml.skipCurrentElement();
+                continue;
+            }
+
+            // the children of the <dtd> root
+            while (xml.readNextStartElement()) {
+                if (xml.name() == QLatin1String("entity")) {
+                    parseEntity(xml);
+                } else if (xml.name() == QLatin1String("element")) {
+                    parseElement(xml);
+                } else if (xml.name() == QLatin1String("attlist")) {
+                    parseAttlist(xml);
+                } else {
+                    xml.skipCurrentElement();
+                }
+            }
+        }
+    }
+
+    if (xml.hasError()) {
+        return NotWellFormed;
     }
 
-    if (doc.doctype().name() != "dtd") {
-        KMessageBox::error(0, i18n("The file '%1' is not in the expected format. "
-                                   "Please check that the file is of this type:\n"
-                                   "-//Norman Walsh//DTD DTDParse V2.0//EN\n"
-                                   "You can produce such files with dtdparse. "
-                                   "See the Kate Plugin documentation for more information.", metaDtdUrl),
-                           i18n("XML Plugin Error"));
-        return;
+    if (!doctypeSeen) {
+        return WrongFormat;
     }
 
-    uint listLength = 0;
-    listLength += doc.elementsByTagName("entity").count();
-    listLength += doc.elementsByTagName("element").count();
-    // count this twice, as it will be iterated twice ( TODO: optimize that? ):
-    listLength += doc.elementsByTagName("attlist").count() * 2;
+    buildIndex();
+    return Ok;
+}
 
-    QProgressDialog progress(i18n("Analyzing meta DTD..."), i18n("Cancel"), 0, listLength);
-    progress.setMinimumDuration(400);
-    progress.setValue(0);
+void PseudoDTD::save(QDataStream &out) const
+{
+    out << m_entityList << m_elementsList << m_attributevaluesList;
 
-    // Get information from meta DTD and put it in Qt data structures for fast access:
-    if (! parseEntities(&doc, &progress)) {
-        return;
+    out << quint32(m_attributesList.size());
+    QMap<QString, ElementAttributes>::ConstIterator it;
+    for (it = m_attributesList.constBegin(); it != m_attributesList.constEnd(); ++it) {
+        out << it.key() << it.value().optionalAttributes << it.value().requiredAttributes;
     }
+}
 
-    if (! parseElements(&doc, &progress)) {
-        return;
-    }
+bool PseudoDTD::load(QDataStream &in)
+{
+    in >> m_entityList >> m_elementsList >> m_attributevaluesList;
 
-    if (! parseAttributes(&doc, &progress)) {
-        return;
+    quint32 count;
+    in >> count;
+    m_attributesList.clear();
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        QString name;
+        ElementAttributes attrs;
+        in >> name >> attrs.optionalAttributes >> attrs.requiredAttributes;
+        m_attributesList.insert(name, attrs);
     }
 
-    if (! parseAttributeValues(&doc, &progress)) {
-        return;
+    if (in.status() != QDataStream::Ok) {
+        return false;
     }
 
-    progress.setValue(listLength);     // just to make sure the dialog disappears
-
+    buildIndex();
+    return true;
 }
 
 // ========================================================================
-// DOM stuff:
+// Meta DTD parsing:
 
 /**
- * Iterate through the XML to get a mapping which sub-elements are allowed for
- * all elements.
+ * Read an <entity>, mapping its name to the expanded version,
+ * e.g. nbsp => &#160;. Parameter entities are ignored.
  */
-bool PseudoDTD::parseElements(QDomDocument *doc, QProgressDialog *progress)
+void PseudoDTD::parseEntity(QXmlStreamReader &xml)
 {
-
-    m_elementsList.clear();
-    // We only display a list, i.e. we pretend that the content model is just
-    // a set, so we use a map. This is necessay e.g. for xhtml 1.0's head element,
-    // which would otherwise display some elements twice.
-    QMap<QString, bool> subelementList;   // the bool is not used
-
-    QDomNodeList list = doc->elementsByTagName("element");
-    uint listLength = list.count();      // speedup (really! )
-
-    for (uint i = 0; i < listLength; i++) {
-        if (progress->wasCanceled()) {
-            return false;
+    const QString name = xml.attributes().value(QLatin1String("name")).toString();
+    const bool isParam = (xml.attributes().value(QLatin1String("type")) == QLatin1String("param"));
+
+    // TODO: what's cdata <-> gen ?
+    QString exp;
+    bool expanded = false;
+    while (xml.readNextStartElement()) {
+        if (xml.name() == QLatin1String("text-expanded") && !expanded) {
+            // TODO: support more than one &#...; in the expanded text
+            exp = xml.readElementText(QXmlStreamReader::IncludeChildElements);
+            expanded = true;
+        } else {
+            xml.skipCurrentElement();
         }
+    }
 
-        progress->setValue(progress->value() + 1);
-        // FIXME!:
-        //qApp->processEvents();
-
-        subelementList.clear();
-        QDomNode node = list.item(i);
-        QDomElement elem = node.toElement();
-
-        if (!elem.isNull()) {
-            // Enter the expanded content model, which may also include stuff not allowed.
-            // We do not care if it's a <sequence-group> or whatever.
-            QDomNodeList contentModelList = elem.elementsByTagName("content-model-expanded");
-            QDomNode contentModelNode = contentModelList.item(0);
-            QDomElement contentModelElem = contentModelNode.toElement();
-            if (! contentModelElem.isNull()) {
-                // check for <pcdata/>:
-                QDomNodeList pcdataList = contentModelElem.elementsByTagName("pcdata");
-
-                // check for other sub elements:
-                QDomNodeList subList = contentModelElem.elementsByTagName("element-name");
-                uint subListLength = subList.count();
-                for (uint l = 0; l < subListLength; l++) {
-                    QDomNode subNode = subList.item(l);
-                    QDomElement subElem = subNode.toElement();
-                    if (!subElem.isNull()) {
-                        subelementList[subElem.attribute("name")] = true;
-                    }
-                }
+    if (!isParam) {
+        m_entityList.insert(name, exp);
+    }
+}
 
-                // anders: check if this is an EMPTY element, and put "__EMPTY" in the
-                // sub list, so that we can insert tags in empty form if required.
-                QDomNodeList emptyList = elem.elementsByTagName("empty");
-                if (emptyList.count()) {
-                    subelementList["__EMPTY"] = true;
-                }
-            }
+/**
+ * Read an <element>, mapping it to the sub-elements allowed in it.
+ */
+void PseudoDTD::parseElement(QXmlStreamReader &xml)
+{
+    const QString name = xml.attributes().value(QLatin1String("name")).toString();
 
-            // Now remove the elements not allowed (e.g. <a> is explicitly not allowed in <a>
-            // in the HTML 4.01 Strict DTD):
-            QDomNodeList exclusionsList = elem.elementsByTagName("exclusions");
-            if (exclusionsList.length() > 0) {
+    // We only display a list, i.e. we pretend that the content model is just
+    // a set. This is necessay e.g. for xhtml 1.0's head element,
+    // which would otherwise display some elements twice.
+    QSet<QString> subelements;
+    QSet<QString> exclusions;
+    bool contentModelSeen = false;
+    bool emptySeen = false;
+
+    // Enter the expanded content model, which may also include stuff not allowed.
+    // We do not care if it's a <sequence-group> or whatever.
+    int contentModelDepth = 0;
+    int exclusionsDepth = 0;
+    bool exclusionsSeen = false;
+    int depth = 1;
+
+    while (depth > 0 && !xml.atEnd()) {
+        xml.readNext();
+
+        if (xml.isStartElement()) {
+            ++depth;
+
+            if (xml.name() == QLatin1String("content-model-expanded") && !contentModelSeen) {
+                contentModelSeen = true;
+                contentModelDepth = depth;
+            } else if (xml.name() == QLatin1String("exclusions") && !exclusionsSeen) {
                 // sometimes there are no exclusions ( e.g. in XML DTDs there are never exclusions )
-                QDomNode exclusionsNode = exclusionsList.item(0);
-                QDomElement exclusionsElem = exclusionsNode.toElement();
-                if (! exclusionsElem.isNull()) {
-                    QDomNodeList subList = exclusionsElem.elementsByTagName("element-name");
-                    uint subListLength = subList.count();
-                    for (uint l = 0; l < subListLength; l++) {
-                        QDomNode subNode = subList.item(l);
-                        QDomElement subElem = subNode.toElement();
-                        if (!subElem.isNull()) {
-                            QMap<QString, bool>::Iterator it = subelementList.find(subElem.attribute("name"));
-                            if (it != subelementList.end()) {
-                                subelementList.erase(it);
-                            }
-                        }
-                    }
+                exclusionsSeen = true;
+                exclusionsDepth = depth;
+            } else if (xml.name() == QLatin1String("empty")) {
+                // anders: check if this is an EMPTY element, and put "__EMPTY" in the
+                // sub list, so that we can insert tags in empty form if required.
+                emptySeen = true;
+            } else if (xml.name() == QLatin1String("element-name")) {
+                const QString subName = xml.attributes().value(QLatin1String("name")).toString();
+                if (contentModelDepth) {
+                    subelements.insert(subName);
+                } else if (exclusionsDepth) {
+                    exclusions.insert(subName);
                 }
             }
-
-            // turn the map into a list:
-            QStringList subelementListTmp;
-            QMap<QString, bool>::Iterator it;
-            for (it = subelementList.begin(); it != subelementList.end(); ++it) {
-                subelementListTmp.append(it.key());
+        } else if (xml.isEndElement()) {
+            if (depth == contentModelDepth) {
+                contentModelDepth = 0;
+            } else if (depth == exclusionsDepth) {
+                exclusionsDepth = 0;
             }
+            --depth;
+        }
+    }
 
-            m_elementsList.insert(elem.attribute("name"), subelementListTmp);
+    if (contentModelSeen && emptySeen) {
+        subelements.insert(QStringLiteral("__EMPTY"));
+    }
 
-        }
+    // Now remove the elements not allowed (e.g. <a> is explicitly not allowed in <a>
+    // in the HTML 4.01 Strict DTD):
+    subelements.subtract(exclusions);
 
-    } // end iteration over all <element> nodes
-    return true;
+    // sorted in buildIndex()
+    m_elementsList.insert(name, subelements.toList());
 }
 
 /**
- * Check which elements are allowed inside a parent element. This returns
- * a list of allowed elements, but it doesn't care about order or if only a certain
- * number of occurrences is allowed.
+ * Read an <attlist>, mapping the element to its attributes and the
+ * attributes to their allowed values.
  */
-QStringList PseudoDTD::allowedElements(QString parentElement)
+void PseudoDTD::parseAttlist(QXmlStreamReader &xml)
 {
-    if (m_sgmlSupport) {
-        // find the matching element, ignoring case:
-        QMap<QString, QStringList>::Iterator it;
-        for (it = m_elementsList.begin(); it != m_elementsList.end(); ++it) {
-            if (it.key().compare(parentElement, Qt::CaseInsensitive) == 0) {
-                return it.value();
+    const QString name = xml.attributes().value(QLatin1String("name")).toString();
+
+    ElementAttributes attrs;
+    QMap<QString, QStringList> attributevalues;   // 1 attribute : n possible values
+
+    int depth = 1;
+    while (depth > 0 && !xml.atEnd()) {
+        xml.readNext();
+
+        if (xml.isStartElement()) {
+            ++depth;
+
+            if (xml.name() == QLatin1String("attribute")) {
+                const QXmlStreamAttributes attributes = xml.attributes();
+                const QString attributeName = attributes.value(QLatin1String("name")).toString();
+
+                if (attributes.value(QLatin1String("type")) == QLatin1String("#REQUIRED")) {
+                    attrs.requiredAttributes.append(attributeName);
+                } else {
+                    attrs.optionalAttributes.append(attributeName);
+                }
+
+                attributevalues.insert(attributeName, attributes.value(QLatin1String("value")).toString().split(QChar(' ')));
             }
+        } else if (xml.isEndElement()) {
+            --depth;
         }
-    } else if (m_elementsList.contains(parentElement)) {
-        return m_elementsList[parentElement];
     }
 
-    return QStringList();
+    m_attributesList.insert(name, attrs);
+    m_attributevaluesList.insert(name, attributevalues);
+}
+
+template<typename T>
+static void indexNames(const QMap<QString, T> &map, QHash<QString, QString> &index)
+{
+    index.clear();
+    index.reserve(map.size());
+
+    // the first match in map order wins, like the linear search did
+    typename QMap<QString, T>::ConstIterator it;
+    for (it = map.constBegin(); it != map.constEnd(); ++it) {
+        const QString folded = it.key().toLower();
+        if (!index.contains(folded)) {
+            index.insert(folded, it.key());
+        }
+    }
+}
+
+static bool vocabularyLessThan(const QString &a, const QString &b)
+{
+    return a.compare(b, Qt::CaseInsensitive) < 0;
 }
 
 /**
- * Iterate through the XML to get a mapping which attributes are allowed inside
- * all elements.
+ * Sort @p list case-insensitively, e.g. "Auml" and "auml" are two different
+ * entities, but they should be sorted next to each other.
  */
-bool PseudoDTD::parseAttributes(QDomDocument *doc, QProgressDialog *progress)
+void PseudoDTD::sortVocabulary(QStringList &list)
 {
-    m_attributesList.clear();
-//   QStringList allowedAttributes;
-    QDomNodeList list = doc->elementsByTagName("attlist");
-    uint listLength = list.count();
-
-    for (uint i = 0; i < listLength; i++) {
-        if (progress->wasCanceled()) {
-            return false;
-        }
+    std::stable_sort(list.begin(), list.end(), vocabularyLessThan);
+}
 
-        progress->setValue(progress->value() + 1);
-        // FIXME!!
-        //qApp->processEvents();
+void PseudoDTD::buildIndex()
+{
+    // the lists are sorted once here instead of on every completion
+    QMap<QString, QStringList>::Iterator it;
+    for (it = m_elementsList.begin(); it != m_elementsList.end(); ++it) {
+        sortVocabulary(it.value());
+    }
 
-        ElementAttributes attrs;
-        QDomNode node = list.item(i);
-        QDomElement elem = node.toElement();
-        if (!elem.isNull()) {
-            QDomNodeList attributeList = elem.elementsByTagName("attribute");
-            uint attributeListLength = attributeList.count();
-            for (uint l = 0; l < attributeListLength; l++) {
-                QDomNode attributeNode = attributeList.item(l);
-                QDomElement attributeElem = attributeNode.toElement();
-
-                if (! attributeElem.isNull()) {
-                    if (attributeElem.attribute("type") == "#REQUIRED") {
-                        attrs.requiredAttributes.append(attributeElem.attribute("name"));
-                    } else {
-                        attrs.optionalAttributes.append(attributeElem.attribute("name"));
-                    }
-                }
-            }
-            m_attributesList.insert(elem.attribute("name"), attrs);
+    QMap< QString, QMap<QString, QStringList> >::Iterator itE;
+    for (itE = m_attributevaluesList.begin(); itE != m_attributevaluesList.end(); ++itE) {
+        for (it = itE.value().begin(); it != itE.value().end(); ++it) {
+            sortVocabulary(it.value());
         }
     }
 
-    return true;
+    m_attributeNamesList.clear();
+    QMap<QString, ElementAttributes>::ConstIterator itA;
+    for (itA = m_attributesList.constBegin(); itA != m_attributesList.constEnd(); ++itA) {
+        QStringList names = itA.value().optionalAttributes + itA.value().requiredAttributes;
+        sortVocabulary(names);
+        m_attributeNamesList.insert(itA.key(), names);
+    }
+
+    m_entityNames = m_entityList.keys();
+    sortVocabulary(m_entityNames);
+
+    indexNames(m_elementsList, m_elementsIndex);
+    indexNames(m_attributesList, m_attributesIndex);
+    indexNames(m_attributevaluesList, m_attributevaluesIndex);
 }
 
-/** Check which attributes are allowed for an element.
+QString PseudoDTD::findName(const QHash<QString, QString> &index, const QString &name)
+{
+    return index.value(name.toLower());
+}
+
+/**
+ * Check which elements are allowed inside a parent element. This returns
+ * a list of allowed elements, but it doesn't care about order or if only a certain
+ * number of occurrences is allowed.
  */
-QStringList PseudoDTD::allowedAttributes(QString element)
+QStringList PseudoDTD::allowedElements(QString parentElement)
 {
     if (m_sgmlSupport) {
         // find the matching element, ignoring case:
-        QMap<QString, ElementAttributes>::Iterator it;
-        for (it = m_attributesList.begin(); it != m_attributesList.end(); ++it) {
-            if (it.key().compare(element, Qt::CaseInsensitive) == 0) {
-                return it.value().optionalAttributes + it.value().requiredAttributes;
-            }
-        }
-    } else if (m_attributesList.contains(element)) {
-        return m_attributesList[element].optionalAttributes + m_attributesList[element].requiredAttributes;
+        parentElement = findName(m_elementsIndex, parentElement);
     }
 
-    return QStringList();
+    return m_elementsList.value(parentElement);
 }
 
-QStringList PseudoDTD::requiredAttributes(const QString &element) const
+/** Check which attributes are allowed for an element.
+ */
+QStringList PseudoDTD::allowedAttributes(QString element)
 {
     if (m_sgmlSupport) {
-        QMap<QString, ElementAttributes>::ConstIterator it;
-        for (it = m_attributesList.begin(); it != m_attributesList.end(); ++it) {
-            if (it.key().compare(element, Qt::CaseInsensitive) == 0) {
-                return it.value().requiredAttributes;
-            }
-        }
-    } else if (m_attributesList.contains(element)) {
-        return m_attributesList[element].requiredAttributes;
+        // find the matching element, ignoring case:
+        element = findName(m_attributesIndex, element);
     }
 
-    return QStringList();
+    return m_attributeNamesList.value(element);
 }
 
-/**
- * Iterate through the XML to get a mapping which attribute values are allowed
- * for all attributes inside all elements.
- */
-bool PseudoDTD::parseAttributeValues(QDomDocument *doc, QProgressDialog *progress)
+QStringList PseudoDTD::requiredAttributes(const QString &element) const
 {
-    m_attributevaluesList.clear();                        // 1 element : n possible attributes
-    QMap<QString, QStringList> attributevaluesTmp;    // 1 attribute : n possible values
-    QDomNodeList list = doc->elementsByTagName("attlist");
-    uint listLength = list.count();
-
-    for (uint i = 0; i < listLength; i++) {
-        if (progress->wasCanceled()) {
-            return false;
-        }
+    const QString name = m_sgmlSupport ? findName(m_attributesIndex, element) : element;
 
-        progress->setValue(progress->value() + 1);
-        // FIXME!
-        //qApp->processEvents();
-
-        attributevaluesTmp.clear();
-        QDomNode node = list.item(i);
-        QDomElement elem = node.toElement();
-        if (!elem.isNull()) {
-            // Enter the list of <attribute>:
-            QDomNodeList attributeList = elem.elementsByTagName("attribute");
-            uint attributeListLength = attributeList.count();
-            for (uint l = 0; l < attributeListLength; l++) {
-                QDomNode attributeNode = attributeList.item(l);
-                QDomElement attributeElem = attributeNode.toElement();
-                if (! attributeElem.isNull()) {
-                    QString value = attributeElem.attribute("value");
-                    attributevaluesTmp.insert(attributeElem.attribute("name"), value.split(QChar(' ')));
-                }
-            }
-            m_attributevaluesList.insert(elem.attribute("name"), attributevaluesTmp);
-        }
-    }
-    return true;
+    return m_attributesList.value(name).requiredAttributes;
 }
 
 /**
@@ -338,83 +379,32 @@ bool PseudoDTD::parseAttributeValues(QDomDocument *doc, QProgressDialog *progres
  */
 QStringList PseudoDTD::attributeValues(QString element, QString attribute)
 {
-    // Direct access would be faster than iteration of course but not always correct,
-    // because we need to be case-insensitive.
     if (m_sgmlSupport) {
         // first find the matching element, ignoring case:
-        QMap< QString, QMap<QString, QStringList> >::Iterator it;
-        for (it = m_attributevaluesList.begin(); it != m_attributevaluesList.end(); ++it) {
-            if (it.key().compare(element, Qt::CaseInsensitive) == 0) {
-                QMap<QString, QStringList> attrVals = it.value();
-                QMap<QString, QStringList>::Iterator itV;
-                // then find the matching attribute for that element, ignoring case:
-                for (itV = attrVals.begin(); itV != attrVals.end(); ++itV) {
-                    if (itV.key().compare(attribute, Qt::CaseInsensitive) == 0) {
-                        return(itV.value());
-                    }
-                }
-            }
-        }
-    } else if (m_attributevaluesList.contains(element)) {
-        QMap<QString, QStringList> attrVals = m_attributevaluesList[element];
-        if (attrVals.contains(attribute)) {
-            return attrVals[attribute];
-        }
+        element = findName(m_attributevaluesIndex, element);
     }
 
-    // no predefined values available:
-    return QStringList();
-}
-
-/**
- * Iterate through the XML to get a mapping of all entity names and their expanded
- * version, e.g. nbsp => &#160;. Parameter entities are ignored.
- */
-bool PseudoDTD::parseEntities(QDomDocument *doc, QProgressDialog *progress)
-{
-    m_entityList.clear();
-    QDomNodeList list = doc->elementsByTagName("entity");
-    uint listLength = list.count();
+    QMap< QString, QMap<QString, QStringList> >::ConstIterator it = m_attributevaluesList.constFind(element);
+    if (it == m_attributevaluesList.constEnd()) {
+        // no predefined values available:
+        return QStringList();
+    }
 
-    for (uint i = 0; i < listLength; i++) {
-        if (progress->wasCanceled()) {
-            return false;
-        }
+    const QMap<QString, QStringList> &attrVals = it.value();
+    if (!m_sgmlSupport) {
+        return attrVals.value(attribute);
+    }
 
-        progress->setValue(progress->value() + 1);
-        //FIXME!!
-        //qApp->processEvents();
-        QDomNode node = list.item(i);
-        QDomElement elem = node.toElement();
-        if (!elem.isNull()
-                && elem.attribute("type") != "param") {
-            // TODO: what's cdata <-> gen ?
-            QDomNodeList expandedList = elem.elementsByTagName("text-expanded");
-            QDomNode expandedNode = expandedList.item(0);
-            QDomElement expandedElem = expandedNode.toElement();
-            if (! expandedElem.isNull()) {
-                QString exp = expandedElem.text();
-                // TODO: support more than one &#...; in the expanded text
-                /* TODO include do this when the unicode font problem is solved:
-                if( exp.contains(QRegExp("^&#x[a-zA-Z0-9]+;$")) ) {
-                // hexadecimal numbers, e.g. "&#x236;"
-                uint end = exp.find( ";" );
-                exp = exp.mid( 3, end-3 );
-                exp = QChar();
-                } else if( exp.contains(QRegExp("^&#[0-9]+;$")) ) {
-                // decimal numbers, e.g. "&#236;"
-                uint end = exp.find( ";" );
-                exp = exp.mid( 2, end-2 );
-                exp = QChar( exp.toInt() );
-                }
-                */
-                m_entityList.insert(elem.attribute("name"), exp);
-            } else {
-                m_entityList.insert(elem.attribute("name"), QString());
-            }
+    // then find the matching attribute for that element, ignoring case,
+    // an element only has a handful of attributes:
+    QMap<QString, QStringList>::ConstIterator itV;
+    for (itV = attrVals.constBegin(); itV != attrVals.constEnd(); ++itV) {
+        if (itV.key().compare(attribute, Qt::CaseInsensitive) == 0) {
+            return itV.value();
         }
     }
-    return true;
+
+    return QStringList();
 }
 
 /**
@@ -422,11 +412,14 @@ bool PseudoDTD::parseEntities(QDomDocument *doc, QProgressDialog *progress)
  */
 QStringList PseudoDTD::entities(QString start)
 {
+    if (start.isEmpty()) {
+        return m_entityNames;
+    }
+
     QStringList entities;
-    QMap<QString, QString>::Iterator it;
-    for (it = m_entityList.begin(); it != m_entityList.end(); ++it) {
-        if ((*it).startsWith(start)) {
-            QString str = it.key();
+    foreach (const QString &name, m_entityNames) {
+        if (m_entityList.value(name).startsWith(start)) {
+            QString str = name;
             /* TODO: show entities as unicode character
             if( !it.data().isEmpty() ) {
             //str += " -- " + it.data();
@@ -445,4 +438,83 @@ QStringList PseudoDTD::entities(QString start)
     return entities;
 }
 
+// ========================================================================
+// PseudoDTDLoader:
+
+PseudoDTDLoader::PseudoDTDLoader(const QString &url, const QByteArray &metaDtd)
+    : m_url(url)
+    , m_metaDtd(metaDtd)
+    , m_cacheDir(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QStringLiteral("/katexmltools"))
+{
+    // deleted by itself after finished() was emitted
+    setAutoDelete(false);
+
+    qRegisterMetaType<QSharedPointer<PseudoDTD> >();
+
+    QDir().mkpath(m_cacheDir);
+}
+
+void PseudoDTDLoader::start(PseudoDTDLoader *loader)
+{
+    QThreadPool::globalInstance()->start(loader);
+}
+
+void PseudoDTDLoader::run()
+{
+    const QString cacheFile = m_cacheDir + QLatin1Char('/')
+        + QString::fromLatin1(QCryptographicHash::hash(m_metaDtd, QCryptographicHash::Sha1).toHex())
+        + QStringLiteral(".dtdcache");
+
+    QSharedPointer<PseudoDTD> dtd(new PseudoDTD());
+    QString error;
+
+    // the cache is keyed by content, an entry can never be stale
+    bool cached = false;
+    QFile in(cacheFile);
+    if (in.open(QIODevice::ReadOnly)) {
+        QDataStream stream(&in);
+        stream.setVersion(QDataStream::Qt_5_0);
+
+        quint32 magic, version;
+        stream >> magic >> version;
+        cached = (magic == CACHE_MAGIC && version == CACHE_VERSION && dtd->load(stream));
+    }
+
+    if (!cached) {
+        switch (dtd->analyzeDTD(m_metaDtd)) {
+        case PseudoDTD::Ok: {
+            QSaveFile out(cacheFile);
+            if (out.open(QIODevice::WriteOnly)) {
+                QDataStream stream(&out);
+                stream.setVersion(QDataStream::Qt_5_0);
+                stream << CACHE_MAGIC << CACHE_VERSION;
+                dtd->save(stream);
+                out.commit();
+            }
+            break;
+        }
+        case PseudoDTD::NotWellFormed:
+            error = i18n("The file '%1' could not be parsed. "
+                         "Please check that the file is well-formed XML.", m_url);
+            break;
+        case PseudoDTD::WrongFormat:
+            error = i18n("The file '%1' is not in the expected format. "
+                         "Please check that the file is of this type:\n"
+                         "-//Norman Walsh//DTD DTDParse V2.0//EN\n"
+                         "You can produce such files with dtdparse. "
+                         "See the Kate Plugin documentation for more information.", m_url);
+            break;
+        }
+
+        if (!error.isEmpty()) {
+            dtd.clear();
+        }
+    }
+
+    emit finished(m_url, dtd, error);
+
+    deleteLater();
+}
+
+
 // kate: space-indent on; indent-width 4; replace-tabs on; mixed-indent off;
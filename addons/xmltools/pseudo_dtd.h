@@ -23,9 +23,16 @@
 #ifndef PSEUDO_DTD_H
 #define PSEUDO_DTD_H
 
-#include <qdom.h>
-#include <qprogressdialog.h>
+#include <QHash>
 #include <QMap>
+#include <QMetaType>
+#include <QObject>
+#include <QRunnable>
+#include <QSharedPointer>
+#include <QStringList>
+
+class QDataStream;
+class QXmlStreamReader;
 
 /**
  * This class contains the attributes for one element.
@@ -45,7 +52,17 @@ public:
     PseudoDTD();
     ~PseudoDTD();
 
-    void analyzeDTD(QString &metaDtdUrl, QString &metaDtd);
+    enum Result { Ok, NotWellFormed, WrongFormat };
+
+    /**
+     * Read a meta DTD as written by dtdparse. This does not touch the GUI,
+     * it may run on any thread.
+     */
+    Result analyzeDTD(const QByteArray &metaDtd);
+
+    /// the compiled form, see PseudoDTDLoader
+    void save(QDataStream &out) const;
+    bool load(QDataStream &in);
 
     QStringList allowedElements(QString parentElement);
     QStringList allowedAttributes(QString parentElement);
@@ -55,10 +72,15 @@ public:
 
 protected:
 
-    bool parseElements(QDomDocument *doc, QProgressDialog *progress);
-    bool parseAttributes(QDomDocument *doc, QProgressDialog *progress);
-    bool parseAttributeValues(QDomDocument *doc, QProgressDialog *progress);
-    bool parseEntities(QDomDocument *doc, QProgressDialog *progress);
+    void parseEntity(QXmlStreamReader &xml);
+    void parseElement(QXmlStreamReader &xml);
+    void parseAttlist(QXmlStreamReader &xml);
+
+    /// build the case-insensitive lookup tables for SGML support
+    /// and sort the vocabulary the way it is offered for completion
+    void buildIndex();
+    static void sortVocabulary(QStringList &list);
+    static QString findName(const QHash<QString, QString> &index, const QString &name);
 
     bool m_sgmlSupport;
 
@@ -71,6 +93,46 @@ protected:
     // Attribute values e.g. <"td", <"align", ( "left", "right", "justify" )>>
     QMap< QString, QMap<QString, QStringList> > m_attributevaluesList;
 
+    // Entity names and all attributes of an element, sorted
+    QStringList m_entityNames;
+    QMap<QString, QStringList> m_attributeNamesList;
+
+    // lower case name -> name as used in the maps above
+    QHash<QString, QString> m_elementsIndex;
+    QHash<QString, QString> m_attributesIndex;
+    QHash<QString, QString> m_attributevaluesIndex;
+
+};
+
+Q_DECLARE_METATYPE(QSharedPointer<PseudoDTD>)
+
+/**
+ * Compiles a meta DTD on the global thread pool.
+ *
+ * The result is kept in a binary cache keyed by the hash of the meta DTD,
+ * so the XML of a meta DTD is only parsed the first time it is used.
+ * finished() is emitted on the pool thread with a null pointer and a
+ * message on errors, the loader deletes itself afterwards.
+ */
+class PseudoDTDLoader : public QObject, public QRunnable
+{
+    Q_OBJECT
+
+public:
+    PseudoDTDLoader(const QString &url, const QByteArray &metaDtd);
+
+    /// Queue @p loader on the global thread pool.
+    static void start(PseudoDTDLoader *loader);
+
+    virtual void run();
+
+Q_SIGNALS:
+    void finished(const QString &url, QSharedPointer<PseudoDTD> dtd, const QString &error);
+
+private:
+    QString m_url;
+    QByteArray m_metaDtd;
+    QString m_cacheDir;
 };
 
 #endif // PSEUDO_DTD_H
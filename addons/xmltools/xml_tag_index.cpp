@@ -0,0 +1,436 @@
+/***************************************************************************
+                           xml_tag_index.cpp - element structure of a document
+                           -------------------
+ ***************************************************************************/
+
+/***************************************************************************
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ ***************************************************************************/
+
+#include "xml_tag_index.h"
+
+#include <ktexteditor/document.h>
+
+#include <algorithm>
+
+XMLTagIndex::State::State()
+    : mode(Text)
+    , closing(false)
+    , slash(false)
+    , equals(false)
+    , inName(false)
+    , depth(0)
+{
+}
+
+bool XMLTagIndex::State::operator==(const State &other) const
+{
+    return mode == other.mode && quote == other.quote && closing == other.closing
+           && slash == other.slash && equals == other.equals && inName == other.inName
+           && depth == other.depth && tag == other.tag && name == other.name
+           && attribute == other.attribute;
+}
+
+XMLTagIndex::XMLTagIndex(KTextEditor::Document *document)
+    : QObject()
+    , m_document(document)
+    , m_leaves(0)
+    , m_treeValid(false)
+{
+    connect(document, SIGNAL(textInserted(KTextEditor::Document *, KTextEditor::Cursor, QString)),
+            this, SLOT(slotTextInserted(KTextEditor::Document *, KTextEditor::Cursor, QString)));
+    connect(document, SIGNAL(textRemoved(KTextEditor::Document *, KTextEditor::Range, QString)),
+            this, SLOT(slotTextRemoved(KTextEditor::Document *, KTextEditor::Range, QString)));
+    connect(document, SIGNAL(reloaded(KTextEditor::Document *)), this, SLOT(reset()));
+}
+
+XMLTagIndex::Context XMLTagIndex::context(const KTextEditor::Cursor &position)
+{
+    Context context;
+
+    const int line = position.line();
+    if (line < 0 || line >= m_document->lines()) {
+        return context;
+    }
+
+    // a missed edit would leave the index out of sync for good
+    if (m_lines.size() > m_document->lines()) {
+        reset();
+    }
+
+    update(line);
+
+    // the lines before, plus the current line up to the position
+    State state = line > 0 ? m_lines.at(line - 1).end : State();
+    const QString text = m_document->line(line);
+    Effect effect;
+    scan(text, qBound(0, position.column(), text.length()), state, effect);
+
+    effect = combine(effectBefore(line), effect);
+
+    switch (state.mode) {
+    case State::Text:
+        if (!effect.pushes.isEmpty()) {
+            context.parentElement = effect.pushes.last();
+        }
+        break;
+
+    case State::AttributeValue:
+        context.attribute = state.attribute;
+        // fall through
+    case State::TagName:
+    case State::Tag:
+        if (!state.closing) {
+            context.tag = state.tag;
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    return context;
+}
+
+void XMLTagIndex::slotTextInserted(KTextEditor::Document *, const KTextEditor::Cursor &position, const QString &text)
+{
+    const int line = position.line();
+    if (line >= m_lines.size()) {
+        // not scanned yet anyway
+        return;
+    }
+
+    const int newLines = text.count(QLatin1Char('\n'));
+    if (newLines > 0) {
+        // the entry stays with the tail of the line, the lines after it
+        // were scanned from the state at its end
+        m_lines.insert(line, newLines, Line());
+
+        for (int i = 0; i < m_dirty.size(); ++i) {
+            if (m_dirty[i] > line) {
+                m_dirty[i] += newLines;
+            }
+        }
+
+        m_treeValid = false;
+    }
+
+    for (int i = line; i <= line + newLines; ++i) {
+        markDirty(i);
+    }
+}
+
+void XMLTagIndex::slotTextRemoved(KTextEditor::Document *, const KTextEditor::Range &range, const QString &)
+{
+    const int first = range.start().line();
+    const int last = range.end().line();
+    if (first >= m_lines.size()) {
+        return;
+    }
+
+    if (last >= m_lines.size()) {
+        // the line now ends with text never scanned, forget it
+        m_lines.resize(first);
+
+        QVector<int>::Iterator it = std::lower_bound(m_dirty.begin(), m_dirty.end(), first);
+        m_dirty.erase(it, m_dirty.end());
+
+        m_treeValid = false;
+        return;
+    }
+
+    if (last > first) {
+        // keep the entry of the last line, for the same reason as above
+        m_lines.remove(first, last - first);
+
+        QVector<int> dirty;
+        foreach (int i, m_dirty) {
+            if (i <= first) {
+                dirty.append(i);
+            } else if (i > last) {
+                dirty.append(i - (last - first));
+            }
+        }
+        m_dirty = dirty;
+
+        m_treeValid = false;
+    }
+
+    markDirty(first);
+}
+
+void XMLTagIndex::reset()
+{
+    m_lines.clear();
+    m_dirty.clear();
+    m_tree.clear();
+    m_leaves = 0;
+    m_treeValid = false;
+}
+
+XMLTagIndex::Effect XMLTagIndex::combine(const Effect &first, const Effect &second)
+{
+    if (second.pops == 0 && second.pushes.isEmpty()) {
+        return first;
+    }
+
+    Effect result = first;
+    if (second.pops <= result.pushes.size()) {
+        result.pushes.erase(result.pushes.end() - second.pops, result.pushes.end());
+    } else {
+        result.pops += second.pops - result.pushes.size();
+        result.pushes.clear();
+    }
+    result.pushes += second.pushes;
+
+    return result;
+}
+
+/**
+ * Scan the first @p length characters of @p text, starting in @p state.
+ */
+void XMLTagIndex::scan(const QString &text, int length, State &state, Effect &effect)
+{
+    for (int i = 0; i < length; ++i) {
+        const QChar ch = text.at(i);
+
+        switch (state.mode) {
+        case State::Text:
+            if (ch != QLatin1Char('<')) {
+                break;
+            }
+
+            if (text.midRef(i + 1, 3) == QLatin1String("!--")) {
+                state.mode = State::Comment;
+                i += 3;
+            } else if (text.midRef(i + 1, 8) == QLatin1String("![CDATA[")) {
+                state.mode = State::CData;
+                i += 8;
+            } else if (text.midRef(i + 1, 1) == QLatin1String("!")) {
+                state.mode = State::Declaration;
+                state.depth = 0;
+                ++i;
+            } else if (text.midRef(i + 1, 1) == QLatin1String("?")) {
+                state.mode = State::ProcessingInstruction;
+                ++i;
+            } else {
+                state = State();
+                state.mode = State::TagName;
+            }
+            break;
+
+        case State::TagName:
+            if (ch == QLatin1Char('/') && state.tag.isEmpty() && !state.closing) {
+                state.closing = true;
+                break;
+            }
+            if (ch != QLatin1Char('>') && ch != QLatin1Char('/') && !ch.isSpace()) {
+                state.tag += ch;
+                break;
+            }
+            state.mode = State::Tag;
+            // fall through
+
+        case State::Tag:
+            if (ch == QLatin1Char('>')) {
+                if (!state.closing) {
+                    // <tag/> is empty and opens nothing
+                    if (!state.slash) {
+                        effect.pushes.append(state.tag);
+                    }
+                } else if (!effect.pushes.isEmpty()) {
+                    effect.pushes.removeLast();
+                } else {
+                    ++effect.pops;
+                }
+                state = State();
+            } else if (ch == QLatin1Char('/')) {
+                state.slash = true;
+                state.inName = false;
+            } else if (ch == QLatin1Char('=')) {
+                state.slash = false;
+                state.equals = true;
+                state.inName = false;
+            } else if (ch == QLatin1Char('"') || ch == QLatin1Char('\'')) {
+                state.mode = State::AttributeValue;
+                state.quote = ch;
+                state.attribute = state.equals ? state.name : QString();
+                state.slash = false;
+                state.inName = false;
+            } else if (ch.isSpace()) {
+                state.inName = false;
+            } else {
+                if (!state.inName) {
+                    state.name.clear();
+                    state.inName = true;
+                    state.equals = false;
+                }
+                state.name += ch;
+                state.slash = false;
+            }
+            break;
+
+        case State::AttributeValue:
+            if (ch == state.quote) {
+                state.mode = State::Tag;
+                state.quote = QChar();
+                state.attribute.clear();
+                state.equals = false;
+            }
+            break;
+
+        case State::Comment:
+            if (ch == QLatin1Char('-') && text.midRef(i, 3) == QLatin1String("-->")) {
+                state = State();
+                i += 2;
+            }
+            break;
+
+        case State::ProcessingInstruction:
+            if (ch == QLatin1Char('?') && text.midRef(i, 2) == QLatin1String("?>")) {
+                state = State();
+                ++i;
+            }
+            break;
+
+        case State::CData:
+            if (ch == QLatin1Char(']') && text.midRef(i, 3) == QLatin1String("]]>")) {
+                state = State();
+                i += 2;
+            }
+            break;
+
+        case State::Declaration:
+            // the internal subset of a DOCTYPE may contain '>'
+            if (ch == QLatin1Char('[')) {
+                ++state.depth;
+            } else if (ch == QLatin1Char(']')) {
+                --state.depth;
+            } else if (ch == QLatin1Char('>') && state.depth <= 0) {
+                state = State();
+            }
+            break;
+        }
+    }
+}
+
+bool XMLTagIndex::scanLine(int line)
+{
+    State state = line > 0 ? m_lines.at(line - 1).end : State();
+    const QString text = m_document->line(line);
+
+    Line &entry = m_lines[line];
+    entry.effect = Effect();
+    scan(text, text.length(), state, entry.effect);
+
+    const bool changed = !(state == entry.end);
+    entry.end = state;
+
+    updateTree(line);
+    return changed;
+}
+
+void XMLTagIndex::update(int line)
+{
+    // rescan the edited lines, a change of the state at the end of a line
+    // (e.g. an unclosed comment) carries over to the following lines
+    while (!m_dirty.isEmpty() && m_dirty.first() < line) {
+        for (int i = m_dirty.takeFirst(); ; ++i) {
+            if (!scanLine(i) || i + 1 >= m_lines.size()) {
+                break;
+            }
+            if (i + 1 >= line) {
+                markDirty(i + 1);
+                break;
+            }
+        }
+    }
+
+    // lines never scanned before
+    if (m_lines.size() < line) {
+        int i = m_lines.size();
+        m_lines.resize(line);
+        m_treeValid = m_treeValid && line <= m_leaves;
+
+        for (; i < line; ++i) {
+            scanLine(i);
+        }
+    }
+}
+
+void XMLTagIndex::markDirty(int line)
+{
+    QVector<int>::Iterator it = std::lower_bound(m_dirty.begin(), m_dirty.end(), line);
+    if (it == m_dirty.end() || *it != line) {
+        m_dirty.insert(it, line);
+    }
+}
+
+void XMLTagIndex::rebuildTree()
+{
+    m_leaves = 1;
+    while (m_leaves < m_lines.size()) {
+        m_leaves *= 2;
+    }
+
+    m_tree.fill(Effect(), 2 * m_leaves);
+    for (int i = 0; i < m_lines.size(); ++i) {
+        m_tree[m_leaves + i] = m_lines.at(i).effect;
+    }
+    for (int i = m_leaves - 1; i > 0; --i) {
+        m_tree[i] = combine(m_tree.at(2 * i), m_tree.at(2 * i + 1));
+    }
+
+    m_treeValid = true;
+}
+
+void XMLTagIndex::updateTree(int line)
+{
+    // line numbers shifted, the tree is rebuilt on the next query
+    if (!m_treeValid) {
+        return;
+    }
+
+    int i = m_leaves + line;
+    m_tree[i] = m_lines.at(line).effect;
+    for (i /= 2; i > 0; i /= 2) {
+        m_tree[i] = combine(m_tree.at(2 * i), m_tree.at(2 * i + 1));
+    }
+}
+
+/**
+ * The combined effect of the lines [0, @p line), from O(log n) tree nodes.
+ */
+XMLTagIndex::Effect XMLTagIndex::effectBefore(int line)
+{
+    if (!m_treeValid) {
+        rebuildTree();
+    }
+
+    Effect left;
+    Effect right;
+    for (int l = m_leaves, r = m_leaves + line; l < r; l /= 2, r /= 2) {
+        if (l & 1) {
+            left = combine(left, m_tree.at(l++));
+        }
+        if (r & 1) {
+            right = combine(m_tree.at(--r), right);
+        }
+    }
+
+    return combine(left, right);
+}
+
+// kate: space-indent on; indent-width 4; replace-tabs on; mixed-indent off;
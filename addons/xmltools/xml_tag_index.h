@@ -0,0 +1,141 @@
+/***************************************************************************
+                           xml_tag_index.h - element structure of a document
+                           -------------------
+ ***************************************************************************/
+
+/***************************************************************************
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ ***************************************************************************/
+
+#ifndef XML_TAG_INDEX_H
+#define XML_TAG_INDEX_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <ktexteditor/cursor.h>
+#include <ktexteditor/range.h>
+
+namespace KTextEditor
+{
+class Document;
+}
+
+/**
+ * Keeps track of the elements opened and closed on each line of a document,
+ * so the element context at a position does not need a scan back to the
+ * start of the document.
+ *
+ * Every line is summarized by the closing tags it has in excess and the
+ * elements it leaves open. The summaries live in a segment tree, the open
+ * elements in front of a line are the combined summary of all lines before
+ * it. Edits only mark lines for a rescan, the work is done lazily on the
+ * next query and stops as soon as the scanner state at the end of a line
+ * is the same as before.
+ *
+ * Like the old backward scan, closing tags are matched by nesting level,
+ * not by name.
+ */
+class XMLTagIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit XMLTagIndex(KTextEditor::Document *document);
+
+    /// What is known about a position in the document.
+    struct Context {
+        /// innermost element still open, empty if the position is inside a tag
+        QString parentElement;
+        /// name of the tag the position is in, empty if outside a tag
+        QString tag;
+        /// attribute whose value the position is in, empty if none
+        QString attribute;
+    };
+
+    Context context(const KTextEditor::Cursor &position);
+
+private Q_SLOTS:
+    void slotTextInserted(KTextEditor::Document *document, const KTextEditor::Cursor &position, const QString &text);
+    void slotTextRemoved(KTextEditor::Document *document, const KTextEditor::Range &range, const QString &text);
+    void reset();
+
+private:
+    /// scanner state, carried from one line to the next
+    struct State {
+        enum Mode { Text, TagName, Tag, AttributeValue, Comment, ProcessingInstruction, CData, Declaration };
+
+        State();
+        bool operator==(const State &other) const;
+
+        Mode mode;
+        QChar quote;
+        bool closing;
+        bool slash;
+        bool equals;
+        bool inName;
+        int depth;
+        QString tag;
+        QString name;
+        QString attribute;
+    };
+
+    /// what a range of lines does to the stack of open elements
+    struct Effect {
+        Effect() : pops(0) {}
+
+        /// closing tags without an opening tag in the range
+        int pops;
+        /// elements opened and not closed in the range, innermost last
+        QStringList pushes;
+    };
+
+    struct Line {
+        State end;
+        Effect effect;
+    };
+
+    static Effect combine(const Effect &first, const Effect &second);
+    static void scan(const QString &text, int length, State &state, Effect &effect);
+
+    /// rescan line @p line, returns true if the state at its end changed
+    bool scanLine(int line);
+    /// bring all lines in front of @p line up to date
+    void update(int line);
+    void markDirty(int line);
+
+    void rebuildTree();
+    void updateTree(int line);
+    Effect effectBefore(int line);
+
+private:
+    KTextEditor::Document *m_document;
+
+    /// the first m_lines.size() lines of the document have been scanned
+    QVector<Line> m_lines;
+    /// scanned lines edited since, sorted
+    QVector<int> m_dirty;
+
+    /// segment tree over the effects of m_lines, node 1 is the root
+    QVector<Effect> m_tree;
+    int m_leaves;
+    bool m_treeValid;
+};
+
+#endif // XML_TAG_INDEX_H
+
+// kate: space-indent on; indent-width 4; replace-tabs on; mixed-indent off;
@@ -26,11 +26,19 @@
 #include <QtTestWidgets>
 #include <QTemporaryDir>
 #include <QCommandLineParser>
+#include <QStandardPaths>
+
+#ifndef Q_OS_WIN
+#include <utime.h>
+#endif
 
 QTEST_MAIN(KateSessionManagerTest)
 
 void KateSessionManagerTest::initTestCase()
 {
+    // the session index goes to the cache dir, keep it away from the real one
+    QStandardPaths::setTestModeEnabled(true);
+
     m_app = new KateApp(QCommandLineParser()); // FIXME: aaaah, why, why, why?!
 }
 
@@ -165,4 +173,69 @@ void KateSessionManagerTest::startNonEmpty()
     QCOMPARE(m.sessionList().size(), 2);
 }
 
+#ifndef Q_OS_WIN
+static void setModificationTime(const QString &path, const QDateTime &time)
+{
+    struct utimbuf times;
+    times.actime = time.toTime_t();
+    times.modtime = time.toTime_t();
+    QCOMPARE(utime(QFile::encodeName(path).constData(), &times), 0);
+}
+#endif
 
+void KateSessionManagerTest::sessionIndex()
+{
+#ifdef Q_OS_WIN
+    QSKIP("needs to set the modification time of the sessions dir");
+#else
+    const QString file = m_tempdir->path() + QLatin1String("/foo.katesession");
+    {
+        KConfig c(file, KConfig::SimpleConfig);
+        c.group("Open Documents").writeEntry("Count", 3);
+    }
+
+    // an index taken right after a change is not trusted, pretend all
+    // of this happened a while ago
+    const QDateTime past = QDateTime::currentDateTime().addSecs(-3600);
+    setModificationTime(file, past);
+    setModificationTime(m_tempdir->path(), past);
+
+    {
+        KateSessionManager m(this, m_tempdir->path());
+        QCOMPARE(m.sessionList().size(), 1);
+        QCOMPARE((int)m.sessionList().first()->documents(), 3);
+    }
+
+    // a session hidden from the dir timestamp is only found by a scan,
+    // the trusted index must be used as it is
+    const QString hidden = m_tempdir->path() + QLatin1String("/bar.katesession");
+    {
+        KConfig c(hidden, KConfig::SimpleConfig);
+        c.group("Open Documents").writeEntry("Count", 1);
+    }
+    setModificationTime(hidden, past);
+    setModificationTime(m_tempdir->path(), past);
+
+    {
+        KateSessionManager m(this, m_tempdir->path());
+        QCOMPARE(m.sessionList().size(), 1);
+        QCOMPARE(m.sessionList().first()->name(), QLatin1String("foo"));
+        QCOMPARE((int)m.sessionList().first()->documents(), 3);
+    }
+
+    // the index knows the count now, a changed session must still be noticed
+    {
+        KConfig c(file, KConfig::SimpleConfig);
+        c.group("Open Documents").writeEntry("Count", 5);
+    }
+
+    KateSessionManager m(this, m_tempdir->path());
+    QCOMPARE(m.sessionList().size(), 2);
+
+    foreach (const KateSession::Ptr &session, m.sessionList()) {
+        if (session->name() == QLatin1String("foo")) {
+            QCOMPARE((int)session->documents(), 5);
+        }
+    }
+#endif
+}
@@ -0,0 +1,117 @@
+/* This file is part of the KDE project
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Library General Public License
+ *  along with this library; see the file COPYING.LIB.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301, USA.
+ */
+
+#include "view_eviction_test.h"
+#include "kateapp.h"
+#include "katedocmanager.h"
+#include "katemainwindow.h"
+#include "kateviewmanager.h"
+#include "kateviewspace.h"
+
+#include <KConfigGroup>
+#include <KSharedConfig>
+#include <KTextEditor/Document>
+#include <KTextEditor/View>
+
+#include <QtTestWidgets>
+#include <QCommandLineParser>
+#include <QPointer>
+#include <QStandardPaths>
+
+QTEST_MAIN(KateViewEvictionTest)
+
+void KateViewEvictionTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+
+    // read by the view manager of the main window created below
+    KConfigGroup(KSharedConfig::openConfig(), "General").writeEntry("Max Live Views Per View Space", 2);
+
+    m_app = new KateApp(QCommandLineParser()); // FIXME: aaaah, why, why, why?!
+    m_window = m_app->newMainWindow();
+}
+
+void KateViewEvictionTest::cleanupTestCase()
+{
+    delete m_window;
+    delete m_app;
+}
+
+KTextEditor::Document *KateViewEvictionTest::createDocument(int lines)
+{
+    QStringList text;
+    for (int i = 0; i < lines; ++i) {
+        text << QString::fromLatin1("line %1").arg(i);
+    }
+
+    KTextEditor::Document *doc = m_app->documentManager()->createDoc();
+    doc->setText(text);
+    return doc;
+}
+
+void KateViewEvictionTest::evictionLimit()
+{
+    KateViewManager *vm = m_window->viewManager();
+
+    for (int i = 0; i < 5; ++i) {
+        vm->activateView(createDocument(10));
+    }
+
+    KateViewSpace *vs = vm->activeViewSpace();
+    QCOMPARE(vs->liveViewCount(), 2);
+    QVERIFY(vs->evictedViewCount() >= 3);
+}
+
+void KateViewEvictionTest::currentViewNeverEvicted()
+{
+    KateViewManager *vm = m_window->viewManager();
+    KTextEditor::Document *doc = createDocument(10);
+    vm->activateView(doc);
+
+    KateViewSpace *vs = vm->activeViewSpace();
+    QCOMPARE(vs->currentView()->document(), doc);
+
+    // even without any room left, the view shown stays alive
+    const QList<KTextEditor::View *> views = vs->viewsToEvict(0);
+    QCOMPARE(views.size(), vs->liveViewCount() - 1);
+    QVERIFY(!views.contains(vs->currentView()));
+}
+
+void KateViewEvictionTest::stateRoundTrip()
+{
+    KateViewManager *vm = m_window->viewManager();
+    KTextEditor::Document *doc = createDocument(10);
+
+    QPointer<KTextEditor::View> view = vm->activateView(doc);
+    QVERIFY(view);
+
+    const KTextEditor::Cursor cursor(3, 2);
+    const KTextEditor::Range selection(1, 0, 2, 4);
+    view->setCursorPosition(cursor);
+    view->setSelection(selection);
+
+    // two more documents push the view out
+    vm->activateView(createDocument(10));
+    vm->activateView(createDocument(10));
+    QVERIFY(!view);
+
+    view = vm->activateView(doc);
+    QVERIFY(view);
+    QCOMPARE(view->cursorPosition(), cursor);
+    QCOMPARE(view->selectionRange(), selection);
+}
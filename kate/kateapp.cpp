@@ -21,6 +21,7 @@
 
 #include "kateviewmanager.h"
 #include "katemainwindow.h"
+#include "kateupdatedisabler.h"
 
 #include <KConfig>
 #include <KSharedConfig>
@@ -29,6 +30,7 @@
 #include <KLocalizedString>
 #include <KConfigGui>
 #include <KConfigGroup>
+#include <KRecentFilesAction>
 
 #include <QCommandLineParser>
 #include <QFileInfo>
@@ -294,6 +296,96 @@ KTextEditor::Document *KateApp::openDocUrl(const QUrl &url, const QString &encod
     return doc;
 }
 
+QList<KTextEditor::Document *> KateApp::openDocUrls(const QList<KateOpenUrlRequest> &requests, bool isTempFile)
+{
+    QList<KTextEditor::Document *> docs;
+
+    KateMainWindow *mainWindow = activeKateMainWindow();
+
+    if (!mainWindow) {
+        for (int i = 0; i < requests.size(); ++i) {
+            docs << 0;
+        }
+        return docs;
+    }
+
+    // no repaints for every single tab
+    KateUpdateDisabler disableUpdates(mainWindow);
+
+    QStringList folders;
+
+    // the document manager takes one encoding per batch, in the usual case all
+    // files share the one given on the command line and this is a single batch
+    for (int first = 0; first < requests.size();) {
+        const QString encoding = requests.at(first).encoding;
+
+        QList<QUrl> urls;
+        QList<int> indexes;
+        int next = first;
+        for (; next < requests.size() && requests.at(next).encoding == encoding; ++next) {
+            const QUrl url(requests.at(next).url);
+
+            // this file is no local dir, open it, else warn
+            if (url.isLocalFile() && QFileInfo(url.toLocalFile()).isDir()) {
+                folders << url.url();
+                continue;
+            }
+
+            urls << url;
+            indexes << next;
+        }
+
+        QTextCodec *codec = encoding.isEmpty() ? 0 : QTextCodec::codecForName(encoding.toLatin1());
+        const QString codecName = codec ? QString::fromLatin1(codec->name()) : QString();
+
+        KateDocumentInfo docInfo;
+        const QList<KTextEditor::Document *> opened = m_docManager.openUrls(urls, codecName, isTempFile, docInfo);
+
+        // folders were skipped, they get no document
+        for (int i = first, n = 0; i < next; ++i) {
+            if (n < indexes.size() && indexes.at(n) == i) {
+                docs << opened.value(n++);
+            } else {
+                docs << 0;
+            }
+        }
+
+        first = next;
+    }
+
+    // a view is only needed to place the cursor and for the last document
+    KTextEditor::Document *last = 0;
+    for (int i = 0; i < requests.size(); ++i) {
+        KTextEditor::Document *doc = docs.at(i);
+        if (!doc) {
+            continue;
+        }
+
+        if (!doc->url().isEmpty()) {
+            mainWindow->fileOpenRecent()->addUrl(doc->url());
+        }
+
+        if (requests.at(i).line >= 0 && requests.at(i).column >= 0) {
+            mainWindow->viewManager()->activateView(doc);
+            setCursor(requests.at(i).line, requests.at(i).column);
+        }
+
+        last = doc;
+    }
+
+    if (last) {
+        mainWindow->viewManager()->activateView(last);
+    }
+
+    if (!folders.isEmpty()) {
+        KMessageBox::informationList(mainWindow,
+                                     i18n("The following could not be opened: they are not normal files, they are folders."),
+                                     folders);
+    }
+
+    return docs;
+}
+
 bool KateApp::setCursor(int line, int column)
 {
     KateMainWindow *mainWindow = activeKateMainWindow();
@@ -193,6 +193,12 @@ public:
 
     KTextEditor::Document *openDocUrl(const QUrl &url, const QString &encoding, bool isTempFile);
 
+    /**
+     * open many urls as one batch, see KateAppAdaptor::tokenOpenUrls()
+     * @return the documents, 0 for urls that could not be opened
+     */
+    QList<KTextEditor::Document *> openDocUrls(const QList<KateOpenUrlRequest> &requests, bool isTempFile);
+
     void emitDocumentClosed(const QString &token);
 
     /**
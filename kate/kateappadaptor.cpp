@@ -26,10 +26,34 @@
 #include "katedebug.h"
 #include <KWindowSystem>
 
+void KateOpenUrlRequest::registerMetaType()
+{
+    qDBusRegisterMetaType<KateOpenUrlRequest>();
+    qDBusRegisterMetaType<QList<KateOpenUrlRequest> >();
+}
+
+QDBusArgument &operator<<(QDBusArgument &argument, const KateOpenUrlRequest &request)
+{
+    argument.beginStructure();
+    argument << request.url << request.line << request.column << request.encoding;
+    argument.endStructure();
+    return argument;
+}
+
+const QDBusArgument &operator>>(const QDBusArgument &argument, KateOpenUrlRequest &request)
+{
+    argument.beginStructure();
+    argument >> request.url >> request.line >> request.column >> request.encoding;
+    argument.endStructure();
+    return argument;
+}
+
 KateAppAdaptor::KateAppAdaptor(KateApp *app)
     : QDBusAbstractAdaptor(app)
     , m_app(app)
-{}
+{
+    KateOpenUrlRequest::registerMetaType();
+}
 
 void KateAppAdaptor::activate()
 {
@@ -89,6 +113,17 @@ QString KateAppAdaptor::tokenOpenUrlAt(QString url, int line, int column, QStrin
     m_app->setCursor(line, column);
     return QString::fromLatin1("%1").arg((qptrdiff)doc);
 }
+
+QStringList KateAppAdaptor::tokenOpenUrls(const QList<KateOpenUrlRequest> &requests, bool isTempFile)
+{
+    qCDebug(LOG_KATE) << "openURLs" << requests.size();
+
+    QStringList tokens;
+    foreach(KTextEditor::Document * doc, m_app->openDocUrls(requests, isTempFile)) {
+        tokens << (doc ? QString::fromLatin1("%1").arg((qptrdiff)doc) : QStringLiteral("ERROR"));
+    }
+    return tokens;
+}
 //--------
 
 bool KateAppAdaptor::setCursor(int line, int column)
@@ -24,6 +24,29 @@
 
 class KateApp;
 
+/**
+ * One file for KateAppAdaptor::tokenOpenUrls(), marshalled as (siis).
+ */
+struct KateOpenUrlRequest {
+    KateOpenUrlRequest() : line(-1), column(-1) {}
+
+    QString url;
+    /// cursor to set, -1 to leave it alone
+    int line;
+    int column;
+    QString encoding;
+
+    /**
+     * register the types with QtDBus, needed on both ends
+     */
+    static void registerMetaType();
+};
+
+Q_DECLARE_METATYPE(KateOpenUrlRequest)
+
+QDBusArgument &operator<<(QDBusArgument &argument, const KateOpenUrlRequest &request);
+const QDBusArgument &operator>>(const QDBusArgument &argument, KateOpenUrlRequest &request);
+
 class KateAppAdaptor : public QDBusAbstractAdaptor
 {
     Q_OBJECT
@@ -69,6 +92,16 @@ public Q_SLOTS:
 
     QString tokenOpenUrlAt(QString url, int line, int column, QString encoding, bool isTempFile);
 
+    /**
+     * open many files in one go, with a single reply
+     * the documents are created as one batch, only the view of the last
+     * one and of those with a cursor to set get activated
+     * @param requests url, cursor and encoding for each file
+     * @param isTempFile see openUrl()
+     * @return token or ERROR for each request
+     */
+    QStringList tokenOpenUrls(const QList<KateOpenUrlRequest> &requests, bool isTempFile);
+
     /**
      * set cursor of active view in active main window
      * will clear selection
@@ -168,6 +168,9 @@ KateConfigDialog::KateConfigDialog(KateMainWindow *parent, KTextEditor::View *vi
     //END Session page
 
     //BEGIN Plugins page
+    // plugins deferred at startup need to be around for their pages
+    KateApp::self()->pluginManager()->finishLoading();
+
     QFrame *page = new QFrame(this);
     QVBoxLayout *vlayout = new QVBoxLayout(page);
     vlayout->setMargin(0);
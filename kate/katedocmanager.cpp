@@ -37,7 +37,9 @@
 #include <KConfigGroup>
 
 #include <QByteArray>
+#include <QCryptographicHash>
 #include <QDateTime>
+#include <QFile>
 #include <QHash>
 #include <QTextCodec>
 #include <QTimer>
@@ -45,6 +47,7 @@
 #include <QListView>
 #include <QProgressDialog>
 #include <QFileDialog>
+#include <QThreadPool>
 
 KateDocManager::KateDocManager(QObject *parent)
     : QObject(parent)
@@ -52,10 +55,15 @@ KateDocManager::KateDocManager(QObject *parent)
     , m_saveMetaInfos(true)
     , m_daysMetaInfos(0)
     , m_documentStillToRestore(0)
+    , m_modOnHdVerifying(0)
 {
     // set our application wrapper
     KTextEditor::Editor::instance()->setApplication(KateApp::self()->wrapper());
 
+    m_modOnHdTimer.setSingleShot(true);
+    m_modOnHdTimer.setInterval(300);
+    connect(&m_modOnHdTimer, SIGNAL(timeout()), this, SLOT(verifyModifiedOnDisc()));
+
     // create one doc, we always have at least one around!
     createDoc();
 }
@@ -472,7 +480,86 @@ void KateDocManager::slotModifiedOnDisc(KTextEditor::Document *doc, bool b, KTex
     if (m_docInfos.contains(doc)) {
         m_docInfos[doc]->modifiedOnDisc = b;
         m_docInfos[doc]->modifiedOnDiscReason = reason;
-        slotModChanged1(doc);
+
+        KateMainWindow *win = KateApp::self()->activeKateMainWindow();
+        if (!win || !win->modNotificationEnabled()) {
+            return;
+        }
+
+        if (!m_modOnHdPending.contains(doc)) {
+            m_modOnHdPending.append(doc);
+        }
+
+        // a fixed window, a steady stream of changes must not delay it forever
+        if (!m_modOnHdTimer.isActive()) {
+            m_modOnHdTimer.start();
+        }
+    }
+}
+
+void KateDocManager::verifyModifiedOnDisc()
+{
+    foreach (KTextEditor::Document *doc, m_modOnHdPending) {
+        if (!doc || !m_docInfos.contains(doc)) {
+            continue;
+        }
+
+        // only a modification can turn out to be none, e.g. a checkout of the same content
+        const KateDocumentInfo *info = m_docInfos.value(doc);
+        const QByteArray checksum = doc->checksum();
+        if (info->modifiedOnDisc && info->modifiedOnDiscReason == KTextEditor::ModificationInterface::OnDiskModified
+            && doc->url().isLocalFile() && !checksum.isEmpty()) {
+            KateModOnHdVerifier *verifier = new KateModOnHdVerifier(doc, doc->url().toLocalFile(), checksum);
+            connect(verifier, SIGNAL(verified(KTextEditor::Document*,bool)), this, SLOT(slotModOnHdVerified(KTextEditor::Document*,bool)));
+            QThreadPool::globalInstance()->start(verifier);
+            ++m_modOnHdVerifying;
+        } else if (!m_modOnHdChanged.contains(doc)) {
+            m_modOnHdChanged.append(doc);
+        }
+    }
+    m_modOnHdPending.clear();
+
+    if (m_modOnHdVerifying == 0) {
+        notifyModifiedOnDisc();
+    }
+}
+
+void KateDocManager::slotModOnHdVerified(KTextEditor::Document *doc, bool changed)
+{
+    --m_modOnHdVerifying;
+
+    // the document might be closed meanwhile
+    if (m_docInfos.contains(doc)) {
+        if (changed) {
+            if (!m_modOnHdChanged.contains(doc)) {
+                m_modOnHdChanged.append(doc);
+            }
+        } else if (KTextEditor::ModificationInterface *iface = qobject_cast<KTextEditor::ModificationInterface *>(doc)) {
+            // same content as loaded, nothing to tell the user about
+            iface->setModifiedOnDisk(KTextEditor::ModificationInterface::OnDiskUnmodified);
+            m_docInfos[doc]->modifiedOnDisc = false;
+            m_docInfos[doc]->modifiedOnDiscReason = KTextEditor::ModificationInterface::OnDiskUnmodified;
+        }
+    }
+
+    if (m_modOnHdVerifying == 0 && !m_modOnHdTimer.isActive()) {
+        notifyModifiedOnDisc();
+    }
+}
+
+void KateDocManager::notifyModifiedOnDisc()
+{
+    QVector<KTextEditor::Document *> documents;
+    foreach (KTextEditor::Document *doc, m_modOnHdChanged) {
+        if (doc && m_docInfos.contains(doc)) {
+            documents.append(doc);
+        }
+    }
+    m_modOnHdChanged.clear();
+
+    KateMainWindow *win = KateApp::self()->activeKateMainWindow();
+    if (win && !documents.isEmpty()) {
+        win->queueModifiedOnDisc(documents);
     }
 }
 
@@ -569,8 +656,56 @@ void KateDocManager::slotModChanged(KTextEditor::Document *doc)
 
 void KateDocManager::slotModChanged1(KTextEditor::Document *doc)
 {
-    QMetaObject::invokeMethod(KateApp::self()->activeKateMainWindow(), "queueModifiedOnDisc",
-                                  Qt::QueuedConnection, Q_ARG(KTextEditor::Document *, doc));
+    // the document changed, not the file: the open notification, if any,
+    // only needs to update the entry, no need to look at the file
+    KateMainWindow *win = KateApp::self()->activeKateMainWindow();
+    if (!win || !win->modNotificationEnabled() || !m_docInfos.contains(doc)) {
+        return;
+    }
+
+    if (!m_modOnHdChanged.contains(doc)) {
+        m_modOnHdChanged.append(doc);
+    }
+
+    if (!m_modOnHdTimer.isActive()) {
+        m_modOnHdTimer.start();
+    }
+}
+
+KateModOnHdVerifier::KateModOnHdVerifier(KTextEditor::Document *doc, const QString &fileName, const QByteArray &checksum)
+    : m_document(doc)
+    , m_fileName(fileName)
+    , m_checksum(checksum)
+{
+    // deleted by itself after verified() was emitted
+    setAutoDelete(false);
+}
+
+void KateModOnHdVerifier::run()
+{
+    bool changed = true;
+
+    // the checksum of a document is the git blob hash of the file it was loaded from
+    QFile file(m_fileName);
+    if (file.open(QIODevice::ReadOnly)) {
+        QCryptographicHash hash(QCryptographicHash::Sha1);
+        QByteArray header = "blob " + QByteArray::number(file.size());
+        header.append('\0');
+        hash.addData(header);
+
+        while (!file.atEnd()) {
+            const QByteArray chunk = file.read(256 * 1024);
+            if (chunk.isEmpty()) {
+                break;
+            }
+            hash.addData(chunk);
+        }
+
+        changed = (file.error() != QFile::NoError) || hash.result() != m_checksum;
+    }
+
+    emit verified(m_document, changed);
+    deleteLater();
 }
 
 void KateDocManager::documentOpened()
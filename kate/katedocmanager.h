@@ -30,7 +30,10 @@
 #include <QHash>
 #include <QMap>
 #include <QPair>
+#include <QPointer>
 #include <QDateTime>
+#include <QRunnable>
+#include <QTimer>
 
 #include <KConfig>
 
@@ -56,6 +59,30 @@ public:
     bool openSuccess;
 };
 
+/**
+ * Checks on the global thread pool whether a file reported as modified on
+ * disk has really new content, by comparing its git blob hash with the
+ * checksum of the document.
+ */
+class KateModOnHdVerifier : public QObject, public QRunnable
+{
+    Q_OBJECT
+
+public:
+    KateModOnHdVerifier(KTextEditor::Document *doc, const QString &fileName, const QByteArray &checksum);
+
+    void run() Q_DECL_OVERRIDE;
+
+Q_SIGNALS:
+    void verified(KTextEditor::Document *doc, bool changed);
+
+private:
+    // only handed back, never touched in the pool thread
+    KTextEditor::Document *m_document;
+    QString m_fileName;
+    QByteArray m_checksum;
+};
+
 class KateDocManager : public QObject
 {
     Q_OBJECT
@@ -197,12 +224,19 @@ private Q_SLOTS:
     void slotModifiedOnDisc(KTextEditor::Document *doc, bool b, KTextEditor::ModificationInterface::ModifiedOnDiskReason reason);
     void slotModChanged(KTextEditor::Document *doc);
     void slotModChanged1(KTextEditor::Document *doc);
+    void verifyModifiedOnDisc();
+    void slotModOnHdVerified(KTextEditor::Document *doc, bool changed);
 
     void showRestoreErrors();
 private:
     bool loadMetaInfos(KTextEditor::Document *doc, const QUrl &url);
     void saveMetaInfos(const QList<KTextEditor::Document *> &docs);
 
+    /**
+     * Hand all documents collected since the last time to the main window, at once.
+     */
+    void notifyModifiedOnDisc();
+
     QList<KTextEditor::Document *> m_docList;
     QHash<KTextEditor::Document *, KateDocumentInfo *> m_docInfos;
 
@@ -215,6 +249,17 @@ private:
     QString m_openingErrors;
     int m_documentStillToRestore;
 
+    /**
+     * changes on disk are collected for a short while, so a git checkout
+     * touching many open files ends up in a single notification:
+     * m_modOnHdPending still needs to be checked for new content,
+     * m_modOnHdChanged is passed on to the main window
+     */
+    QTimer m_modOnHdTimer;
+    QList<QPointer<KTextEditor::Document> > m_modOnHdPending;
+    QList<QPointer<KTextEditor::Document> > m_modOnHdChanged;
+    int m_modOnHdVerifying;
+
 private Q_SLOTS:
     void documentOpened();
 };
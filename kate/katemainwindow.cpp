@@ -905,7 +905,11 @@ bool KateMainWindow::showModOnDiskPrompt()
     }
 
     if (!list.isEmpty() && !m_modignore) {
+        // the modal prompt takes over all documents of a notification still open
+        delete s_modOnHdDialog;
+
         KateMwModOnHdDialog mhdlg(list, this);
+        s_modOnHdDialog = &mhdlg;
         m_modignore = true;
         bool res = mhdlg.exec();
         m_modignore = false;
@@ -985,6 +989,7 @@ void KateMainWindow::saveProperties(KConfigGroup &config)
             }
         }
     }
+    KateApp::self()->pluginManager()->writePendingViewConfig(this, config.config(), id);
 
     m_fileOpenRecent->saveEntries(KConfigGroup(config.config(), "Recent Files"));
     m_viewManager->saveViewConfiguration(config);
@@ -1054,30 +1059,35 @@ void KateMainWindow::slotUpdateBottomViewBar()
     }
 }
 
-void KateMainWindow::queueModifiedOnDisc(KTextEditor::Document *doc)
+void KateMainWindow::queueModifiedOnDisc(const QVector<KTextEditor::Document *> &docs)
 {
     if (!m_modNotification) {
         return;
     }
-    KateDocumentInfo *docInfo = KateApp::self()->documentManager()->documentInfo(doc);
-    if (!docInfo) {
+
+    if (s_modOnHdDialog != 0) {
+        s_modOnHdDialog->addDocuments(docs);
         return;
     }
-    bool modOnDisk = (uint)docInfo->modifiedOnDisc;
 
-    if (s_modOnHdDialog == 0 && modOnDisk) {
-        DocVector list;
-        list.append(doc);
+    DocVector list;
+    foreach (KTextEditor::Document *doc, docs) {
+        KateDocumentInfo *docInfo = KateApp::self()->documentManager()->documentInfo(doc);
+        if (docInfo && docInfo->modifiedOnDisc) {
+            list.append(doc);
+        }
+    }
 
-        s_modOnHdDialog = new KateMwModOnHdDialog(list, this);
-        m_modignore = true;
-        KWindowSystem::setOnAllDesktops(s_modOnHdDialog->winId(), true);
-        s_modOnHdDialog->exec();
-        delete s_modOnHdDialog; // s_modOnHdDialog is set to 0 in destructor of KateMwModOnHdDialog (jowenn!!!)
-        m_modignore = false;
-    } else if (s_modOnHdDialog != 0) {
-        s_modOnHdDialog->addDocument(doc);
+    if (list.isEmpty()) {
+        return;
     }
+
+    // not modal, editing goes on while the dialog is open,
+    // later changes on disk are added to it
+    s_modOnHdDialog = new KateMwModOnHdDialog(list, this);
+    connect(s_modOnHdDialog, SIGNAL(finished(int)), s_modOnHdDialog, SLOT(deleteLater()));
+    KWindowSystem::setOnAllDesktops(s_modOnHdDialog->winId(), true);
+    s_modOnHdDialog->show();
 }
 
 bool KateMainWindow::event(QEvent *e)
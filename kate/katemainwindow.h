@@ -39,6 +39,7 @@
 #include <QStackedWidget>
 #include <QStackedLayout>
 #include <QUrl>
+#include <QVector>
 
 class QMenu;
 
@@ -160,7 +161,7 @@ private:
 public Q_SLOTS:
     void slotFileClose();
     void slotFileQuit();
-    void queueModifiedOnDisc(KTextEditor::Document *doc);
+    void queueModifiedOnDisc(const QVector<KTextEditor::Document *> &docs);
 
     void slotFocusPrevTab();
     void slotFocusNextTab();
@@ -692,6 +692,25 @@ void Sidebar::restoreSession(KConfigGroup &config)
     }
 }
 
+void Sidebar::restoreToolView(ToolView *widget, KConfigGroup &config)
+{
+    if (!m_widgetToId.contains(widget)) {
+        return;
+    }
+
+    widget->persistent = config.readEntry(QString::fromLatin1("Kate-MDI-ToolView-%1-Persistent").arg(widget->id), false);
+
+    // the sizes are only right once all toolviews saved with them are back
+    QList<int> s = config.readEntry(QString::fromLatin1("Kate-MDI-Sidebar-%1-Splitter").arg(position()), QList<int>());
+    if (s.size() == m_ownSplit->count()) {
+        m_ownSplit->setSizes(s);
+    }
+
+    if (config.readEntry(QString::fromLatin1("Kate-MDI-ToolView-%1-Visible").arg(widget->id), false)) {
+        showWidget(widget);
+    }
+}
+
 void Sidebar::saveSession(KConfigGroup &config)
 {
     // store the own splitter sizes
@@ -717,6 +736,7 @@ MainWindow::MainWindow(QWidget *parentWidget)
     : KParts::MainWindow(parentWidget, Qt::Window)
     , m_sidebarsVisible(true)
     , m_restoreConfig(0)
+    , m_lateRestoreConfig(QString(), KConfig::SimpleConfig)
     , m_guiClient(new GUIClient(this))
 {
     // init the internal widgets
@@ -798,10 +818,16 @@ ToolView *MainWindow::createToolView(KTextEditor::Plugin *plugin, const QString
         return 0;
     }
 
+    const QString positionKey = QString::fromLatin1("Kate-MDI-ToolView-%1-Position").arg(identifier);
+
     // try the restore config to figure out real pos
+    KConfigGroup lateGroup(&m_lateRestoreConfig, QStringLiteral("MainWindow"));
+    const bool late = !m_restoreConfig && lateGroup.hasKey(positionKey);
     if (m_restoreConfig && m_restoreConfig->hasGroup(m_restoreGroup)) {
         KConfigGroup cg(m_restoreConfig, m_restoreGroup);
-        pos = (KMultiTabBar::KMultiTabBarPosition) cg.readEntry(QString::fromLatin1("Kate-MDI-ToolView-%1-Position").arg(identifier), int(pos));
+        pos = (KMultiTabBar::KMultiTabBarPosition) cg.readEntry(positionKey, int(pos));
+    } else if (late) {
+        pos = (KMultiTabBar::KMultiTabBarPosition) lateGroup.readEntry(positionKey, int(pos));
     }
 
     ToolView *v  = m_sidebars[pos]->addWidget(icon, text, 0);
@@ -814,6 +840,17 @@ ToolView *MainWindow::createToolView(KTextEditor::Plugin *plugin, const QString
     // register for menu stuff
     m_guiClient->registerToolView(v);
 
+    // finishRestore() did not see it, apply the rest of its config now,
+    // only once, a toolview created again later starts out fresh
+    if (late) {
+        m_sidebars[pos]->restoreToolView(v, lateGroup);
+
+        lateGroup.deleteEntry(positionKey);
+        lateGroup.deleteEntry(QString::fromLatin1("Kate-MDI-ToolView-%1-Sidebar-Position").arg(identifier));
+        lateGroup.deleteEntry(QString::fromLatin1("Kate-MDI-ToolView-%1-Visible").arg(identifier));
+        lateGroup.deleteEntry(QString::fromLatin1("Kate-MDI-ToolView-%1-Persistent").arg(identifier));
+    }
+
     return v;
 }
 
@@ -939,6 +976,7 @@ void MainWindow::startRestore(KConfigBase *config, const QString &group)
     // first save this stuff
     m_restoreConfig = config;
     m_restoreGroup = group;
+    m_lateRestoreConfig.deleteGroup(QStringLiteral("MainWindow"));
 
     if (!m_restoreConfig || !m_restoreConfig->hasGroup(m_restoreGroup)) {
         // if no config around, set already now sane default sizes
@@ -1007,6 +1045,10 @@ void MainWindow::finishRestore()
 
         m_hSplitter->setSizes(hs);
         m_vSplitter->setSizes(vs);
+
+        // for the toolviews not created yet
+        KConfigGroup lateGroup(&m_lateRestoreConfig, QStringLiteral("MainWindow"));
+        cg.copyTo(&lateGroup);
     }
 
     // clear this stuff, we are done ;)
@@ -1046,6 +1088,25 @@ void MainWindow::saveSession(KConfigGroup &config)
     for (unsigned int i = 0; i < 4; ++i) {
         m_sidebars[i]->saveSession(config);
     }
+
+    // toolviews not created since the restore keep their config
+    KConfigGroup lateGroup(&m_lateRestoreConfig, QStringLiteral("MainWindow"));
+    const QString prefix = QStringLiteral("Kate-MDI-ToolView-");
+    foreach (const QString &key, lateGroup.keyList()) {
+        if (!key.startsWith(prefix)) {
+            continue;
+        }
+
+        // the identifier may contain dashes itself
+        QString identifier = key.mid(prefix.size(), key.lastIndexOf(QLatin1Char('-')) - prefix.size());
+        if (identifier.endsWith(QLatin1String("-Sidebar"))) {
+            identifier.chop(8);
+        }
+
+        if (!m_idToWidget.contains(identifier)) {
+            config.writeEntry(key, lateGroup.readEntry(key, QString()));
+        }
+    }
 }
 
 //END MAIN WINDOW
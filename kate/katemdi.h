@@ -25,6 +25,7 @@
 
 #include <KParts/MainWindow>
 
+#include <KConfig>
 #include <KMultiTabBar>
 #include <KXMLGUIClient>
 #include <KToggleAction>
@@ -215,6 +216,14 @@ public:
     */
     void restoreSession(KConfigGroup &config);
 
+    /**
+    * restore the session config of a toolview added after the restore
+    * was finished
+    * @param widget the new toolview
+    * @param config config object to use
+    */
+    void restoreToolView(ToolView *widget, KConfigGroup &config);
+
     /**
     * save the current session config to given object, use current group
     * @param config config object to use
@@ -445,6 +454,12 @@ private:
      */
     QString m_restoreGroup;
 
+    /**
+     * copy of the restore group kept after the restore, for toolviews
+     * created later, e.g. by plugins created once the GUI is idle
+     */
+    KConfig m_lateRestoreConfig;
+
     /**
      * out guiclient
      */
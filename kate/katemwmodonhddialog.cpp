@@ -33,6 +33,7 @@
 #include <QTextStream>
 #include <QHeaderView>
 #include <QLabel>
+#include <QPointer>
 #include <QPushButton>
 
 #include <QTreeWidget>
@@ -55,7 +56,8 @@ public:
     ~KateDocItem()
     {}
 
-    KTextEditor::Document *document;
+    // documents can be closed while the dialog is open
+    QPointer<KTextEditor::Document> document;
 };
 
 KateMwModOnHdDialog::KateMwModOnHdDialog(DocVector docs, QWidget *parent, const char *name)
@@ -66,8 +68,6 @@ KateMwModOnHdDialog::KateMwModOnHdDialog(DocVector docs, QWidget *parent, const
 {
     setWindowTitle(i18n("Documents Modified on Disk"));
     setObjectName(QString::fromLatin1(name));
-    setModal(true);
-
     QVBoxLayout *mainLayout = new QVBoxLayout;
     setLayout(mainLayout);
 
@@ -139,6 +139,8 @@ KateMwModOnHdDialog::KateMwModOnHdDialog(DocVector docs, QWidget *parent, const
     connect(reloadButton, &QPushButton::clicked, this, &KateMwModOnHdDialog::slotReload);
 
     slotSelectionChanged(NULL, NULL);
+
+    connect(KateApp::self()->documentManager(), &KateDocManager::documentDeleted, this, &KateMwModOnHdDialog::slotDocumentDeleted);
 }
 
 KateMwModOnHdDialog::~KateMwModOnHdDialog()
@@ -183,7 +185,10 @@ void KateMwModOnHdDialog::handleSelected(int action)
     QList<QTreeWidgetItem *> itemsToDelete;
     for (QTreeWidgetItemIterator it(twDocuments); *it; ++it) {
         KateDocItem *item = (KateDocItem *) * it;
-        if (item->checkState(0) == Qt::Checked) {
+        if (!item->document) {
+            // closed meanwhile, e.g. while a message box was shown
+            itemsToDelete.append(item);
+        } else if (item->checkState(0) == Qt::Checked) {
             KTextEditor::ModificationInterface::ModifiedOnDiskReason reason = KateApp::self()->documentManager()->documentInfo(item->document)->modifiedOnDiscReason;
             bool success = true;
 
@@ -236,9 +241,9 @@ void KateMwModOnHdDialog::handleSelected(int action)
 void KateMwModOnHdDialog::slotSelectionChanged(QTreeWidgetItem *current, QTreeWidgetItem *)
 {
     KateDocItem *currentDocItem = static_cast<KateDocItem *>(current);
+    KateDocumentInfo *info = (currentDocItem && currentDocItem->document) ? KateApp::self()->documentManager()->documentInfo(currentDocItem->document) : Q_NULLPTR;
     // set the diff button enabled
-    btnDiff->setEnabled(currentDocItem &&
-                        KateApp::self()->documentManager()->documentInfo(currentDocItem->document)->modifiedOnDiscReason != KTextEditor::ModificationInterface::OnDiskDeleted);
+    btnDiff->setEnabled(info && info->modifiedOnDiscReason != KTextEditor::ModificationInterface::OnDiskDeleted);
 }
 
 // ### the code below is slightly modified from kdelibs/kate/part/katedialogs,
@@ -254,9 +259,10 @@ void KateMwModOnHdDialog::slotDiff()
     }
 
     KTextEditor::Document *doc = (static_cast<KateDocItem *>(twDocuments->currentItem()))->document;
+    KateDocumentInfo *info = doc ? KateApp::self()->documentManager()->documentInfo(doc) : Q_NULLPTR;
 
     // don't try to diff a deleted file
-    if (KateApp::self()->documentManager()->documentInfo(doc)->modifiedOnDiscReason == KTextEditor::ModificationInterface::OnDiskDeleted) {
+    if (!info || info->modifiedOnDiscReason == KTextEditor::ModificationInterface::OnDiskDeleted) {
         return;
     }
 
@@ -332,28 +338,71 @@ void KateMwModOnHdDialog::slotPDone()
 }
 
 void KateMwModOnHdDialog::addDocument(KTextEditor::Document *doc)
+{
+    addDocuments(DocVector() << doc);
+}
+
+void KateMwModOnHdDialog::addDocuments(const DocVector &docs)
 {
     // guard this e.g. during handleSelected
     if (m_blockAddDocument)
         return;
 
+    // a whole batch of changes is shown at once, not row by row
+    twDocuments->setUpdatesEnabled(false);
+    foreach (KTextEditor::Document *doc, docs) {
+        for (QTreeWidgetItemIterator it(twDocuments); *it; ++it) {
+            KateDocItem *item = (KateDocItem *) * it;
+            if (item->document == doc) {
+                delete item;
+                break;
+            }
+        }
+        KateDocumentInfo *info = KateApp::self()->documentManager()->documentInfo(doc);
+        uint reason = info ? (uint)info->modifiedOnDiscReason : 0;
+        if (reason) {
+            new KateDocItem(doc, m_stateTexts[reason], twDocuments);
+        }
+    }
+    twDocuments->setUpdatesEnabled(true);
+
+    if (! twDocuments->topLevelItemCount()) {
+        accept();
+    }
+}
+
+void KateMwModOnHdDialog::slotDocumentDeleted()
+{
+    // handleSelected() drops them itself, it is iterating over the items
+    if (m_blockAddDocument) {
+        return;
+    }
+
+    QList<QTreeWidgetItem *> itemsToDelete;
     for (QTreeWidgetItemIterator it(twDocuments); *it; ++it) {
-        KateDocItem *item = (KateDocItem *) * it;
-        if (item->document == doc) {
-            delete item;
-            break;
+        if (!static_cast<KateDocItem *>(*it)->document) {
+            itemsToDelete.append(*it);
         }
     }
-    uint reason = (uint)KateApp::self()->documentManager()->documentInfo(doc)->modifiedOnDiscReason;
-    if (reason) {
-        new KateDocItem(doc, m_stateTexts[reason], twDocuments);
+
+    if (itemsToDelete.isEmpty()) {
+        return;
     }
 
+    qDeleteAll(itemsToDelete);
+    slotSelectionChanged(twDocuments->currentItem(), 0);
+
     if (! twDocuments->topLevelItemCount()) {
         accept();
     }
 }
 
+void KateMwModOnHdDialog::done(int result)
+{
+    KateMainWindow::unsetModifiedOnDiscDialogIfIf(this);
+    QDialog::done(result);
+}
+
 void KateMwModOnHdDialog::keyPressEvent(QKeyEvent *event)
 {
     if (event->modifiers() == 0) {
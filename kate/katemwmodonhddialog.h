@@ -43,6 +43,13 @@ public:
     explicit KateMwModOnHdDialog(DocVector docs, QWidget *parent = 0, const char *name = 0);
     ~KateMwModOnHdDialog();
     void addDocument(KTextEditor::Document *doc);
+    void addDocuments(const DocVector &docs);
+
+    /**
+     * The dialog is not modal, new changes on disk must go to another one
+     * as soon as this one is finished, not only once it is deleted.
+     */
+    virtual void done(int result);
 
 private Q_SLOTS:
     void slotIgnore();
@@ -52,6 +59,7 @@ private Q_SLOTS:
     void slotSelectionChanged(QTreeWidgetItem *current, QTreeWidgetItem *);
     void slotDataAvailable();
     void slotPDone();
+    void slotDocumentDeleted();
 
 private:
     enum Action { Ignore, Overwrite, Reload };
@@ -31,8 +31,11 @@
 #include <KPluginFactory>
 #include <KPluginLoader>
 
+#include <QElapsedTimer>
 #include <QFile>
 #include <QFileInfo>
+#include <QLibrary>
+#include <QThreadPool>
 
 #include <ktexteditor/sessionconfiginterface.h>
 
@@ -41,9 +44,42 @@ QString KatePluginInfo::saveName() const
     return QFileInfo(metaData.fileName()).baseName();
 }
 
-KatePluginManager::KatePluginManager(QObject *parent) : QObject(parent)
+KatePluginLibraryLoader::KatePluginLibraryLoader(const QStringList &fileNames)
+    : m_fileNames(fileNames)
+{
+    // deleted by itself after the last library was loaded
+    setAutoDelete(false);
+}
+
+void KatePluginLibraryLoader::run()
+{
+    foreach (const QString &fileName, m_fileNames) {
+        QElapsedTimer timer;
+        timer.start();
+
+        // the QLibrary is not unloaded on destruction, the library stays
+        // around for the KPluginLoader in the GUI thread
+        QLibrary library(fileName);
+        if (!library.load()) {
+            qCWarning(LOG_KATE) << "failed to load plugin library" << fileName << library.errorString();
+        }
+
+        emit libraryLoaded(fileName, timer.elapsed());
+    }
+
+    deleteLater();
+}
+
+KatePluginManager::KatePluginManager(QObject *parent)
+    : QObject(parent)
+    , m_pendingConfig(QString(), KConfig::SimpleConfig)
 {
     setupPluginList();
+
+    // a zero timer fires once all pending events, like the first paint, are processed
+    m_pendingTimer.setSingleShot(true);
+    m_pendingTimer.setInterval(0);
+    connect(&m_pendingTimer, SIGNAL(timeout()), this, SLOT(createNextPendingPlugin()));
 }
 
 KatePluginManager::~KatePluginManager()
@@ -115,23 +151,116 @@ void KatePluginManager::loadConfig(KConfig *config)
     }
 
     /**
-     * load plugins
+     * only remember the plugins to load here, their libraries are loaded
+     * in the background, the plugins and their views are created once the
+     * GUI is idle or on first use through plugin()
      */
+    QStringList fileNames;
     for (KatePluginList::iterator it = m_pluginList.begin(); it != m_pluginList.end(); ++it) {
         if (it->load) {
-            /**
-             * load plugin + trigger update of GUI for already existing main windows
-             */
-            loadPlugin(&(*it));
-            enablePluginGUI(&(*it));
-
-            // restore config
-            if (auto interface = qobject_cast<KTextEditor::SessionConfigInterface *> (it->plugin)) {
-                KConfigGroup group(config, QString::fromLatin1("Plugin:%1:").arg(it->saveName()));
-                interface->readSessionConfig(group);
+            m_pendingPlugins.append(&(*it));
+
+            if (!m_loadedLibraries.contains(it->metaData.fileName())) {
+                fileNames.append(it->metaData.fileName());
+            }
+
+            // keep config, to restore it once the plugin is created
+            if (config) {
+                const QString groupName = QString::fromLatin1("Plugin:%1:").arg(it->saveName());
+                KConfigGroup pendingGroup(&m_pendingConfig, groupName);
+                KConfigGroup(config, groupName).copyTo(&pendingGroup);
             }
         }
     }
+
+    if (!fileNames.isEmpty()) {
+        KatePluginLibraryLoader *loader = new KatePluginLibraryLoader(fileNames);
+        connect(loader, SIGNAL(libraryLoaded(QString,qint64)), this, SLOT(libraryLoaded(QString,qint64)));
+        QThreadPool::globalInstance()->start(loader);
+    }
+
+    if (!m_pendingPlugins.isEmpty()) {
+        m_pendingTimer.start();
+    }
+}
+
+void KatePluginManager::libraryLoaded(const QString &fileName, qint64 msecs)
+{
+    qCDebug(LOG_KATE) << "plugin library" << fileName << "loaded in" << msecs << "ms";
+
+    m_loadedLibraries.insert(fileName);
+    m_pendingTimer.start();
+}
+
+void KatePluginManager::createNextPendingPlugin()
+{
+    // keep the load order, wait for the library of the first plugin
+    if (m_pendingPlugins.isEmpty() || !m_loadedLibraries.contains(m_pendingPlugins.first()->metaData.fileName())) {
+        return;
+    }
+
+    createPendingPlugin(m_pendingPlugins.first());
+
+    // one plugin per round, to not block the GUI for too long
+    if (!m_pendingPlugins.isEmpty()) {
+        m_pendingTimer.start();
+    }
+}
+
+void KatePluginManager::createPendingPlugin(KatePluginInfo *item)
+{
+    m_pendingPlugins.removeOne(item);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    /**
+     * load plugin + trigger update of GUI for already existing main windows
+     */
+    loadPlugin(item);
+    const qint64 created = timer.elapsed();
+
+    for (int i = 0; i < KateApp::self()->mainWindowsCount(); i++) {
+        KateMainWindow *win = KateApp::self()->mainWindow(i);
+        const QString groupName = pendingViewGroup(item, win);
+        createPluginView(item, win, m_pendingConfig.hasGroup(groupName) ? KConfigGroup(&m_pendingConfig, groupName) : KConfigGroup());
+        m_pendingConfig.deleteGroup(groupName);
+    }
+
+    // restore config
+    const QString groupName = QString::fromLatin1("Plugin:%1:").arg(item->saveName());
+    if (auto interface = qobject_cast<KTextEditor::SessionConfigInterface *> (item->plugin)) {
+        KConfigGroup group(&m_pendingConfig, groupName);
+        interface->readSessionConfig(group);
+    }
+    m_pendingConfig.deleteGroup(groupName);
+
+    qCDebug(LOG_KATE) << "plugin" << item->saveName() << "created in" << created << "ms, views created in" << timer.elapsed() - created << "ms";
+}
+
+void KatePluginManager::finishLoading()
+{
+    m_pendingTimer.stop();
+
+    while (!m_pendingPlugins.isEmpty()) {
+        createPendingPlugin(m_pendingPlugins.first());
+    }
+}
+
+void KatePluginManager::writePendingViewConfig(KateMainWindow *win, KConfigBase *config, int id)
+{
+    foreach (KatePluginInfo *item, m_pendingPlugins) {
+        const QString groupName = pendingViewGroup(item, win);
+        if (m_pendingConfig.hasGroup(groupName)) {
+            KConfigGroup group(config, QString::fromLatin1("Plugin:%1:MainWindow:%2").arg(item->saveName()).arg(id));
+            KConfigGroup(&m_pendingConfig, groupName).copyTo(&group);
+        }
+    }
+}
+
+QString KatePluginManager::pendingViewGroup(KatePluginInfo *item, KateMainWindow *win)
+{
+    return QString::fromLatin1("Plugin:%1:MainWindow:%2").arg(item->saveName()).arg(quintptr(win));
 }
 
 void KatePluginManager::writeConfig(KConfig *config)
@@ -144,16 +273,24 @@ void KatePluginManager::writeConfig(KConfig *config)
 
         cg.writeEntry(saveName, plugin.load);
 
-        // save config
+        // save config, a plugin not created yet still has the config it was loaded with
         if (auto interface = qobject_cast<KTextEditor::SessionConfigInterface *> (plugin.plugin)) {
             KConfigGroup group(config, QString::fromLatin1("Plugin:%1:").arg(saveName));
             interface->writeSessionConfig(group);
+        } else if (m_pendingConfig.hasGroup(QString::fromLatin1("Plugin:%1:").arg(saveName))) {
+            KConfigGroup group(config, QString::fromLatin1("Plugin:%1:").arg(saveName));
+            KConfigGroup(&m_pendingConfig, QString::fromLatin1("Plugin:%1:").arg(saveName)).copyTo(&group);
         }
     }
 }
 
 void KatePluginManager::unloadAllPlugins()
 {
+    // forget the plugins not created yet
+    while (!m_pendingPlugins.isEmpty()) {
+        unloadPlugin(m_pendingPlugins.first());
+    }
+
     for (KatePluginList::iterator it = m_pluginList.begin(); it != m_pluginList.end(); ++it) {
         if (it->plugin) {
             unloadPlugin(&(*it));
@@ -168,10 +305,23 @@ void KatePluginManager::enableAllPluginsGUI(KateMainWindow *win, KConfigBase *co
             enablePluginGUI(&(*it), win, config);
         }
     }
+
+    // the views of pending plugins are created with them, keep their config until then,
+    // the main window keeps the placement of their tool views
+    if (config) {
+        foreach (KatePluginInfo *item, m_pendingPlugins) {
+            KConfigGroup pendingGroup(&m_pendingConfig, pendingViewGroup(item, win));
+            KConfigGroup(config, QString::fromLatin1("Plugin:%1:MainWindow:0").arg(item->saveName())).copyTo(&pendingGroup);
+        }
+    }
 }
 
 void KatePluginManager::disableAllPluginsGUI(KateMainWindow *win)
 {
+    foreach (KatePluginInfo *item, m_pendingPlugins) {
+        m_pendingConfig.deleteGroup(pendingViewGroup(item, win));
+    }
+
     for (KatePluginList::iterator it = m_pluginList.begin(); it != m_pluginList.end(); ++it) {
         if (it->plugin) {
             disablePluginGUI(&(*it), win);
@@ -202,6 +352,16 @@ bool KatePluginManager::loadPlugin(KatePluginInfo *item)
 
 void KatePluginManager::unloadPlugin(KatePluginInfo *item)
 {
+    // not created yet, just forget about it
+    if (m_pendingPlugins.removeOne(item)) {
+        m_pendingConfig.deleteGroup(QString::fromLatin1("Plugin:%1:").arg(item->saveName()));
+        for (int i = 0; i < KateApp::self()->mainWindowsCount(); i++) {
+            m_pendingConfig.deleteGroup(pendingViewGroup(item, KateApp::self()->mainWindow(i)));
+        }
+        item->load = false;
+        return;
+    }
+
     disablePluginGUI(item);
     delete item->plugin;
     KTextEditor::Plugin *plugin = item->plugin;
@@ -211,6 +371,11 @@ void KatePluginManager::unloadPlugin(KatePluginInfo *item)
 }
 
 void KatePluginManager::enablePluginGUI(KatePluginInfo *item, KateMainWindow *win, KConfigBase *config)
+{
+    createPluginView(item, win, config ? KConfigGroup(config, QString::fromLatin1("Plugin:%1:MainWindow:0").arg(item->saveName())) : KConfigGroup());
+}
+
+void KatePluginManager::createPluginView(KatePluginInfo *item, KateMainWindow *win, const KConfigGroup &group)
 {
     // plugin around at all?
     if (!item->plugin) {
@@ -228,9 +393,8 @@ void KatePluginManager::enablePluginGUI(KatePluginInfo *item, KateMainWindow *wi
     }
 
     // load session config if needed
-    if (config && win->pluginViews().contains(item->plugin)) {
+    if (group.isValid() && win->pluginViews().contains(item->plugin)) {
         if (auto interface = qobject_cast<KTextEditor::SessionConfigInterface *> (win->pluginViews().value(item->plugin))) {
-            KConfigGroup group(config, QString::fromLatin1("Plugin:%1:MainWindow:0").arg(item->saveName()));
             interface->readSessionConfig(group);
         }
     }
@@ -294,10 +458,18 @@ KTextEditor::Plugin *KatePluginManager::plugin(const QString &name)
         return 0;
     }
 
+    /**
+     * first use of a plugin not created yet, don't wait for the idle GUI
+     */
+    KatePluginInfo *item = m_name2Plugin.value(name);
+    if (m_pendingPlugins.contains(item)) {
+        createPendingPlugin(item);
+    }
+
     /**
      * real plugin instance, if any ;)
      */
-    return m_name2Plugin.value(name)->plugin;
+    return item->plugin;
 }
 
 bool KatePluginManager::pluginAvailable(const QString &name)
@@ -25,11 +25,16 @@
 #include <KTextEditor/Plugin>
 
 #include <KPluginMetaData>
+#include <KConfig>
 #include <KConfigBase>
 
 #include <QObject>
 #include <QList>
 #include <QMap>
+#include <QRunnable>
+#include <QSet>
+#include <QStringList>
+#include <QTimer>
 
 class KConfig;
 class KateMainWindow;
@@ -51,6 +56,27 @@ public:
 
 typedef QList<KatePluginInfo> KatePluginList;
 
+/**
+ * Loads the libraries of plugins on the global thread pool.
+ * Only the library is loaded there, the factory and the plugin must be
+ * created in the GUI thread afterwards.
+ */
+class KatePluginLibraryLoader : public QObject, public QRunnable
+{
+    Q_OBJECT
+
+public:
+    KatePluginLibraryLoader(const QStringList &fileNames);
+
+    void run() Q_DECL_OVERRIDE;
+
+Q_SIGNALS:
+    void libraryLoaded(const QString &fileName, qint64 msecs);
+
+private:
+    QStringList m_fileNames;
+};
+
 class KatePluginManager : public QObject
 {
     Q_OBJECT
@@ -86,9 +112,36 @@ public:
     KTextEditor::Plugin *loadPlugin(const QString &name, bool permanent = true);
     void unloadPlugin(const QString &name, bool permanent = true);
 
+    /**
+     * Create all plugins loadConfig() deferred, and their views, right now.
+     */
+    void finishLoading();
+
+    /**
+     * Write the session config of the views of deferred plugins for @p win,
+     * like KateMainWindow::saveProperties() does for the existing views.
+     */
+    void writePendingViewConfig(KateMainWindow *win, KConfigBase *config, int id);
+
+private Q_SLOTS:
+    void libraryLoaded(const QString &fileName, qint64 msecs);
+    void createNextPendingPlugin();
+
 private:
     void setupPluginList();
 
+    /**
+     * Create the view of @p item for @p win, reading its session config from @p group if valid.
+     */
+    void createPluginView(KatePluginInfo *item, KateMainWindow *win, const KConfigGroup &group);
+
+    /**
+     * Create the deferred plugin @p item, with its views in all main windows.
+     */
+    void createPendingPlugin(KatePluginInfo *item);
+
+    static QString pendingViewGroup(KatePluginInfo *item, KateMainWindow *win);
+
     /**
      * all known plugins
      */
@@ -99,6 +152,27 @@ private:
      * uses the info stored in the plugin list
      */
     QMap<QString, KatePluginInfo *> m_name2Plugin;
+
+    /**
+     * plugins to be loaded, but not created yet, in load order
+     */
+    QList<KatePluginInfo *> m_pendingPlugins;
+
+    /**
+     * libraries already loaded by a KatePluginLibraryLoader
+     */
+    QSet<QString> m_loadedLibraries;
+
+    /**
+     * session config of the pending plugins and their views, kept in memory
+     * until they are created, the session config they came from might be gone
+     */
+    KConfig m_pendingConfig;
+
+    /**
+     * creates one pending plugin per event loop round, once the GUI is idle
+     */
+    QTimer m_pendingTimer;
 };
 
 #endif
@@ -18,13 +18,43 @@
 */
 
 #include "katerunninginstanceinfo.h"
+#include <QDBusConnection>
+#include <QDBusConnectionInterface>
+#include <QDBusMessage>
+#include <QDBusPendingReply>
 #include <QDBusReply>
+#include <QDBusVariant>
+#include <QPair>
 #include <QStringList>
 #include <QCoreApplication>
-#include <QDBusConnectionInterface>
+#include <iostream>
 
 int KateRunningInstanceInfo::dummy_session = 0;
 
+KateRunningInstanceInfo::KateRunningInstanceInfo(const QString &serviceName_, const QVariant &activeSession)
+    : valid(false)
+    , serviceName(serviceName_)
+{
+    if (!activeSession.isValid()) {
+        sessionName = QString::fromLatin1("___NO_SESSION_OPENED__%1").arg(dummy_session++);
+        valid = false;
+    } else {
+        if (activeSession.toString().isEmpty()) {
+            sessionName = QString::fromLatin1("___DEFAULT_CONSTRUCTED_SESSION__%1").arg(dummy_session++);
+        } else {
+            sessionName = activeSession.toString();
+        }
+        valid = true;
+    }
+}
+
+void KateRunningInstanceInfo::activate() const
+{
+    QDBusMessage m = QDBusMessage::createMethodCall(serviceName,
+                     QStringLiteral("/MainApplication"), QStringLiteral("org.kde.Kate.Application"), QStringLiteral("activate"));
+    QDBusConnection::sessionBus().call(m);
+}
+
 bool fillinRunningKateAppInstances(KateRunningInstanceMap *map)
 {
     QDBusConnectionInterface *i = QDBusConnection::sessionBus().interface();
@@ -39,28 +69,53 @@ bool fillinRunningKateAppInstances(KateRunningInstanceMap *map)
         services = servicesReply.value();
     }
 
-    QString serviceName;
-
     QString my_pid = QString::number(QCoreApplication::applicationPid());
 
+    // ask all instances at once and collect the answers afterwards, one round
+    // trip for all of them instead of an introspection and a property read each
+    QList<QPair<QString, QDBusPendingCall> > pending;
     foreach(const QString & s, services) {
         if (s.startsWith(QStringLiteral("org.kde.kate-"))) {
             if (s.contains(my_pid)) {
                 continue;
             }
-            KateRunningInstanceInfo *rii = new KateRunningInstanceInfo(s);
-            if (rii->valid) {
-                if (map->contains(rii->sessionName)) {
-                    return false;    //ERROR no two instances may have the same session name
-                }
-                map->insert(rii->sessionName, rii);
-                //std::cerr<<qPrintable(s)<<"running instance:"<< rii->sessionName.toUtf8().data()<<std::endl;
-            } else {
+            QDBusMessage m = QDBusMessage::createMethodCall(s, QStringLiteral("/MainApplication"),
+                             QStringLiteral("org.freedesktop.DBus.Properties"), QStringLiteral("Get"));
+            m << QStringLiteral("org.kde.Kate.Application") << QStringLiteral("activeSession");
+            pending.append(qMakePair(s, QDBusConnection::sessionBus().asyncCall(m)));
+        }
+    }
+
+    bool ok = true;
+    for (int n = 0; n < pending.size(); ++n) {
+        QDBusPendingReply<QDBusVariant> reply(pending[n].second);
+        reply.waitForFinished();
+
+        if (!ok) {
+            continue;
+        }
+
+        QVariant activeSession;
+        if (reply.isError()) {
+            std::cerr << qPrintable(reply.error().message()) << std::endl;
+        } else {
+            activeSession = reply.value().variant();
+        }
+
+        KateRunningInstanceInfo *rii = new KateRunningInstanceInfo(pending[n].first, activeSession);
+        if (rii->valid) {
+            if (map->contains(rii->sessionName)) {
                 delete rii;
+                ok = false;    //ERROR no two instances may have the same session name
+                continue;
             }
+            map->insert(rii->sessionName, rii);
+            //std::cerr<<qPrintable(s)<<"running instance:"<< rii->sessionName.toUtf8().data()<<std::endl;
+        } else {
+            delete rii;
         }
     }
-    return true;
+    return ok;
 }
 
 void cleanupRunningKateAppInstanceMap(KateRunningInstanceMap *map)
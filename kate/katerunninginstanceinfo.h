@@ -22,47 +22,25 @@
 #define _KATE_RUNNING_INSTANCE_INFO_
 
 #include <QMap>
-#include <QDBusInterface>
-#include <QDBusConnection>
+#include <QString>
 #include <QVariant>
-#include <iostream>
 
-class KateRunningInstanceInfo: public QObject
+class KateRunningInstanceInfo
 {
-    Q_OBJECT
-
 public:
-    KateRunningInstanceInfo(const QString &serviceName_):
-        QObject(), valid(false),
-        serviceName(serviceName_),
-        dbus_if(new QDBusInterface(serviceName_, QStringLiteral("/MainApplication"),
-                                   QString(), //I don't know why it does not work if I specify org.kde.Kate.Application here
-                                   QDBusConnection::sessionBus(), this)) {
-        if (!dbus_if->isValid()) {
-            std::cerr << qPrintable(QDBusConnection::sessionBus().lastError().message()) << std::endl;
-        }
-        QVariant a_s = dbus_if->property("activeSession");
-        /*      std::cerr<<a_s.isValid()<<std::endl;
-              std::cerr<<"property:"<<qPrintable(a_s.toString())<<std::endl;
-              std::cerr<<qPrintable(QDBusConnection::sessionBus().lastError().message())<<std::endl;*/
-        if (!a_s.isValid()) {
-            sessionName = QString::fromLatin1("___NO_SESSION_OPENED__%1").arg(dummy_session++);
-            valid = false;
-        } else {
-            if (a_s.toString().isEmpty()) {
-                sessionName = QString::fromLatin1("___DEFAULT_CONSTRUCTED_SESSION__%1").arg(dummy_session++);
-            } else {
-                sessionName = a_s.toString();
-            }
-            valid = true;
-        }
-    }
-    virtual ~KateRunningInstanceInfo() {
-        delete dbus_if;
-    }
+    /**
+     * @param activeSession the activeSession property of the instance,
+     * invalid if it could not be read
+     */
+    KateRunningInstanceInfo(const QString &serviceName_, const QVariant &activeSession);
+
+    /**
+     * bring the instance to the front
+     */
+    void activate() const;
+
     bool valid;
     const QString serviceName;
-    QDBusInterface *dbus_if;
     QString sessionName;
 
 private:
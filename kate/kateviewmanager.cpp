@@ -25,6 +25,7 @@
 #include "katemainwindow.h"
 #include "kateviewspace.h"
 #include "kateupdatedisabler.h"
+#include "katedebug.h"
 
 #include <KTextEditor/View>
 #include <KTextEditor/Document>
@@ -36,6 +37,7 @@
 #include <KRecentFilesAction>
 #include <KConfig>
 #include <KConfigGroup>
+#include <KSharedConfig>
 #include <KLocalizedString>
 #include <KXMLGUIFactory>
 
@@ -60,6 +62,9 @@ KateViewManager::KateViewManager(QWidget *parentW, KateMainWindow *parent)
     , m_minAge(0)
     , m_guiMergedView(nullptr)
 {
+    // views beyond this count are deleted, least recently used first, 0 == no limit
+    m_maxLiveViews = KConfigGroup(KSharedConfig::openConfig(), "General").readEntry("Max Live Views Per View Space", 20);
+
     // while init
     m_init = true;
 
@@ -656,7 +661,31 @@ void KateViewManager::activateView(KTextEditor::View *view)
         m_views[view].activityResource->setUri(view->document()->url());
         m_views[view].activityResource->notifyFocusedIn();
 #endif
+
+        // the view shown before might be one too many now
+        evictViews(activeViewSpace());
+    }
+}
+
+void KateViewManager::evictViews(KateViewSpace *vs)
+{
+    if (m_maxLiveViews <= 0 || !vs) {
+        return;
     }
+
+    const QList<KTextEditor::View *> views = vs->viewsToEvict(m_maxLiveViews);
+    if (views.isEmpty()) {
+        return;
+    }
+
+    foreach (KTextEditor::View *view, views) {
+        vs->saveViewState(view);
+        deleteView(view);
+    }
+
+    qCDebug(LOG_KATE) << "view space" << vs << "deleted" << views.size() << "least recently used views,"
+                      << vs->liveViewCount() << "views alive," << vs->evictedViewCount() << "to be recreated on activation,"
+                      << m_views.size() << "views alive in the main window";
 }
 
 KTextEditor::View *KateViewManager::activateView(KTextEditor::Document *d)
@@ -121,6 +121,12 @@ public:
 private:
     bool deleteView(KTextEditor::View *view);
 
+    /**
+     * Delete the least recently used views of @p vs beyond the configured
+     * maximum, their state is kept to recreate them on activation.
+     */
+    void evictViews(KateViewSpace *vs);
+
     void moveViewtoSplit(KTextEditor::View *view);
     void moveViewtoStack(KTextEditor::View *view);
 
@@ -338,6 +344,11 @@ private:
      */
     qint64 m_minAge;
 
+    /**
+     * maximal number of views alive per view space, 0 for no limit
+     */
+    int m_maxLiveViews;
+
     /**
      * the view that is ATM merged to the xml gui factory
      */
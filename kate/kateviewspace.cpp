@@ -54,6 +54,7 @@ KateViewSpace::KateViewSpace(KateViewManager *viewManager,
     : QWidget(parent)
     , m_viewManager(viewManager)
     , m_isActiveSpace(false)
+    , m_viewStateConfig(QString(), KConfig::SimpleConfig)
 {
     setObjectName(QString::fromLatin1(name));
     QVBoxLayout *layout = new QVBoxLayout(this);
@@ -242,6 +243,11 @@ KTextEditor::View *KateViewSpace::createView(KTextEditor::Document *doc)
     m_docToView[doc] = v;
     showView(v);
 
+    // the view was deleted before to save memory, continue where it was
+    if (m_viewStates.contains(doc)) {
+        restoreViewState(v);
+    }
+
     return v;
 }
 
@@ -302,6 +308,87 @@ bool KateViewSpace::showView(KTextEditor::Document *document)
     return true;
 }
 
+QList<KTextEditor::View *> KateViewSpace::viewsToEvict(int maxViews) const
+{
+    QList<KTextEditor::View *> views;
+
+    int excess = m_docToView.size() - maxViews;
+    if (excess <= 0) {
+        return views;
+    }
+
+    KTextEditor::View *current = static_cast<KTextEditor::View *>(stack->currentWidget());
+    for (int i = 0; i < m_lruDocList.size() && excess > 0; ++i) {
+        KTextEditor::View *view = m_docToView.value(m_lruDocList[i]);
+        if (view && view != current) {
+            views.append(view);
+            --excess;
+        }
+    }
+
+    return views;
+}
+
+void KateViewSpace::saveViewState(KTextEditor::View *view)
+{
+    KTextEditor::Document *doc = view->document();
+
+    // session config: cursor, folding, view local settings
+    KConfigGroup cg(&m_viewStateConfig, viewStateGroup(doc));
+    cg.deleteGroup();
+    view->writeSessionConfig(cg);
+
+    ViewState state;
+    state.selection = view->selectionRange();
+    state.firstLine = view->firstDisplayedLine();
+    m_viewStates[doc] = state;
+}
+
+void KateViewSpace::restoreViewState(KTextEditor::View *view)
+{
+    KTextEditor::Document *doc = view->document();
+    const ViewState state = m_viewStates.take(doc);
+
+    KConfigGroup cg(&m_viewStateConfig, viewStateGroup(doc));
+    view->readSessionConfig(cg);
+    const KTextEditor::Cursor cursor = view->cursorPosition();
+    cg.deleteGroup();
+
+    // there is no API to scroll, but moving the cursor scrolls just far
+    // enough to make it visible: coming from the end of the document,
+    // the first line ends up at the top
+    const int firstLine = qMin(state.firstLine, doc->lines() - 1);
+    if (firstLine > 0) {
+        view->setCursorPosition(doc->documentEnd());
+        view->setCursorPosition(KTextEditor::Cursor(firstLine, 0));
+    }
+
+    // a cursor scrolled out of sight would scroll the view away again,
+    // it then stays at the top of the restored lines
+    if (firstLine <= 0 || (cursor.line() >= view->firstDisplayedLine() && cursor.line() <= view->lastDisplayedLine())) {
+        view->setCursorPosition(cursor);
+    }
+
+    if (state.selection.isValid() && doc->documentRange().contains(state.selection)) {
+        view->setSelection(state.selection);
+    }
+}
+
+int KateViewSpace::liveViewCount() const
+{
+    return m_docToView.size();
+}
+
+int KateViewSpace::evictedViewCount() const
+{
+    return m_viewStates.size();
+}
+
+QString KateViewSpace::viewStateGroup(KTextEditor::Document *doc)
+{
+    return QString::number(quintptr(doc));
+}
+
 void KateViewSpace::changeView(int id)
 {
     KTextEditor::Document *doc = m_docToTabId.key(id);
@@ -488,6 +575,11 @@ void KateViewSpace::documentDestroyed(QObject *doc)
         }
     }
 
+    // forget the state of an evicted view
+    if (m_viewStates.remove(invalidDoc)) {
+        m_viewStateConfig.deleteGroup(viewStateGroup(invalidDoc));
+    }
+
     // at this point, the doc should be completely unknown
     Q_ASSERT(! m_lruDocList.contains(invalidDoc));
     Q_ASSERT(! m_docToView.contains(invalidDoc));
@@ -658,6 +750,15 @@ void KateViewSpace::saveConfig(KConfigBase *config, int myIndex , const QString
 
         ++idx;
     }
+
+    // views deleted to save memory still have their state to be saved
+    for (auto it = m_viewStates.constBegin(); it != m_viewStates.constEnd(); ++it) {
+        const QString url = it.key()->url().toString();
+        if (!url.isEmpty()) {
+            KConfigGroup viewGroup(config, QString::fromLatin1("%1 %2").arg(groupname).arg(url));
+            KConfigGroup(&m_viewStateConfig, viewStateGroup(it.key())).copyTo(&viewGroup);
+        }
+    }
 }
 
 void KateViewSpace::restoreConfig(KateViewManager *viewMan, const KConfigBase *config, const QString &groupname)
@@ -25,6 +25,8 @@
 #include <ktexteditor/document.h>
 #include <ktexteditor/modificationinterface.h>
 
+#include <KConfig>
+
 #include <QHash>
 #include <QWidget>
 
@@ -89,6 +91,29 @@ public:
      */
     void registerDocument(KTextEditor::Document *doc, bool append = true);
 
+    /**
+     * Returns the views beyond the @p maxViews most recently used ones,
+     * least recently used first. The current view is never returned.
+     */
+    QList<KTextEditor::View *> viewsToEvict(int maxViews) const;
+
+    /**
+     * Remember cursor, selection and scroll position of @p view, which
+     * is about to be deleted. A view created later for the same document
+     * starts from that state again.
+     */
+    void saveViewState(KTextEditor::View *view);
+
+    /**
+     * Returns the number of views alive in this view space.
+     */
+    int liveViewCount() const;
+
+    /**
+     * Returns the number of documents whose view was deleted to save memory.
+     */
+    int evictedViewCount() const;
+
     /**
      * Event filter to catch events from view space tool buttons.
      */
@@ -175,6 +200,16 @@ private:
      */
     int hiddenDocuments() const;
 
+    /**
+     * Restore the state saved by saveViewState() for the document of @p view.
+     */
+    void restoreViewState(KTextEditor::View *view);
+
+    /**
+     * Returns the group in m_viewStateConfig used for @p doc.
+     */
+    static QString viewStateGroup(KTextEditor::Document *doc);
+
 private:
     // Kate's view manager
     KateViewManager *m_viewManager;
@@ -198,6 +233,16 @@ private:
     // note: the number of entries match stack->count();
     QHash<KTextEditor::Document*, KTextEditor::View*> m_docToView;
 
+    // state of the views deleted by the view manager to save memory:
+    // the session config of the view (in memory only), plus selection
+    // and first visible line, which the session config does not cover
+    struct ViewState {
+        KTextEditor::Range selection;
+        int firstLine;
+    };
+    QHash<KTextEditor::Document*, ViewState> m_viewStates;
+    KConfig m_viewStateConfig;
+
     // tab bar that contains viewspace tabs
     KateTabBar *m_tabBar;
     
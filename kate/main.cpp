@@ -41,6 +41,7 @@
 #include <QVariant>
 #include <QDBusInterface>
 #include <QDBusMessage>
+#include <QDBusPendingReply>
 #include <QDBusReply>
 #include <QApplication>
 #include <QDir>
@@ -324,34 +325,25 @@ int main(int argc, char **argv)
         bool foundRunningService = false;
         if ((!force_new) && (serviceName.isEmpty())) {
             const int desktopnumber = KWindowSystem::currentDesktop();
-            int sessionDesktopNumber;
-            for (int s = 0; s < kateServices.count(); s++) {
-
-                serviceName = kateServices[s];
 
-                if (!serviceName.isEmpty()) {
-                    QDBusReply<bool> there = sessionBusInterface->isServiceRegistered(serviceName);
+            // query all instances current desktop at once, the services come
+            // from the list of registered names, so they are known to be there
+            QList<QDBusPendingCall> desktopCalls;
+            for (int s = 0; s < kateServices.count(); s++) {
+                QDBusMessage m = QDBusMessage::createMethodCall(kateServices[s],
+                                 QStringLiteral("/MainApplication"), QStringLiteral("org.kde.Kate.Application"), QStringLiteral("desktopNumber"));
+                desktopCalls.append(QDBusConnection::sessionBus().asyncCall(m));
+            }
 
-                    if (there.isValid() && there.value()) {
-                        sessionDesktopNumber = -1;
+            for (int s = 0; s < desktopCalls.count(); s++) {
+                QDBusPendingReply<int> res(desktopCalls[s]);
+                res.waitForFinished();
 
-                        // query instance current desktop
-                        QDBusMessage m = QDBusMessage::createMethodCall(serviceName,
-                                         QStringLiteral("/MainApplication"), QStringLiteral("org.kde.Kate.Application"), QStringLiteral("desktopNumber"));
-
-                        QDBusMessage res = QDBusConnection::sessionBus().call(m);
-                        QList<QVariant> answer = res.arguments();
-                        if (answer.size() == 1) {
-                            sessionDesktopNumber = answer.at(0).toInt();
-                            if (sessionDesktopNumber ==  desktopnumber) {
-                                // stop searching. a candidate instance in the current desktop has been found
-                                foundRunningService = true;
-                                break;
-                            }
-                        }
-                    }
+                if (!foundRunningService && res.isValid() && res.value() == desktopnumber) {
+                    // stop searching. a candidate instance in the current desktop has been found
+                    serviceName = kateServices[s];
+                    foundRunningService = true;
                 }
-                serviceName.clear();
             }
         }
 
@@ -381,28 +373,55 @@ int main(int argc, char **argv)
 
             QStringList tokens;
 
-            // open given files...
-            foreach(const QString & url, urls) {
+            // open given files, all in one call...
+            if (!urls.isEmpty()) {
+                KateOpenUrlRequest::registerMetaType();
+
+                QList<KateOpenUrlRequest> requests;
+                foreach(const QString & url, urls) {
+                    UrlInfo info(url);
+
+                    KateOpenUrlRequest request;
+                    request.url = info.url.toString();
+                    request.line = info.cursor.line();
+                    request.column = info.cursor.column();
+                    request.encoding = enc;
+                    requests.append(request);
+                }
+
                 QDBusMessage m = QDBusMessage::createMethodCall(serviceName,
-                                QStringLiteral("/MainApplication"), QStringLiteral("org.kde.Kate.Application"), QStringLiteral("tokenOpenUrlAt"));
+                                QStringLiteral("/MainApplication"), QStringLiteral("org.kde.Kate.Application"), QStringLiteral("tokenOpenUrls"));
 
-                UrlInfo info(url);
                 QList<QVariant> dbusargs;
-
-                // convert to an url
-                dbusargs.append(info.url.toString());
-                dbusargs.append(info.cursor.line());
-                dbusargs.append(info.cursor.column());
-                dbusargs.append(enc);
+                dbusargs.append(QVariant::fromValue(requests));
                 dbusargs.append(tempfileSet);
                 m.setArguments(dbusargs);
 
-                QDBusMessage res = QDBusConnection::sessionBus().call(m);
-                if (res.type() == QDBusMessage::ReplyMessage) {
-                    if (res.arguments().count() == 1) {
-                        QVariant v = res.arguments()[0];
-                        if (v.isValid()) {
-                            QString s = v.toString();
+                // opening thousands of files may well take longer than the default timeout
+                QDBusReply<QStringList> res = QDBusConnection::sessionBus().call(m, QDBus::Block, 5 * 60 * 1000);
+                if (res.isValid()) {
+                    foreach(const QString & s, res.value()) {
+                        if ((!s.isEmpty()) && (s != QStringLiteral("ERROR"))) {
+                            tokens << s;
+                        }
+                    }
+                } else if (res.error().type() == QDBusError::UnknownMethod) {
+                    // an older instance without tokenOpenUrls, one call per file
+                    foreach(const KateOpenUrlRequest & request, requests) {
+                        QDBusMessage m = QDBusMessage::createMethodCall(serviceName,
+                                        QStringLiteral("/MainApplication"), QStringLiteral("org.kde.Kate.Application"), QStringLiteral("tokenOpenUrlAt"));
+
+                        QList<QVariant> dbusargs;
+                        dbusargs.append(request.url);
+                        dbusargs.append(request.line);
+                        dbusargs.append(request.column);
+                        dbusargs.append(request.encoding);
+                        dbusargs.append(tempfileSet);
+                        m.setArguments(dbusargs);
+
+                        QDBusReply<QString> res = QDBusConnection::sessionBus().call(m);
+                        if (res.isValid()) {
+                            QString s = res.value();
                             if ((!s.isEmpty()) && (s != QStringLiteral("ERROR"))) {
                                 tokens << s;
                             }
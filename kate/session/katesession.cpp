@@ -38,6 +38,7 @@ KateSession::KateSession(const QString &file, const QString &name, const bool an
     , m_file(file)
     , m_anonymous(anonymous)
     , m_documents(0)
+    , m_documentsKnown(false)
     , m_config(0)
     , m_timestamp()
 {
@@ -47,13 +48,25 @@ KateSession::KateSession(const QString &file, const QString &name, const bool an
         m_config = _config->copyTo(m_file);
     } else if (!QFile::exists(m_file)) { // given file exists, use it to load some stuff
         qCDebug(LOG_KATE) << "Warning, session file not found: " << m_file;
+        m_documentsKnown = true;
         return;
     }
 
     m_timestamp = QFileInfo(m_file).lastModified();
 
-    // get the document count
-    m_documents = config()->group(opGroupName).readEntry(keyCount, 0);
+    // the document count is read on demand, listing sessions must not parse them all
+}
+
+KateSession::KateSession(const QString &file, const QString &name, const QDateTime &timestamp, int documents)
+    : m_name(name)
+    , m_file(file)
+    , m_anonymous(false)
+    , m_documents(qMax(documents, 0))
+    , m_documentsKnown(documents >= 0)
+    , m_config(0)
+    , m_timestamp(timestamp)
+{
+    Q_ASSERT(!m_file.isEmpty());
 }
 
 KateSession::~KateSession()
@@ -66,10 +79,32 @@ const QString &KateSession::file() const
     return m_file;
 }
 
+unsigned int KateSession::documents() const
+{
+    if (!m_documentsKnown) {
+        if (m_config) {
+            m_documents = m_config->group(opGroupName).readEntry(keyCount, 0);
+        } else {
+            // only the count is needed, don't keep the whole config around
+            m_documents = KConfig(m_file, KConfig::SimpleConfig).group(opGroupName).readEntry(keyCount, 0);
+        }
+        m_documentsKnown = true;
+    }
+
+    return m_documents;
+}
+
 void KateSession::setDocuments(const unsigned int number)
 {
     config()->group(opGroupName).writeEntry(keyCount, number);
     m_documents = number;
+    m_documentsKnown = true;
+}
+
+void KateSession::setTimestamp(const QDateTime &timestamp)
+{
+    m_timestamp = timestamp;
+    m_documentsKnown = false;
 }
 
 void KateSession::setFile(const QString &filename)
@@ -59,11 +59,10 @@ public:
 
     /**
      * count of documents in this session
+     * read from the session file on first access, unless the session index knew it
      * @return documents count
      */
-    unsigned int documents() const {
-        return m_documents;
-    }
+    unsigned int documents() const;
 
     /**
      * update @number of openned documents in session
@@ -114,6 +113,11 @@ private:
      */
     void setFile(const QString &filename);
 
+    /**
+     * update the last save time, the documents count is read again on next access
+     */
+    void setTimestamp(const QDateTime &timestamp);
+
     /**
      * create a session from given @file
      * @param file configuration file
@@ -123,11 +127,19 @@ private:
      */
     KateSession(const QString &file, const QString &name, const bool anonymous, const KConfig *config = 0);
 
+    /**
+     * create a named session from what the session index remembered about @file,
+     * neither the file nor its config are touched
+     * @param documents documents count, -1 if not known
+     */
+    KateSession(const QString &file, const QString &name, const QDateTime &timestamp, int documents);
+
 private:
     QString m_name;
     QString m_file;
     bool m_anonymous;
-    unsigned int m_documents;
+    mutable unsigned int m_documents;
+    mutable bool m_documentsKnown;
     KConfig *m_config;
     QDateTime m_timestamp;
 };
@@ -38,8 +38,12 @@
 #include <KDirWatch>
 
 #include <QApplication>
+#include <QCryptographicHash>
+#include <QDataStream>
 #include <QDir>
+#include <QFileInfo>
 #include <QInputDialog>
+#include <QSaveFile>
 #include <QUrl>
 
 #ifndef Q_OS_WIN
@@ -64,27 +68,37 @@ KateSessionManager::KateSessionManager(QObject *parent, const QString &sessionsD
     m_dirWatch->addDir(m_sessionsDir);
     connect(m_dirWatch, SIGNAL(dirty(QString)), this, SLOT(updateSessionList()));
 
-    updateSessionList();
+    // an index written for the current dir content saves the scan,
+    // the dir watch rescans on every change from here on
+    if (!readSessionIndex()) {
+        updateSessionList();
+    }
 
     m_activeSession = KateSession::createAnonymous(anonymousSessionFile());
 }
 
 KateSessionManager::~KateSessionManager()
 {
+    // documents counts read meanwhile are kept for next time
+    writeSessionIndex();
+
     delete m_dirWatch;
 }
 
 void KateSessionManager::updateSessionList()
 {
-    QStringList list;
+    // taken before the scan, so changes made meanwhile invalidate the index
+    const QDateTime dirTimestamp = QFileInfo(m_sessionsDir).lastModified();
 
     // Let's get a list of all session we have atm
     QDir dir(m_sessionsDir, QStringLiteral("*.katesession"));
+    const QFileInfoList files = dir.entryInfoList(QDir::Files);
 
-    for (unsigned int i = 0; i < dir.count(); ++i) {
-        QString name = dir[i];
+    QHash<QString, QDateTime> list;
+    foreach(const QFileInfo & info, files) {
+        QString name = info.fileName();
         name.chop(12); // .katesession
-        list << QUrl::fromPercentEncoding(name.toLatin1());
+        list.insert(QUrl::fromPercentEncoding(name.toLatin1()), info.lastModified());
     }
 
     // delete old items;
@@ -92,21 +106,114 @@ void KateSessionManager::updateSessionList()
 
     while (i.hasNext()) {
         i.next();
-        const int idx = list.indexOf(i.key());
-        if (idx == -1) { // the key is invalid, remove it from m_session
+        QHash<QString, QDateTime>::iterator it = list.find(i.key());
+        if (it == list.end()) { // the key is invalid, remove it from m_session
             if (i.value() != m_activeSession) { // if active, ignore missing config
                 i.remove();
             }
         } else { // remove it from scan list
-            list.removeAt(idx);
+            if (i.value()->timestamp() != it.value()) {
+                i.value()->setTimestamp(it.value());
+            }
+            list.erase(it);
         }
     }
 
     // load the new ones
-    foreach(const QString & newName, list) {
-        const QString file = sessionFileForName(newName);
-        m_sessions[newName] = KateSession::create(file, newName);
+    for (QHash<QString, QDateTime>::const_iterator it = list.constBegin(); it != list.constEnd(); ++it) {
+        const QString file = sessionFileForName(it.key());
+        m_sessions[it.key()] = KateSession::create(file, it.key());
+    }
+
+    m_sessionsDirTimestamp = dirTimestamp;
+    writeSessionIndex();
+}
+
+QString KateSessionManager::sessionIndexFile() const
+{
+    // not in the dir itself, writing it must not trigger the dir watch
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    QDir().mkpath(dir);
+
+    const QByteArray hash = QCryptographicHash::hash(m_sessionsDir.toUtf8(), QCryptographicHash::Md5).toHex();
+    return dir + QStringLiteral("/sessions-") + QString::fromLatin1(hash) + QStringLiteral(".index");
+}
+
+static const quint32 SessionIndexMagic = 0x4b534958; // "KSIX"
+static const quint32 SessionIndexVersion = 1;
+
+bool KateSessionManager::readSessionIndex()
+{
+    QFile file(sessionIndexFile());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
     }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic, version;
+    QString dir;
+    QDateTime written;
+    QDateTime dirTimestamp;
+    quint32 count;
+    stream >> magic >> version >> dir >> written >> dirTimestamp >> count;
+
+    if (stream.status() != QDataStream::Ok || magic != SessionIndexMagic || version != SessionIndexVersion || dir != m_sessionsDir) {
+        return false;
+    }
+
+    QHash<QString, KateSession::Ptr> sessions;
+    for (quint32 n = 0; n < count; ++n) {
+        QString name;
+        QDateTime timestamp;
+        qint32 documents;
+        stream >> name >> timestamp >> documents;
+
+        if (stream.status() != QDataStream::Ok) {
+            return false;
+        }
+
+        // file times can be as coarse as a second or two, a session saved
+        // again right after its count was taken may look unchanged
+        if (timestamp.secsTo(written) < 2) {
+            documents = -1;
+        }
+
+        sessions[name] = KateSession::Ptr(new KateSession(sessionFileForName(name), name, timestamp, documents));
+    }
+
+    m_sessions = sessions;
+
+    // if the dir did not change since, neither did the list of sessions,
+    // else updateSessionList() checks the entries against it
+    const QDateTime currentDirTimestamp = QFileInfo(m_sessionsDir).lastModified();
+    if (!currentDirTimestamp.isValid() || currentDirTimestamp != dirTimestamp || dirTimestamp.secsTo(written) < 2) {
+        return false;
+    }
+
+    m_sessionsDirTimestamp = dirTimestamp;
+    return true;
+}
+
+void KateSessionManager::writeSessionIndex()
+{
+    QSaveFile file(sessionIndexFile());
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    stream << SessionIndexMagic << SessionIndexVersion << m_sessionsDir << QDateTime::currentDateTime() << m_sessionsDirTimestamp << quint32(m_sessions.size());
+
+    for (QHash<QString, KateSession::Ptr>::const_iterator it = m_sessions.constBegin(); it != m_sessions.constEnd(); ++it) {
+        const KateSession::Ptr &session = it.value();
+        stream << it.key() << session->timestamp() << (session->m_documentsKnown ? qint32(session->m_documents) : qint32(-1));
+    }
+
+    file.commit();
 }
 
 bool KateSessionManager::activateSession(KateSession::Ptr session,
@@ -128,7 +235,7 @@ bool KateSessionManager::activateSession(KateSession::Ptr session,
         if (instances.contains(session->name())) {
             if (KMessageBox::questionYesNo(0, i18n("Session '%1' is already opened in another kate instance, change there instead of reopening?", session->name()),
                                            QString(), KStandardGuiItem::yes(), KStandardGuiItem::no(), QStringLiteral("katesessionmanager_switch_instance")) == KMessageBox::Yes) {
-                instances[session->name()]->dbus_if->call(QStringLiteral("activate"));
+                instances[session->name()]->activate();
                 cleanupRunningKateAppInstanceMap(&instances);
                 return false;
             }
@@ -186,6 +186,14 @@ private:
      */
     void loadSession(const KateSession::Ptr &session) const;
 
+    /**
+     * the session index remembers name, documents count and last save time
+     * of all sessions, so listing them needs no session file to be parsed
+     */
+    QString sessionIndexFile() const;
+    bool readSessionIndex();
+    void writeSessionIndex();
+
 private:
     /**
      * absolute path to dir in home dir where to store the sessions
@@ -197,6 +205,12 @@ private:
      */
     QHash<QString, KateSession::Ptr> m_sessions;
 
+    /**
+     * modification time of the sessions dir at the last scan, an index
+     * is only used at startup if the dir still has it
+     */
+    QDateTime m_sessionsDirTimestamp;
+
     /**
      * current active session
      */